@@ -193,10 +193,12 @@
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <sys/times.h>
+#include <sys/uio.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <dirent.h>
 #include <aio.h>
 #include <netinet/in.h>
@@ -231,6 +233,19 @@ typedef struct { int portev_object; } port_event_t;
 #define TTUSEEVPORTS   1
 #else
 #include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#define TTUSEFUTEX     1
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#if defined(IORING_ACCEPT_MULTISHOT) && defined(IORING_POLL_ADD_MULTI) && \
+  defined(IORING_ENTER_EXT_ARG) && defined(__NR_io_uring_setup)
+#define TTUSEURING     1
+#endif
+#endif
+#endif
 #endif
 
 
@@ -45,7 +45,7 @@ typedef struct _SCREXT {                 // type of structure of the script exte
 /* Initialize the global scripting language extension. */
 void *scrextnew(void **screxts, int thnum, int thid, const char *path, TCADB *adb, TCULOG *ulog,
                 uint32_t sid, TCMDB *stash, pthread_mutex_t *lcks, int lcknum,
-                void (*logger)(int, const char *, void *), void *logopq){
+                pthread_mutex_t *itermtx, void (*logger)(int, const char *, void *), void *logopq){
   SCREXT *scr = tcmalloc(sizeof(*scr));
   scr->screxts = (SCREXT **)screxts;
   scr->thnum = thnum;
@@ -167,6 +167,7 @@ typedef struct {                         // type of structure of the server data
   TCMDB *stash;                          // global stash object
   pthread_mutex_t *lcks;                 // mutex for user locks
   int lcknum;                            // number of user locks
+  pthread_mutex_t *itermtx;              // mutex for the iterator of the database
   void (*logger)(int, const char *, void *);  // logging function
   void *logopq;                          // opaque pointer for the logging function
 } SERV;
@@ -223,7 +224,7 @@ static int serv_mkdir(lua_State *lua);
 /* Initialize the global scripting language extension. */
 void *scrextnew(void **screxts, int thnum, int thid, const char *path, TCADB *adb, TCULOG *ulog,
                 uint32_t sid, TCMDB *stash, pthread_mutex_t *lcks, int lcknum,
-                void (*logger)(int, const char *, void *), void *logopq){
+                pthread_mutex_t *itermtx, void (*logger)(int, const char *, void *), void *logopq){
   char *ibuf;
   int isiz;
   if(*path == '@'){
@@ -253,6 +254,7 @@ void *scrextnew(void **screxts, int thnum, int thid, const char *path, TCADB *ad
   serv->stash = stash;
   serv->lcks = lcks;
   serv->lcknum = lcknum;
+  serv->itermtx = itermtx;
   serv->logger = logger;
   serv->logopq = logopq;
   lua_setglobal(lua, SERVVAR);
@@ -668,7 +670,12 @@ static int serv_iterinit(lua_State *lua){
   }
   lua_getglobal(lua, SERVVAR);
   SERV *serv = lua_touserdata(lua, -1);
+  if(pthread_mutex_lock(serv->itermtx) != 0){
+    lua_pushstring(lua, "_iterinit: pthread_mutex_lock failed");
+    lua_error(lua);
+  }
   bool rv = tcadbiterinit(serv->adb);
+  pthread_mutex_unlock(serv->itermtx);
   lua_settop(lua, 0);
   lua_pushboolean(lua, rv);
   return 1;
@@ -684,8 +691,13 @@ static int serv_iternext(lua_State *lua){
   }
   lua_getglobal(lua, SERVVAR);
   SERV *serv = lua_touserdata(lua, -1);
+  if(pthread_mutex_lock(serv->itermtx) != 0){
+    lua_pushstring(lua, "_iternext: pthread_mutex_lock failed");
+    lua_error(lua);
+  }
   int vsiz;
   char *vbuf = tcadbiternext(serv->adb, &vsiz);
+  pthread_mutex_unlock(serv->itermtx);
   lua_settop(lua, 0);
   if(vbuf){
     lua_pushlstring(lua, vbuf, vsiz);
@@ -845,8 +857,10 @@ static int serv_misc(lua_State *lua){
   }
   lua_getglobal(lua, SERVVAR);
   SERV *serv = lua_touserdata(lua, -1);
+  if(!ulog) tculogbloommisc(serv->ulog, name, args);
   TCLIST *res = ulog ? tculogadbmisc(serv->ulog, serv->sid, serv->adb, name, args) :
     tcadbmisc(serv->adb, name, args);
+  if(!ulog) tculogcachemisc(serv->ulog, name, args);
   lua_settop(lua, 0);
   if(res){
     int rnum = tclistnum(res);
@@ -54,12 +54,13 @@
    `stash' specifies the stash object.
    `lcks' specifies the mutex objects for user locks.
    `lcknum' specifies the number of user locks.
+   `itermtx' specifies the mutex object guarding the iterator of the database.
    `logger' specifies the pointer to a function to do with a log message.
    `logopq' specifies the opaque pointer for the logging function.
    The return value is the scripting object or `NULL' on failure. */
 void *scrextnew(void **screxts, int thnum, int thid, const char *path, TCADB *adb, TCULOG *ulog,
                 uint32_t sid, TCMDB *stash, pthread_mutex_t *lcks, int lcknum,
-                void (*logger)(int, const char *, void *), void *logopq);
+                pthread_mutex_t *itermtx, void (*logger)(int, const char *, void *), void *logopq);
 
 
 /* Destroy the scripting language extension.
@@ -20,6 +20,26 @@
 #include "tcrdb.h"
 #include "myconf.h"
 
+#define RDBSCANPAGE    1024              // number of records of each page of scanning
+
+typedef struct {                         // type of structure for a partition of scanning
+  const char *host;
+  int port;
+  int part;
+  int pnum;
+  TCITER iter;
+  void *op;
+  bool *stop;
+} RDBSCANARG;
+
+
+/* private function prototypes */
+static bool tcrdbopenshm(TCRDB *rdb);
+static void *tcrdbscanpart(void *targ);
+static void tcrdbbatchadd(RDBBATCH *batch, int cmd,
+                          const void *kbuf, int ksiz, const void *vbuf, int vsiz);
+static int tcrdbcodeerr(int code, int ecode);
+
 
 
 /*************************************************************************************************
@@ -38,6 +58,7 @@ const char *tcrdberrmsg(int ecode){
   case TTERECV: return "recv error";
   case TTEKEEP: return "existing record";
   case TTENOREC: return "no record found";
+  case TTEBUSY: return "server busy";
   case TTEMISC: return "miscellaneous error";
   }
   return "unknown error";
@@ -76,6 +97,8 @@ bool tcrdbopen(TCRDB *rdb, const char *host, int port){
     rdb->ecode = TTEINVALID;
     return false;
   }
+  bool shm = tcstrfwm(host, "shm:");
+  if(shm) host += 4;
   int fd;
   if(port < 1){
     fd = ttopensockunix(host);
@@ -93,6 +116,12 @@ bool tcrdbopen(TCRDB *rdb, const char *host, int port){
   }
   rdb->fd = fd;
   rdb->sock = ttsocknew(fd);
+  if(shm && !tcrdbopenshm(rdb)){
+    int ecode = rdb->ecode;
+    tcrdbclose(rdb);
+    rdb->ecode = ecode;
+    return false;
+  }
   return true;
 }
 
@@ -148,7 +177,7 @@ bool tcrdbput(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz
   } else {
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   }
@@ -196,7 +225,7 @@ bool tcrdbputkeep(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int
   } else {
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEKEEP;
+      rdb->ecode = tcrdbcodeerr(code, TTEKEEP);
       err = true;
     }
   }
@@ -244,7 +273,7 @@ bool tcrdbputcat(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int v
   } else {
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   }
@@ -295,7 +324,7 @@ bool tcrdbputshl(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int v
   } else {
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   }
@@ -311,6 +340,50 @@ bool tcrdbputshl2(TCRDB *rdb, const char *kstr, const char *vstr, int width){
 }
 
 
+/* Store a record with an expiration time into a remote database object. */
+bool tcrdbputttl(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz, int ttl){
+  assert(rdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0 && ttl >= 0);
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return false;
+  }
+  bool err = false;
+  int rsiz = 2 + sizeof(uint32_t) * 3 + ksiz + vsiz;
+  unsigned char stack[TTIOBUFSIZ];
+  unsigned char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz);
+  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  unsigned char *wp = buf;
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = TTCMDPUTTTL;
+  uint32_t num;
+  num = TTHTONL((uint32_t)ksiz);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  num = TTHTONL((uint32_t)vsiz);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  num = TTHTONL((uint32_t)ttl);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  memcpy(wp, kbuf, ksiz);
+  wp += ksiz;
+  memcpy(wp, vbuf, vsiz);
+  wp += vsiz;
+  if(!ttsocksend(rdb->sock, buf, wp - buf)){
+    rdb->ecode = TTESEND;
+    err = true;
+  } else {
+    int code = ttsockgetc(rdb->sock);
+    if(code != 0){
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
+      err = true;
+    }
+  }
+  pthread_cleanup_pop(1);
+  return !err;
+}
+
+
 /* Store a record into a remote database object without repsponse from the server. */
 bool tcrdbputnr(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(rdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
@@ -380,7 +453,7 @@ bool tcrdbout(TCRDB *rdb, const void *kbuf, int ksiz){
   } else {
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTENOREC;
+      rdb->ecode = tcrdbcodeerr(code, TTENOREC);
       err = true;
     }
   }
@@ -418,7 +491,7 @@ void *tcrdbget(TCRDB *rdb, const void *kbuf, int ksiz, int *sp){
   memcpy(wp, kbuf, ksiz);
   wp += ksiz;
   if(ttsocksend(rdb->sock, buf, wp - buf)){
-    int code = ttsockgetc(rdb->sock);
+    int code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
     if(code == 0){
       int vsiz = ttsockgetint32(rdb->sock);
       if(!ttsockcheckend(rdb->sock) && vsiz >= 0){
@@ -435,7 +508,7 @@ void *tcrdbget(TCRDB *rdb, const void *kbuf, int ksiz, int *sp){
         rdb->ecode = TTERECV;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTENOREC;
+      rdb->ecode = tcrdbcodeerr(code, TTENOREC);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -482,7 +555,7 @@ bool tcrdbget3(TCRDB *rdb, TCMAP *recs){
   tcmapclear(recs);
   char stack[TTIOBUFSIZ];
   if(ttsocksend(rdb->sock, tcxstrptr(xstr), tcxstrsize(xstr))){
-    int code = ttsockgetc(rdb->sock);
+    int code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
     int rnum = ttsockgetint32(rdb->sock);
     if(code == 0){
       if(!ttsockcheckend(rdb->sock) && rnum >= 0){
@@ -509,7 +582,7 @@ bool tcrdbget3(TCRDB *rdb, TCMAP *recs){
         err = true;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTENOREC;
+      rdb->ecode = tcrdbcodeerr(code, TTENOREC);
       err = true;
     }
   } else {
@@ -521,6 +594,181 @@ bool tcrdbget3(TCRDB *rdb, TCMAP *recs){
 }
 
 
+/* Retrieve records in a remote database object by streamed chunks. */
+bool tcrdbget4(TCRDB *rdb, TCMAP *recs){
+  assert(rdb && recs);
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return NULL;
+  }
+  bool err = false;
+  TCXSTR *xstr = tcxstrnew();
+  pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+  uint8_t magic[2];
+  magic[0] = TTMAGICNUM;
+  magic[1] = TTCMDMGETSTRM;
+  tcxstrcat(xstr, magic, sizeof(magic));
+  uint32_t num;
+  num = (uint32_t)tcmaprnum(recs);
+  num = TTHTONL(num);
+  tcxstrcat(xstr, &num, sizeof(num));
+  tcmapiterinit(recs);
+  const char *kbuf;
+  int ksiz;
+  while((kbuf = tcmapiternext(recs, &ksiz)) != NULL){
+    num = TTHTONL((uint32_t)ksiz);
+    tcxstrcat(xstr, &num, sizeof(num));
+    tcxstrcat(xstr, kbuf, ksiz);
+  }
+  tcmapclear(recs);
+  char stack[TTIOBUFSIZ];
+  if(ttsocksend(rdb->sock, tcxstrptr(xstr), tcxstrsize(xstr))){
+    int code;
+    do {
+      code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
+      int rnum = ttsockgetint32(rdb->sock);
+      if(code != 0 && code != TTCODEMORE){
+        rdb->ecode = tcrdbcodeerr(code, TTEMISC);
+        err = true;
+      } else if(!ttsockcheckend(rdb->sock) && rnum >= 0){
+        for(int i = 0; i < rnum; i++){
+          int rksiz = ttsockgetint32(rdb->sock);
+          int rvsiz = ttsockgetint32(rdb->sock);
+          if(ttsockcheckend(rdb->sock)){
+            rdb->ecode = TTERECV;
+            err = true;
+            break;
+          }
+          int rsiz = rksiz + rvsiz;
+          char *rbuf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz + 1);
+          if(ttsockrecv(rdb->sock, rbuf, rsiz)){
+            tcmapput(recs, rbuf, rksiz, rbuf + rksiz, rvsiz);
+          } else {
+            rdb->ecode = TTERECV;
+            err = true;
+          }
+          if(rbuf != stack) tcfree(rbuf);
+          if(err) break;
+        }
+      } else {
+        rdb->ecode = TTERECV;
+        err = true;
+      }
+    } while(!err && code == TTCODEMORE);
+  } else {
+    rdb->ecode = TTESEND;
+    err = true;
+  }
+  pthread_cleanup_pop(1);
+  return !err;
+}
+
+
+/* Retrieve a record in a remote database object with its version token. */
+void *tcrdbgets(TCRDB *rdb, const void *kbuf, int ksiz, int *sp, uint64_t *verp){
+  assert(rdb && kbuf && ksiz >= 0 && sp && verp);
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return NULL;
+  }
+  char *vbuf = NULL;
+  int rsiz = 2 + sizeof(uint32_t) + ksiz;
+  unsigned char stack[TTIOBUFSIZ];
+  unsigned char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz);
+  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  unsigned char *wp = buf;
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = TTCMDGETS;
+  uint32_t num;
+  num = TTHTONL((uint32_t)ksiz);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  memcpy(wp, kbuf, ksiz);
+  wp += ksiz;
+  if(ttsocksend(rdb->sock, buf, wp - buf)){
+    int code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
+    if(code == 0){
+      int vsiz = ttsockgetint32(rdb->sock);
+      uint64_t ver = ttsockgetint64(rdb->sock);
+      if(!ttsockcheckend(rdb->sock) && vsiz >= 0){
+        vbuf = tcmalloc(vsiz + 1);
+        if(ttsockrecv(rdb->sock, vbuf, vsiz)){
+          vbuf[vsiz] = '\0';
+          *sp = vsiz;
+          *verp = ver;
+        } else {
+          rdb->ecode = TTERECV;
+          tcfree(vbuf);
+          vbuf = NULL;
+        }
+      } else {
+        rdb->ecode = TTERECV;
+      }
+    } else {
+      rdb->ecode = tcrdbcodeerr(code, TTENOREC);
+    }
+  } else {
+    rdb->ecode = TTESEND;
+  }
+  pthread_cleanup_pop(1);
+  return vbuf;
+}
+
+
+/* Store a record into a remote database object only if it is not modified since retrieved. */
+bool tcrdbcas(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz,
+              uint64_t ver, uint64_t *verp){
+  assert(rdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return false;
+  }
+  bool err = false;
+  int rsiz = 2 + sizeof(uint32_t) * 2 + sizeof(uint64_t) + ksiz + vsiz;
+  unsigned char stack[TTIOBUFSIZ];
+  unsigned char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz);
+  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  unsigned char *wp = buf;
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = TTCMDCAS;
+  uint32_t num;
+  num = TTHTONL((uint32_t)ksiz);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  num = TTHTONL((uint32_t)vsiz);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  uint64_t llnum;
+  llnum = TTHTONLL(ver);
+  memcpy(wp, &llnum, sizeof(uint64_t));
+  wp += sizeof(uint64_t);
+  memcpy(wp, kbuf, ksiz);
+  wp += ksiz;
+  memcpy(wp, vbuf, vsiz);
+  wp += vsiz;
+  if(!ttsocksend(rdb->sock, buf, wp - buf)){
+    rdb->ecode = TTESEND;
+    err = true;
+  } else {
+    int code = ttsockgetc(rdb->sock);
+    if(code == 0){
+      uint64_t nver = ttsockgetint64(rdb->sock);
+      if(ttsockcheckend(rdb->sock)){
+        rdb->ecode = TTERECV;
+        err = true;
+      } else if(verp){
+        *verp = nver;
+      }
+    } else {
+      rdb->ecode = tcrdbcodeerr(code, (code == 1) ? TTEKEEP : (code == 2) ? TTENOREC : TTEMISC);
+      err = true;
+    }
+  }
+  pthread_cleanup_pop(1);
+  return !err;
+}
+
+
 /* Get the size of the value of a record in a remote database object. */
 int tcrdbvsiz(TCRDB *rdb, const void *kbuf, int ksiz){
   assert(rdb && kbuf && ksiz >= 0);
@@ -551,7 +799,7 @@ int tcrdbvsiz(TCRDB *rdb, const void *kbuf, int ksiz){
         vsiz = -1;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTENOREC;
+      rdb->ecode = tcrdbcodeerr(code, TTENOREC);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -583,7 +831,7 @@ bool tcrdbiterinit(TCRDB *rdb){
   if(ttsocksend(rdb->sock, buf, wp - buf)){
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   } else {
@@ -607,7 +855,7 @@ void *tcrdbiternext(TCRDB *rdb, int *sp){
   *(wp++) = TTMAGICNUM;
   *(wp++) = TTCMDITERNEXT;
   if(ttsocksend(rdb->sock, buf, wp - buf)){
-    int code = ttsockgetc(rdb->sock);
+    int code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
     if(code == 0){
       int vsiz = ttsockgetint32(rdb->sock);
       if(!ttsockcheckend(rdb->sock) && vsiz >= 0){
@@ -624,7 +872,7 @@ void *tcrdbiternext(TCRDB *rdb, int *sp){
         rdb->ecode = TTERECV;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTENOREC;
+      rdb->ecode = tcrdbcodeerr(code, TTENOREC);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -641,6 +889,147 @@ char *tcrdbiternext2(TCRDB *rdb){
 }
 
 
+/* Get the next records of the iterator of a remote database object. */
+TCLIST *tcrdbiterpage(TCRDB *rdb, int max){
+  assert(rdb);
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return NULL;
+  }
+  if(max < 0) max = INT_MAX;
+  TCLIST *res = NULL;
+  unsigned char buf[TTIOBUFSIZ];
+  unsigned char *wp = buf;
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = TTCMDITERPAGE;
+  uint32_t num;
+  num = TTHTONL((uint32_t)max);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  if(ttsocksend(rdb->sock, buf, wp - buf)){
+    int code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
+    if(code == 0){
+      int rnum = ttsockgetint32(rdb->sock);
+      if(!ttsockcheckend(rdb->sock) && rnum >= 0){
+        res = tclistnew2(rnum * 2);
+        bool err = false;
+        for(int i = 0; i < rnum; i++){
+          int ksiz = ttsockgetint32(rdb->sock);
+          int vsiz = ttsockgetint32(rdb->sock);
+          if(ttsockcheckend(rdb->sock) || ksiz < 0 || vsiz < 0){
+            err = true;
+            break;
+          }
+          int rsiz = ksiz + vsiz;
+          char *rbuf = (rsiz < TTIOBUFSIZ) ? (char *)buf : tcmalloc(rsiz + 1);
+          if(ttsockrecv(rdb->sock, rbuf, rsiz)){
+            tclistpush(res, rbuf, ksiz);
+            tclistpush(res, rbuf + ksiz, vsiz);
+          } else {
+            err = true;
+          }
+          if(rbuf != (char *)buf) tcfree(rbuf);
+          if(err) break;
+        }
+        if(err){
+          rdb->ecode = TTERECV;
+          tclistdel(res);
+          res = NULL;
+        }
+      } else {
+        rdb->ecode = TTERECV;
+      }
+    } else {
+      rdb->ecode = tcrdbcodeerr(code, TTENOREC);
+    }
+  } else {
+    rdb->ecode = TTESEND;
+  }
+  return res;
+}
+
+
+/* Initialize the iterator of a remote database object over a partition of the key space. */
+bool tcrdbiterpart(TCRDB *rdb, int part, int pnum){
+  assert(rdb && part >= 0 && pnum > part);
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return false;
+  }
+  bool err = false;
+  unsigned char buf[TTIOBUFSIZ];
+  unsigned char *wp = buf;
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = TTCMDITERPART;
+  uint32_t num;
+  num = TTHTONL((uint32_t)part);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  num = TTHTONL((uint32_t)pnum);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  if(ttsocksend(rdb->sock, buf, wp - buf)){
+    int code = ttsockgetc(rdb->sock);
+    if(code != 0){
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
+      err = true;
+    }
+  } else {
+    rdb->ecode = TTESEND;
+    err = true;
+  }
+  return !err;
+}
+
+
+/* Process each record of a remote database with parallel connections. */
+bool tcrdbscan(const char *host, int port, int pnum, TCITER iter, void *op){
+  assert(host && pnum > 0 && iter);
+  if(pnum > 1){
+    TCRDB *rdb = tcrdbnew();
+    if(!tcrdbopen(rdb, host, port)){
+      tcrdbdel(rdb);
+      return false;
+    }
+    if(!tcrdbiterpart(rdb, 0, pnum)){
+      if(tcrdbecode(rdb) != TTEMISC){
+        tcrdbdel(rdb);
+        return false;
+      }
+      pnum = 1;
+    }
+    tcrdbdel(rdb);
+  }
+  bool err = false;
+  bool stop = false;
+  RDBSCANARG *args = tcmalloc(sizeof(*args) * pnum);
+  pthread_t *ths = tcmalloc(sizeof(*ths) * pnum);
+  int tnum = 0;
+  for(int i = 0; i < pnum; i++){
+    RDBSCANARG *arg = args + i;
+    arg->host = host;
+    arg->port = port;
+    arg->part = i;
+    arg->pnum = pnum;
+    arg->iter = iter;
+    arg->op = op;
+    arg->stop = &stop;
+    if(pthread_create(ths + i, NULL, tcrdbscanpart, arg) != 0){
+      err = true;
+      break;
+    }
+    tnum++;
+  }
+  for(int i = 0; i < tnum; i++){
+    void *rv;
+    if(pthread_join(ths[i], &rv) != 0 || rv) err = true;
+  }
+  tcfree(ths);
+  tcfree(args);
+  return !err;
+}
+
+
 /* Get forward matching keys in a remote database object. */
 TCLIST *tcrdbfwmkeys(TCRDB *rdb, const void *pbuf, int psiz, int max){
   assert(rdb && pbuf && psiz >= 0);
@@ -667,7 +1056,7 @@ TCLIST *tcrdbfwmkeys(TCRDB *rdb, const void *pbuf, int psiz, int max){
   memcpy(wp, pbuf, psiz);
   wp += psiz;
   if(ttsocksend(rdb->sock, buf, wp - buf)){
-    int code = ttsockgetc(rdb->sock);
+    int code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
     if(code == 0){
       int knum = ttsockgetint32(rdb->sock);
       if(!ttsockcheckend(rdb->sock) && knum >= 0){
@@ -689,7 +1078,7 @@ TCLIST *tcrdbfwmkeys(TCRDB *rdb, const void *pbuf, int psiz, int max){
         rdb->ecode = TTERECV;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTENOREC;
+      rdb->ecode = tcrdbcodeerr(code, TTENOREC);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -706,6 +1095,118 @@ TCLIST *tcrdbfwmkeys2(TCRDB *rdb, const char *pstr, int max){
 }
 
 
+/* Get forward matching records in a remote database object. */
+TCLIST *tcrdbfwmrecs(TCRDB *rdb, const void *pbuf, int psiz, const void *sbuf, int ssiz,
+                     int max, int opts, void **nbp, int *nsp){
+  assert(rdb && pbuf && psiz >= 0 && (!nbp || nsp));
+  if(nbp) *nbp = NULL;
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return NULL;
+  }
+  if(!sbuf) ssiz = 0;
+  bool err = false;
+  TCLIST *recs = tclistnew();
+  int rsiz = 2 + sizeof(uint32_t) * 4 + psiz + ssiz;
+  if(max < 0) max = INT_MAX;
+  unsigned char stack[TTIOBUFSIZ];
+  unsigned char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz);
+  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  unsigned char *wp = buf;
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = TTCMDFWMRECS;
+  uint32_t num;
+  num = TTHTONL((uint32_t)psiz);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  num = TTHTONL((uint32_t)ssiz);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  num = TTHTONL((uint32_t)max);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  num = TTHTONL((uint32_t)opts);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  memcpy(wp, pbuf, psiz);
+  wp += psiz;
+  if(ssiz > 0){
+    memcpy(wp, sbuf, ssiz);
+    wp += ssiz;
+  }
+  if(ttsocksend(rdb->sock, buf, wp - buf)){
+    int code;
+    do {
+      code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
+      int rnum = ttsockgetint32(rdb->sock);
+      if(code != 0 && code != TTCODEMORE){
+        rdb->ecode = tcrdbcodeerr(code, TTEMISC);
+        err = true;
+      } else if(!ttsockcheckend(rdb->sock) && rnum >= 0){
+        for(int i = 0; i < rnum; i++){
+          int rksiz = ttsockgetint32(rdb->sock);
+          int rvsiz = ttsockgetint32(rdb->sock);
+          if(ttsockcheckend(rdb->sock)){
+            rdb->ecode = TTERECV;
+            err = true;
+            break;
+          }
+          int rsiz = rksiz + rvsiz;
+          char *rbuf = (rsiz < TTIOBUFSIZ) ? (char *)stack : tcmalloc(rsiz + 1);
+          if(ttsockrecv(rdb->sock, rbuf, rsiz)){
+            tclistpush(recs, rbuf, rksiz);
+            tclistpush(recs, rbuf + rksiz, rvsiz);
+          } else {
+            rdb->ecode = TTERECV;
+            err = true;
+          }
+          if(rbuf != (char *)stack) tcfree(rbuf);
+          if(err) break;
+        }
+        if(!err && code == 0){
+          int nsiz = ttsockgetint32(rdb->sock);
+          if(ttsockcheckend(rdb->sock)){
+            rdb->ecode = TTERECV;
+            err = true;
+          } else if(nsiz >= 0){
+            char *nbuf = tcmalloc(nsiz + 1);
+            if(ttsockrecv(rdb->sock, nbuf, nsiz)){
+              nbuf[nsiz] = '\0';
+              if(nbp){
+                *nbp = nbuf;
+                *nsp = nsiz;
+              } else {
+                tcfree(nbuf);
+              }
+            } else {
+              tcfree(nbuf);
+              rdb->ecode = TTERECV;
+              err = true;
+            }
+          }
+        }
+      } else {
+        rdb->ecode = TTERECV;
+        err = true;
+      }
+    } while(!err && code == TTCODEMORE);
+  } else {
+    rdb->ecode = TTESEND;
+    err = true;
+  }
+  pthread_cleanup_pop(1);
+  if(err){
+    if(nbp){
+      tcfree(*nbp);
+      *nbp = NULL;
+    }
+    tclistdel(recs);
+    return NULL;
+  }
+  return recs;
+}
+
+
 /* Add an integer to a record in a remote database object. */
 int tcrdbaddint(TCRDB *rdb, const void *kbuf, int ksiz, int num){
   assert(rdb && kbuf && ksiz >= 0);
@@ -739,7 +1240,7 @@ int tcrdbaddint(TCRDB *rdb, const void *kbuf, int ksiz, int num){
         sum = -1;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTEKEEP;
+      rdb->ecode = tcrdbcodeerr(code, TTEKEEP);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -782,7 +1283,7 @@ double tcrdbadddouble(TCRDB *rdb, const void *kbuf, int ksiz, double num){
         rdb->ecode = TTERECV;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTEKEEP;
+      rdb->ecode = tcrdbcodeerr(code, TTEKEEP);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -848,7 +1349,7 @@ void *tcrdbext(TCRDB *rdb, const char *name, int opts,
         rdb->ecode = TTERECV;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
     }
   }
   pthread_cleanup_pop(1);
@@ -879,7 +1380,7 @@ bool tcrdbsync(TCRDB *rdb){
   if(ttsocksend(rdb->sock, buf, wp - buf)){
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   } else {
@@ -905,7 +1406,7 @@ bool tcrdbvanish(TCRDB *rdb){
   if(ttsocksend(rdb->sock, buf, wp - buf)){
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   } else {
@@ -941,7 +1442,7 @@ bool tcrdbcopy(TCRDB *rdb, const char *path){
   if(ttsocksend(rdb->sock, buf, wp - buf)){
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   } else {
@@ -980,7 +1481,7 @@ bool tcrdbrestore(TCRDB *rdb, const char *path, uint64_t ts){
   if(ttsocksend(rdb->sock, buf, wp - buf)){
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   } else {
@@ -1022,7 +1523,7 @@ bool tcrdbsetmst(TCRDB *rdb, const char *host, int port){
   if(ttsocksend(rdb->sock, buf, wp - buf)){
     int code = ttsockgetc(rdb->sock);
     if(code != 0){
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   } else {
@@ -1034,6 +1535,39 @@ bool tcrdbsetmst(TCRDB *rdb, const char *host, int port){
 }
 
 
+/* Set the compression of responses of a remote database object. */
+bool tcrdbsetcomp(TCRDB *rdb, int codec, int thres){
+  assert(rdb);
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return false;
+  }
+  bool err = false;
+  unsigned char buf[2+sizeof(uint32_t)*2];
+  unsigned char *wp = buf;
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = TTCMDCOMP;
+  uint32_t num;
+  num = TTHTONL((uint32_t)codec);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  num = TTHTONL((uint32_t)thres);
+  memcpy(wp, &num, sizeof(uint32_t));
+  wp += sizeof(uint32_t);
+  if(ttsocksend(rdb->sock, buf, wp - buf)){
+    int code = ttsockgetc(rdb->sock);
+    if(code != 0){
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
+      err = true;
+    }
+  } else {
+    rdb->ecode = TTESEND;
+    err = true;
+  }
+  return !err;
+}
+
+
 /* Get the number of records of a remote database object. */
 uint64_t tcrdbrnum(TCRDB *rdb){
   assert(rdb);
@@ -1055,7 +1589,7 @@ uint64_t tcrdbrnum(TCRDB *rdb){
         rdb->ecode = TTERECV;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -1085,7 +1619,7 @@ uint64_t tcrdbsize(TCRDB *rdb){
         rdb->ecode = TTERECV;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -1116,7 +1650,7 @@ char *tcrdbstat(TCRDB *rdb){
         rdb->ecode = TTERECV;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
     }
   } else {
     rdb->ecode = TTESEND;
@@ -1163,7 +1697,7 @@ TCLIST *tcrdbmisc(TCRDB *rdb, const char *name, int opts, const TCLIST *args){
   }
   char stack[TTIOBUFSIZ];
   if(ttsocksend(rdb->sock, tcxstrptr(xstr), tcxstrsize(xstr))){
-    int code = ttsockgetc(rdb->sock);
+    int code = ttsockexpand(rdb->sock) ? ttsockgetc(rdb->sock) : -1;
     int rnum = ttsockgetint32(rdb->sock);
     if(code == 0){
       if(!ttsockcheckend(rdb->sock) && rnum >= 0){
@@ -1189,7 +1723,7 @@ TCLIST *tcrdbmisc(TCRDB *rdb, const char *name, int opts, const TCLIST *args){
         err = true;
       }
     } else {
-      rdb->ecode = (code == -1) ? TTERECV : TTEMISC;
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
       err = true;
     }
   } else {
@@ -1205,6 +1739,151 @@ TCLIST *tcrdbmisc(TCRDB *rdb, const char *name, int opts, const TCLIST *args){
 }
 
 
+/* Create a batch object. */
+RDBBATCH *tcrdbbatchnew(TCRDB *rdb){
+  assert(rdb);
+  RDBBATCH *batch = tcmalloc(sizeof(*batch));
+  batch->rdb = rdb;
+  batch->ops = tcxstrnew();
+  batch->num = 0;
+  batch->res = tcxstrnew();
+  return batch;
+}
+
+
+/* Delete a batch object. */
+void tcrdbbatchdel(RDBBATCH *batch){
+  assert(batch);
+  tcxstrdel(batch->res);
+  tcxstrdel(batch->ops);
+  tcfree(batch);
+}
+
+
+/* Add a put operation to a batch object. */
+void tcrdbbatchput(RDBBATCH *batch, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
+  assert(batch && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  tcrdbbatchadd(batch, TTCMDPUT, kbuf, ksiz, vbuf, vsiz);
+}
+
+
+/* Add a putkeep operation to a batch object. */
+void tcrdbbatchputkeep(RDBBATCH *batch, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
+  assert(batch && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  tcrdbbatchadd(batch, TTCMDPUTKEEP, kbuf, ksiz, vbuf, vsiz);
+}
+
+
+/* Add a putcat operation to a batch object. */
+void tcrdbbatchputcat(RDBBATCH *batch, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
+  assert(batch && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  tcrdbbatchadd(batch, TTCMDPUTCAT, kbuf, ksiz, vbuf, vsiz);
+}
+
+
+/* Add an out operation to a batch object. */
+void tcrdbbatchout(RDBBATCH *batch, const void *kbuf, int ksiz){
+  assert(batch && kbuf && ksiz >= 0);
+  tcrdbbatchadd(batch, TTCMDOUT, kbuf, ksiz, "", 0);
+}
+
+
+/* Add an addint operation to a batch object. */
+void tcrdbbatchaddint(RDBBATCH *batch, const void *kbuf, int ksiz, int num){
+  assert(batch && kbuf && ksiz >= 0);
+  uint32_t lnum = TTHTONL((uint32_t)num);
+  tcrdbbatchadd(batch, TTCMDADDINT, kbuf, ksiz, &lnum, sizeof(lnum));
+}
+
+
+/* Get the number of operations of a batch object. */
+int tcrdbbatchnum(RDBBATCH *batch){
+  assert(batch);
+  return batch->num;
+}
+
+
+/* Remove all operations and results of a batch object. */
+void tcrdbbatchclear(RDBBATCH *batch){
+  assert(batch);
+  tcxstrclear(batch->ops);
+  batch->num = 0;
+  tcxstrclear(batch->res);
+}
+
+
+/* Execute the operations of a batch object. */
+bool tcrdbbatchrun(RDBBATCH *batch){
+  assert(batch);
+  TCRDB *rdb = batch->rdb;
+  tcxstrclear(batch->res);
+  if(rdb->fd < 0){
+    rdb->ecode = TTEINVALID;
+    return false;
+  }
+  bool err = false;
+  TCXSTR *xstr = tcxstrnew3(tcxstrsize(batch->ops) + sizeof(uint8_t) * 2 + sizeof(uint32_t));
+  pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+  uint8_t magic[2];
+  magic[0] = TTMAGICNUM;
+  magic[1] = TTCMDBATCH;
+  tcxstrcat(xstr, magic, sizeof(magic));
+  uint32_t num;
+  num = TTHTONL((uint32_t)batch->num);
+  tcxstrcat(xstr, &num, sizeof(num));
+  tcxstrcat(xstr, tcxstrptr(batch->ops), tcxstrsize(batch->ops));
+  if(ttsocksend(rdb->sock, tcxstrptr(xstr), tcxstrsize(xstr))){
+    int code = ttsockgetc(rdb->sock);
+    if(code == 0 || code == 1){
+      int rnum = ttsockgetint32(rdb->sock);
+      if(!ttsockcheckend(rdb->sock) && rnum == batch->num){
+        for(int i = 0; i < rnum; i++){
+          char rbuf[sizeof(uint8_t)+sizeof(int32_t)];
+          *rbuf = ttsockgetc(rdb->sock);
+          int32_t sum = ttsockgetint32(rdb->sock);
+          memcpy(rbuf + sizeof(uint8_t), &sum, sizeof(sum));
+          tcxstrcat(batch->res, rbuf, sizeof(rbuf));
+        }
+        if(ttsockcheckend(rdb->sock)){
+          tcxstrclear(batch->res);
+          rdb->ecode = TTERECV;
+          err = true;
+        } else if(code != 0){
+          rdb->ecode = TTEMISC;
+          err = true;
+        }
+      } else {
+        rdb->ecode = TTERECV;
+        err = true;
+      }
+    } else {
+      rdb->ecode = tcrdbcodeerr(code, TTEMISC);
+      err = true;
+    }
+  } else {
+    rdb->ecode = TTESEND;
+    err = true;
+  }
+  pthread_cleanup_pop(1);
+  return !err;
+}
+
+
+/* Get the result of an operation of the last execution of a batch object. */
+bool tcrdbbatchresult(RDBBATCH *batch, int index, int *np){
+  assert(batch);
+  int rsiz = sizeof(uint8_t) + sizeof(int32_t);
+  if(index < 0 || index >= tcxstrsize(batch->res) / rsiz) return false;
+  const char *rp = (char *)tcxstrptr(batch->res) + index * rsiz;
+  if(np){
+    int32_t sum;
+    memcpy(&sum, rp + sizeof(uint8_t), sizeof(sum));
+    *np = sum;
+  }
+  return *rp == 0;
+}
+
+
 
 /*************************************************************************************************
  * table extension
@@ -1462,4 +2141,112 @@ int tcrdbqrysearchcount(RDBQRY *qry){
 
 
 
+/*************************************************************************************************
+ * private features
+ *************************************************************************************************/
+
+
+/* Switch the connection of a remote database object to a shared memory transport.
+   `rdb' specifies the remote database object connected to a co-located server.
+   If successful, the return value is true, else, it is false. */
+static bool tcrdbopenshm(TCRDB *rdb){
+  unsigned char magic[2];
+  magic[0] = TTMAGICNUM;
+  magic[1] = TTCMDSHM;
+  if(!ttsocksend(rdb->sock, magic, sizeof(magic))){
+    rdb->ecode = TTESEND;
+    return false;
+  }
+  int code = ttsockgetc(rdb->sock);
+  int nsiz = ttsockgetint32(rdb->sock);
+  if(code != 0){
+    rdb->ecode = tcrdbcodeerr(code, TTEMISC);
+    return false;
+  }
+  char name[TTADDRBUFSIZ];
+  if(ttsockcheckend(rdb->sock) || nsiz < 1 || nsiz >= TTADDRBUFSIZ ||
+     !ttsockrecv(rdb->sock, name, nsiz)){
+    rdb->ecode = TTERECV;
+    return false;
+  }
+  name[nsiz] = '\0';
+  TTSHM *shm = ttshmopen(rdb->fd, name);
+  if(!shm){
+    rdb->ecode = TTEMISC;
+    return false;
+  }
+  ttsocksetshm(rdb->sock, shm);
+  return true;
+}
+
+
+/* Scan a partition of a remote database.
+   `targ' specifies the pointer to the argument object of the partition.
+   The return value is `NULL' if successful or another on failure. */
+static void *tcrdbscanpart(void *targ){
+  RDBSCANARG *arg = targ;
+  bool err = false;
+  TCRDB *rdb = tcrdbnew();
+  if(tcrdbopen(rdb, arg->host, arg->port) && tcrdbiterpart(rdb, arg->part, arg->pnum)){
+    bool end = false;
+    while(!end){
+      TCLIST *recs = tcrdbiterpage(rdb, RDBSCANPAGE);
+      if(!recs){
+        err = true;
+        break;
+      }
+      int rnum = tclistnum(recs);
+      if(rnum < 2) end = true;
+      for(int i = 0; i < rnum - 1 && !__atomic_load_n(arg->stop, __ATOMIC_RELAXED); i += 2){
+        int ksiz, vsiz;
+        const char *kbuf = tclistval(recs, i, &ksiz);
+        const char *vbuf = tclistval(recs, i + 1, &vsiz);
+        if(!arg->iter(kbuf, ksiz, vbuf, vsiz, arg->op))
+          __atomic_store_n(arg->stop, true, __ATOMIC_RELAXED);
+      }
+      if(__atomic_load_n(arg->stop, __ATOMIC_RELAXED)) end = true;
+      tclistdel(recs);
+    }
+  } else {
+    err = true;
+  }
+  tcrdbdel(rdb);
+  return err ? "error" : NULL;
+}
+
+
+/* Add an operation to a batch object.
+   `batch' specifies the batch object.
+   `cmd' specifies the command ID of the operation.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value. */
+static void tcrdbbatchadd(RDBBATCH *batch, int cmd,
+                          const void *kbuf, int ksiz, const void *vbuf, int vsiz){
+  uint8_t code = cmd;
+  tcxstrcat(batch->ops, &code, sizeof(code));
+  uint32_t num;
+  num = TTHTONL((uint32_t)ksiz);
+  tcxstrcat(batch->ops, &num, sizeof(num));
+  num = TTHTONL((uint32_t)vsiz);
+  tcxstrcat(batch->ops, &num, sizeof(num));
+  tcxstrcat(batch->ops, kbuf, ksiz);
+  tcxstrcat(batch->ops, vbuf, vsiz);
+  batch->num++;
+}
+
+
+/* Get the error code corresponding to the response code of a command.
+   `code' specifies the response code or -1 if receiving failed.
+   `ecode' specifies the error code of ordinary failure of the command.
+   The return value is the error code. */
+static int tcrdbcodeerr(int code, int ecode){
+  if(code == -1) return TTERECV;
+  if(code == TTCODEBUSY) return TTEBUSY;
+  return ecode;
+}
+
+
+
 // END OF FILE
@@ -58,6 +58,7 @@ enum {                                   /* enumeration for error codes */
   TTERECV,                               /* recv error */
   TTEKEEP,                               /* existing record */
   TTENOREC,                              /* no record found */
+  TTEBUSY,                               /* server busy */
   TTEMISC = 9999                         /* miscellaneous error */
 };
 
@@ -70,6 +71,10 @@ enum {                                   /* enumeration for scripting extension
   RDBMONOULOG = 1 << 0                   /* omission of update log */
 };
 
+enum {                                   /* enumeration for range retrieval options */
+  RDBFWMDESC = 1 << 0                    /* descending order */
+};
+
 
 /* Get the message string corresponding to an error code.
    `ecode' specifies the error code.
@@ -93,13 +98,19 @@ void tcrdbdel(TCRDB *rdb);
    The following error code is defined: `TTESUCCESS' for success, `TTEINVALID' for invalid
    operation, `TTENOHOST' for host not found, `TTEREFUSED' for connection refused, `TTESEND' for
    send error, `TTERECV' for recv error, `TTEKEEP' for existing record, `TTENOREC' for no record
-   found, `TTEMISC' for miscellaneous error. */
+   found, `TTEBUSY' for server busy, `TTEMISC' for miscellaneous error. */
 int tcrdbecode(TCRDB *rdb);
 
 
 /* Open a remote database.
    `rdb' specifies the remote database object.
-   `host' specifies the name or the address of the server.
+   `host' specifies the name or the address of the server.  If it is prefixed with "shm:",
+   requests and responses are exchanged through a shared memory segment after connecting,
+   which is available only with a server on the same host running on Linux.  The segment is
+   created by the server and is accessible only by the user of the server.  The server must be
+   started with the option `-shm', and it accepts only clients connecting through a UNIX domain
+   socket or the loopback address, one session for each connection, and as many sessions as the
+   maximum number of worker threads.
    `port' specifies the port number.  If it is not more than 0, UNIX domain socket is used and
    the path of the socket file is specified by the host parameter.
    If successful, the return value is true, else, it is false. */
@@ -194,6 +205,26 @@ bool tcrdbputshl(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int v
 bool tcrdbputshl2(TCRDB *rdb, const char *kstr, const char *vstr, int width);
 
 
+/* Store a record with an expiration time into a remote database object.
+   `rdb' specifies the remote database object connected as a writer.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   `ttl' specifies the lifetime of the record in seconds.  If it is 0, the record does not
+   expire.
+   If successful, the return value is true, else, it is false.
+   If a record with the same key exists in the database, it is overwritten.  An expired record is
+   hidden from retrieval and removed by the server in the background.  Replacing or removing the
+   record by `tcrdbput', `tcrdbputkeep', `tcrdbout', `tcrdbvanish', or the same operations of
+   batches, versatile functions, and script extensions clears its expiration time, while
+   `tcrdbputcat', `tcrdbputshl', `tcrdbaddint', and `tcrdbadddouble' keep it.  The expiration
+   time is stored in a file beside the database file with the suffix ".ttl", so that it survives
+   a restart of the server, and it is recorded in the update log, so that slaves expire the
+   record too. */
+bool tcrdbputttl(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz, int ttl);
+
+
 /* Store a record into a remote database object without response from the server.
    `rdb' specifies the remote database object.
    `kbuf' specifies the pointer to the region of the key.
@@ -259,10 +290,61 @@ char *tcrdbget2(TCRDB *rdb, const char *kstr);
    `recs' specifies a map object containing the retrieval keys.  As a result of this function,
    keys existing in the database have the corresponding values and keys not existing in the
    database are removed.
-   If successful, the return value is true, else, it is false. */
+   If successful, the return value is true, else, it is false.  It fails if the total size of
+   the records exceeds 256MB. */
 bool tcrdbget3(TCRDB *rdb, TCMAP *recs);
 
 
+/* Retrieve records in a remote database object by streamed chunks.
+   `rdb' specifies the remote database object.
+   `recs' specifies a map object containing the retrieval keys.  As a result of this function,
+   keys existing in the database have the corresponding values and keys not existing in the
+   database are removed.
+   If successful, the return value is true, else, it is false.
+   This function is the same as `tcrdbget3' except that the server sends the records in chunks
+   as they are retrieved, which saves memory of the server for large results.  The server should
+   support the mgetstrm command, and the total size of the records is limited to 256MB. */
+bool tcrdbget4(TCRDB *rdb, TCMAP *recs);
+
+
+/* Retrieve a record in a remote database object with its version token.
+   `rdb' specifies the remote database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   `verp' specifies the pointer to the variable into which the version token of the record is
+   assigned.
+   If successful, the return value is the pointer to the region of the value of the corresponding
+   record.  `NULL' is returned if no record corresponds.
+   The version token changes whenever the record is modified and is passed to `tcrdbcas'.
+   Because the region of the return value is allocated with the `malloc' call, it should be
+   released with the `free' call when it is no longer in use. */
+void *tcrdbgets(TCRDB *rdb, const void *kbuf, int ksiz, int *sp, uint64_t *verp);
+
+
+/* Store a record into a remote database object only if it is not modified since retrieved.
+   `rdb' specifies the remote database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   `ver' specifies the version token given by `tcrdbgets'.
+   `verp' specifies the pointer to the variable into which the new version token of the record
+   is assigned.  If it is `NULL', it is not used.
+   If successful, the return value is true, else, it is false.
+   If the record was modified since the token was given, this function has no effect and the
+   error code is `TTEKEEP'.  If no record corresponds, the error code is `TTENOREC'.  The version
+   of each record is changed by every modification including those by `tcrdbext', `tcrdbmisc',
+   and the replication master.  Version tokens of all records are invalidated by `tcrdbvanish'
+   and by `tcrdbmisc' functions whose modified records are not known by their arguments.  The
+   server keeps the versions of recently modified records in 1021 shards holding 256 records each,
+   so a token can also be invalidated spuriously if more than 256 other records of the same shard
+   are modified before it is used, which takes about 260000 modifications on average. */
+bool tcrdbcas(TCRDB *rdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz,
+              uint64_t ver, uint64_t *verp);
+
+
 /* Get the size of the value of a record in a remote database object.
    `rdb' specifies the remote database object.
    `kbuf' specifies the pointer to the region of the key.
@@ -283,7 +365,8 @@ int tcrdbvsiz2(TCRDB *rdb, const char *kstr);
 /* Initialize the iterator of a remote database object.
    `rdb' specifies the remote database object.
    If successful, the return value is true, else, it is false.
-   The iterator is used in order to access the key of every record stored in a database. */
+   The iterator is used in order to access the key of every record stored in a database.  Each
+   connection has its own iterator. */
 bool tcrdbiterinit(TCRDB *rdb);
 
 
@@ -296,8 +379,7 @@ bool tcrdbiterinit(TCRDB *rdb);
    Because an additional zero code is appended at the end of the region of the return value, the
    return value can be treated as a character string.  Because the region of the return value is
    allocated with the `malloc' call, it should be released with the `free' call when it is no
-   longer in use.  The iterator can be updated by multiple connections and then it is not assured
-   that every record is traversed. */
+   longer in use.  The iterator belongs to the connection and is not disturbed by the others. */
 void *tcrdbiternext(TCRDB *rdb, int *sp);
 
 
@@ -306,11 +388,60 @@ void *tcrdbiternext(TCRDB *rdb, int *sp);
    If successful, the return value is the string of the next key, else, it is `NULL'.  `NULL' is
    returned when no record is to be get out of the iterator.
    Because the region of the return value is allocated with the `malloc' call, it should be
-   released with the `free' call when it is no longer in use.  The iterator can be updated by
-   multiple connections and then it is not assured that every record is traversed. */
+   released with the `free' call when it is no longer in use.  The iterator belongs to the
+   connection and is not disturbed by the others. */
 char *tcrdbiternext2(TCRDB *rdb);
 
 
+/* Get the next records of the iterator of a remote database object.
+   `rdb' specifies the remote database object.
+   `max' specifies the maximum number of records to be fetched.  If it is negative, no limit is
+   specified.
+   If successful, the return value is a list object of the keys and the values of the next
+   records one after the other, else, it is `NULL'.  An empty list is returned when no record is
+   to be get out of the iterator.
+   Because the object of the return value is created with the function `tclistnew', it should be
+   deleted with the function `tclistdel' when it is no longer in use.  The iterator should be
+   initialized with `tcrdbiterinit' beforehand and is shared with `tcrdbiternext'.  A page of
+   records costs one round trip. */
+TCLIST *tcrdbiterpage(TCRDB *rdb, int max);
+
+
+/* Initialize the iterator of a remote database object over a partition of the key space.
+   `rdb' specifies the remote database object.
+   `part' specifies the index of the partition, which is from 0 to `pnum' - 1.
+   `pnum' specifies the number of the partitions.
+   If successful, the return value is true, else, it is false.
+   The partitions are disjoint and cover all records.  Only a fixed-length database can be split,
+   into ranges of ID numbers.  For the other databases, this function fails unless `pnum' is 1,
+   because they can not be split without scanning all records for each partition.  The iterator
+   is traversed with `tcrdbiternext' or `tcrdbiterpage'. */
+bool tcrdbiterpart(TCRDB *rdb, int part, int pnum);
+
+
+/* Process each record of a remote database with parallel connections.
+   `host' specifies the name or the address of the server.
+   `port' specifies the port number.  If it is not more than 0, UNIX domain socket is used and
+   the path of the socket file is specified by the host parameter.
+   `pnum' specifies the number of the partitions.  Each partition is scanned by a dedicated
+   thread with its own connection.  If the database can not be split, it is scanned as one
+   partition.
+   `iter' specifies the pointer to the iterator function called for each record.  It receives
+   four parameters.  The first parameter is the pointer to the region of the key.  The second
+   parameter is the size of the region of the key.  The third parameter is the pointer to the
+   region of the value.  The fourth parameter is the size of the region of the value.  The fifth
+   parameter is the pointer to the optional opaque object.  It returns true to continue
+   iteration or false to stop iteration.
+   `op' specifies an arbitrary pointer to be given as a parameter of the iterator function.  If
+   it is not needed, `NULL' can be specified.
+   If successful, the return value is true, else, it is false.
+   The iterator function is called concurrently by the threads of the partitions without any
+   lock, so it should be thread-safe if `pnum' is more than 1.  The order of the records is not
+   defined.  After the function returns false, the other threads stop before their next
+   records. */
+bool tcrdbscan(const char *host, int port, int pnum, TCITER iter, void *op);
+
+
 /* Get forward matching keys in a remote database object.
    `rdb' specifies the remote database object.
    `pbuf' specifies the pointer to the region of the prefix.
@@ -336,6 +467,36 @@ TCLIST *tcrdbfwmkeys(TCRDB *rdb, const void *pbuf, int psiz, int max);
 TCLIST *tcrdbfwmkeys2(TCRDB *rdb, const char *pstr, int max);
 
 
+/* Get forward matching records in a remote database object.
+   `rdb' specifies the remote database object.
+   `pbuf' specifies the pointer to the region of the prefix.
+   `psiz' specifies the size of the region of the prefix.
+   `sbuf' specifies the pointer to the region of the key after which the range starts.  If it is
+   `NULL', the range starts at the edge of the prefix.
+   `ssiz' specifies the size of the region of the start key.
+   `max' specifies the maximum number of records to be fetched.  If it is negative, no limit is
+   specified.
+   `opts' specifies options by bitwise-or: `RDBFWMDESC' specifies that the records are fetched in
+   descending order of the keys.
+   `nbp' specifies the pointer to the variable into which the pointer to the region of the start
+   key of the next page is assigned.  If it is `NULL', it is not used.  `NULL' is assigned if the
+   range has been exhausted.
+   `nsp' specifies the pointer to the variable into which the size of the region of the start key
+   of the next page is assigned.
+   If successful, the return value is a list object of the keys and the values of the
+   corresponding records one after the other, else, it is `NULL'.
+   Because the object of the return value is created with the function `tclistnew', it should be
+   deleted with the function `tclistdel' when it is no longer in use.  Because the region of the
+   start key of the next page is allocated with the `malloc' call, it should be released with the
+   `free' call when it is no longer in use.  The records of B+ tree databases and on-memory tree
+   databases are in the order of the keys, and those of the other databases are in the lexical
+   order.  A page can hold fewer records than `max' before the end of the range, because records
+   removed or expired while being fetched are skipped and the page is cut at 256MB.  So, the next
+   page should be fetched while a start key is assigned. */
+TCLIST *tcrdbfwmrecs(TCRDB *rdb, const void *pbuf, int psiz, const void *sbuf, int ssiz,
+                     int max, int opts, void **nbp, int *nsp);
+
+
 /* Add an integer to a record in a remote database object.
    `rdb' specifies the remote database object connected as a writer.
    `kbuf' specifies the pointer to the region of the key.
@@ -435,6 +596,20 @@ bool tcrdbrestore(TCRDB *rdb, const char *path, uint64_t ts);
 bool tcrdbsetmst(TCRDB *rdb, const char *host, int port);
 
 
+/* Set the compression of responses of a remote database object.
+   `rdb' specifies the remote database object.
+   `codec' specifies the compression codec: `TTZNONE' for no compression, `TTZDEFLATE' for
+   Deflate, `TTZBZIP' for BZIP2.
+   `thres' specifies the minimum size of a response to be compressed.  If it is less than 256,
+   256 is specified.
+   If successful, the return value is true, else, it is false.  It fails if the server does not
+   support the codec.
+   The get, mget, iternext, fwmkeys, and misc responses bigger than the threshold are
+   compressed by the server and decompressed transparently.  The setting is valid until the
+   connection is closed. */
+bool tcrdbsetcomp(TCRDB *rdb, int codec, int thres);
+
+
 /* Get the number of records of a remote database object.
    `rdb' specifies the remote database object.
    The return value is the number of records or 0 if the object does not connect to any database
@@ -475,6 +650,99 @@ char *tcrdbstat(TCRDB *rdb);
 TCLIST *tcrdbmisc(TCRDB *rdb, const char *name, int opts, const TCLIST *args);
 
 
+typedef struct {                         /* type of structure for a batch of operations */
+  TCRDB *rdb;                            /* database object */
+  TCXSTR *ops;                           /* serialized operations */
+  int num;                               /* number of operations */
+  TCXSTR *res;                           /* results of the last execution */
+} RDBBATCH;
+
+
+/* Create a batch object.
+   `rdb' specifies the remote database object.
+   The return value is the new batch object.
+   Operations added to a batch object are sent by one request and applied by the server at once.
+   The update log records of them are also written at once. */
+RDBBATCH *tcrdbbatchnew(TCRDB *rdb);
+
+
+/* Delete a batch object.
+   `batch' specifies the batch object. */
+void tcrdbbatchdel(RDBBATCH *batch);
+
+
+/* Add a put operation to a batch object.
+   `batch' specifies the batch object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value. */
+void tcrdbbatchput(RDBBATCH *batch, const void *kbuf, int ksiz, const void *vbuf, int vsiz);
+
+
+/* Add a putkeep operation to a batch object.
+   `batch' specifies the batch object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value. */
+void tcrdbbatchputkeep(RDBBATCH *batch, const void *kbuf, int ksiz, const void *vbuf, int vsiz);
+
+
+/* Add a putcat operation to a batch object.
+   `batch' specifies the batch object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value. */
+void tcrdbbatchputcat(RDBBATCH *batch, const void *kbuf, int ksiz, const void *vbuf, int vsiz);
+
+
+/* Add an out operation to a batch object.
+   `batch' specifies the batch object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key. */
+void tcrdbbatchout(RDBBATCH *batch, const void *kbuf, int ksiz);
+
+
+/* Add an addint operation to a batch object.
+   `batch' specifies the batch object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `num' specifies the additional value. */
+void tcrdbbatchaddint(RDBBATCH *batch, const void *kbuf, int ksiz, int num);
+
+
+/* Get the number of operations of a batch object.
+   `batch' specifies the batch object.
+   The return value is the number of operations. */
+int tcrdbbatchnum(RDBBATCH *batch);
+
+
+/* Remove all operations and results of a batch object.
+   `batch' specifies the batch object. */
+void tcrdbbatchclear(RDBBATCH *batch);
+
+
+/* Execute the operations of a batch object.
+   `batch' specifies the batch object of the database connected as a writer.
+   If all of the operations succeed, the return value is true, else, it is false.
+   The result of each operation can be checked with `tcrdbbatchresult' unless the communication
+   fails.  If any operation is forbidden or not supported by the server, no operation is applied
+   and every operation fails.  The operations are kept in the object and can be executed
+   again. */
+bool tcrdbbatchrun(RDBBATCH *batch);
+
+
+/* Get the result of an operation of the last execution of a batch object.
+   `batch' specifies the batch object.
+   `index' specifies the index of the operation.
+   `np' specifies the pointer to the variable into which the summation of an addint operation is
+   assigned.  If it is `NULL', it is not used.
+   If the operation succeeded, the return value is true, else, it is false. */
+bool tcrdbbatchresult(RDBBATCH *batch, int index, int *np);
+
+
 
 /*************************************************************************************************
  * table extension
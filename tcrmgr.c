@@ -21,6 +21,7 @@
 #define DEFPORT        1978              // default port
 #define REQHEADMAX     32                // maximum number of request headers of HTTP
 #define MINIBNUM       31                // bucket number of map for trivial use
+#define LISTPAGENUM    1024              // number of records of each page of listing
 
 
 /* global variables */
@@ -61,7 +62,7 @@ static int procget(const char *host, int port, const char *kbuf, int ksiz, int s
                    bool px, bool pz);
 static int procmget(const char *host, int port, const TCLIST *keys, int sep, bool px);
 static int proclist(const char *host, int port, int sep, int max, bool pv, bool px,
-                    const char *fmstr);
+                    const char *fmstr, const char *fsstr, bool rd);
 static int procext(const char *host, int port, const char *func, int opts,
                    const char *kbuf, int ksiz, const char *vbuf, int vsiz, int sep,
                    bool px, bool pz);
@@ -136,8 +137,8 @@ static void usage(void){
   fprintf(stderr, "  %s out [-port num] [-sx] [-sep chr] host key\n", g_progname);
   fprintf(stderr, "  %s get [-port num] [-sx] [-sep chr] [-px] [-pz] host key\n", g_progname);
   fprintf(stderr, "  %s mget [-port num] [-sx] [-sep chr] [-px] host [key...]\n", g_progname);
-  fprintf(stderr, "  %s list [-port num] [-sep chr] [-m num] [-pv] [-px] [-fm str] host\n",
-          g_progname);
+  fprintf(stderr, "  %s list [-port num] [-sep chr] [-m num] [-pv] [-px] [-fm str] [-fs str]"
+          " [-rd] host\n", g_progname);
   fprintf(stderr, "  %s ext [-port num] [-xlr|-xlg] [-sx] [-sep chr] [-px] host func"
           " [key [value]]\n", g_progname);
   fprintf(stderr, "  %s sync [-port num] host\n", g_progname);
@@ -496,6 +497,8 @@ static int runlist(int argc, char **argv){
   bool pv = false;
   bool px = false;
   char *fmstr = NULL;
+  char *fsstr = NULL;
+  bool rd = false;
   for(int i = 2; i < argc; i++){
     if(!host && argv[i][0] == '-'){
       if(!strcmp(argv[i], "-port")){
@@ -514,6 +517,11 @@ static int runlist(int argc, char **argv){
       } else if(!strcmp(argv[i], "-fm")){
         if(++i >= argc) usage();
         fmstr = argv[i];
+      } else if(!strcmp(argv[i], "-fs")){
+        if(++i >= argc) usage();
+        fsstr = argv[i];
+      } else if(!strcmp(argv[i], "-rd")){
+        rd = true;
       } else {
         usage();
       }
@@ -524,7 +532,7 @@ static int runlist(int argc, char **argv){
     }
   }
   if(!host) usage();
-  int rv = proclist(host, port, sep, max, pv, px, fmstr);
+  int rv = proclist(host, port, sep, max, pv, px, fmstr, fsstr, rd);
   return rv;
 }
 
@@ -1070,7 +1078,7 @@ static int procmget(const char *host, int port, const TCLIST *keys, int sep, boo
 
 /* perform list command */
 static int proclist(const char *host, int port, int sep, int max, bool pv, bool px,
-                    const char *fmstr){
+                    const char *fmstr, const char *fsstr, bool rd){
   TCRDB *rdb = tcrdbnew();
   if(!tcrdbopen(rdb, host, port)){
     printerr(rdb);
@@ -1078,7 +1086,95 @@ static int proclist(const char *host, int port, int sep, int max, bool pv, bool
     return 1;
   }
   bool err = false;
-  if(fmstr){
+  bool old = true;
+  if(fsstr || rd || (fmstr && pv)){
+    old = false;
+    if(!fmstr) fmstr = "";
+    char *sbuf = fsstr ? tcstrdup(fsstr) : NULL;
+    int ssiz = fsstr ? strlen(fsstr) : 0;
+    int cnt = 0;
+    while(!err && (max < 0 || cnt < max)){
+      int pnum = (max >= 0 && max - cnt < LISTPAGENUM) ? max - cnt : LISTPAGENUM;
+      void *nbuf;
+      int nsiz;
+      TCLIST *recs = tcrdbfwmrecs(rdb, fmstr, strlen(fmstr), sbuf, ssiz, pnum,
+                                  rd ? RDBFWMDESC : 0, &nbuf, &nsiz);
+      if(!recs){
+        if(cnt < 1 && !fsstr && !rd){
+          old = true;
+        } else {
+          printerr(rdb);
+          err = true;
+        }
+        break;
+      }
+      int rnum = tclistnum(recs);
+      for(int i = 0; i < rnum - 1; i += 2){
+        int ksiz;
+        const char *kbuf = tclistval(recs, i, &ksiz);
+        printdata(kbuf, ksiz, px, sep);
+        if(pv){
+          int vsiz;
+          const char *vbuf = tclistval(recs, i + 1, &vsiz);
+          putchar('\t');
+          printdata(vbuf, vsiz, px, sep);
+        }
+        putchar('\n');
+        cnt++;
+      }
+      tclistdel(recs);
+      if(!nbuf) break;
+      tcfree(sbuf);
+      sbuf = nbuf;
+      ssiz = nsiz;
+    }
+    tcfree(sbuf);
+  } else if(pv){
+    old = false;
+    if(!tcrdbiterinit(rdb)){
+      printerr(rdb);
+      err = true;
+    }
+    int cnt = 0;
+    while(!err && (max < 0 || cnt < max)){
+      int pnum = (max >= 0 && max - cnt < LISTPAGENUM) ? max - cnt : LISTPAGENUM;
+      TCLIST *recs = tcrdbiterpage(rdb, pnum);
+      if(!recs){
+        if(tcrdbecode(rdb) != TTENOREC){
+          if(cnt < 1){
+            old = true;
+          } else {
+            printerr(rdb);
+            err = true;
+          }
+        }
+        break;
+      }
+      int rnum = tclistnum(recs);
+      for(int i = 0; i < rnum - 1; i += 2){
+        int ksiz;
+        const char *kbuf = tclistval(recs, i, &ksiz);
+        int vsiz;
+        const char *vbuf = tclistval(recs, i + 1, &vsiz);
+        printdata(kbuf, ksiz, px, sep);
+        putchar('\t');
+        printdata(vbuf, vsiz, px, sep);
+        putchar('\n');
+        cnt++;
+      }
+      tclistdel(recs);
+      if(rnum < 1) break;
+    }
+  }
+  if(old && pv){
+    /* the server does not know the paging commands and has closed the connection */
+    tcrdbclose(rdb);
+    if(!tcrdbopen(rdb, host, port)){
+      printerr(rdb);
+      err = true;
+    }
+  }
+  if(!err && old && fmstr){
     TCLIST *keys = tcrdbfwmkeys2(rdb, fmstr, max);
     for(int i = 0; i < tclistnum(keys); i++){
       int ksiz;
@@ -1096,7 +1192,7 @@ static int proclist(const char *host, int port, int sep, int max, bool pv, bool
       putchar('\n');
     }
     tclistdel(keys);
-  } else {
+  } else if(!err && old){
     if(!tcrdbiterinit(rdb)){
       printerr(rdb);
       err = true;
@@ -19,6 +19,23 @@
 
 #define DEFPORT        1978              // default port
 #define RECBUFSIZ      32                // buffer for records
+#define COMPVALSIZ     4096              // size of values of compression test
+#define BATCHCNTNUM    4                 // number of counters of batch test
+#define ITERPAGEMAX    100               // maximum number of records of an iterator page
+#define MGETVALSIZ     4096              // maximum size of values of mget test
+#define TTLWAITMIN     3.5               // seconds to wait for records to expire
+#define TTLWAITMAX     10.0              // maximum seconds to wait for records to be reaped
+#define MISSWAITMAX    10.0              // maximum seconds to wait for the Bloom filter
+#define HANDWAITMAX    10.0              // maximum seconds to wait for the handover
+#define CACHEKEYNUM    64                // number of keys of each thread of cache test
+#define SHEDKINDNUM    6                 // number of kinds of requests which can be shed
+#define FRAMECHUNKMAX  16                // maximum size of each chunk of framing test
+#define FRAMEDELAY     0.001             // seconds of the delay between chunks
+#define FRAMEHOLDMAX   1.0               // maximum seconds of a request beside a stalled one
+#define FRAMEWAITMAX   10.0              // maximum seconds to wait for a connection to be closed
+#define FRAMEARGSIZ    (32*1024*1024)    // maximum size of each argument of the server
+#define FRAMEMAXSIZ    (256*1024*1024)   // maximum total size of a request of the server
+#define FRAMEZBUFSIZ   (1024*1024)       // size of the buffer to send a too large request
 
 typedef struct {                         // type of structure for write thread
   TCRDB *rdb;
@@ -44,6 +61,52 @@ typedef struct {                         // type of structure for remove thread
   int id;
 } TARGREMOVE;
 
+typedef struct {                         // type of structure for bench thread
+  TCRDB **rdbs;
+  int cnum;
+  int rnum;
+  int vsiz;
+  double *lats;
+  int64_t bsum;
+  int id;
+} TARGBENCH;
+
+typedef struct {                         // type of structure for batch thread
+  TCRDB *rdb;
+  int rnum;
+  int id;
+} TARGBATCH;
+
+typedef struct {                         // type of structure for iterator thread
+  TCRDB *rdb;
+  int rnum;
+  int id;
+} TARGITER;
+
+typedef struct {                         // type of structure for cas thread
+  TCRDB *rdb;
+  int rnum;
+  int cnum;
+  int id;
+} TARGCAS;
+
+typedef struct {                         // type of structure for cache thread
+  TCRDB *rdb;
+  TCRDB *rrdb;
+  int rnum;
+  int id;
+} TARGCACHE;
+
+typedef struct {                         // type of structure for shed thread
+  TCRDB *rdb;
+  const char *host;
+  int port;
+  int rnum;
+  int64_t busy[SHEDKINDNUM];
+  int id;
+} TARGSHED;
+
+
 
 /* global variables */
 const char *g_progname;                  // program name
@@ -56,16 +119,61 @@ static void iprintf(const char *format, ...);
 static void eprint(TCRDB *rdb, const char *func);
 static int myrand(int range);
 static int myrandnd(int range);
+static int dblcmp(const void *a, const void *b);
+static uint64_t statnum(TCRDB *rdb, const char *name, char *vbuf);
+static bool iterpages(TCRDB *rdb, TCMAP *recs);
+static bool iterscan(const void *kbuf, int ksiz, const void *vbuf, int vsiz, void *op);
+static TTSOCK *opensock(const char *host, int port);
+static void closesock(TTSOCK *sock);
+static void xstrcatint32(TCXSTR *xstr, int num);
+static bool sendchunks(TTSOCK *sock, const char *buf, int size);
+static int recvhttp(TTSOCK *sock, char *bbuf, int bmax, int *sp);
+static bool recvelem(TTSOCK *sock, const char *buf, int size);
 static int runwrite(int argc, char **argv);
 static int runread(int argc, char **argv);
 static int runremove(int argc, char **argv);
+static int runbench(int argc, char **argv);
+static int runcomp(int argc, char **argv);
+static int runbatch(int argc, char **argv);
+static int runiter(int argc, char **argv);
+static int runcas(int argc, char **argv);
+static int runmget(int argc, char **argv);
+static int runfwm(int argc, char **argv);
+static int runttl(int argc, char **argv);
+static int runmiss(int argc, char **argv);
+static int runcache(int argc, char **argv);
+static int runhand(int argc, char **argv);
+static int runshed(int argc, char **argv);
+static int runframe(int argc, char **argv);
 static int procwrite(const char *host, int port, int tnum, int rnum,
                      bool nr, const char *ext, bool rnd);
 static int procread(const char *host, int port, int tnum, int mul, bool rnd);
 static int procremove(const char *host, int port, int tnum, bool rnd);
+static int procbench(const char *host, int port, int tnum, int cnum, int vsiz, int rnum);
+static int proccomp(const char *host, int port, int rnum);
+static int procbatch(const char *host, int port, int tnum, int rnum);
+static int prociter(const char *host, int port, int tnum, int rnum);
+static int proccas(const char *host, int port, int tnum, int rnum);
+static int procmget(const char *host, int port, int rnum);
+static int procfwm(const char *host, int port, int rnum);
+static int procttl(const char *host, int port, int rnum);
+static int procmiss(const char *host, int port, int rnum);
+static int proccache(const char *host, int port, int tnum, int rnum);
+static int prochand(const char *host, int port, int rnum);
+static int procshed(const char *host, int port, int tnum, int rnum);
+static int procframe(const char *host, int port, int tout, int rnum);
+static bool chunkbin(TTSOCK *sock, const char *kbuf, int ksiz, const char *vbuf, int vsiz);
+static bool chunkmc(TTSOCK *sock, const char *kbuf, int ksiz, const char *vbuf, int vsiz);
+static bool chunkhttp(TTSOCK *sock, const char *kbuf, int ksiz, const char *vbuf, int vsiz);
 static void *threadwrite(void *targ);
 static void *threadread(void *targ);
 static void *threadremove(void *targ);
+static void *threadbench(void *targ);
+static void *threadbatch(void *targ);
+static void *threaditer(void *targ);
+static void *threadcas(void *targ);
+static void *threadcache(void *targ);
+static void *threadshed(void *targ);
 
 
 /* main routine */
@@ -80,6 +188,32 @@ int main(int argc, char **argv){
     rv = runread(argc, argv);
   } else if(!strcmp(argv[1], "remove")){
     rv = runremove(argc, argv);
+  } else if(!strcmp(argv[1], "bench")){
+    rv = runbench(argc, argv);
+  } else if(!strcmp(argv[1], "comp")){
+    rv = runcomp(argc, argv);
+  } else if(!strcmp(argv[1], "batch")){
+    rv = runbatch(argc, argv);
+  } else if(!strcmp(argv[1], "iter")){
+    rv = runiter(argc, argv);
+  } else if(!strcmp(argv[1], "cas")){
+    rv = runcas(argc, argv);
+  } else if(!strcmp(argv[1], "mget")){
+    rv = runmget(argc, argv);
+  } else if(!strcmp(argv[1], "fwm")){
+    rv = runfwm(argc, argv);
+  } else if(!strcmp(argv[1], "ttl")){
+    rv = runttl(argc, argv);
+  } else if(!strcmp(argv[1], "miss")){
+    rv = runmiss(argc, argv);
+  } else if(!strcmp(argv[1], "cache")){
+    rv = runcache(argc, argv);
+  } else if(!strcmp(argv[1], "hand")){
+    rv = runhand(argc, argv);
+  } else if(!strcmp(argv[1], "shed")){
+    rv = runshed(argc, argv);
+  } else if(!strcmp(argv[1], "frame")){
+    rv = runframe(argc, argv);
   } else {
     usage();
   }
@@ -96,6 +230,20 @@ static void usage(void){
           g_progname);
   fprintf(stderr, "  %s read [-port num] [-tnum num] [-mul num] host\n", g_progname);
   fprintf(stderr, "  %s remove [-port num] [-tnum num] host\n", g_progname);
+  fprintf(stderr, "  %s bench [-port num] [-tnum num] [-cnum num] [-vsiz num] host rnum\n",
+          g_progname);
+  fprintf(stderr, "  %s comp [-port num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s batch [-port num] [-tnum num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s iter [-port num] [-tnum num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s cas [-port num] [-tnum num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s mget [-port num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s fwm [-port num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s ttl [-port num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s miss [-port num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s cache [-port num] [-tnum num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s hand [-port num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s shed [-port num] [-tnum num] host rnum\n", g_progname);
+  fprintf(stderr, "  %s frame [-port num] [-tout num] host rnum\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
 }
@@ -131,6 +279,124 @@ static int myrandnd(int range){
 }
 
 
+/* compare two real numbers */
+static int dblcmp(const void *a, const void *b){
+  double da = *(double *)a;
+  double db = *(double *)b;
+  return (da > db) ? 1 : ((da < db) ? -1 : 0);
+}
+
+
+/* get a numeric value of the status of the server */
+static uint64_t statnum(TCRDB *rdb, const char *name, char *vbuf){
+  uint64_t num = 0;
+  if(vbuf) sprintf(vbuf, "unknown");
+  char *status = tcrdbstat(rdb);
+  if(!status) return 0;
+  int nsiz = strlen(name);
+  TCLIST *lines = tcstrsplit(status, "\n");
+  for(int i = 0; i < tclistnum(lines); i++){
+    const char *line = tclistval2(lines, i);
+    if(strncmp(line, name, nsiz) || line[nsiz] != '\t') continue;
+    const char *pv = line + nsiz + 1;
+    num = tcatoi(pv);
+    if(vbuf) snprintf(vbuf, RECBUFSIZ, "%s", pv);
+  }
+  tclistdel(lines);
+  tcfree(status);
+  return num;
+}
+
+
+/* collect the records of the iterator of a remote database by pages */
+static bool iterpages(TCRDB *rdb, TCMAP *recs){
+  while(true){
+    TCLIST *res = tcrdbiterpage(rdb, ITERPAGEMAX);
+    if(!res) return false;
+    int num = tclistnum(res);
+    bool err = false;
+    for(int i = 0; i < num - 1; i += 2){
+      int ksiz;
+      const char *kbuf = tclistval(res, i, &ksiz);
+      if(!tcmapputkeep(recs, kbuf, ksiz, "", 0)) err = true;
+    }
+    tclistdel(res);
+    if(err) return false;
+    if(num < 1) break;
+  }
+  return true;
+}
+
+
+/* count the records of a parallel scan */
+static bool iterscan(const void *kbuf, int ksiz, const void *vbuf, int vsiz, void *op){
+  __atomic_add_fetch((int *)op, 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+
+/* open a raw connection to a server */
+static TTSOCK *opensock(const char *host, int port){
+  int fd = (port > 0) ? ttopensock(host, port) : ttopensockunix(host);
+  if(fd == -1) return NULL;
+  return ttsocknew(fd);
+}
+
+
+/* close a raw connection to a server */
+static void closesock(TTSOCK *sock){
+  if(!sock) return;
+  int fd = sock->fd;
+  ttsockdel(sock);
+  ttclosesock(fd);
+}
+
+
+/* append a 32-bit integer in the network byte order to a string object */
+static void xstrcatint32(TCXSTR *xstr, int num){
+  uint32_t lnum = TTHTONL((uint32_t)num);
+  tcxstrcat(xstr, &lnum, sizeof(lnum));
+}
+
+
+/* send data by a socket in small chunks with short delays */
+static bool sendchunks(TTSOCK *sock, const char *buf, int size){
+  while(size > 0){
+    int csiz = tclmin(myrand(FRAMECHUNKMAX) + 1, size);
+    if(!ttsocksend(sock, buf, csiz)) return false;
+    buf += csiz;
+    size -= csiz;
+    if(size > 0 && myrand(4) == 0) tcsleep(FRAMEDELAY);
+  }
+  return true;
+}
+
+
+/* receive a response of the HTTP */
+static int recvhttp(TTSOCK *sock, char *bbuf, int bmax, int *sp){
+  char line[RECBUFSIZ*4];
+  if(!ttsockgets(sock, line, sizeof(line)) || !tcstrfwm(line, "HTTP/1.1 ")) return -1;
+  int code = tcatoi(line + 9);
+  int bsiz = 0;
+  while(ttsockgets(sock, line, sizeof(line)) && *line != '\0'){
+    if(tcstrifwm(line, "content-length:")) bsiz = tcatoi(line + 15);
+  }
+  if(bsiz < 0 || bsiz > bmax || !ttsockrecv(sock, bbuf, bsiz) || ttsockcheckend(sock)) return -1;
+  *sp = bsiz;
+  return code;
+}
+
+
+/* receive an element of a list of the binary protocol and compare it with a buffer */
+static bool recvelem(TTSOCK *sock, const char *buf, int size){
+  char ebuf[RECBUFSIZ*2];
+  int esiz = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || esiz != size || esiz > (int)sizeof(ebuf) ||
+     !ttsockrecv(sock, ebuf, esiz)) return false;
+  return !memcmp(ebuf, buf, size);
+}
+
+
 /* parse arguments of write command */
 static int runwrite(int argc, char **argv){
   char *host = NULL;
@@ -240,197 +506,2183 @@ static int runremove(int argc, char **argv){
 }
 
 
-/* perform write command */
-static int procwrite(const char *host, int port, int tnum, int rnum,
-                     bool nr, const char *ext, bool rnd){
-  iprintf("<Writing Test>\n  host=%s  port=%d  tnum=%d  rnum=%d  nr=%d  ext=%s  rnd=%d\n\n",
-          host, port, tnum, rnum, nr, ext ? ext : "", rnd);
-  bool err = false;
-  double stime = tctime();
-  TCRDB *rdbs[tnum];
-  for(int i = 0; i < tnum; i++){
-    rdbs[i] = tcrdbnew();
-    if(!tcrdbopen(rdbs[i], host, port)){
-      eprint(rdbs[i], "tcrdbopen");
-      err = true;
-    }
-  }
-  TCRDB *rdb = rdbs[0];
-  TARGWRITE targs[tnum];
-  pthread_t threads[tnum];
-  if(tnum == 1){
-    targs[0].rdb = rdbs[0];
-    targs[0].rnum = rnum;
-    targs[0].nr = nr;
-    targs[0].ext = ext;
-    targs[0].rnd = rnd;
-    targs[0].id = 0;
-    if(threadwrite(targs) != NULL) err = true;
-  } else {
-    for(int i = 0; i < tnum; i++){
-      targs[i].rdb = rdbs[i];
-      targs[i].rnum = rnum;
-      targs[i].nr = nr;
-      targs[i].ext = ext;
-      targs[i].rnd = rnd;
-      targs[i].id = i;
-      if(pthread_create(threads + i, NULL, threadwrite, targs + i) != 0){
-        eprint(rdb, "pthread_create");
-        targs[i].id = -1;
-        err = true;
-      }
-    }
-    for(int i = 0; i < tnum; i++){
-      if(targs[i].id == -1) continue;
-      void *rv;
-      if(pthread_join(threads[i], &rv) != 0){
-        eprint(rdb, "pthread_join");
-        err = true;
-      } else if(rv){
-        err = true;
+/* parse arguments of bench command */
+static int runbench(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  int tnum = 1;
+  int cnum = 1;
+  int vsiz = 0;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-tnum")){
+        if(++i >= argc) usage();
+        tnum = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-cnum")){
+        if(++i >= argc) usage();
+        cnum = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-vsiz")){
+        if(++i >= argc) usage();
+        vsiz = tcatoi(argv[i]);
+      } else {
+        usage();
       }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
     }
   }
-  iprintf("record number: %llu\n", (unsigned long long)tcrdbrnum(rdb));
-  iprintf("size: %llu\n", (unsigned long long)tcrdbsize(rdb));
-  for(int i = 0; i < tnum; i++){
-    if(!tcrdbclose(rdbs[i])){
-      eprint(rdbs[i], "tcrdbclose");
-      err = true;
-    }
-    tcrdbdel(rdbs[i]);
-  }
-  iprintf("time: %.3f\n", tctime() - stime);
-  iprintf("%s\n\n", err ? "error" : "ok");
-  return err ? 1 : 0;
+  if(!host || !rstr || tnum < 1 || cnum < 1 || vsiz < 0) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = procbench(host, port, tnum, cnum, vsiz, rnum);
+  return rv;
 }
 
 
-/* perform read command */
-static int procread(const char *host, int port, int tnum, int mul, bool rnd){
-  iprintf("<Reading Test>\n  host=%s  port=%d  tnum=%d  mul=%d  rnd=%d\n\n",
-          host, port, tnum, mul, rnd);
-  bool err = false;
-  double stime = tctime();
-  TCRDB *rdbs[tnum];
-  for(int i = 0; i < tnum; i++){
-    rdbs[i] = tcrdbnew();
-    if(!tcrdbopen(rdbs[i], host, port)){
-      eprint(rdbs[i], "tcrdbopen");
-      err = true;
-    }
-  }
-  TCRDB *rdb = rdbs[0];
-  int rnum = tcrdbrnum(rdb) / tnum;
-  TARGREAD targs[tnum];
-  pthread_t threads[tnum];
-  if(tnum == 1){
-    targs[0].rdb = rdbs[0];
-    targs[0].rnum = rnum;
-    targs[0].mul = mul;
-    targs[0].rnd = rnd;
-    targs[0].id = 0;
-    if(threadread(targs) != NULL) err = true;
-  } else {
-    for(int i = 0; i < tnum; i++){
-      targs[i].rdb = rdbs[i];
-      targs[i].rnum = rnum;
-      targs[i].mul = mul;
-      targs[i].rnd = rnd;
-      targs[i].id = i;
-      if(pthread_create(threads + i, NULL, threadread, targs + i) != 0){
-        eprint(rdb, "pthread_create");
-        targs[i].id = -1;
-        err = true;
-      }
-    }
-    for(int i = 0; i < tnum; i++){
-      if(targs[i].id == -1) continue;
-      void *rv;
-      if(pthread_join(threads[i], &rv) != 0){
-        eprint(rdb, "pthread_join");
-        err = true;
-      } else if(rv){
-        err = true;
+/* parse arguments of comp command */
+static int runcomp(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else {
+        usage();
       }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
     }
   }
-  iprintf("record number: %llu\n", (unsigned long long)tcrdbrnum(rdb));
-  iprintf("size: %llu\n", (unsigned long long)tcrdbsize(rdb));
-  for(int i = 0; i < tnum; i++){
-    if(!tcrdbclose(rdbs[i])){
-      eprint(rdbs[i], "tcrdbclose");
-      err = true;
-    }
-    tcrdbdel(rdbs[i]);
-  }
-  iprintf("time: %.3f\n", tctime() - stime);
-  iprintf("%s\n\n", err ? "error" : "ok");
-  return err ? 1 : 0;
+  if(!host || !rstr) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = proccomp(host, port, rnum);
+  return rv;
 }
 
 
-/* perform remove command */
-static int procremove(const char *host, int port, int tnum, bool rnd){
-  iprintf("<Removing Test>\n  host=%s  port=%d  tnum=%d  rnd=%d\n\n", host, port, tnum, rnd);
-  bool err = false;
-  double stime = tctime();
-  TCRDB *rdbs[tnum];
-  for(int i = 0; i < tnum; i++){
-    rdbs[i] = tcrdbnew();
-    if(!tcrdbopen(rdbs[i], host, port)){
-      eprint(rdbs[i], "tcrdbopen");
-      err = true;
+/* parse arguments of batch command */
+static int runbatch(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  int tnum = 1;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-tnum")){
+        if(++i >= argc) usage();
+        tnum = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
     }
   }
-  TCRDB *rdb = rdbs[0];
-  int rnum = tcrdbrnum(rdb) / tnum;
+  if(!host || !rstr || tnum < 1) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = procbatch(host, port, tnum, rnum);
+  return rv;
+}
+
+
+/* parse arguments of iter command */
+static int runiter(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  int tnum = 1;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-tnum")){
+        if(++i >= argc) usage();
+        tnum = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr || tnum < 1) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = prociter(host, port, tnum, rnum);
+  return rv;
+}
+
+
+/* parse arguments of cas command */
+static int runcas(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  int tnum = 1;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-tnum")){
+        if(++i >= argc) usage();
+        tnum = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr || tnum < 1) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = proccas(host, port, tnum, rnum);
+  return rv;
+}
+
+
+/* parse arguments of mget command */
+static int runmget(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = procmget(host, port, rnum);
+  return rv;
+}
+
+
+/* parse arguments of fwm command */
+static int runfwm(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = procfwm(host, port, rnum);
+  return rv;
+}
+
+
+/* parse arguments of ttl command */
+static int runttl(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = procttl(host, port, rnum);
+  return rv;
+}
+
+
+/* parse arguments of miss command */
+static int runmiss(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = procmiss(host, port, rnum);
+  return rv;
+}
+
+
+/* parse arguments of cache command */
+static int runcache(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  int tnum = 1;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-tnum")){
+        if(++i >= argc) usage();
+        tnum = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr || tnum < 1) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = proccache(host, port, tnum, rnum);
+  return rv;
+}
+
+
+/* parse arguments of hand command */
+static int runhand(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = prochand(host, port, rnum);
+  return rv;
+}
+
+
+/* parse arguments of shed command */
+static int runshed(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  int tnum = 1;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-tnum")){
+        if(++i >= argc) usage();
+        tnum = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr || tnum < 1) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = procshed(host, port, tnum, rnum);
+  return rv;
+}
+
+
+/* parse arguments of frame command */
+static int runframe(int argc, char **argv){
+  char *host = NULL;
+  char *rstr = NULL;
+  int port = DEFPORT;
+  int tout = 0;
+  for(int i = 2; i < argc; i++){
+    if(!host && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-port")){
+        if(++i >= argc) usage();
+        port = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-tout")){
+        if(++i >= argc) usage();
+        tout = tcatoi(argv[i]);
+      } else {
+        usage();
+      }
+    } else if(!host){
+      host = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!host || !rstr) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = procframe(host, port, tout, rnum);
+  return rv;
+}
+
+
+/* perform write command */
+static int procwrite(const char *host, int port, int tnum, int rnum,
+                     bool nr, const char *ext, bool rnd){
+  iprintf("<Writing Test>\n  host=%s  port=%d  tnum=%d  rnum=%d  nr=%d  ext=%s  rnd=%d\n\n",
+          host, port, tnum, rnum, nr, ext ? ext : "", rnd);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdbs[tnum];
+  for(int i = 0; i < tnum; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  TARGWRITE targs[tnum];
+  pthread_t threads[tnum];
+  if(tnum == 1){
+    targs[0].rdb = rdbs[0];
+    targs[0].rnum = rnum;
+    targs[0].nr = nr;
+    targs[0].ext = ext;
+    targs[0].rnd = rnd;
+    targs[0].id = 0;
+    if(threadwrite(targs) != NULL) err = true;
+  } else {
+    for(int i = 0; i < tnum; i++){
+      targs[i].rdb = rdbs[i];
+      targs[i].rnum = rnum;
+      targs[i].nr = nr;
+      targs[i].ext = ext;
+      targs[i].rnd = rnd;
+      targs[i].id = i;
+      if(pthread_create(threads + i, NULL, threadwrite, targs + i) != 0){
+        eprint(rdb, "pthread_create");
+        targs[i].id = -1;
+        err = true;
+      }
+    }
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  iprintf("record number: %llu\n", (unsigned long long)tcrdbrnum(rdb));
+  iprintf("size: %llu\n", (unsigned long long)tcrdbsize(rdb));
+  for(int i = 0; i < tnum; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform read command */
+static int procread(const char *host, int port, int tnum, int mul, bool rnd){
+  iprintf("<Reading Test>\n  host=%s  port=%d  tnum=%d  mul=%d  rnd=%d\n\n",
+          host, port, tnum, mul, rnd);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdbs[tnum];
+  for(int i = 0; i < tnum; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  int rnum = tcrdbrnum(rdb) / tnum;
+  TARGREAD targs[tnum];
+  pthread_t threads[tnum];
+  if(tnum == 1){
+    targs[0].rdb = rdbs[0];
+    targs[0].rnum = rnum;
+    targs[0].mul = mul;
+    targs[0].rnd = rnd;
+    targs[0].id = 0;
+    if(threadread(targs) != NULL) err = true;
+  } else {
+    for(int i = 0; i < tnum; i++){
+      targs[i].rdb = rdbs[i];
+      targs[i].rnum = rnum;
+      targs[i].mul = mul;
+      targs[i].rnd = rnd;
+      targs[i].id = i;
+      if(pthread_create(threads + i, NULL, threadread, targs + i) != 0){
+        eprint(rdb, "pthread_create");
+        targs[i].id = -1;
+        err = true;
+      }
+    }
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  iprintf("record number: %llu\n", (unsigned long long)tcrdbrnum(rdb));
+  iprintf("size: %llu\n", (unsigned long long)tcrdbsize(rdb));
+  for(int i = 0; i < tnum; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform remove command */
+static int procremove(const char *host, int port, int tnum, bool rnd){
+  iprintf("<Removing Test>\n  host=%s  port=%d  tnum=%d  rnd=%d\n\n", host, port, tnum, rnd);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdbs[tnum];
+  for(int i = 0; i < tnum; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  int rnum = tcrdbrnum(rdb) / tnum;
   TARGREMOVE targs[tnum];
   pthread_t threads[tnum];
   if(tnum == 1){
     targs[0].rdb = rdbs[0];
     targs[0].rnum = rnum;
-    targs[0].rnd = rnd;
+    targs[0].rnd = rnd;
+    targs[0].id = 0;
+    if(threadremove(targs) != NULL) err = true;
+  } else {
+    for(int i = 0; i < tnum; i++){
+      targs[i].rdb = rdbs[i];
+      targs[i].rnum = rnum;
+      targs[i].rnd = rnd;
+      targs[i].id = i;
+      if(pthread_create(threads + i, NULL, threadremove, targs + i) != 0){
+        eprint(rdb, "pthread_create");
+        targs[i].id = -1;
+        err = true;
+      }
+    }
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  iprintf("record number: %llu\n", (unsigned long long)tcrdbrnum(rdb));
+  iprintf("size: %llu\n", (unsigned long long)tcrdbsize(rdb));
+  for(int i = 0; i < tnum; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform bench command */
+static int procbench(const char *host, int port, int tnum, int cnum, int vsiz, int rnum){
+  iprintf("<Benchmark Test>\n  host=%s  port=%d  tnum=%d  cnum=%d  vsiz=%d  rnum=%d\n\n",
+          host, port, tnum, cnum, vsiz, rnum);
+  bool err = false;
+  int anum = tnum * cnum;
+  TCRDB **rdbs = tcmalloc(sizeof(*rdbs) * anum);
+  for(int i = 0; i < anum; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  double *lats = tcmalloc(sizeof(*lats) * tnum * rnum);
+  char backend[RECBUFSIZ];
+  statnum(rdb, "evbackend", backend);
+  uint64_t evsnum = statnum(rdb, "evsyscall", NULL);
+  double stime = tctime();
+  TARGBENCH targs[tnum];
+  pthread_t threads[tnum];
+  if(tnum == 1){
+    targs[0].rdbs = rdbs;
+    targs[0].cnum = cnum;
+    targs[0].rnum = rnum;
+    targs[0].vsiz = vsiz;
+    targs[0].lats = lats;
+    targs[0].bsum = 0;
+    targs[0].id = 0;
+    if(threadbench(targs) != NULL) err = true;
+  } else {
+    for(int i = 0; i < tnum; i++){
+      targs[i].rdbs = rdbs + i * cnum;
+      targs[i].cnum = cnum;
+      targs[i].rnum = rnum;
+      targs[i].vsiz = vsiz;
+      targs[i].lats = lats + i * rnum;
+      targs[i].bsum = 0;
+      targs[i].id = i;
+      if(pthread_create(threads + i, NULL, threadbench, targs + i) != 0){
+        eprint(rdb, "pthread_create");
+        targs[i].id = -1;
+        err = true;
+      }
+    }
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  double etime = tctime() - stime;
+  int lnum = tnum * rnum;
+  int64_t bsum = 0;
+  for(int i = 0; i < tnum; i++){
+    bsum += targs[i].bsum;
+  }
+  uint64_t evenum = statnum(rdb, "evsyscall", NULL);
+  if(!err){
+    qsort(lats, lnum, sizeof(*lats), dblcmp);
+    iprintf("backend: %s\n", backend);
+    iprintf("connections: %d\n", anum);
+    iprintf("requests: %d\n", lnum);
+    iprintf("throughput: %.3f\n", etime > 0 ? lnum / etime : 0.0);
+    iprintf("latency p50: %.6f\n", lats[lnum / 2]);
+    iprintf("latency p99: %.6f\n", lats[lnum * 99 / 100]);
+    iprintf("latency max: %.6f\n", lats[lnum - 1]);
+    iprintf("event syscalls per request: %.3f\n",
+            evenum > evsnum ? (double)(evenum - evsnum) / lnum : 0.0);
+    if(vsiz > 0){
+      iprintf("transferred: %lld\n", (long long)bsum);
+      iprintf("bandwidth MB/s: %.3f\n", etime > 0 ? bsum / etime / (1024 * 1024) : 0.0);
+    }
+  }
+  tcfree(lats);
+  for(int i = 0; i < anum; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  tcfree(rdbs);
+  iprintf("time: %.3f\n", etime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform comp command */
+static int proccomp(const char *host, int port, int rnum){
+  iprintf("<Compression Test>\n  host=%s  port=%d  rnum=%d\n\n", host, port, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdb = tcrdbnew();
+  if(!tcrdbopen(rdb, host, port)){
+    eprint(rdb, "tcrdbopen");
+    err = true;
+  }
+  TCRDB *crdb = tcrdbnew();
+  if(!tcrdbopen(crdb, host, port)){
+    eprint(crdb, "tcrdbopen");
+    err = true;
+  }
+  char vbuf[COMPVALSIZ];
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "comp:%08d", i);
+    int vsiz = 0;
+    while(vsiz < COMPVALSIZ - RECBUFSIZ){
+      vsiz += sprintf(vbuf + vsiz, "%08d:", i);
+    }
+    if(!tcrdbput(rdb, kbuf, ksiz, vbuf, vsiz)){
+      eprint(rdb, "tcrdbput");
+      err = true;
+    }
+  }
+  if(!err && tcrdbsetcomp(crdb, -1, 0)){
+    eprint(crdb, "tcrdbsetcomp (invalid codec)");
+    err = true;
+  }
+  int codec = TTZNONE;
+  if(!err){
+    if(tcrdbsetcomp(crdb, TTZDEFLATE, 0)){
+      codec = TTZDEFLATE;
+    } else if(tcrdbsetcomp(crdb, TTZBZIP, 0)){
+      codec = TTZBZIP;
+    } else {
+      eprint(crdb, "tcrdbsetcomp");
+      err = true;
+    }
+  }
+  iprintf("codec: %s\n", codec == TTZDEFLATE ? "deflate" : codec == TTZBZIP ? "bzip" : "none");
+  uint64_t inum = statnum(rdb, "comp_in", NULL);
+  uint64_t onum = statnum(rdb, "comp_out", NULL);
+  int cnt = 0;
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "comp:%08d", i);
+    int psiz, csiz;
+    char *pbuf = tcrdbget(rdb, kbuf, ksiz, &psiz);
+    char *cbuf = tcrdbget(crdb, kbuf, ksiz, &csiz);
+    if(!pbuf || !cbuf){
+      eprint(pbuf ? crdb : rdb, "tcrdbget");
+      err = true;
+    } else if(psiz != csiz || memcmp(pbuf, cbuf, psiz)){
+      eprint(crdb, "(validation)");
+      err = true;
+    }
+    tcfree(cbuf);
+    tcfree(pbuf);
+    if(i % 10 == 0){
+      TCMAP *precs = tcmapnew();
+      TCMAP *crecs = tcmapnew();
+      for(int j = i - 9; j <= i; j++){
+        ksiz = sprintf(kbuf, "comp:%08d", j);
+        tcmapput(precs, kbuf, ksiz, "", 0);
+        tcmapput(crecs, kbuf, ksiz, "", 0);
+      }
+      if(!tcrdbget3(rdb, precs) || !tcrdbget3(crdb, crecs)){
+        eprint(crdb, "tcrdbget3");
+        err = true;
+      } else if(tcmaprnum(precs) != 10 || tcmaprnum(crecs) != 10){
+        eprint(crdb, "(validation)");
+        err = true;
+      } else {
+        tcmapiterinit(precs);
+        const char *pkbuf;
+        int pksiz;
+        while((pkbuf = tcmapiternext(precs, &pksiz)) != NULL){
+          int pvsiz, cvsiz;
+          const char *pvbuf = tcmapiterval(pkbuf, &pvsiz);
+          const char *cvbuf = tcmapget(crecs, pkbuf, pksiz, &cvsiz);
+          if(!cvbuf || cvsiz != pvsiz || memcmp(cvbuf, pvbuf, pvsiz)){
+            eprint(crdb, "(validation)");
+            err = true;
+            break;
+          }
+        }
+      }
+      tcmapdel(crecs);
+      tcmapdel(precs);
+    }
+    cnt++;
+  }
+  if(!err){
+    TCLIST *pkeys = tcrdbfwmkeys2(rdb, "comp:", -1);
+    TCLIST *ckeys = tcrdbfwmkeys2(crdb, "comp:", -1);
+    if(tclistnum(pkeys) != rnum || tclistnum(ckeys) != rnum){
+      eprint(crdb, "tcrdbfwmkeys2");
+      err = true;
+    }
+    tclistdel(ckeys);
+    tclistdel(pkeys);
+  }
+  if(!err){
+    char rbuf[RECBUFSIZ];
+    uint64_t inumx = statnum(rdb, "comp_in", NULL);
+    uint64_t onumx = statnum(rdb, "comp_out", NULL);
+    statnum(rdb, "comp_ratio", rbuf);
+    double ratio = tcatof(rbuf);
+    iprintf("compressed: %llu -> %llu\n",
+            (unsigned long long)(inumx - inum), (unsigned long long)(onumx - onum));
+    iprintf("ratio: %.6f\n", ratio);
+    if(inumx <= inum || onumx <= onum || onumx - onum >= inumx - inum || ratio >= 1.0){
+      eprint(rdb, "(compression)");
+      err = true;
+    }
+  }
+  if(!err && !tcrdbsetcomp(crdb, TTZNONE, 0)){
+    eprint(crdb, "tcrdbsetcomp");
+    err = true;
+  }
+  if(!err && tcrdbvsiz2(crdb, "comp:00000001") < 1){
+    eprint(crdb, "tcrdbvsiz2");
+    err = true;
+  }
+  iprintf("checked: %d\n", cnt);
+  if(!tcrdbclose(crdb)){
+    eprint(crdb, "tcrdbclose");
+    err = true;
+  }
+  tcrdbdel(crdb);
+  if(!tcrdbclose(rdb)){
+    eprint(rdb, "tcrdbclose");
+    err = true;
+  }
+  tcrdbdel(rdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform batch command */
+static int procbatch(const char *host, int port, int tnum, int rnum){
+  iprintf("<Batch Test>\n  host=%s  port=%d  tnum=%d  rnum=%d\n\n", host, port, tnum, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdbs[tnum];
+  for(int i = 0; i < tnum; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  TCLIST *keys = tcrdbfwmkeys2(rdb, "batch:", -1);
+  for(int i = 0; !err && i < tclistnum(keys); i++){
+    const char *kstr = tclistval2(keys, i);
+    if(!tcrdbout2(rdb, kstr) && tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbout2");
+      err = true;
+    }
+  }
+  tclistdel(keys);
+  TARGBATCH targs[tnum];
+  pthread_t threads[tnum];
+  if(tnum == 1){
+    targs[0].rdb = rdbs[0];
+    targs[0].rnum = rnum;
+    targs[0].id = 0;
+    if(threadbatch(targs) != NULL) err = true;
+  } else {
+    for(int i = 0; i < tnum; i++){
+      targs[i].rdb = rdbs[i];
+      targs[i].rnum = rnum;
+      targs[i].id = i;
+      if(pthread_create(threads + i, NULL, threadbatch, targs + i) != 0){
+        eprint(rdb, "pthread_create");
+        targs[i].id = -1;
+        err = true;
+      }
+    }
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  for(int i = 0; !err && i < BATCHCNTNUM; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "batch:cnt:%d", i);
+    if(tcrdbaddint(rdb, kbuf, ksiz, 0) != tnum * rnum){
+      eprint(rdb, "(validation)");
+      err = true;
+    }
+  }
+  if(!err){
+    keys = tcrdbfwmkeys2(rdb, "batch:rec:", -1);
+    if(tclistnum(keys) != tnum){
+      eprint(rdb, "(validation)");
+      err = true;
+    }
+    tclistdel(keys);
+  }
+  if(!err){
+    RDBBATCH *batch = tcrdbbatchnew(rdb);
+    tcrdbbatchaddint(batch, "batch:cnt:0", 11, 1);
+    tcrdbbatchput(batch, "batch:reject", 12, "reject", 6);
+    uint8_t cmd = TTCMDPUTSHL;
+    tcxstrcat(batch->ops, &cmd, sizeof(cmd));
+    uint32_t num = TTHTONL((uint32_t)12);
+    tcxstrcat(batch->ops, &num, sizeof(num));
+    num = TTHTONL((uint32_t)6);
+    tcxstrcat(batch->ops, &num, sizeof(num));
+    tcxstrcat(batch->ops, "batch:reject", 12);
+    tcxstrcat(batch->ops, "reject", 6);
+    batch->num++;
+    if(tcrdbbatchrun(batch) || tcrdbecode(rdb) != TTEMISC){
+      eprint(rdb, "tcrdbbatchrun (unsupported operation)");
+      err = true;
+    }
+    for(int i = 0; i < tcrdbbatchnum(batch); i++){
+      if(tcrdbbatchresult(batch, i, NULL)){
+        eprint(rdb, "tcrdbbatchresult");
+        err = true;
+      }
+    }
+    tcrdbbatchdel(batch);
+    if(tcrdbvsiz2(rdb, "batch:reject") >= 0 ||
+       tcrdbaddint(rdb, "batch:cnt:0", 11, 0) != tnum * rnum){
+      eprint(rdb, "(validation)");
+      err = true;
+    }
+  }
+  iprintf("record number: %llu\n", (unsigned long long)tcrdbrnum(rdb));
+  for(int i = 0; i < tnum; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform iter command */
+static int prociter(const char *host, int port, int tnum, int rnum){
+  iprintf("<Iterator Test>\n  host=%s  port=%d  tnum=%d  rnum=%d\n\n", host, port, tnum, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdbs[tnum];
+  for(int i = 0; i < tnum; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  if(!err && !tcrdbvanish(rdb)){
+    eprint(rdb, "tcrdbvanish");
+    err = true;
+  }
+  for(int i = 1; !err && i <= rnum; i++){
+    char buf[RECBUFSIZ];
+    int len = sprintf(buf, "%08d", i);
+    if(!tcrdbput(rdb, buf, len, buf, len)){
+      eprint(rdb, "tcrdbput");
+      err = true;
+    }
+  }
+  TARGITER targs[tnum];
+  pthread_t threads[tnum];
+  if(tnum == 1){
+    targs[0].rdb = rdbs[0];
+    targs[0].rnum = rnum;
+    targs[0].id = 0;
+    if(threaditer(targs) != NULL) err = true;
+  } else {
+    for(int i = 0; i < tnum; i++){
+      targs[i].rdb = rdbs[i];
+      targs[i].rnum = rnum;
+      targs[i].id = i;
+      if(pthread_create(threads + i, NULL, threaditer, targs + i) != 0){
+        eprint(rdb, "pthread_create");
+        targs[i].id = -1;
+        err = true;
+      }
+    }
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  if(!err){
+    TCMAP *recs = tcmapnew();
+    if(!tcrdbiterpart(rdb, 0, 1)){
+      eprint(rdb, "tcrdbiterpart");
+      err = true;
+    } else if(!iterpages(rdb, recs) || tcmaprnum(recs) != rnum){
+      eprint(rdb, "(validation)");
+      err = true;
+    }
+    tcmapclear(recs);
+    int pnum = tnum + 1;
+    if(!err && tcrdbiterpart(rdb, 0, pnum)){
+      for(int i = 0; !err && i < pnum; i++){
+        if(!tcrdbiterpart(rdb, i, pnum)){
+          eprint(rdb, "tcrdbiterpart");
+          err = true;
+        } else if(!iterpages(rdb, recs)){
+          eprint(rdb, "(validation)");
+          err = true;
+        }
+      }
+      if(!err && tcmaprnum(recs) != rnum){
+        eprint(rdb, "(validation)");
+        err = true;
+      }
+      iprintf("partitions: %d\n", pnum);
+    } else if(!err && tcrdbecode(rdb) != TTEMISC){
+      eprint(rdb, "tcrdbiterpart");
+      err = true;
+    }
+    tcmapdel(recs);
+    int cnt = 0;
+    if(!err && (!tcrdbscan(host, port, pnum, iterscan, &cnt) || cnt != rnum)){
+      eprint(rdb, "tcrdbscan");
+      err = true;
+    }
+  }
+  iprintf("record number: %llu\n", (unsigned long long)tcrdbrnum(rdb));
+  for(int i = 0; i < tnum; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform cas command */
+static int proccas(const char *host, int port, int tnum, int rnum){
+  iprintf("<Compare-and-swap Test>\n  host=%s  port=%d  tnum=%d  rnum=%d\n\n",
+          host, port, tnum, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdbs[tnum];
+  for(int i = 0; i < tnum; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  if(!err && !tcrdbput2(rdb, "cas:counter", "0")){
+    eprint(rdb, "tcrdbput2");
+    err = true;
+  }
+  TARGCAS targs[tnum];
+  pthread_t threads[tnum];
+  if(tnum == 1){
+    targs[0].rdb = rdbs[0];
+    targs[0].rnum = rnum;
+    targs[0].cnum = 0;
+    targs[0].id = 0;
+    if(threadcas(targs) != NULL) err = true;
+  } else {
+    for(int i = 0; i < tnum; i++){
+      targs[i].rdb = rdbs[i];
+      targs[i].rnum = rnum;
+      targs[i].cnum = 0;
+      targs[i].id = i;
+      if(pthread_create(threads + i, NULL, threadcas, targs + i) != 0){
+        eprint(rdb, "pthread_create");
+        targs[i].id = -1;
+        err = true;
+      }
+    }
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  int cnum = 0;
+  for(int i = 0; i < tnum; i++){
+    cnum += targs[i].cnum;
+  }
+  char *vstr = tcrdbget2(rdb, "cas:counter");
+  if(!vstr || tcatoi(vstr) != tnum * rnum){
+    eprint(rdb, "(validation)");
+    err = true;
+  }
+  tcfree(vstr);
+  for(int i = 0; !err && i < 4; i++){
+    int vsiz;
+    uint64_t ver;
+    char *vbuf = tcrdbgets(rdb, "cas:counter", 11, &vsiz, &ver);
+    if(!vbuf){
+      eprint(rdb, "tcrdbgets");
+      err = true;
+      break;
+    }
+    tcfree(vbuf);
+    bool ok = false;
+    switch(i){
+    case 0:
+      ok = tcrdbput2(rdb, "cas:counter", "0");
+      break;
+    case 1:
+      ok = tcrdbputcat2(rdb, "cas:counter", "0");
+      break;
+    case 2:
+      ok = tcrdbaddint(rdb, "cas:counter", 11, 0) != INT_MIN;
+      break;
+    default: {
+      RDBBATCH *batch = tcrdbbatchnew(rdb);
+      tcrdbbatchput(batch, "cas:counter", 11, "0", 1);
+      ok = tcrdbbatchrun(batch);
+      tcrdbbatchdel(batch);
+      break;
+    }
+    }
+    if(!ok){
+      eprint(rdb, "(modification)");
+      err = true;
+    } else if(tcrdbcas(rdb, "cas:counter", 11, "1", 1, ver, NULL) ||
+              tcrdbecode(rdb) != TTEKEEP){
+      eprint(rdb, "tcrdbcas (stale token)");
+      err = true;
+    }
+  }
+  if(!err){
+    int vsiz;
+    uint64_t ver, nver, cver;
+    char *vbuf = tcrdbgets(rdb, "cas:counter", 11, &vsiz, &ver);
+    if(!vbuf){
+      eprint(rdb, "tcrdbgets");
+      err = true;
+    } else if(!tcrdbcas(rdb, "cas:counter", 11, "1", 1, ver, &nver) || nver == ver){
+      eprint(rdb, "tcrdbcas");
+      err = true;
+    } else {
+      tcfree(vbuf);
+      vbuf = tcrdbgets(rdb, "cas:counter", 11, &vsiz, &cver);
+      if(!vbuf || cver != nver || vsiz != 1 || *vbuf != '1'){
+        eprint(rdb, "(validation)");
+        err = true;
+      }
+    }
+    tcfree(vbuf);
+  }
+  if(!err){
+    tcrdbout2(rdb, "cas:missing");
+    if(tcrdbcas(rdb, "cas:missing", 11, "1", 1, 1, NULL) || tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbcas (missing record)");
+      err = true;
+    }
+  }
+  iprintf("conflicts: %d\n", cnum);
+  for(int i = 0; i < tnum; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform mget command */
+static int procmget(const char *host, int port, int rnum){
+  iprintf("<Streaming Multiple Retrieval Test>\n  host=%s  port=%d  rnum=%d\n\n",
+          host, port, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdb = tcrdbnew();
+  if(!tcrdbopen(rdb, host, port)){
+    eprint(rdb, "tcrdbopen");
+    err = true;
+  }
+  char vbuf[MGETVALSIZ];
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "mget:%08d", i);
+    int vsiz = myrand(MGETVALSIZ - RECBUFSIZ) + ksiz;
+    for(int j = 0; j < vsiz; j++){
+      vbuf[j] = kbuf[j%ksiz];
+    }
+    if(!tcrdbput(rdb, kbuf, ksiz, vbuf, vsiz)){
+      eprint(rdb, "tcrdbput");
+      err = true;
+    }
+  }
+  TCMAP *srecs = tcmapnew();
+  TCMAP *mrecs = tcmapnew();
+  for(int i = 1; i <= rnum + rnum / 10; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "mget:%08d", myrand(rnum + rnum / 10) + 1);
+    tcmapput(srecs, kbuf, ksiz, "", 0);
+    tcmapput(mrecs, kbuf, ksiz, "", 0);
+  }
+  int qnum = tcmaprnum(srecs);
+  if(!err && !tcrdbget4(rdb, srecs)){
+    eprint(rdb, "tcrdbget4");
+    err = true;
+  }
+  if(!err && !tcrdbget3(rdb, mrecs)){
+    eprint(rdb, "tcrdbget3");
+    err = true;
+  }
+  if(!err && tcmaprnum(srecs) != tcmaprnum(mrecs)){
+    eprint(rdb, "(validation)");
+    err = true;
+  }
+  if(!err){
+    tcmapiterinit(srecs);
+    const char *kbuf;
+    int ksiz;
+    while((kbuf = tcmapiternext(srecs, &ksiz)) != NULL){
+      int svsiz, mvsiz;
+      const char *svbuf = tcmapiterval(kbuf, &svsiz);
+      const char *mvbuf = tcmapget(mrecs, kbuf, ksiz, &mvsiz);
+      bool ok = mvbuf && svsiz == mvsiz && !memcmp(svbuf, mvbuf, svsiz) && svsiz >= ksiz;
+      for(int i = 0; ok && i < svsiz; i++){
+        if(svbuf[i] != kbuf[i%ksiz]) ok = false;
+      }
+      if(!ok){
+        eprint(rdb, "(validation)");
+        err = true;
+        break;
+      }
+    }
+  }
+  iprintf("queried: %d\n", qnum);
+  iprintf("retrieved: %d\n", (int)tcmaprnum(srecs));
+  tcmapclear(srecs);
+  if(!err && (!tcrdbget4(rdb, srecs) || tcmaprnum(srecs) != 0)){
+    eprint(rdb, "tcrdbget4");
+    err = true;
+  }
+  tcmapdel(mrecs);
+  tcmapdel(srecs);
+  if(!tcrdbclose(rdb)){
+    eprint(rdb, "tcrdbclose");
+    err = true;
+  }
+  tcrdbdel(rdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform fwm command */
+static int procfwm(const char *host, int port, int rnum){
+  iprintf("<Forward Matching Test>\n  host=%s  port=%d  rnum=%d\n\n", host, port, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdb = tcrdbnew();
+  if(!tcrdbopen(rdb, host, port)){
+    eprint(rdb, "tcrdbopen");
+    err = true;
+  }
+  TCLIST *keys = tcrdbfwmkeys2(rdb, "fwm:", -1);
+  for(int i = 0; !err && i < tclistnum(keys); i++){
+    const char *kstr = tclistval2(keys, i);
+    if(!tcrdbout2(rdb, kstr) && tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbout2");
+      err = true;
+    }
+  }
+  tclistdel(keys);
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "fwm:%08d", i);
+    if(!tcrdbput(rdb, kbuf, ksiz, kbuf, ksiz)){
+      eprint(rdb, "tcrdbput");
+      err = true;
+    }
+    ksiz = sprintf(kbuf, "fwl:%08d", i);
+    if(i % 10 == 0 && !tcrdbput(rdb, kbuf, ksiz, kbuf, ksiz)){
+      eprint(rdb, "tcrdbput");
+      err = true;
+    }
+    ksiz = sprintf(kbuf, "fwn:%08d", i);
+    if(i % 10 == 0 && !tcrdbput(rdb, kbuf, ksiz, kbuf, ksiz)){
+      eprint(rdb, "tcrdbput");
+      err = true;
+    }
+  }
+  int pnum = 0;
+  for(int desc = 0; !err && desc < 2; desc++){
+    TCMAP *recs = tcmapnew();
+    char *sbuf = NULL;
+    int ssiz = 0;
+    char pbuf[RECBUFSIZ];
+    int psiz = 0;
+    do {
+      void *nbuf;
+      int nsiz;
+      TCLIST *res = tcrdbfwmrecs(rdb, "fwm:", 4, sbuf, ssiz, myrand(ITERPAGEMAX) + 1,
+                                 desc ? RDBFWMDESC : 0, &nbuf, &nsiz);
+      tcfree(sbuf);
+      sbuf = nbuf;
+      ssiz = nsiz;
+      if(!res){
+        eprint(rdb, "tcrdbfwmrecs");
+        err = true;
+        break;
+      }
+      for(int i = 0; !err && i < tclistnum(res) - 1; i += 2){
+        int ksiz, vsiz;
+        const char *kbuf = tclistval(res, i, &ksiz);
+        const char *vbuf = tclistval(res, i + 1, &vsiz);
+        int cmp = psiz > 0 ? tccmplexical(kbuf, ksiz, pbuf, psiz, NULL) : desc ? -1 : 1;
+        if(ksiz != vsiz || memcmp(kbuf, vbuf, ksiz) || ksiz >= RECBUFSIZ ||
+           memcmp(kbuf, "fwm:", 4) || (desc ? cmp >= 0 : cmp <= 0) ||
+           !tcmapputkeep(recs, kbuf, ksiz, "", 0)){
+          eprint(rdb, "(validation)");
+          err = true;
+          break;
+        }
+        memcpy(pbuf, kbuf, ksiz);
+        psiz = ksiz;
+      }
+      tclistdel(res);
+      pnum++;
+    } while(sbuf);
+    tcfree(sbuf);
+    if(!err && tcmaprnum(recs) != rnum){
+      eprint(rdb, "(validation)");
+      err = true;
+    }
+    tcmapdel(recs);
+  }
+  if(!err){
+    void *nbuf;
+    int nsiz;
+    TCLIST *res = tcrdbfwmrecs(rdb, "fwm:", 4, NULL, 0, -1, 0, &nbuf, &nsiz);
+    if(!res || tclistnum(res) != rnum * 2 || nbuf){
+      eprint(rdb, "tcrdbfwmrecs");
+      err = true;
+    }
+    if(res) tclistdel(res);
+    tcfree(nbuf);
+  }
+  iprintf("pages: %d\n", pnum);
+  if(!tcrdbclose(rdb)){
+    eprint(rdb, "tcrdbclose");
+    err = true;
+  }
+  tcrdbdel(rdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform ttl command */
+static int procttl(const char *host, int port, int rnum){
+  iprintf("<Expiration Test>\n  host=%s  port=%d  rnum=%d\n\n", host, port, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdb = tcrdbnew();
+  if(!tcrdbopen(rdb, host, port)){
+    eprint(rdb, "tcrdbopen");
+    err = true;
+  }
+  TCLIST *keys = tcrdbfwmkeys2(rdb, "ttl:", -1);
+  for(int i = 0; !err && i < tclistnum(keys); i++){
+    const char *kstr = tclistval2(keys, i);
+    if(!tcrdbout2(rdb, kstr) && tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbout2");
+      err = true;
+    }
+  }
+  tclistdel(keys);
+  uint64_t base = tcrdbrnum(rdb);
+  int snum = 0;
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "ttl:%08d", i);
+    if(i % 2 == 0){
+      if(!tcrdbput(rdb, kbuf, ksiz, kbuf, ksiz)){
+        eprint(rdb, "tcrdbput");
+        err = true;
+      }
+      snum++;
+    } else if(!tcrdbputttl(rdb, kbuf, ksiz, kbuf, ksiz, 2)){
+      eprint(rdb, "tcrdbputttl");
+      err = true;
+    } else if(i % 10 == 1){
+      if(!tcrdbput(rdb, kbuf, ksiz, kbuf, ksiz)){
+        eprint(rdb, "tcrdbput");
+        err = true;
+      }
+      snum++;
+    } else if(i % 10 == 3){
+      if(!tcrdbputcat(rdb, kbuf, ksiz, "", 0)){
+        eprint(rdb, "tcrdbputcat");
+        err = true;
+      }
+    }
+  }
+  if(!err && tcrdbrnum(rdb) != base + rnum){
+    eprint(rdb, "(validation)");
+    err = true;
+  }
+  tcsleep(TTLWAITMIN);
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "ttl:%08d", i);
+    bool live = i % 2 == 0 || i % 10 == 1;
+    int vsiz;
+    char *vbuf = tcrdbget(rdb, kbuf, ksiz, &vsiz);
+    if(live ? !vbuf : vbuf || tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbget");
+      err = true;
+    }
+    tcfree(vbuf);
+  }
+  double etime = tctime() + TTLWAITMAX;
+  uint64_t num = tcrdbrnum(rdb);
+  while(!err && num != base + snum && tctime() < etime){
+    tcsleep(0.5);
+    num = tcrdbrnum(rdb);
+  }
+  if(!err && num != base + snum){
+    eprint(rdb, "(reaping)");
+    err = true;
+  }
+  iprintf("expired: %d\n", rnum - snum);
+  iprintf("record number: %llu\n", (unsigned long long)num);
+  if(!tcrdbclose(rdb)){
+    eprint(rdb, "tcrdbclose");
+    err = true;
+  }
+  tcrdbdel(rdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform miss command */
+static int procmiss(const char *host, int port, int rnum){
+  iprintf("<Missing Record Test>\n  host=%s  port=%d  rnum=%d\n\n", host, port, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdb = tcrdbnew();
+  if(!tcrdbopen(rdb, host, port)){
+    eprint(rdb, "tcrdbopen");
+    err = true;
+  }
+  TCLIST *keys = tcrdbfwmkeys2(rdb, "miss:", -1);
+  for(int i = 0; !err && i < tclistnum(keys); i++){
+    const char *kstr = tclistval2(keys, i);
+    if(!tcrdbout2(rdb, kstr) && tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbout2");
+      err = true;
+    }
+  }
+  tclistdel(keys);
+  char sbuf[RECBUFSIZ];
+  statnum(rdb, "bloom_size", sbuf);
+  bool bloom = strcmp(sbuf, "unknown") != 0;
+  double etime = tctime() + MISSWAITMAX;
+  while(!err && bloom && statnum(rdb, "bloom_ready", NULL) < 1 && tctime() < etime){
+    tcsleep(0.1);
+  }
+  uint64_t nnum = statnum(rdb, "bloom_neg", NULL);
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "miss:%08d", i);
+    int vsiz;
+    char *vbuf = tcrdbget(rdb, kbuf, ksiz, &vsiz);
+    if(vbuf || tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbget");
+      err = true;
+    }
+    tcfree(vbuf);
+    if(tcrdbvsiz(rdb, kbuf, ksiz) >= 0){
+      eprint(rdb, "tcrdbvsiz");
+      err = true;
+    }
+  }
+  uint64_t nnumx = statnum(rdb, "bloom_neg", NULL);
+  if(!err && bloom && nnumx <= nnum){
+    eprint(rdb, "(bloom filter)");
+    err = true;
+  }
+  iprintf("bloom filter: %s\n", bloom ? "on" : "off");
+  iprintf("negatives: %llu\n", (unsigned long long)(nnumx - nnum));
+  RDBBATCH *batch = tcrdbbatchnew(rdb);
+  int snum = 0;
+  for(int i = 1; !err && i <= rnum; i += 2){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "miss:%08d", i);
+    bool ok = true;
+    switch(snum % 6){
+    case 0:
+      ok = tcrdbput(rdb, kbuf, ksiz, kbuf, ksiz);
+      break;
+    case 1:
+      ok = tcrdbputkeep(rdb, kbuf, ksiz, kbuf, ksiz);
+      break;
+    case 2:
+      ok = tcrdbputcat(rdb, kbuf, ksiz, kbuf, ksiz);
+      break;
+    case 3:
+      ok = tcrdbaddint(rdb, kbuf, ksiz, 1) == 1;
+      break;
+    case 4:
+      tcrdbbatchclear(batch);
+      tcrdbbatchput(batch, kbuf, ksiz, kbuf, ksiz);
+      ok = tcrdbbatchrun(batch);
+      break;
+    default: {
+      TCLIST *args = tclistnew2(2);
+      tclistpush(args, kbuf, ksiz);
+      tclistpush(args, kbuf, ksiz);
+      TCLIST *res = tcrdbmisc(rdb, "putlist", 0, args);
+      if(res){
+        tclistdel(res);
+      } else {
+        ok = false;
+      }
+      tclistdel(args);
+      break;
+    }
+    }
+    if(!ok){
+      eprint(rdb, "(modification)");
+      err = true;
+    }
+    snum++;
+  }
+  tcrdbbatchdel(batch);
+  TCMAP *recs = tcmapnew();
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "miss:%08d", i);
+    if((tcrdbvsiz(rdb, kbuf, ksiz) >= 0) != (i % 2 == 1)){
+      eprint(rdb, "tcrdbvsiz");
+      err = true;
+    }
+    tcmapput(recs, kbuf, ksiz, "", 0);
+  }
+  if(!err && (!tcrdbget3(rdb, recs) || tcmaprnum(recs) != snum)){
+    eprint(rdb, "tcrdbget3");
+    err = true;
+  }
+  tcmapdel(recs);
+  iprintf("stored: %d\n", snum);
+  if(!tcrdbclose(rdb)){
+    eprint(rdb, "tcrdbclose");
+    err = true;
+  }
+  tcrdbdel(rdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform cache command */
+static int proccache(const char *host, int port, int tnum, int rnum){
+  iprintf("<Record Cache Test>\n  host=%s  port=%d  tnum=%d  rnum=%d\n\n",
+          host, port, tnum, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdbs[tnum*2];
+  for(int i = 0; i < tnum * 2; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  TCLIST *keys = tcrdbfwmkeys2(rdb, "cache:", -1);
+  for(int i = 0; !err && i < tclistnum(keys); i++){
+    const char *kstr = tclistval2(keys, i);
+    if(!tcrdbout2(rdb, kstr) && tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbout2");
+      err = true;
+    }
+  }
+  tclistdel(keys);
+  char sbuf[RECBUFSIZ];
+  statnum(rdb, "cache_size", sbuf);
+  bool cache = strcmp(sbuf, "unknown") != 0;
+  uint64_t hnum = statnum(rdb, "cache_hit", NULL);
+  TARGCACHE targs[tnum];
+  pthread_t threads[tnum];
+  if(tnum == 1){
+    targs[0].rdb = rdbs[0];
+    targs[0].rrdb = rdbs[1];
+    targs[0].rnum = rnum;
     targs[0].id = 0;
-    if(threadremove(targs) != NULL) err = true;
+    if(threadcache(targs) != NULL) err = true;
   } else {
     for(int i = 0; i < tnum; i++){
-      targs[i].rdb = rdbs[i];
+      targs[i].rdb = rdbs[i*2];
+      targs[i].rrdb = rdbs[i*2+1];
       targs[i].rnum = rnum;
-      targs[i].rnd = rnd;
       targs[i].id = i;
-      if(pthread_create(threads + i, NULL, threadremove, targs + i) != 0){
+      if(pthread_create(threads + i, NULL, threadcache, targs + i) != 0){
+        eprint(rdb, "pthread_create");
+        targs[i].id = -1;
+        err = true;
+      }
+    }
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  uint64_t hnumx = statnum(rdb, "cache_hit", NULL);
+  if(!err && cache && hnumx <= hnum){
+    eprint(rdb, "(record cache)");
+    err = true;
+  }
+  iprintf("record cache: %s\n", cache ? "on" : "off");
+  iprintf("hits: %llu\n", (unsigned long long)(hnumx - hnum));
+  for(int i = 0; i < tnum * 2; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform hand command */
+static int prochand(const char *host, int port, int rnum){
+  iprintf("<Handover Test>\n  host=%s  port=%d  rnum=%d\n\n", host, port, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdb = tcrdbnew();
+  if(!tcrdbopen(rdb, host, port)){
+    eprint(rdb, "tcrdbopen");
+    err = true;
+  }
+  uint64_t opid = statnum(rdb, "pid", NULL);
+  uint64_t npid = opid;
+  double etime = tctime() + HANDWAITMAX;
+  int cnt = 0;
+  while(!err && (cnt < rnum || npid == opid) && tctime() < etime){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "hand:%08d", ++cnt);
+    if(!tcrdbput(rdb, kbuf, ksiz, kbuf, ksiz)){
+      eprint(rdb, "tcrdbput");
+      err = true;
+      break;
+    }
+    npid = statnum(rdb, "pid", NULL);
+    if(npid < 1){
+      eprint(rdb, "tcrdbstat");
+      err = true;
+    }
+    if(npid == opid) tcsleep(0.01);
+  }
+  if(!err && npid == opid){
+    eprint(rdb, "(handover)");
+    err = true;
+  }
+  TCRDB *nrdb = tcrdbnew();
+  if(!err && !tcrdbopen(nrdb, host, port)){
+    eprint(nrdb, "tcrdbopen");
+    err = true;
+  }
+  for(int i = 1; !err && i <= cnt; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "hand:%08d", i);
+    TCRDB *trdb = (i % 2 == 0) ? rdb : nrdb;
+    int vsiz;
+    char *vbuf = tcrdbget(trdb, kbuf, ksiz, &vsiz);
+    if(!vbuf || vsiz != ksiz || memcmp(vbuf, kbuf, ksiz)){
+      eprint(trdb, "tcrdbget");
+      err = true;
+    }
+    tcfree(vbuf);
+    if(!tcrdbout(trdb, kbuf, ksiz)){
+      eprint(trdb, "tcrdbout");
+      err = true;
+    }
+  }
+  iprintf("old pid: %llu\n", (unsigned long long)opid);
+  iprintf("new pid: %llu\n", (unsigned long long)npid);
+  iprintf("record number: %d\n", cnt);
+  if(!tcrdbclose(nrdb) && !err){
+    eprint(nrdb, "tcrdbclose");
+    err = true;
+  }
+  tcrdbdel(nrdb);
+  if(!tcrdbclose(rdb)){
+    eprint(rdb, "tcrdbclose");
+    err = true;
+  }
+  tcrdbdel(rdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform shed command */
+static int procshed(const char *host, int port, int tnum, int rnum){
+  iprintf("<Load Shedding Test>\n  host=%s  port=%d  tnum=%d  rnum=%d\n\n",
+          host, port, tnum, rnum);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdbs[tnum];
+  for(int i = 0; i < tnum; i++){
+    rdbs[i] = tcrdbnew();
+    if(!tcrdbopen(rdbs[i], host, port)){
+      eprint(rdbs[i], "tcrdbopen");
+      err = true;
+    }
+  }
+  TCRDB *rdb = rdbs[0];
+  TCLIST *keys = tcrdbfwmkeys2(rdb, "shed:", -1);
+  for(int i = 0; !err && i < tclistnum(keys); i++){
+    const char *kstr = tclistval2(keys, i);
+    if(!tcrdbout2(rdb, kstr) && tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbout2");
+      err = true;
+    }
+  }
+  tclistdel(keys);
+  const char *pnames[] = { "shed_bin", "shed_mc", "shed_http" };
+  uint64_t onums[3];
+  for(int i = 0; i < 3; i++){
+    onums[i] = statnum(rdb, pnames[i], NULL);
+  }
+  TARGSHED targs[tnum];
+  pthread_t threads[tnum];
+  for(int i = 0; i < tnum; i++){
+    targs[i].rdb = rdbs[i];
+    targs[i].host = host;
+    targs[i].port = port;
+    targs[i].rnum = rnum;
+    for(int j = 0; j < SHEDKINDNUM; j++){
+      targs[i].busy[j] = 0;
+    }
+    targs[i].id = i;
+  }
+  if(!err && tnum == 1){
+    if(threadshed(targs) != NULL) err = true;
+  } else if(!err){
+    for(int i = 0; i < tnum; i++){
+      if(pthread_create(threads + i, NULL, threadshed, targs + i) != 0){
         eprint(rdb, "pthread_create");
         targs[i].id = -1;
         err = true;
       }
     }
-    for(int i = 0; i < tnum; i++){
-      if(targs[i].id == -1) continue;
-      void *rv;
-      if(pthread_join(threads[i], &rv) != 0){
-        eprint(rdb, "pthread_join");
+    for(int i = 0; i < tnum; i++){
+      if(targs[i].id == -1) continue;
+      void *rv;
+      if(pthread_join(threads[i], &rv) != 0){
+        eprint(rdb, "pthread_join");
+        err = true;
+      } else if(rv){
+        err = true;
+      }
+    }
+  }
+  const char *knames[] = { "put", "mget", "fwmrecs", "misc", "memcached set", "http put" };
+  int64_t busy[SHEDKINDNUM];
+  int64_t pbusy[3] = { 0, 0, 0 };
+  for(int i = 0; i < SHEDKINDNUM; i++){
+    busy[i] = 0;
+    for(int j = 0; j < tnum; j++){
+      busy[i] += targs[j].busy[i];
+    }
+    pbusy[(i < 4) ? 0 : i - 3] += busy[i];
+    iprintf("busy by %s: %lld\n", knames[i], (long long)busy[i]);
+  }
+  for(int i = 0; i < 3; i++){
+    uint64_t num = statnum(rdb, pnames[i], NULL);
+    iprintf("%s: %llu\n", pnames[i], (unsigned long long)(num - onums[i]));
+    if(!err && (pbusy[i] < 1 || num - onums[i] != (uint64_t)pbusy[i])){
+      eprint(rdb, "(load shedding)");
+      err = true;
+    }
+  }
+  for(int i = 0; i < tnum; i++){
+    if(!tcrdbclose(rdbs[i])){
+      eprint(rdbs[i], "tcrdbclose");
+      err = true;
+    }
+    tcrdbdel(rdbs[i]);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform frame command */
+static int procframe(const char *host, int port, int tout, int rnum){
+  iprintf("<Framing Test>\n  host=%s  port=%d  tout=%d  rnum=%d\n\n", host, port, tout, rnum);
+  signal(SIGPIPE, SIG_IGN);
+  bool err = false;
+  double stime = tctime();
+  TCRDB *rdb = tcrdbnew();
+  if(!tcrdbopen(rdb, host, port)){
+    eprint(rdb, "tcrdbopen");
+    err = true;
+  }
+  TCLIST *keys = tcrdbfwmkeys2(rdb, "frame:", -1);
+  for(int i = 0; !err && i < tclistnum(keys); i++){
+    const char *kstr = tclistval2(keys, i);
+    if(!tcrdbout2(rdb, kstr) && tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbout2");
+      err = true;
+    }
+  }
+  tclistdel(keys);
+  uint64_t dnum = statnum(rdb, "deferred", NULL);
+  TTSOCK *socks[3];
+  for(int i = 0; i < 3; i++){
+    socks[i] = opensock(host, port);
+    if(!socks[i]){
+      eprint(rdb, "ttopensock");
+      err = true;
+    }
+  }
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "frame:%08d", i);
+    char vbuf[RECBUFSIZ];
+    int vsiz = sprintf(vbuf, "%d", myrand(rnum) + 1);
+    bool ok;
+    switch(i % 3){
+    case 0:
+      ok = chunkbin(socks[0], kbuf, ksiz, vbuf, vsiz);
+      break;
+    case 1:
+      ok = chunkmc(socks[1], kbuf, ksiz, vbuf, vsiz);
+      break;
+    default:
+      ok = chunkhttp(socks[2], kbuf, ksiz, vbuf, vsiz);
+      break;
+    }
+    if(!ok){
+      eprint(rdb, "(framing)");
+      err = true;
+    }
+    if(rnum > 250 && i % (rnum / 250) == 0){
+      putchar('.');
+      fflush(stdout);
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  if(!err){
+    TCXSTR *xstrs[3];
+    for(int i = 0; i < 3; i++){
+      xstrs[i] = tcxstrnew();
+    }
+    uint8_t magic[2];
+    magic[0] = TTMAGICNUM;
+    magic[1] = TTCMDPUT;
+    tcxstrcat(xstrs[0], magic, sizeof(magic));
+    xstrcatint32(xstrs[0], 15);
+    xstrcatint32(xstrs[0], 3);
+    tcxstrcat(xstrs[0], "frame:stall:bin", 15);
+    tcxstrcat(xstrs[0], "bin", 3);
+    tcxstrprintf(xstrs[1], "set frame:stall:mc 0 0 2\r\nmc\r\n");
+    tcxstrprintf(xstrs[2], "PUT /frame:stall:http HTTP/1.1\r\nContent-Length: 4\r\n\r\nhttp");
+    for(int i = 0; !err && i < 3; i++){
+      if(!ttsocksend(socks[i], tcxstrptr(xstrs[i]), tcxstrsize(xstrs[i]) / 2)){
+        eprint(rdb, "ttsocksend");
+        err = true;
+      }
+    }
+    tcsleep(FRAMEDELAY * 100);
+    double htime = tctime();
+    if(!err && !tcrdbput2(rdb, "frame:stall:probe", "probe")){
+      eprint(rdb, "tcrdbput2");
+      err = true;
+    }
+    char *vstr = err ? NULL : tcrdbget2(rdb, "frame:stall:probe");
+    if(!err && (!vstr || strcmp(vstr, "probe"))){
+      eprint(rdb, "tcrdbget2");
+      err = true;
+    }
+    tcfree(vstr);
+    htime = tctime() - htime;
+    if(!err && htime >= FRAMEHOLDMAX){
+      eprint(rdb, "(worker held)");
+      err = true;
+    }
+    for(int i = 0; !err && i < 3; i++){
+      int half = tcxstrsize(xstrs[i]) / 2;
+      if(!sendchunks(socks[i], (char *)tcxstrptr(xstrs[i]) + half, tcxstrsize(xstrs[i]) - half)){
+        eprint(rdb, "ttsocksend");
+        err = true;
+      }
+    }
+    char line[RECBUFSIZ*4];
+    int bsiz;
+    if(!err && (ttsockgetc(socks[0]) != 0 || !ttsockgets(socks[1], line, sizeof(line)) ||
+                strcmp(line, "STORED") || recvhttp(socks[2], line, sizeof(line), &bsiz) != 201)){
+      eprint(rdb, "(stalled request)");
+      err = true;
+    }
+    const char *skeys[] = { "frame:stall:bin", "frame:stall:mc", "frame:stall:http" };
+    const char *svals[] = { "bin", "mc", "http" };
+    for(int i = 0; !err && i < 3; i++){
+      vstr = tcrdbget2(rdb, skeys[i]);
+      if(!vstr || strcmp(vstr, svals[i])){
+        eprint(rdb, "tcrdbget2");
         err = true;
-      } else if(rv){
+      }
+      tcfree(vstr);
+    }
+    for(int i = 0; i < 3; i++){
+      tcxstrdel(xstrs[i]);
+    }
+    iprintf("stalled request: %.3f sec. for another\n", htime);
+  }
+  for(int i = 0; i < 3; i++){
+    closesock(socks[i]);
+  }
+  uint64_t dnumx = statnum(rdb, "deferred", NULL);
+  iprintf("deferred: %llu\n", (unsigned long long)(dnumx - dnum));
+  if(!err && dnumx <= dnum){
+    eprint(rdb, "(deferred)");
+    err = true;
+  }
+  if(!err){
+    TTSOCK *sock = opensock(host, port);
+    if(sock){
+      TCXSTR *xstr = tcxstrnew();
+      uint8_t magic[2];
+      magic[0] = TTMAGICNUM;
+      magic[1] = TTCMDMGET;
+      tcxstrcat(xstr, magic, sizeof(magic));
+      xstrcatint32(xstr, FRAMEMAXSIZ / FRAMEARGSIZ + 1);
+      bool sent = ttsocksend(sock, tcxstrptr(xstr), tcxstrsize(xstr));
+      tcxstrdel(xstr);
+      char *zbuf = tccalloc(1, FRAMEZBUFSIZ);
+      for(int i = 0; sent && i < FRAMEMAXSIZ / FRAMEARGSIZ; i++){
+        uint32_t num = TTHTONL((uint32_t)FRAMEARGSIZ);
+        sent = ttsocksend(sock, &num, sizeof(num));
+        for(int j = 0; sent && j < FRAMEARGSIZ / FRAMEZBUFSIZ; j++){
+          sent = ttsocksend(sock, zbuf, FRAMEZBUFSIZ);
+        }
+      }
+      tcfree(zbuf);
+      double wtime = tctime();
+      ttsocksetlife(sock, FRAMEWAITMAX);
+      if(ttsockgetc(sock) != -1 || tctime() - wtime >= FRAMEWAITMAX){
+        eprint(rdb, "(too large request)");
         err = true;
       }
+      closesock(sock);
+    } else {
+      eprint(rdb, "ttopensock");
+      err = true;
     }
+    iprintf("too large request: %s\n", err ? "accepted" : "rejected");
   }
-  iprintf("record number: %llu\n", (unsigned long long)tcrdbrnum(rdb));
-  iprintf("size: %llu\n", (unsigned long long)tcrdbsize(rdb));
-  for(int i = 0; i < tnum; i++){
-    if(!tcrdbclose(rdbs[i])){
-      eprint(rdbs[i], "tcrdbclose");
+  if(!err && tout > 0){
+    TTSOCK *sock = opensock(host, port);
+    if(sock){
+      TCXSTR *xstr = tcxstrnew();
+      uint8_t magic[2];
+      magic[0] = TTMAGICNUM;
+      magic[1] = TTCMDPUT;
+      tcxstrcat(xstr, magic, sizeof(magic));
+      xstrcatint32(xstr, 14);
+      xstrcatint32(xstr, 4);
+      tcxstrcat(xstr, "frame:timeout", 14);
+      tcxstrcat(xstr, "late", 4);
+      int half = tcxstrsize(xstr) / 2;
+      bool sent = ttsocksend(sock, tcxstrptr(xstr), half);
+      tcsleep(tout + 1.0);
+      if(sent) ttsocksend(sock, (char *)tcxstrptr(xstr) + half, tcxstrsize(xstr) - half);
+      tcxstrdel(xstr);
+      double wtime = tctime();
+      ttsocksetlife(sock, FRAMEWAITMAX);
+      if(ttsockgetc(sock) != -1 || tctime() - wtime >= FRAMEWAITMAX ||
+         tcrdbvsiz2(rdb, "frame:timeout") >= 0){
+        eprint(rdb, "(partial request timeout)");
+        err = true;
+      }
+      closesock(sock);
+    } else {
+      eprint(rdb, "ttopensock");
       err = true;
     }
-    tcrdbdel(rdbs[i]);
+    iprintf("partial request: %s\n", err ? "kept" : "timed out");
+  }
+  if(!tcrdbclose(rdb)){
+    eprint(rdb, "tcrdbclose");
+    err = true;
   }
+  tcrdbdel(rdb);
   iprintf("time: %.3f\n", tctime() - stime);
   iprintf("%s\n\n", err ? "error" : "ok");
   return err ? 1 : 0;
 }
 
 
+/* perform binary requests in chunks and check the responses */
+static bool chunkbin(TTSOCK *sock, const char *kbuf, int ksiz, const char *vbuf, int vsiz){
+  char abuf[RECBUFSIZ], bbuf[RECBUFSIZ], cbuf[RECBUFSIZ];
+  int asiz = sprintf(abuf, "%s:a", kbuf);
+  int bsiz = sprintf(bbuf, "%s:b", kbuf);
+  int csiz = sprintf(cbuf, "%s:c", kbuf);
+  TCXSTR *xstr = tcxstrnew();
+  uint8_t magic[2];
+  magic[0] = TTMAGICNUM;
+  magic[1] = TTCMDPUT;
+  tcxstrcat(xstr, magic, sizeof(magic));
+  xstrcatint32(xstr, ksiz);
+  xstrcatint32(xstr, vsiz);
+  tcxstrcat(xstr, kbuf, ksiz);
+  tcxstrcat(xstr, vbuf, vsiz);
+  magic[1] = TTCMDBATCH;
+  tcxstrcat(xstr, magic, sizeof(magic));
+  xstrcatint32(xstr, 3);
+  uint8_t ocmds[] = { TTCMDPUT, TTCMDPUT, TTCMDOUT };
+  const char *okbufs[] = { abuf, bbuf, bbuf };
+  int oksizs[] = { asiz, bsiz, bsiz };
+  for(int i = 0; i < 3; i++){
+    int ovsiz = (ocmds[i] == TTCMDOUT) ? 0 : vsiz;
+    tcxstrcat(xstr, ocmds + i, sizeof(*ocmds));
+    xstrcatint32(xstr, oksizs[i]);
+    xstrcatint32(xstr, ovsiz);
+    tcxstrcat(xstr, okbufs[i], oksizs[i]);
+    tcxstrcat(xstr, vbuf, ovsiz);
+  }
+  magic[1] = TTCMDMGET;
+  tcxstrcat(xstr, magic, sizeof(magic));
+  xstrcatint32(xstr, 3);
+  const char *mkbufs[] = { kbuf, abuf, bbuf };
+  int mksizs[] = { ksiz, asiz, bsiz };
+  for(int i = 0; i < 3; i++){
+    xstrcatint32(xstr, mksizs[i]);
+    tcxstrcat(xstr, mkbufs[i], mksizs[i]);
+  }
+  const char *names[] = { "putlist", "getlist" };
+  for(int i = 0; i < 2; i++){
+    int nsiz = strlen(names[i]);
+    magic[1] = TTCMDMISC;
+    tcxstrcat(xstr, magic, sizeof(magic));
+    xstrcatint32(xstr, nsiz);
+    xstrcatint32(xstr, 0);
+    xstrcatint32(xstr, 2 - i);
+    tcxstrcat(xstr, names[i], nsiz);
+    xstrcatint32(xstr, csiz);
+    tcxstrcat(xstr, cbuf, csiz);
+    if(i == 0){
+      xstrcatint32(xstr, vsiz);
+      tcxstrcat(xstr, vbuf, vsiz);
+    }
+  }
+  magic[1] = TTCMDGET;
+  tcxstrcat(xstr, magic, sizeof(magic));
+  xstrcatint32(xstr, ksiz);
+  tcxstrcat(xstr, kbuf, ksiz);
+  bool err = !sendchunks(sock, tcxstrptr(xstr), tcxstrsize(xstr));
+  tcxstrdel(xstr);
+  if(!err && ttsockgetc(sock) != 0) err = true;
+  if(!err && (ttsockgetc(sock) != 0 || ttsockgetint32(sock) != 3)) err = true;
+  for(int i = 0; !err && i < 3; i++){
+    int code = ttsockgetc(sock);
+    ttsockgetint32(sock);
+    if(code != 0 || ttsockcheckend(sock)) err = true;
+  }
+  if(!err && (ttsockgetc(sock) != 0 || ttsockgetint32(sock) != 2)) err = true;
+  for(int i = 0; !err && i < 2; i++){
+    char rbuf[RECBUFSIZ*2];
+    int rksiz = ttsockgetint32(sock);
+    int rvsiz = ttsockgetint32(sock);
+    if(ttsockcheckend(sock) || rksiz < 0 || rvsiz < 0 || rksiz + rvsiz > (int)sizeof(rbuf) ||
+       !ttsockrecv(sock, rbuf, rksiz + rvsiz)){
+      err = true;
+    } else if(!(rksiz == ksiz && !memcmp(rbuf, kbuf, ksiz)) &&
+              !(rksiz == asiz && !memcmp(rbuf, abuf, asiz))){
+      err = true;
+    } else if(rvsiz != vsiz || memcmp(rbuf + rksiz, vbuf, vsiz)){
+      err = true;
+    }
+  }
+  if(!err && (ttsockgetc(sock) != 0 || ttsockgetint32(sock) != 0)) err = true;
+  if(!err && (ttsockgetc(sock) != 0 || ttsockgetint32(sock) != 2 ||
+              !recvelem(sock, cbuf, csiz) || !recvelem(sock, vbuf, vsiz))) err = true;
+  if(!err && (ttsockgetc(sock) != 0 || !recvelem(sock, vbuf, vsiz))) err = true;
+  return !err;
+}
+
+
+/* perform memcached requests in chunks and check the responses */
+static bool chunkmc(TTSOCK *sock, const char *kbuf, int ksiz, const char *vbuf, int vsiz){
+  TCXSTR *xstr = tcxstrnew();
+  tcxstrprintf(xstr, "set %s 0 0 %d\r\n", kbuf, vsiz);
+  tcxstrcat(xstr, vbuf, vsiz);
+  tcxstrprintf(xstr, "\r\nget %s\r\n", kbuf);
+  bool err = !sendchunks(sock, tcxstrptr(xstr), tcxstrsize(xstr));
+  tcxstrdel(xstr);
+  char line[RECBUFSIZ*4];
+  char ebuf[RECBUFSIZ*4];
+  sprintf(ebuf, "VALUE %s 0 %d", kbuf, vsiz);
+  if(!err && (!ttsockgets(sock, line, sizeof(line)) || strcmp(line, "STORED"))) err = true;
+  if(!err && (!ttsockgets(sock, line, sizeof(line)) || strcmp(line, ebuf))) err = true;
+  if(!err && (!ttsockgets(sock, line, sizeof(line)) || (int)strlen(line) != vsiz ||
+              memcmp(line, vbuf, vsiz))) err = true;
+  if(!err && (!ttsockgets(sock, line, sizeof(line)) || strcmp(line, "END"))) err = true;
+  return !err;
+}
+
+
+/* perform HTTP requests in chunks and check the responses */
+static bool chunkhttp(TTSOCK *sock, const char *kbuf, int ksiz, const char *vbuf, int vsiz){
+  TCXSTR *xstr = tcxstrnew();
+  tcxstrprintf(xstr, "PUT /%s HTTP/1.1\r\nContent-Length: %d\r\n\r\n", kbuf, vsiz);
+  tcxstrcat(xstr, vbuf, vsiz);
+  tcxstrprintf(xstr, "GET /%s HTTP/1.1\r\n\r\n", kbuf);
+  bool err = !sendchunks(sock, tcxstrptr(xstr), tcxstrsize(xstr));
+  tcxstrdel(xstr);
+  char bbuf[RECBUFSIZ*4];
+  int bsiz;
+  if(!err && recvhttp(sock, bbuf, sizeof(bbuf), &bsiz) != 201) err = true;
+  if(!err && (recvhttp(sock, bbuf, sizeof(bbuf), &bsiz) != 200 || bsiz != vsiz ||
+              memcmp(bbuf, vbuf, vsiz))) err = true;
+  return !err;
+}
+
+
 /* thread the write function */
 static void *threadwrite(void *targ){
   TCRDB *rdb = ((TARGWRITE *)targ)->rdb;
@@ -547,4 +2799,522 @@ static void *threadremove(void *targ){
 
 
 
+/* thread the bench function */
+static void *threadbench(void *targ){
+  TCRDB **rdbs = ((TARGBENCH *)targ)->rdbs;
+  int cnum = ((TARGBENCH *)targ)->cnum;
+  int rnum = ((TARGBENCH *)targ)->rnum;
+  double *lats = ((TARGBENCH *)targ)->lats;
+  int vsiz = ((TARGBENCH *)targ)->vsiz;
+  int id = ((TARGBENCH *)targ)->id;
+  bool err = false;
+  char *lbuf = NULL;
+  if(vsiz > 0){
+    lbuf = tcmalloc(vsiz);
+    for(int i = 0; i < vsiz; i++){
+      lbuf[i] = 'A' + i % 26;
+    }
+  }
+  int64_t bsum = 0;
+  int base = id * rnum;
+  for(int i = 1; i <= rnum && !err; i++){
+    TCRDB *rdb = rdbs[i % cnum];
+    char kbuf[RECBUFSIZ];
+    int ksiz = lbuf ? sprintf(kbuf, "bench:%d:%08d", vsiz, base + myrand(i) + 1) :
+      sprintf(kbuf, "%08d", base + myrand(i) + 1);
+    double stime = tctime();
+    if(i % 2 == 1){
+      if(!tcrdbput(rdb, kbuf, ksiz, lbuf ? lbuf : kbuf, lbuf ? vsiz : ksiz)){
+        eprint(rdb, "tcrdbput");
+        err = true;
+        break;
+      }
+      if(lbuf) bsum += vsiz;
+    } else {
+      int rsiz;
+      char *vbuf = tcrdbget(rdb, kbuf, ksiz, &rsiz);
+      if(!vbuf && tcrdbecode(rdb) != TTENOREC){
+        eprint(rdb, "tcrdbget");
+        err = true;
+        break;
+      }
+      if(vbuf && lbuf){
+        if(rsiz != vsiz || memcmp(vbuf, lbuf, vsiz)){
+          eprint(rdb, "(validation)");
+          err = true;
+        }
+        bsum += rsiz;
+      }
+      tcfree(vbuf);
+    }
+    lats[i - 1] = tctime() - stime;
+    if(id == 0 && rnum > 250 && i % (rnum / 250) == 0){
+      putchar('.');
+      fflush(stdout);
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  tcfree(lbuf);
+  ((TARGBENCH *)targ)->bsum = bsum;
+  return err ? "error" : NULL;
+}
+
+
+
+/* thread the batch function */
+static void *threadbatch(void *targ){
+  TCRDB *rdb = ((TARGBATCH *)targ)->rdb;
+  int rnum = ((TARGBATCH *)targ)->rnum;
+  int id = ((TARGBATCH *)targ)->id;
+  bool err = false;
+  RDBBATCH *batch = tcrdbbatchnew(rdb);
+  int sums[BATCHCNTNUM];
+  memset(sums, 0, sizeof(sums));
+  for(int i = 1; i <= rnum; i++){
+    tcrdbbatchclear(batch);
+    char kbuf[RECBUFSIZ];
+    int ksiz;
+    for(int j = 0; j < BATCHCNTNUM; j++){
+      ksiz = sprintf(kbuf, "batch:cnt:%d", j);
+      tcrdbbatchaddint(batch, kbuf, ksiz, 1);
+    }
+    ksiz = sprintf(kbuf, "batch:rec:%d:%08d", id, i);
+    tcrdbbatchput(batch, kbuf, ksiz, kbuf, ksiz);
+    tcrdbbatchputkeep(batch, kbuf, ksiz, kbuf, ksiz);
+    ksiz = sprintf(kbuf, "batch:rec:%d:%08d", id, i - 1);
+    tcrdbbatchout(batch, kbuf, ksiz);
+    if(tcrdbbatchrun(batch) || tcrdbecode(rdb) != TTEMISC ||
+       tcrdbbatchnum(batch) != BATCHCNTNUM + 3){
+      eprint(rdb, "tcrdbbatchrun");
+      err = true;
+      break;
+    }
+    for(int j = 0; j < BATCHCNTNUM; j++){
+      int sum;
+      if(!tcrdbbatchresult(batch, j, &sum) || sum <= sums[j]){
+        eprint(rdb, "tcrdbbatchresult");
+        err = true;
+        break;
+      }
+      sums[j] = sum;
+    }
+    if(err) break;
+    if(!tcrdbbatchresult(batch, BATCHCNTNUM, NULL) ||
+       tcrdbbatchresult(batch, BATCHCNTNUM + 1, NULL) ||
+       tcrdbbatchresult(batch, BATCHCNTNUM + 2, NULL) != (i > 1)){
+      eprint(rdb, "tcrdbbatchresult");
+      err = true;
+      break;
+    }
+    if(id == 0 && rnum > 250 && i % (rnum / 250) == 0){
+      putchar('.');
+      fflush(stdout);
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  tcrdbbatchdel(batch);
+  return err ? "error" : NULL;
+}
+
+
+
+/* thread the iter function */
+static void *threaditer(void *targ){
+  TCRDB *rdb = ((TARGITER *)targ)->rdb;
+  int rnum = ((TARGITER *)targ)->rnum;
+  int id = ((TARGITER *)targ)->id;
+  bool err = false;
+  TCMAP *recs = tcmapnew();
+  if(!tcrdbiterinit(rdb)){
+    eprint(rdb, "tcrdbiterinit");
+    err = true;
+  }
+  int cnt = 0;
+  while(!err){
+    int max = myrand(ITERPAGEMAX) + 1;
+    TCLIST *res = tcrdbiterpage(rdb, max);
+    if(!res){
+      eprint(rdb, "tcrdbiterpage");
+      err = true;
+      break;
+    }
+    int num = tclistnum(res);
+    if(num % 2 != 0 || num > max * 2){
+      eprint(rdb, "(validation)");
+      err = true;
+    }
+    for(int i = 0; !err && i < num; i += 2){
+      int ksiz, vsiz;
+      const char *kbuf = tclistval(res, i, &ksiz);
+      const char *vbuf = tclistval(res, i + 1, &vsiz);
+      if(ksiz != vsiz || memcmp(kbuf, vbuf, ksiz) || !tcmapputkeep(recs, kbuf, ksiz, "", 0)){
+        eprint(rdb, "(validation)");
+        err = true;
+      }
+    }
+    tclistdel(res);
+    if(num < 1) break;
+    int ksiz;
+    char *kbuf = tcrdbiternext(rdb, &ksiz);
+    if(kbuf){
+      if(!tcmapputkeep(recs, kbuf, ksiz, "", 0)){
+        eprint(rdb, "(validation)");
+        err = true;
+      }
+      tcfree(kbuf);
+    } else if(tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "tcrdbiternext");
+      err = true;
+    }
+    if(id == 0 && ++cnt % 10 == 0){
+      putchar('.');
+      fflush(stdout);
+    }
+  }
+  if(!err && tcmaprnum(recs) != rnum){
+    eprint(rdb, "(validation)");
+    err = true;
+  }
+  if(id == 0) iprintf(" (%08d)\n", (int)tcmaprnum(recs));
+  tcmapdel(recs);
+  return err ? "error" : NULL;
+}
+
+
+
+/* thread the cas function */
+static void *threadcas(void *targ){
+  TCRDB *rdb = ((TARGCAS *)targ)->rdb;
+  int rnum = ((TARGCAS *)targ)->rnum;
+  int id = ((TARGCAS *)targ)->id;
+  bool err = false;
+  int cnum = 0;
+  for(int i = 1; i <= rnum; i++){
+    while(true){
+      int vsiz;
+      uint64_t ver;
+      char *vbuf = tcrdbgets(rdb, "cas:counter", 11, &vsiz, &ver);
+      if(!vbuf){
+        eprint(rdb, "tcrdbgets");
+        err = true;
+        break;
+      }
+      char nbuf[RECBUFSIZ];
+      int nsiz = sprintf(nbuf, "%d", (int)tcatoi(vbuf) + 1);
+      tcfree(vbuf);
+      if(tcrdbcas(rdb, "cas:counter", 11, nbuf, nsiz, ver, NULL)) break;
+      if(tcrdbecode(rdb) != TTEKEEP){
+        eprint(rdb, "tcrdbcas");
+        err = true;
+        break;
+      }
+      cnum++;
+    }
+    if(err) break;
+    if(id == 0 && rnum > 250 && i % (rnum / 250) == 0){
+      putchar('.');
+      fflush(stdout);
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  ((TARGCAS *)targ)->cnum = cnum;
+  return err ? "error" : NULL;
+}
+
+
+
+/* thread the cache function */
+static void *threadcache(void *targ){
+  TCRDB *rdb = ((TARGCACHE *)targ)->rdb;
+  TCRDB *rrdb = ((TARGCACHE *)targ)->rrdb;
+  int rnum = ((TARGCACHE *)targ)->rnum;
+  int id = ((TARGCACHE *)targ)->id;
+  bool err = false;
+  TCMAP *recs = tcmapnew();
+  RDBBATCH *batch = tcrdbbatchnew(rdb);
+  for(int i = 1; i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "cache:%d:%d", id, myrand(CACHEKEYNUM));
+    char vbuf[RECBUFSIZ];
+    int vsiz = sprintf(vbuf, "%d", i);
+    int ovsiz;
+    const char *ovbuf = tcmapget(recs, kbuf, ksiz, &ovsiz);
+    bool ok = true;
+    switch(myrand(8)){
+    case 0:
+      ok = tcrdbput(rdb, kbuf, ksiz, vbuf, vsiz);
+      if(ok) tcmapput(recs, kbuf, ksiz, vbuf, vsiz);
+      break;
+    case 1:
+      ok = tcrdbputcat(rdb, kbuf, ksiz, vbuf, vsiz);
+      if(ok) tcmapputcat(recs, kbuf, ksiz, vbuf, vsiz);
+      break;
+    case 2:
+      ok = tcrdbout(rdb, kbuf, ksiz) || (!ovbuf && tcrdbecode(rdb) == TTENOREC);
+      if(ok) tcmapout(recs, kbuf, ksiz);
+      break;
+    case 3:
+      tcrdbbatchclear(batch);
+      tcrdbbatchput(batch, kbuf, ksiz, vbuf, vsiz);
+      ok = tcrdbbatchrun(batch);
+      if(ok) tcmapput(recs, kbuf, ksiz, vbuf, vsiz);
+      break;
+    case 4: {
+      TCLIST *args = tclistnew2(2);
+      tclistpush(args, kbuf, ksiz);
+      if(ovbuf){
+        TCLIST *res = tcrdbmisc(rdb, "outlist", 0, args);
+        if(res){
+          tclistdel(res);
+          tcmapout(recs, kbuf, ksiz);
+        } else {
+          ok = false;
+        }
+      } else {
+        tclistpush(args, vbuf, vsiz);
+        TCLIST *res = tcrdbmisc(rdb, "putlist", 0, args);
+        if(res){
+          tclistdel(res);
+          tcmapput(recs, kbuf, ksiz, vbuf, vsiz);
+        } else {
+          ok = false;
+        }
+      }
+      tclistdel(args);
+      break;
+    }
+    default: {
+      int rvsiz;
+      char *rvbuf = tcrdbget(rrdb, kbuf, ksiz, &rvsiz);
+      if(rvbuf){
+        ok = ovbuf && rvsiz == ovsiz && !memcmp(rvbuf, ovbuf, ovsiz);
+        tcfree(rvbuf);
+      } else {
+        ok = !ovbuf && tcrdbecode(rrdb) == TTENOREC;
+      }
+      break;
+    }
+    }
+    if(!ok){
+      eprint(rdb, "(validation)");
+      err = true;
+      break;
+    }
+    if(id == 0 && rnum > 250 && i % (rnum / 250) == 0){
+      putchar('.');
+      fflush(stdout);
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  tcrdbbatchdel(batch);
+  for(int i = 0; !err && i < CACHEKEYNUM; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "cache:%d:%d", id, i);
+    int vsiz, rvsiz;
+    const char *vbuf = tcmapget(recs, kbuf, ksiz, &vsiz);
+    char *rvbuf = tcrdbget(rrdb, kbuf, ksiz, &rvsiz);
+    if(vbuf ? !rvbuf || rvsiz != vsiz || memcmp(rvbuf, vbuf, vsiz) : rvbuf != NULL){
+      eprint(rrdb, "(validation)");
+      err = true;
+    }
+    tcfree(rvbuf);
+  }
+  tcmapdel(recs);
+  return err ? "error" : NULL;
+}
+
+
+
+/* thread the shed function */
+static void *threadshed(void *targ){
+  TCRDB *rdb = ((TARGSHED *)targ)->rdb;
+  const char *host = ((TARGSHED *)targ)->host;
+  int port = ((TARGSHED *)targ)->port;
+  int rnum = ((TARGSHED *)targ)->rnum;
+  int64_t *busy = ((TARGSHED *)targ)->busy;
+  int id = ((TARGSHED *)targ)->id;
+  bool err = false;
+  TTSOCK *socks[2];
+  for(int i = 0; i < 2; i++){
+    socks[i] = opensock(host, port);
+    if(!socks[i]){
+      eprint(rdb, "ttopensock");
+      err = true;
+    }
+  }
+  TTSOCK *mcsock = socks[0];
+  TTSOCK *htsock = socks[1];
+  TCMAP *recs = tcmapnew();
+  TCMAP *sheds = tcmapnew();
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "shed:%d:%d", id, i);
+    char vbuf[RECBUFSIZ];
+    int vsiz = sprintf(vbuf, "%d", i);
+    int kind = i % (SHEDKINDNUM + 2);
+    bool ok = true;
+    bool shed = false;
+    switch(kind){
+    case 0:
+      if(tcrdbput(rdb, kbuf, ksiz, vbuf, vsiz)){
+        tcmapput(recs, kbuf, ksiz, vbuf, vsiz);
+      } else {
+        shed = tcrdbecode(rdb) == TTEBUSY;
+        ok = shed;
+      }
+      break;
+    case 1: {
+      TCMAP *mrecs = tcmapnew();
+      for(int j = 1; j <= 8 && j < i; j++){
+        char mkbuf[RECBUFSIZ];
+        int mksiz = sprintf(mkbuf, "shed:%d:%d", id, i - j);
+        tcmapput(mrecs, mkbuf, mksiz, "", 0);
+      }
+      if(tcrdbget3(rdb, mrecs)){
+        tcmapiterinit(mrecs);
+        int mksiz;
+        const char *mkbuf;
+        while(ok && (mkbuf = tcmapiternext(mrecs, &mksiz)) != NULL){
+          int mvsiz, ovsiz;
+          const char *mvbuf = tcmapiterval(mkbuf, &mvsiz);
+          const char *ovbuf = tcmapget(recs, mkbuf, mksiz, &ovsiz);
+          if(!ovbuf || ovsiz != mvsiz || memcmp(ovbuf, mvbuf, mvsiz)) ok = false;
+        }
+      } else {
+        shed = tcrdbecode(rdb) == TTEBUSY;
+        ok = shed;
+      }
+      tcmapdel(mrecs);
+      break;
+    }
+    case 2: {
+      char pbuf[RECBUFSIZ];
+      int psiz = sprintf(pbuf, "shed:%d:", id);
+      TCLIST *res = tcrdbfwmrecs(rdb, pbuf, psiz, NULL, 0, 8, 0, NULL, NULL);
+      if(res){
+        for(int j = 0; ok && j < tclistnum(res) - 1; j += 2){
+          int rksiz, rvsiz, ovsiz;
+          const char *rkbuf = tclistval(res, j, &rksiz);
+          const char *rvbuf = tclistval(res, j + 1, &rvsiz);
+          const char *ovbuf = tcmapget(recs, rkbuf, rksiz, &ovsiz);
+          if(!ovbuf || ovsiz != rvsiz || memcmp(ovbuf, rvbuf, rvsiz)) ok = false;
+        }
+        tclistdel(res);
+      } else {
+        shed = tcrdbecode(rdb) == TTEBUSY;
+        ok = shed;
+      }
+      break;
+    }
+    case 3: {
+      TCLIST *args = tclistnew2(2);
+      tclistpush(args, kbuf, ksiz);
+      tclistpush(args, vbuf, vsiz);
+      TCLIST *res = tcrdbmisc(rdb, "putlist", 0, args);
+      if(res){
+        tclistdel(res);
+        tcmapput(recs, kbuf, ksiz, vbuf, vsiz);
+      } else {
+        shed = tcrdbecode(rdb) == TTEBUSY;
+        ok = shed;
+      }
+      tclistdel(args);
+      break;
+    }
+    case 4: {
+      char line[RECBUFSIZ*4];
+      int len = sprintf(line, "set %s 0 0 %d\r\n%s\r\n", kbuf, vsiz, vbuf);
+      if(ttsocksend(mcsock, line, len) && ttsockgets(mcsock, line, sizeof(line))){
+        if(!strcmp(line, "STORED")){
+          tcmapput(recs, kbuf, ksiz, vbuf, vsiz);
+        } else {
+          shed = !strcmp(line, "SERVER_ERROR busy");
+          ok = shed;
+        }
+      } else {
+        ok = false;
+      }
+      break;
+    }
+    case 5: {
+      char line[RECBUFSIZ*4];
+      int len = sprintf(line, "PUT /%s HTTP/1.1\r\nContent-Length: %d\r\n\r\n%s",
+                        kbuf, vsiz, vbuf);
+      int bsiz;
+      int code = ttsocksend(htsock, line, len) ? recvhttp(htsock, line, sizeof(line), &bsiz) : -1;
+      if(code == 201){
+        tcmapput(recs, kbuf, ksiz, vbuf, vsiz);
+      } else {
+        shed = code == 503;
+        ok = shed;
+      }
+      break;
+    }
+    case 6: {
+      ksiz = sprintf(kbuf, "shed:%d:%d", id, i - 6);
+      int ovsiz, rvsiz;
+      const char *ovbuf = tcmapget(recs, kbuf, ksiz, &ovsiz);
+      char *rvbuf = tcrdbget(rdb, kbuf, ksiz, &rvsiz);
+      if(rvbuf){
+        ok = ovbuf && rvsiz == ovsiz && !memcmp(rvbuf, ovbuf, ovsiz);
+        tcfree(rvbuf);
+      } else {
+        ok = !ovbuf && tcrdbecode(rdb) == TTENOREC;
+      }
+      break;
+    }
+    default: {
+      char *status = tcrdbstat(rdb);
+      if(status){
+        tcfree(status);
+      } else {
+        ok = false;
+      }
+      break;
+    }
+    }
+    if(shed){
+      busy[kind]++;
+      if(kind != 1 && kind != 2) tcmapput(sheds, kbuf, ksiz, "", 0);
+    }
+    if(!ok){
+      eprint(rdb, "(validation)");
+      err = true;
+    }
+    if(id == 0 && rnum > 250 && i % (rnum / 250) == 0){
+      putchar('.');
+      fflush(stdout);
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  tcmapiterinit(recs);
+  const char *kbuf;
+  int ksiz;
+  while(!err && (kbuf = tcmapiternext(recs, &ksiz)) != NULL){
+    int vsiz, rvsiz;
+    const char *vbuf = tcmapiterval(kbuf, &vsiz);
+    char *rvbuf = tcrdbget(rdb, kbuf, ksiz, &rvsiz);
+    if(!rvbuf || rvsiz != vsiz || memcmp(rvbuf, vbuf, vsiz)){
+      eprint(rdb, "(validation)");
+      err = true;
+    }
+    tcfree(rvbuf);
+  }
+  tcmapiterinit(sheds);
+  while(!err && (kbuf = tcmapiternext(sheds, &ksiz)) != NULL){
+    if(tcrdbvsiz(rdb, kbuf, ksiz) >= 0 || tcrdbecode(rdb) != TTENOREC){
+      eprint(rdb, "(load shedding)");
+      err = true;
+    }
+  }
+  tcmapdel(sheds);
+  tcmapdel(recs);
+  for(int i = 0; i < 2; i++){
+    closesock(socks[i]);
+  }
+  return err ? "error" : NULL;
+}
+
+
+
 // END OF FILE
@@ -16,14 +16,26 @@
 
 #include "ttutil.h"
 #include "tculog.h"
+#include "ttpriv.h"
 #include "myconf.h"
 
 #define TCULAIOCBNUM   64                // number of AIO tasks
 #define TCREPLTIMEO    5.0               // timeout of the replication socket
+#define TCULHEADSIZ    (sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t) * 2)
+                                         // size of the header of each record
 
 
 /* private function prototypes */
+static unsigned char *tculogsethead(unsigned char *wp, uint64_t ts, uint32_t sid, int size);
+static bool tculogappend(TCULOG *ulog, const void *buf, int size);
+static int tculogopsiz(const TCULOP *op);
+static unsigned char *tculogsetop(unsigned char *wp, const TCULOP *op);
+static void tculogmisckeys(TCULOG *ulog, const char *name, const TCLIST *args,
+                           void (*proc)(TCULOG *, const char *, int, int64_t));
+static void tculogcacheproc(TCULOG *ulog, const char *kbuf, int ksiz, int64_t xt);
+static void tculogmodproc(TCULOG *ulog, const char *kbuf, int ksiz, int64_t xt);
 static bool tculogflushaiocbp(struct aiocb *aiocbp);
+static int tcreplconnect(TCREPL *repl, const char *addr, int port, uint64_t ts, uint32_t sid);
 
 
 
@@ -49,6 +61,10 @@ TCULOG *tculognew(void){
   ulog->aiocbs = NULL;
   ulog->aiocbi = 0;
   ulog->aioend = 0;
+  ulog->bloom = NULL;
+  ulog->cache = NULL;
+  ulog->mod = NULL;
+  ulog->modopq = NULL;
   return ulog;
 }
 
@@ -86,6 +102,28 @@ bool tculogsetaio(TCULOG *ulog){
 }
 
 
+/* Set the Bloom filter of an update log object. */
+void tculogsetbloom(TCULOG *ulog, TTBLOOM *bloom){
+  assert(ulog);
+  ulog->bloom = bloom;
+}
+
+
+/* Set the record cache of an update log object. */
+void tculogsetcache(TCULOG *ulog, TTCACHE *cache){
+  assert(ulog);
+  ulog->cache = cache;
+}
+
+
+/* Set the hook of modified records of an update log object. */
+void tculogsetmod(TCULOG *ulog, void (*mod)(void *, const void *, int, int, int64_t), void *opq){
+  assert(ulog);
+  ulog->mod = mod;
+  ulog->modopq = opq;
+}
+
+
 /* Open files of an update log object. */
 bool tculogopen(TCULOG *ulog, const char *base, uint64_t limsiz){
   assert(ulog && base);
@@ -194,101 +232,48 @@ bool tculogwrite(TCULOG *ulog, uint64_t ts, uint32_t sid, const void *ptr, int s
   assert(ulog && ptr && size >= 0);
   if(!ulog->base) return false;
   if(ts < 1) ts = (uint64_t)(tctime() * 1000000);
+  int rsiz = TCULHEADSIZ + size;
   bool err = false;
-  if(pthread_rwlock_wrlock(&ulog->rwlck) != 0) return false;
-  pthread_cleanup_push((void (*)(void *))pthread_rwlock_unlock, &ulog->rwlck);
-  if(ulog->fd == -1){
-    char *path = tcsprintf("%s/%08d%s", ulog->base, ulog->max, TCULSUFFIX);
-    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 00644);
-    tcfree(path);
-    struct stat sbuf;
-    if(fd != -1 && fstat(fd, &sbuf) == 0){
-      ulog->fd = fd;
-      ulog->size = sbuf.st_size;
-    } else {
-      err = true;
-    }
-  }
-  int rsiz = sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t) * 2 + size;
   unsigned char stack[TTIOBUFSIZ];
   unsigned char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz);
   pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
-  unsigned char *wp = buf;
-  *(wp++) = TCULMAGICNUM;
-  uint64_t llnum = TTHTONLL(ts);
-  memcpy(wp, &llnum, sizeof(llnum));
-  wp += sizeof(llnum);
-  uint32_t lnum = TTHTONL(sid);
-  memcpy(wp, &lnum, sizeof(lnum));
-  wp += sizeof(lnum);
-  lnum = TTHTONL(size);
-  memcpy(wp, &lnum, sizeof(lnum));
-  wp += sizeof(lnum);
+  unsigned char *wp = tculogsethead(buf, ts, sid, size);
   memcpy(wp, ptr, size);
-  if(ulog->fd != -1){
-    struct aiocb *aiocbs = (struct aiocb *)ulog->aiocbs;
-    if(aiocbs){
-      struct aiocb *aiocbp = aiocbs + ulog->aiocbi;
-      if(aiocbp->aio_buf){
-        off_t aioend = aiocbp->aio_offset + aiocbp->aio_nbytes;
-        if(tculogflushaiocbp(aiocbp)){
-          ulog->aioend = aioend;
-        } else {
-          err = true;
-        }
-      }
-      aiocbp->aio_fildes = ulog->fd;
-      aiocbp->aio_offset = ulog->size;
-      aiocbp->aio_buf = tcmemdup(buf, rsiz);
-      aiocbp->aio_nbytes = rsiz;
-      while(aio_write(aiocbp) != 0){
-        if(errno != EAGAIN){
-          tcfree((char *)aiocbp->aio_buf);
-          aiocbp->aio_buf = NULL;
-          err = true;
-          break;
-        }
-        for(int i = 0; i < TCULAIOCBNUM; i++){
-          if(i == ulog->aiocbi) continue;
-          if(!tculogflushaiocbp(aiocbs + i)){
-            err = true;
-            break;
-          }
-        }
-      }
-      ulog->aiocbi = (ulog->aiocbi + 1) % TCULAIOCBNUM;
-    } else {
-      if(!tcwrite(ulog->fd, buf, rsiz)) err = true;
-    }
-    if(!err){
-      ulog->size += rsiz;
-      if(ulog->size >= ulog->limsiz){
-        if(aiocbs){
-          for(int i = 0; i < TCULAIOCBNUM; i++){
-            if(!tculogflushaiocbp(aiocbs + i)) err = true;
-          }
-          ulog->aiocbi = 0;
-          ulog->aioend = 0;
-        }
-        char *path = tcsprintf("%s/%08d%s", ulog->base, ulog->max + 1, TCULSUFFIX);
-        int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 00644);
-        tcfree(path);
-        if(fd != 0){
-          if(close(ulog->fd) != 0) err = true;
-          ulog->fd = fd;
-          ulog->size = 0;
-          ulog->max++;
-        } else {
-          err = true;
-        }
-      }
-      if(pthread_cond_broadcast(&ulog->cnd) != 0) err = true;
-    }
+  if(!tculogappend(ulog, buf, rsiz)) err = true;
+  pthread_cleanup_pop(1);
+  return !err;
+}
+
+
+/* Wait the next message is written into an update log object. */
+void tculogwait(TCULOG *ulog){
+  assert(ulog);
+  if(pthread_mutex_lock(&ulog->wmtx) != 0) return;
+  pthread_cleanup_push((void (*)(void *))pthread_mutex_unlock, &ulog->wmtx);
+  int ocs = PTHREAD_CANCEL_DISABLE;
+  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &ocs);
+  struct timeval tv;
+  struct timespec ts;
+  if(gettimeofday(&tv, NULL) == 0){
+    ts.tv_sec = tv.tv_sec + 1;
+    ts.tv_nsec = tv.tv_usec * 1000;
   } else {
-    err = true;
+    ts.tv_sec = (1ULL << (sizeof(time_t) * 8 - 1)) - 1;
+    ts.tv_nsec = 0;
   }
+  pthread_cond_timedwait(&ulog->cnd, &ulog->wmtx, &ts);
+  pthread_setcancelstate(ocs, NULL);
   pthread_cleanup_pop(1);
-  pthread_cleanup_pop(1);
+}
+
+
+/* Wake up every thread waiting for the next message of an update log object. */
+bool tculogwake(TCULOG *ulog){
+  assert(ulog);
+  if(pthread_mutex_lock(&ulog->wmtx) != 0) return false;
+  bool err = false;
+  if(pthread_cond_broadcast(&ulog->cnd) != 0) err = true;
+  if(pthread_mutex_unlock(&ulog->wmtx) != 0) err = true;
   return !err;
 }
 
@@ -360,23 +345,7 @@ void tculrddel(TCULRD *ulrd){
 /* Wait the next message is written. */
 void tculrdwait(TCULRD *ulrd){
   assert(ulrd);
-  TCULOG *ulog = ulrd->ulog;
-  if(pthread_mutex_lock(&ulog->wmtx) != 0) return;
-  pthread_cleanup_push((void (*)(void *))pthread_mutex_unlock, &ulog->wmtx);
-  int ocs = PTHREAD_CANCEL_DISABLE;
-  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &ocs);
-  struct timeval tv;
-  struct timespec ts;
-  if(gettimeofday(&tv, NULL) == 0){
-    ts.tv_sec = tv.tv_sec + 1;
-    ts.tv_nsec = tv.tv_usec * 1000;
-  } else {
-    ts.tv_sec = (1ULL << (sizeof(time_t) * 8 - 1)) - 1;
-    ts.tv_nsec = 0;
-  }
-  pthread_cond_timedwait(&ulog->cnd, &ulog->wmtx, &ts);
-  pthread_setcancelstate(ocs, NULL);
-  pthread_cleanup_pop(1);
+  tculogwait(ulrd->ulog);
 }
 
 
@@ -464,8 +433,11 @@ bool tculogadbput(TCULOG *ulog, uint32_t sid, TCADB *adb,
   assert(ulog && adb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
   bool err = false;
   int rmidx = tculogrmtxidx(ulog, kbuf, ksiz);
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODBEGIN, -1);
   bool dolog = tculogbegin(ulog, rmidx);
+  if(ulog->bloom) ttbloomadd(ulog->bloom, kbuf, ksiz);
   if(!tcadbput(adb, kbuf, ksiz, vbuf, vsiz)) err = true;
+  if(ulog->cache) ttcacheout(ulog->cache, kbuf, ksiz);
   if(dolog){
     unsigned char mstack[TTIOBUFSIZ];
     int msiz = sizeof(uint8_t) * 3 + sizeof(uint32_t) * 2 + ksiz + vsiz;
@@ -489,6 +461,7 @@ bool tculogadbput(TCULOG *ulog, uint32_t sid, TCADB *adb,
     if(mbuf != mstack) tcfree(mbuf);
     tculogend(ulog, rmidx);
   }
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODEND, err ? -1 : 0);
   return !err;
 }
 
@@ -499,8 +472,11 @@ bool tculogadbputkeep(TCULOG *ulog, uint32_t sid, TCADB *adb,
   assert(ulog && adb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
   bool err = false;
   int rmidx = tculogrmtxidx(ulog, kbuf, ksiz);
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODBEGIN, -1);
   bool dolog = tculogbegin(ulog, rmidx);
+  if(ulog->bloom) ttbloomadd(ulog->bloom, kbuf, ksiz);
   if(!tcadbputkeep(adb, kbuf, ksiz, vbuf, vsiz)) err = true;
+  if(ulog->cache) ttcacheout(ulog->cache, kbuf, ksiz);
   if(dolog){
     unsigned char mstack[TTIOBUFSIZ];
     int msiz = sizeof(uint8_t) * 3 + sizeof(uint32_t) * 2 + ksiz + vsiz;
@@ -524,6 +500,7 @@ bool tculogadbputkeep(TCULOG *ulog, uint32_t sid, TCADB *adb,
     if(mbuf != mstack) tcfree(mbuf);
     tculogend(ulog, rmidx);
   }
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODEND, err ? -1 : 0);
   return !err;
 }
 
@@ -534,8 +511,11 @@ bool tculogadbputcat(TCULOG *ulog, uint32_t sid, TCADB *adb,
   assert(ulog && adb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
   bool err = false;
   int rmidx = tculogrmtxidx(ulog, kbuf, ksiz);
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODBEGIN, -1);
   bool dolog = tculogbegin(ulog, rmidx);
+  if(ulog->bloom) ttbloomadd(ulog->bloom, kbuf, ksiz);
   if(!tcadbputcat(adb, kbuf, ksiz, vbuf, vsiz)) err = true;
+  if(ulog->cache) ttcacheout(ulog->cache, kbuf, ksiz);
   if(dolog){
     unsigned char mstack[TTIOBUFSIZ];
     int msiz = sizeof(uint8_t) * 3 + sizeof(uint32_t) * 2 + ksiz + vsiz;
@@ -559,6 +539,7 @@ bool tculogadbputcat(TCULOG *ulog, uint32_t sid, TCADB *adb,
     if(mbuf != mstack) tcfree(mbuf);
     tculogend(ulog, rmidx);
   }
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODEND, -1);
   return !err;
 }
 
@@ -568,8 +549,10 @@ bool tculogadbout(TCULOG *ulog, uint32_t sid, TCADB *adb, const void *kbuf, int
   assert(ulog && adb && kbuf && ksiz >= 0);
   bool err = false;
   int rmidx = tculogrmtxidx(ulog, kbuf, ksiz);
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODBEGIN, -1);
   bool dolog = tculogbegin(ulog, rmidx);
   if(!tcadbout(adb, kbuf, ksiz)) err = true;
+  if(ulog->cache) ttcacheout(ulog->cache, kbuf, ksiz);
   if(dolog){
     unsigned char mstack[TTIOBUFSIZ];
     int msiz = sizeof(uint8_t) * 3 + sizeof(uint32_t) + ksiz;
@@ -588,6 +571,7 @@ bool tculogadbout(TCULOG *ulog, uint32_t sid, TCADB *adb, const void *kbuf, int
     if(mbuf != mstack) tcfree(mbuf);
     tculogend(ulog, rmidx);
   }
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODEND, 0);
   return !err;
 }
 
@@ -596,8 +580,11 @@ bool tculogadbout(TCULOG *ulog, uint32_t sid, TCADB *adb, const void *kbuf, int
 int tculogadbaddint(TCULOG *ulog, uint32_t sid, TCADB *adb, const void *kbuf, int ksiz, int num){
   assert(ulog && adb && kbuf && ksiz >= 0);
   int rmidx = tculogrmtxidx(ulog, kbuf, ksiz);
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODBEGIN, -1);
   bool dolog = tculogbegin(ulog, rmidx);
+  if(ulog->bloom) ttbloomadd(ulog->bloom, kbuf, ksiz);
   int rnum = tcadbaddint(adb, kbuf, ksiz, num);
+  if(ulog->cache) ttcacheout(ulog->cache, kbuf, ksiz);
   if(dolog){
     unsigned char mstack[TTIOBUFSIZ];
     int msiz = sizeof(uint8_t) * 3 + sizeof(uint32_t) * 2 + ksiz;
@@ -619,6 +606,7 @@ int tculogadbaddint(TCULOG *ulog, uint32_t sid, TCADB *adb, const void *kbuf, in
     if(mbuf != mstack) tcfree(mbuf);
     tculogend(ulog, rmidx);
   }
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODEND, -1);
   return rnum;
 }
 
@@ -628,8 +616,11 @@ double tculogadbadddouble(TCULOG *ulog, uint32_t sid, TCADB *adb,
                           const void *kbuf, int ksiz, double num){
   assert(ulog && adb && kbuf && ksiz >= 0);
   int rmidx = tculogrmtxidx(ulog, kbuf, ksiz);
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODBEGIN, -1);
   bool dolog = tculogbegin(ulog, rmidx);
+  if(ulog->bloom) ttbloomadd(ulog->bloom, kbuf, ksiz);
   double rnum = tcadbadddouble(adb, kbuf, ksiz, num);
+  if(ulog->cache) ttcacheout(ulog->cache, kbuf, ksiz);
   if(dolog){
     unsigned char mstack[TTIOBUFSIZ];
     int msiz = sizeof(uint8_t) * 3 + sizeof(uint32_t) + sizeof(uint64_t) * 2 + ksiz;
@@ -650,6 +641,7 @@ double tculogadbadddouble(TCULOG *ulog, uint32_t sid, TCADB *adb,
     if(mbuf != mstack) tcfree(mbuf);
     tculogend(ulog, rmidx);
   }
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODEND, -1);
   return rnum;
 }
 
@@ -660,6 +652,7 @@ bool tculogadbvanish(TCULOG *ulog, uint32_t sid, TCADB *adb){
   bool err = false;
   bool dolog = tculogbegin(ulog, -1);
   if(!tcadbvanish(adb)) err = true;
+  if(ulog->cache) ttcacheclear(ulog->cache);
   if(dolog){
     unsigned char mbuf[sizeof(uint8_t)*3];
     unsigned char *wp = mbuf;
@@ -669,6 +662,7 @@ bool tculogadbvanish(TCULOG *ulog, uint32_t sid, TCADB *adb){
     if(!tculogwrite(ulog, 0, sid, mbuf, wp - mbuf)) err = true;
     tculogend(ulog, -1);
   }
+  if(ulog->mod) ulog->mod(ulog->modopq, "", -1, TCULMODTOUCH, 0);
   return !err;
 }
 
@@ -678,7 +672,9 @@ TCLIST *tculogadbmisc(TCULOG *ulog, uint32_t sid,
                       TCADB *adb, const char *name, const TCLIST *args){
   assert(ulog && adb && name && args);
   bool dolog = tculogbegin(ulog, -1);
+  tculogbloommisc(ulog, name, args);
   TCLIST *rv = tcadbmisc(adb, name, args);
+  tculogcachemisc(ulog, name, args);
   if(dolog){
     int nsiz = strlen(name);
     int anum = tclistnum(args);
@@ -719,10 +715,160 @@ TCLIST *tculogadbmisc(TCULOG *ulog, uint32_t sid,
     if(mbuf != mstack) tcfree(mbuf);
     tculogend(ulog, -1);
   }
+  tculogmodmisc(ulog, name, args);
   return rv;
 }
 
 
+/* Add the keys stored by a versatile function to the Bloom filter of an update log object. */
+void tculogbloommisc(TCULOG *ulog, const char *name, const TCLIST *args){
+  assert(ulog && name && args);
+  if(!ulog->bloom) return;
+  int anum = tclistnum(args);
+  if(!strcmp(name, "putlist")){
+    for(int i = 0; i < anum - 1; i += 2){
+      int ksiz;
+      const char *kbuf = tclistval(args, i, &ksiz);
+      ttbloomadd(ulog->bloom, kbuf, ksiz);
+    }
+  } else if(tcstrfwm(name, "put") && anum > 0){
+    int ksiz;
+    const char *kbuf = tclistval(args, 0, &ksiz);
+    ttbloomadd(ulog->bloom, kbuf, ksiz);
+  }
+}
+
+
+/* Remove the records modified by a versatile function from the record cache of an update log
+   object. */
+void tculogcachemisc(TCULOG *ulog, const char *name, const TCLIST *args){
+  assert(ulog && name && args);
+  if(!ulog->cache) return;
+  tculogmisckeys(ulog, name, args, tculogcacheproc);
+}
+
+
+/* Call the hook of the records modified by a versatile function of an update log object. */
+void tculogmodmisc(TCULOG *ulog, const char *name, const TCLIST *args){
+  assert(ulog && name && args);
+  if(!ulog->mod) return;
+  tculogmisckeys(ulog, name, args, tculogmodproc);
+}
+
+
+/* Record the expiration time of a record in an update log object. */
+bool tculogputxt(TCULOG *ulog, uint32_t sid, const void *kbuf, int ksiz, int64_t xt){
+  assert(ulog && kbuf && ksiz >= 0);
+  bool err = false;
+  int rmidx = tculogrmtxidx(ulog, kbuf, ksiz);
+  bool dolog = tculogbegin(ulog, rmidx);
+  if(dolog){
+    unsigned char mstack[TTIOBUFSIZ];
+    int msiz = sizeof(uint8_t) * 3 + sizeof(uint32_t) + sizeof(uint64_t) + ksiz;
+    unsigned char *mbuf = (msiz < TTIOBUFSIZ) ? mstack : tcmalloc(msiz + 1);
+    unsigned char *wp = mbuf;
+    *(wp++) = TTMAGICNUM;
+    *(wp++) = TTCMDPUTXT;
+    uint32_t lnum;
+    lnum = TTHTONL(ksiz);
+    memcpy(wp, &lnum, sizeof(lnum));
+    wp += sizeof(lnum);
+    uint64_t llnum;
+    llnum = TTHTONLL((uint64_t)xt);
+    memcpy(wp, &llnum, sizeof(llnum));
+    wp += sizeof(llnum);
+    memcpy(wp, kbuf, ksiz);
+    wp += ksiz;
+    *(wp++) = 0;
+    if(!tculogwrite(ulog, 0, sid, mbuf, msiz)) err = true;
+    if(mbuf != mstack) tcfree(mbuf);
+    tculogend(ulog, rmidx);
+  }
+  if(ulog->mod) ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODTOUCH, xt);
+  return !err;
+}
+
+
+/* Apply a batch of operations to an abstract database object. */
+bool tculogadbbatch(TCULOG *ulog, uint32_t sid, TCADB *adb, TCULOP *ops, int onum){
+  assert(ulog && adb && ops && onum >= 0);
+  uint32_t midxs = 0;
+  for(int i = 0; i < onum; i++){
+    midxs |= 1U << tculogrmtxidx(ulog, ops[i].kbuf, ops[i].ksiz);
+  }
+  bool dolog = true;
+  uint32_t locked = 0;
+  for(int i = 0; i < TCULRMTXNUM; i++){
+    if(!(midxs & (1U << i))) continue;
+    if(!tculogbegin(ulog, i)){
+      dolog = false;
+      break;
+    }
+    locked |= 1U << i;
+  }
+  bool err = false;
+  int64_t msiz = 0;
+  for(int i = 0; i < onum; i++){
+    TCULOP *op = ops + i;
+    op->rnum = INT_MIN;
+    if(ulog->bloom && op->cmd != TTCMDOUT) ttbloomadd(ulog->bloom, op->kbuf, op->ksiz);
+    switch(op->cmd){
+    case TTCMDPUT:
+      op->ok = tcadbput(adb, op->kbuf, op->ksiz, op->vbuf, op->vsiz);
+      break;
+    case TTCMDPUTKEEP:
+      op->ok = tcadbputkeep(adb, op->kbuf, op->ksiz, op->vbuf, op->vsiz);
+      break;
+    case TTCMDPUTCAT:
+      op->ok = tcadbputcat(adb, op->kbuf, op->ksiz, op->vbuf, op->vsiz);
+      break;
+    case TTCMDOUT:
+      op->ok = tcadbout(adb, op->kbuf, op->ksiz);
+      break;
+    case TTCMDADDINT:
+      op->rnum = tcadbaddint(adb, op->kbuf, op->ksiz, op->num);
+      op->ok = op->rnum != INT_MIN;
+      break;
+    default:
+      op->ok = false;
+      break;
+    }
+    if(ulog->cache) ttcacheout(ulog->cache, op->kbuf, op->ksiz);
+    if(!op->ok) err = true;
+    int osiz = tculogopsiz(op);
+    if(osiz > 0) msiz += TCULHEADSIZ + osiz;
+  }
+  if(dolog && msiz > 0){
+    if(msiz > INT_MAX){
+      err = true;
+    } else {
+      unsigned char *mbuf = tcmalloc(msiz);
+      unsigned char *wp = mbuf;
+      uint64_t ts = (uint64_t)(tctime() * 1000000);
+      for(int i = 0; i < onum; i++){
+        int osiz = tculogopsiz(ops + i);
+        if(osiz < 1) continue;
+        wp = tculogsethead(wp, ts, sid, osiz);
+        wp = tculogsetop(wp, ops + i);
+      }
+      if(!tculogappend(ulog, mbuf, msiz)) err = true;
+      tcfree(mbuf);
+    }
+  }
+  for(int i = TCULRMTXNUM - 1; i >= 0; i--){
+    if(locked & (1U << i)) tculogend(ulog, i);
+  }
+  if(ulog->mod){
+    for(int i = 0; i < onum; i++){
+      if(!ops[i].ok) continue;
+      int64_t xt = (ops[i].cmd == TTCMDPUTCAT || ops[i].cmd == TTCMDADDINT) ? -1 : 0;
+      ulog->mod(ulog->modopq, ops[i].kbuf, ops[i].ksiz, TCULMODTOUCH, xt);
+    }
+  }
+  return !err;
+}
+
+
 /* Restore an abstract database object. */
 bool tculogadbrestore(TCADB *adb, const char *path, uint64_t ts, bool con, TCULOG *ulog){
   assert(adb && path);
@@ -852,6 +998,21 @@ bool tculogadbredo(TCADB *adb, const char *ptr, int size, bool con, TCULOG *ulog
       err = true;
     }
     break;
+  case TTCMDPUTXT:
+    if(size >= sizeof(uint32_t) + sizeof(uint64_t)){
+      uint32_t ksiz;
+      memcpy(&ksiz, rp, sizeof(ksiz));
+      ksiz = TTNTOHL(ksiz);
+      rp += sizeof(ksiz);
+      uint64_t xt;
+      memcpy(&xt, rp, sizeof(xt));
+      xt = TTNTOHLL(xt);
+      rp += sizeof(xt);
+      if(!tculogputxt(ulog, sid, rp, ksiz, (int64_t)xt) && con) err = true;
+    } else {
+      err = true;
+    }
+    break;
   case TTCMDVANISH:
     if(size == 0){
       if(tculogadbvanish(ulog, sid, adb) != exp && con) err = true;
@@ -906,6 +1067,8 @@ TCREPL *tcreplnew(void){
   TCREPL *repl = tcmalloc(sizeof(*repl));
   repl->fd = -1;
   repl->sock = NULL;
+  repl->zcodec = TTZNONE;
+  repl->zthres = 0;
   return repl;
 }
 
@@ -924,27 +1087,20 @@ bool tcreplopen(TCREPL *repl, const char *host, int port, uint64_t ts, uint32_t
   if(repl->fd >= 0) return false;
   char addr[TTADDRBUFSIZ];
   if(!ttgethostaddr(host, addr)) return false;
-  int fd = ttopensock(addr, port);
-  if(fd == -1) return false;
-  unsigned char buf[TTIOBUFSIZ];
-  unsigned char *wp = buf;
-  *(wp++) = TTMAGICNUM;
-  *(wp++) = TTCMDREPL;
-  uint64_t llnum = TTHTONLL(ts);
-  memcpy(wp, &llnum, sizeof(llnum));
-  wp += sizeof(llnum);
-  uint64_t lnum = TTHTONL(sid);
-  memcpy(wp, &lnum, sizeof(lnum));
-  wp += sizeof(lnum);
-  repl->fd = fd;
-  repl->sock = ttsocknew(fd);
-  repl->rbuf = tcmalloc(TTIOBUFSIZ);
-  repl->rsiz = TTIOBUFSIZ;
-  if(!ttsocksend(repl->sock, buf, wp - buf)){
-    tcreplclose(repl);
-    return false;
+  int rv = tcreplconnect(repl, addr, port, ts, sid);
+  if(rv == 0 && repl->zcodec != TTZNONE){
+    repl->zcodec = TTZNONE;
+    rv = tcreplconnect(repl, addr, port, ts, sid);
   }
-  return true;
+  return rv > 0;
+}
+
+
+/* Set the compression of the stream of a replication object. */
+void tcreplsetcomp(TCREPL *repl, int codec, int thres){
+  assert(repl);
+  repl->zcodec = codec;
+  repl->zthres = thres;
 }
 
 
@@ -968,6 +1124,10 @@ const char *tcreplread(TCREPL *repl, int *sp, uint64_t *tsp, uint32_t *sidp){
   int ocs = PTHREAD_CANCEL_DISABLE;
   pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &ocs);
   ttsocksetlife(repl->sock, TCREPLTIMEO);
+  if(!ttsockexpand(repl->sock)){
+    pthread_setcancelstate(ocs, NULL);
+    return NULL;
+  }
   int c = ttsockgetc(repl->sock);
   if(c == TCULMAGICNOP){
     *sp = 0;
@@ -999,6 +1159,236 @@ const char *tcreplread(TCREPL *repl, int *sp, uint64_t *tsp, uint32_t *sidp){
 }
 
 
+/* Set the header of a record of an update log.
+   `wp' specifies the pointer to the region of the record.
+   `ts' specifies the time stamp of the record.
+   `sid' specifies the server ID of the record.
+   `size' specifies the size of the message of the record.
+   The return value is the pointer to the region of the message. */
+static unsigned char *tculogsethead(unsigned char *wp, uint64_t ts, uint32_t sid, int size){
+  *(wp++) = TCULMAGICNUM;
+  uint64_t llnum = TTHTONLL(ts);
+  memcpy(wp, &llnum, sizeof(llnum));
+  wp += sizeof(llnum);
+  uint32_t lnum = TTHTONL(sid);
+  memcpy(wp, &lnum, sizeof(lnum));
+  wp += sizeof(lnum);
+  lnum = TTHTONL(size);
+  memcpy(wp, &lnum, sizeof(lnum));
+  wp += sizeof(lnum);
+  return wp;
+}
+
+
+/* Append serialized records to an update log object.
+   `ulog' specifies the update log object.
+   `buf' specifies the pointer to the region of the records.
+   `size' specifies the size of the region.
+   If successful, the return value is true, else, it is false. */
+static bool tculogappend(TCULOG *ulog, const void *buf, int size){
+  bool err = false;
+  if(pthread_rwlock_wrlock(&ulog->rwlck) != 0) return false;
+  pthread_cleanup_push((void (*)(void *))pthread_rwlock_unlock, &ulog->rwlck);
+  if(ulog->fd == -1){
+    char *path = tcsprintf("%s/%08d%s", ulog->base, ulog->max, TCULSUFFIX);
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 00644);
+    tcfree(path);
+    struct stat sbuf;
+    if(fd != -1 && fstat(fd, &sbuf) == 0){
+      ulog->fd = fd;
+      ulog->size = sbuf.st_size;
+    } else {
+      err = true;
+    }
+  }
+  if(ulog->fd != -1){
+    struct aiocb *aiocbs = (struct aiocb *)ulog->aiocbs;
+    if(aiocbs){
+      struct aiocb *aiocbp = aiocbs + ulog->aiocbi;
+      if(aiocbp->aio_buf){
+        off_t aioend = aiocbp->aio_offset + aiocbp->aio_nbytes;
+        if(tculogflushaiocbp(aiocbp)){
+          ulog->aioend = aioend;
+        } else {
+          err = true;
+        }
+      }
+      aiocbp->aio_fildes = ulog->fd;
+      aiocbp->aio_offset = ulog->size;
+      aiocbp->aio_buf = tcmemdup(buf, size);
+      aiocbp->aio_nbytes = size;
+      while(aio_write(aiocbp) != 0){
+        if(errno != EAGAIN){
+          tcfree((char *)aiocbp->aio_buf);
+          aiocbp->aio_buf = NULL;
+          err = true;
+          break;
+        }
+        for(int i = 0; i < TCULAIOCBNUM; i++){
+          if(i == ulog->aiocbi) continue;
+          if(!tculogflushaiocbp(aiocbs + i)){
+            err = true;
+            break;
+          }
+        }
+      }
+      ulog->aiocbi = (ulog->aiocbi + 1) % TCULAIOCBNUM;
+    } else {
+      if(!tcwrite(ulog->fd, buf, size)) err = true;
+    }
+    if(!err){
+      ulog->size += size;
+      if(ulog->size >= ulog->limsiz){
+        if(aiocbs){
+          for(int i = 0; i < TCULAIOCBNUM; i++){
+            if(!tculogflushaiocbp(aiocbs + i)) err = true;
+          }
+          ulog->aiocbi = 0;
+          ulog->aioend = 0;
+        }
+        char *path = tcsprintf("%s/%08d%s", ulog->base, ulog->max + 1, TCULSUFFIX);
+        int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 00644);
+        tcfree(path);
+        if(fd != 0){
+          if(close(ulog->fd) != 0) err = true;
+          ulog->fd = fd;
+          ulog->size = 0;
+          ulog->max++;
+        } else {
+          err = true;
+        }
+      }
+      if(pthread_cond_broadcast(&ulog->cnd) != 0) err = true;
+    }
+  } else {
+    err = true;
+  }
+  pthread_cleanup_pop(1);
+  return !err;
+}
+
+
+/* Get the size of the message of an operation of a batch.
+   `op' specifies the operation object.
+   The return value is the size of the message or 0 if the command is not supported. */
+static int tculogopsiz(const TCULOP *op){
+  switch(op->cmd){
+  case TTCMDPUT:
+  case TTCMDPUTKEEP:
+  case TTCMDPUTCAT:
+    return sizeof(uint8_t) * 3 + sizeof(uint32_t) * 2 + op->ksiz + op->vsiz;
+  case TTCMDOUT:
+    return sizeof(uint8_t) * 3 + sizeof(uint32_t) + op->ksiz;
+  case TTCMDADDINT:
+    return sizeof(uint8_t) * 3 + sizeof(uint32_t) * 2 + op->ksiz;
+  }
+  return 0;
+}
+
+
+/* Serialize the message of an operation of a batch.
+   `wp' specifies the pointer to the region of the message.
+   `op' specifies the operation object whose result is set.
+   The return value is the pointer to the end of the message. */
+static unsigned char *tculogsetop(unsigned char *wp, const TCULOP *op){
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = op->cmd;
+  uint32_t lnum;
+  lnum = TTHTONL(op->ksiz);
+  memcpy(wp, &lnum, sizeof(lnum));
+  wp += sizeof(lnum);
+  switch(op->cmd){
+  case TTCMDPUT:
+  case TTCMDPUTKEEP:
+  case TTCMDPUTCAT:
+    lnum = TTHTONL(op->vsiz);
+    memcpy(wp, &lnum, sizeof(lnum));
+    wp += sizeof(lnum);
+    memcpy(wp, op->kbuf, op->ksiz);
+    wp += op->ksiz;
+    memcpy(wp, op->vbuf, op->vsiz);
+    wp += op->vsiz;
+    break;
+  case TTCMDADDINT:
+    lnum = TTHTONL(op->num);
+    memcpy(wp, &lnum, sizeof(lnum));
+    wp += sizeof(lnum);
+    memcpy(wp, op->kbuf, op->ksiz);
+    wp += op->ksiz;
+    break;
+  default:
+    memcpy(wp, op->kbuf, op->ksiz);
+    wp += op->ksiz;
+    break;
+  }
+  *(wp++) = op->ok ? 0 : 1;
+  return wp;
+}
+
+
+/* Process the records modified by a versatile function.
+   `ulog' specifies the update log object.
+   `name' specifies the name of the function.
+   `args' specifies a list object containing arguments.
+   `proc' specifies the function called for each modified record.  Its size is negative if the
+   modified records are not known by the arguments.  Its expiration time is 0 if the records are
+   replaced or removed as a whole, or negative if not. */
+static void tculogmisckeys(TCULOG *ulog, const char *name, const TCLIST *args,
+                           void (*proc)(TCULOG *, const char *, int, int64_t)){
+  assert(ulog && name && args && proc);
+  if(tcstrfwm(name, "get") || tcstrfwm(name, "iter")) return;
+  int anum = tclistnum(args);
+  if(!strcmp(name, "putlist") || !strcmp(name, "outlist")){
+    int step = strcmp(name, "putlist") ? 1 : 2;
+    for(int i = 0; i < anum; i += step){
+      int ksiz;
+      const char *kbuf = tclistval(args, i, &ksiz);
+      proc(ulog, kbuf, ksiz, 0);
+    }
+  } else if((tcstrfwm(name, "put") || !strcmp(name, "out")) && anum > 0){
+    int ksiz;
+    const char *kbuf = tclistval(args, 0, &ksiz);
+    proc(ulog, kbuf, ksiz, strcmp(name, "putcat") ? 0 : -1);
+  } else if(!strcmp(name, "search")){
+    for(int i = 0; i < anum; i++){
+      if(!strcmp(tclistval2(args, i), "out")){
+        proc(ulog, "", -1, -1);
+        break;
+      }
+    }
+  } else {
+    proc(ulog, "", -1, strcmp(name, "vanish") ? -1 : 0);
+  }
+}
+
+
+/* Remove a record modified by a versatile function from the record cache.
+   `ulog' specifies the update log object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.  If it is negative, the cache is cleared.
+   `xt' is ignored. */
+static void tculogcacheproc(TCULOG *ulog, const char *kbuf, int ksiz, int64_t xt){
+  assert(ulog && kbuf);
+  if(ksiz < 0){
+    ttcacheclear(ulog->cache);
+  } else {
+    ttcacheout(ulog->cache, kbuf, ksiz);
+  }
+}
+
+
+/* Call the hook of a record modified by a versatile function.
+   `ulog' specifies the update log object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.  If it is negative, every record is
+   regarded as modified.
+   `xt' specifies the expiration time passed to the hook. */
+static void tculogmodproc(TCULOG *ulog, const char *kbuf, int ksiz, int64_t xt){
+  assert(ulog && kbuf);
+  ulog->mod(ulog->modopq, kbuf, ksiz, TCULMODTOUCH, xt);
+}
+
+
 /* Flush a AIO task.
    `aiocbp' specifies the pointer to the AIO task object.
    If successful, the return value is true, else, it is false. */
@@ -1022,5 +1412,51 @@ static bool tculogflushaiocbp(struct aiocb *aiocbp){
 }
 
 
+/* Connect a replication object to the server and send the replication request.
+   `repl' specifies the replication object.
+   `addr' specifies the address of the server.
+   `port' specifies the port number.
+   `ts' specifies the beginning time stamp.
+   `sid' specifies the server ID of self messages.
+   The return value is 1 if successful, 0 if the server rejects the request, or -1 if the
+   connection fails.
+   If compression is specified, it is negotiated before the replication request. */
+static int tcreplconnect(TCREPL *repl, const char *addr, int port, uint64_t ts, uint32_t sid){
+  assert(repl && addr && port >= 0);
+  int fd = ttopensock(addr, port);
+  if(fd == -1) return -1;
+  unsigned char buf[TTIOBUFSIZ];
+  unsigned char *wp = buf;
+  if(repl->zcodec != TTZNONE){
+    *(wp++) = TTMAGICNUM;
+    *(wp++) = TTCMDCOMP;
+    uint32_t num = TTHTONL((uint32_t)repl->zcodec);
+    memcpy(wp, &num, sizeof(num));
+    wp += sizeof(num);
+    num = TTHTONL((uint32_t)repl->zthres);
+    memcpy(wp, &num, sizeof(num));
+    wp += sizeof(num);
+  }
+  *(wp++) = TTMAGICNUM;
+  *(wp++) = TTCMDREPL;
+  uint64_t llnum = TTHTONLL(ts);
+  memcpy(wp, &llnum, sizeof(llnum));
+  wp += sizeof(llnum);
+  uint64_t lnum = TTHTONL(sid);
+  memcpy(wp, &lnum, sizeof(lnum));
+  wp += sizeof(lnum);
+  repl->fd = fd;
+  repl->sock = ttsocknew(fd);
+  repl->rbuf = tcmalloc(TTIOBUFSIZ);
+  repl->rsiz = TTIOBUFSIZ;
+  if(!ttsocksend(repl->sock, buf, wp - buf) ||
+     (repl->zcodec != TTZNONE && ttsockgetc(repl->sock) != 0)){
+    tcreplclose(repl);
+    return 0;
+  }
+  return 1;
+}
+
+
 
 // END OF FILE
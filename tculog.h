@@ -61,6 +61,10 @@ typedef struct {                         /* type of structure for an update log
   void *aiocbs;                          /* AIO tasks */
   int aiocbi;                            /* index of AIO tasks */
   uint64_t aioend;                       /* end offset of AIO tasks */
+  void *bloom;                           /* Bloom filter of stored keys */
+  void *cache;                           /* cache of hot records */
+  void (*mod)(void *, const void *, int, int, int64_t);  /* hook of modified records */
+  void *modopq;                          /* opaque object of the hook of modified records */
 } TCULOG;
 
 typedef struct {                         /* type of structure for a log reader */
@@ -72,11 +76,24 @@ typedef struct {                         /* type of structure for a log reader *
   int rsiz;                              /* size of the record buffer */
 } TCULRD;
 
+typedef struct {                         /* type of structure for an operation of a batch */
+  int cmd;                               /* command ID */
+  const void *kbuf;                      /* pointer to the region of the key */
+  int ksiz;                              /* size of the region of the key */
+  const void *vbuf;                      /* pointer to the region of the value */
+  int vsiz;                              /* size of the region of the value */
+  int num;                               /* additional value of addint */
+  bool ok;                               /* whether the operation succeeded */
+  int rnum;                              /* summation of addint */
+} TCULOP;
+
 typedef struct {                         /* type of structure for a replication */
   int fd;                                /* file descriptor */
   TTSOCK *sock;                          /* socket object */
   char *rbuf;                            /* record buffer */
   int rsiz;                              /* size of the record buffer */
+  int zcodec;                            /* compression codec of the stream */
+  int zthres;                            /* threshold size of compression */
 } TCREPL;
 
 
@@ -143,6 +160,18 @@ bool tculogend(TCULOG *ulog, int idx);
 bool tculogwrite(TCULOG *ulog, uint64_t ts, uint32_t sid, const void *ptr, int size);
 
 
+/* Wait the next message is written into an update log object.
+   `ulog' specifies the update log object.
+   The waiting time is one second at most. */
+void tculogwait(TCULOG *ulog);
+
+
+/* Wake up every thread waiting for the next message of an update log object.
+   `ulog' specifies the update log object.
+   If successful, the return value is true, else, it is false. */
+bool tculogwake(TCULOG *ulog);
+
+
 /* Create a log reader object.
    `ulog' specifies the update log object.
    `ts' specifies the beginning timestamp.
@@ -277,6 +306,22 @@ TCLIST *tculogadbmisc(TCULOG *ulog, uint32_t sid,
                       TCADB *adb, const char *name, const TCLIST *args);
 
 
+/* Apply a batch of operations to an abstract database object.
+   `ulog' specifies the update log object.
+   `sid' specifies the server ID of the messages.
+   `adb' specifies the abstract database object.
+   `ops' specifies the array of the operations.  The command ID of each operation is one of
+   `TTCMDPUT', `TTCMDPUTKEEP', `TTCMDPUTCAT', `TTCMDOUT', and `TTCMDADDINT'.  An operation of
+   another command fails without any effect.  The members `ok' and `rnum' of each operation are
+   set by this function.
+   `onum' specifies the number of the operations.
+   If all of the operations succeed, the return value is true, else, it is false.
+   The records of all operations are locked during the batch and the messages are written into
+   the update log by one append.  Each message is the same as that of the single operation, so a
+   batch is redone as the sequence of its operations. */
+bool tculogadbbatch(TCULOG *ulog, uint32_t sid, TCADB *adb, TCULOP *ops, int onum);
+
+
 /* Restore an abstract database object.
    `adb' specifies the abstract database object.
    `path' specifies the path of the update log directory.
@@ -317,6 +362,18 @@ void tcrepldel(TCREPL *repl);
 bool tcreplopen(TCREPL *repl, const char *host, int port, uint64_t ts, uint32_t sid);
 
 
+/* Set the compression of the stream of a replication object.
+   `repl' specifies the replication object which is not opened.
+   `codec' specifies the compression codec: `TTZNONE' for no compression, `TTZDEFLATE' for
+   Deflate, `TTZBZIP' for BZIP2.
+   `thres' specifies the minimum size of a chunk of the stream to be compressed.  If it is not
+   more than 0, the default value of the server is specified.
+   The compression is negotiated with the server when the object is opened.  If the server
+   rejects it or does not know the negotiation, the object is reopened without compression and
+   the codec is reset to `TTZNONE', which can be checked with the member `zcodec'. */
+void tcreplsetcomp(TCREPL *repl, int codec, int thres);
+
+
 /* Close a remote database object.
    `rdb' specifies the remote database object.
    If successful, the return value is true, else, it is false. */
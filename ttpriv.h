@@ -0,0 +1,312 @@
+/*************************************************************************************************
+ * The private utilities of Tokyo Tyrant
+ *                                                      Copyright (C) 2006-2009 Mikio Hirabayashi
+ * This file is part of Tokyo Tyrant.
+ * Tokyo Tyrant is free software; you can redistribute it and/or modify it under the terms of
+ * the GNU Lesser General Public License as published by the Free Software Foundation; either
+ * version 2.1 of the License or any later version.  Tokyo Tyrant is distributed in the hope
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with Tokyo
+ * Tyrant; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307 USA.
+ *************************************************************************************************/
+
+
+/* This header is not installed.  The objects declared here are used by the server only and they
+   are held by the public structures as opaque pointers. */
+
+
+#ifndef _TTPRIV_H                        /* duplication check */
+#define _TTPRIV_H
+
+
+#include <ttutil.h>
+#include <tculog.h>
+
+
+
+/*************************************************************************************************
+ * buffer arenas, Bloom filters, and record caches
+ *************************************************************************************************/
+
+
+typedef struct {                         /* type of structure for a buffer arena */
+  void *chunks;                          /* list of chunks of small regions */
+  void *cur;                             /* current chunk */
+  size_t off;                            /* offset in the current chunk */
+  void *used;                            /* list of blocks of large regions in use */
+  void **frees;                          /* free lists of blocks of each size class */
+  size_t fsiz;                           /* total size of the retained free blocks */
+  TCXSTR **xstrs;                        /* pool of string objects */
+  int xnum;                              /* number of pooled string objects */
+  int xused;                             /* number of pooled string objects in use */
+  void **owns;                           /* array of owned regions */
+  int onum;                              /* number of owned regions */
+  int oanum;                             /* allocated number of owned regions */
+} TTARENA;
+
+typedef struct {                         /* type of structure for a Bloom filter */
+  uint64_t *blocks;                      /* array of the words of the blocks */
+  uint64_t bnum;                         /* number of the blocks */
+  bool ready;                            /* whether every existing key has been added */
+  uint64_t nnum;                         /* number of negative answers */
+  uint64_t fnum;                         /* number of false positive answers */
+} TTBLOOM;
+
+typedef struct {                         /* type of structure for a record cache */
+  void *shards;                          /* array of the shards */
+  int snum;                              /* number of the shards */
+  uint64_t limsiz;                       /* limit size of each shard */
+  uint64_t hnum;                         /* number of hits */
+  uint64_t mnum;                         /* number of misses */
+  uint64_t vnum;                         /* number of evicted records */
+} TTCACHE;
+
+
+/* Create a buffer arena object.
+   The return value is the new buffer arena object.
+   A buffer arena is owned by a single thread.  Every region allocated in it is released at once
+   by `ttarenareset', and the memory is recycled for later allocations without the allocator of
+   the process. */
+TTARENA *ttarenanew(void);
+
+
+/* Delete a buffer arena object.
+   `arena' specifies the buffer arena object. */
+void ttarenadel(TTARENA *arena);
+
+
+/* Allocate a region in a buffer arena object.
+   `arena' specifies the buffer arena object.
+   `size' specifies the size of the region.
+   The return value is the pointer to the allocated region, which is aligned for any type.  It
+   should not be released with the `free' call and it is valid until the arena is reset. */
+void *ttarenaalloc(TTARENA *arena, size_t size);
+
+
+/* Get a string object from the pool of a buffer arena object.
+   `arena' specifies the buffer arena object.
+   The return value is an empty string object.  It should not be deleted and it is valid until
+   the arena is reset. */
+TCXSTR *ttarenaxstr(TTARENA *arena);
+
+
+/* Hand over a region allocated with `malloc' to a buffer arena object.
+   `arena' specifies the buffer arena object.
+   `ptr' specifies the pointer to the region.  If it is `NULL', this function has no effect.
+   The region is released with the `free' call when the arena is reset. */
+void ttarenaown(TTARENA *arena, void *ptr);
+
+
+/* Reset a buffer arena object.
+   `arena' specifies the buffer arena object.
+   All regions and string objects taken from the arena are released.  Memory beyond the retained
+   amount is returned to the allocator of the process. */
+void ttarenareset(TTARENA *arena);
+
+
+/* Create a Bloom filter object.
+   `num' specifies the expected number of keys.  If it is not more than 0, the default value is
+   specified.
+   The return value is the new Bloom filter object.
+   The filter consists of blocks of a cache line and each key is mapped to bits in one block.
+   Keys can be added but not removed, so the answer of a removed key stays positive.  The filter
+   answers positive for every key until it is marked as ready. */
+TTBLOOM *ttbloomnew(int64_t num);
+
+
+/* Delete a Bloom filter object.
+   `bloom' specifies the Bloom filter object. */
+void ttbloomdel(TTBLOOM *bloom);
+
+
+/* Add a key to a Bloom filter object.
+   `bloom' specifies the Bloom filter object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   This function can be called by multiple threads at the same time. */
+void ttbloomadd(TTBLOOM *bloom, const void *kbuf, int ksiz);
+
+
+/* Check whether a key may be in a Bloom filter object.
+   `bloom' specifies the Bloom filter object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   If the key may have been added or the filter is not ready, the return value is true, else, it
+   is false. */
+bool ttbloomcheck(TTBLOOM *bloom, const void *kbuf, int ksiz);
+
+
+/* Count a false positive answer of a Bloom filter object.
+   `bloom' specifies the Bloom filter object.
+   This function should be called when a key for which `ttbloomcheck' answered positive turns
+   out to be missing. */
+void ttbloomfalse(TTBLOOM *bloom);
+
+
+/* Mark a Bloom filter object as ready.
+   `bloom' specifies the Bloom filter object.
+   This function should be called after every existing key has been added. */
+void ttbloomsetready(TTBLOOM *bloom);
+
+
+/* Get the size of the memory used by a Bloom filter object.
+   `bloom' specifies the Bloom filter object.
+   The return value is the size of the bit array in bytes. */
+uint64_t ttbloomsize(TTBLOOM *bloom);
+
+
+/* Create a record cache object.
+   `limsiz' specifies the limit size of the memory used by the records.
+   The return value is the new record cache object.
+   The records are divided into shards by the hash value of the key and each shard is evicted by
+   the CLOCK algorithm.  A new record is inserted without the reference bit, so a record which is
+   never retrieved again is evicted in the first sweep of the hand. */
+TTCACHE *ttcachenew(uint64_t limsiz);
+
+
+/* Delete a record cache object.
+   `cache' specifies the record cache object. */
+void ttcachedel(TTCACHE *cache);
+
+
+/* Retrieve a record in a record cache object.
+   `cache' specifies the record cache object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   `genp' specifies the pointer to the variable into which the generation of the shard is
+   assigned if the record is not cached.  It should be passed to `ttcacheput'.
+   If successful, the return value is the pointer to the region of the value of the
+   corresponding record.  `NULL' is returned if no record corresponds.
+   Because the region of the return value is allocated with the `malloc' call, it should be
+   released with the `free' call when it is no longer in use. */
+char *ttcacheget(TTCACHE *cache, const void *kbuf, int ksiz, int *sp, uint64_t *genp);
+
+
+/* Store a record into a record cache object.
+   `cache' specifies the record cache object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   `gen' specifies the generation given by `ttcacheget' before the value was read from the
+   database.
+   If a record of the same shard has been removed since the generation was given, this function
+   has no effect, so a value read before a modification is never cached after it. */
+void ttcacheput(TTCACHE *cache, const void *kbuf, int ksiz, const void *vbuf, int vsiz,
+                uint64_t gen);
+
+
+/* Remove a record of a record cache object.
+   `cache' specifies the record cache object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   This function should be called after the record in the database is modified. */
+void ttcacheout(TTCACHE *cache, const void *kbuf, int ksiz);
+
+
+/* Remove all records of a record cache object.
+   `cache' specifies the record cache object. */
+void ttcacheclear(TTCACHE *cache);
+
+
+/* Get the total size of the records of a record cache object.
+   `cache' specifies the record cache object.
+   The return value is the total size including the overhead of each record. */
+uint64_t ttcachesize(TTCACHE *cache);
+
+
+
+/*************************************************************************************************
+ * hooks of update logs
+ *************************************************************************************************/
+
+
+enum {                                   /* enumeration for phases of the hook of modified records */
+  TCULMODBEGIN,                          /* before a record is modified */
+  TCULMODEND,                            /* after a record is modified */
+  TCULMODTOUCH                           /* after a record of a bulk operation is modified */
+};
+
+
+/* Set the Bloom filter of an update log object.
+   `ulog' specifies the update log object.
+   `bloom' specifies the Bloom filter object.  If it is `NULL', no filter is maintained.
+   The key of every record stored by the functions of this API is added to the filter before the
+   database is modified.  The filter is not deleted with the update log object. */
+void tculogsetbloom(TCULOG *ulog, TTBLOOM *bloom);
+
+
+/* Add the keys stored by a versatile function to the Bloom filter of an update log object.
+   `ulog' specifies the update log object.
+   `name' specifies the name of the function.
+   `args' specifies a list object containing arguments.
+   This function should be called before `tcadbmisc' is called directly.  If no filter is set,
+   it has no effect. */
+void tculogbloommisc(TCULOG *ulog, const char *name, const TCLIST *args);
+
+
+/* Set the record cache of an update log object.
+   `ulog' specifies the update log object.
+   `cache' specifies the record cache object.  If it is `NULL', no cache is maintained.
+   The record modified by every function of this API is removed from the cache after the
+   database is modified.  The cache is not deleted with the update log object. */
+void tculogsetcache(TCULOG *ulog, TTCACHE *cache);
+
+
+/* Remove the records modified by a versatile function from the record cache of an update log
+   object.
+   `ulog' specifies the update log object.
+   `name' specifies the name of the function.
+   `args' specifies a list object containing arguments.
+   This function should be called after `tcadbmisc' is called directly.  If no cache is set, it
+   has no effect.  The whole cache is cleared after a function whose modification is not known
+   by the arguments. */
+void tculogcachemisc(TCULOG *ulog, const char *name, const TCLIST *args);
+
+
+/* Set the hook of modified records of an update log object.
+   `ulog' specifies the update log object.
+   `mod' specifies the pointer to the hook function.  Its parameters are the opaque object, the
+   pointer to the region of the key, the size of the region of the key, the phase, and the
+   expiration time of the record.  If it is `NULL', no hook is called.
+   `opq' specifies the opaque object passed to the hook.
+   A function of this API modifying a single record calls the hook with `TCULMODBEGIN' before
+   the update log is locked and with `TCULMODEND' after it is unlocked.  A bulk operation calls
+   the hook with `TCULMODTOUCH' for each record after the update log is unlocked, and the size is
+   negative if the modified records are not known.  The expiration time is 0 if the record was
+   replaced or removed as a whole, negative if the expiration time should be kept, or the time
+   recorded by `tculogputxt'. */
+void tculogsetmod(TCULOG *ulog, void (*mod)(void *, const void *, int, int, int64_t), void *opq);
+
+
+/* Call the hook of the records modified by a versatile function of an update log object.
+   `ulog' specifies the update log object.
+   `name' specifies the name of the function.
+   `args' specifies a list object containing arguments.
+   This function should be called after `tcadbmisc' is called directly.  If no hook is set, it
+   has no effect. */
+void tculogmodmisc(TCULOG *ulog, const char *name, const TCLIST *args);
+
+
+/* Record the expiration time of a record in an update log object.
+   `ulog' specifies the update log object.
+   `sid' specifies the server ID of the message.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `xt' specifies the expiration time of the record.
+   If successful, the return value is true, else, it is false.
+   The database is not modified.  The hook of modified records is called with `TCULMODTOUCH' and
+   the expiration time, and the message is redone by `tculogadbredo' in the same way. */
+bool tculogputxt(TCULOG *ulog, uint32_t sid, const void *kbuf, int ksiz, int64_t xt);
+
+
+
+#endif                                   /* duplication check */
+
+
+/* END OF FILE */
@@ -19,6 +19,7 @@
 #include <tcrdb.h>
 #include "myconf.h"
 #include "scrext.h"
+#include "ttpriv.h"
 
 #define DEFPORT        1978              // default port
 #define DEFTHNUM       8                 // default thread number
@@ -26,11 +27,29 @@
 #define DEFRTSPATH     "ttserver.rts"    // default name of the RTS file
 #define MAXARGSIZ      (32*1024*1024)    // maximum size of each argument
 #define MAXARGNUM      (1*1024*1024)     // maximum number of arguments
+#define MAXFRAMESIZ    (256*1024*1024)   // maximum total size of a framed request
 #define NUMBUFSIZ      32                // size of a numeric buffer
 #define LINEBUFSIZ     8192              // size of a line buffer
-#define TOKENUNIT      256               // unit number of tokens
 #define RECMTXNUM      31                // number of mutexes of records
 #define STASHBNUM      1021              // bucket number of the script stash object
+#define REPLBUFSIZ     (256*1024)        // size of the output buffer of each slave
+#define REPLNOPFREQ    1.0               // frequency of NOP commands to idle slaves
+#define REPLBUSYWAIT   10                // waiting milliseconds for unwritable slaves
+#define HANDSUFFIX     ".hand"           // suffix of the socket file for the handover
+#define HANDWAIT       60.0              // waiting seconds for the handover
+#define RESVCOPYMAX    4096              // maximum size of a value copied into a response
+#define COMPTHRESMIN   256               // minimum size of a response to be compressed
+#define COMPTHRESMAX   0xffffff          // maximum threshold size of compression
+#define COMPHEADSIZ    10                // size of the header of a compressed frame
+#define RESCHUNKSIZ    (256*1024)        // size of each chunk of a streamed response
+#define RESSIZMAX      (256*1024*1024)   // maximum total size of a multiple retrieval
+#define VERMTXNUM      1021              // number of shards of record versions
+#define VERSHARDMAX    256               // maximum number of records of each shard of versions
+#define TTLMTXNUM      61                // number of mutexes of expiration times
+#define TTLREAPFREQ    1.0               // frequency of reaping expired records
+#define TTLREAPMAX     4096              // maximum number of records reaped at a time
+#define TTLRELMAX      (60*60*24*30)     // maximum relative expiration time of memcached
+#define BLOOMSCANUNIT  1024              // number of keys added to the Bloom filter at a lock
 
 #define TTMSKPUT       (1ULL<<0)         /* bit mask of put command */
 #define TTMSKPUTKEEP   (1ULL<<1)         /* bit mask of putkeep command */
@@ -64,11 +83,43 @@
 #define TTMSKALLREAD   (1ULL<<29)        /* bit mask of all commands of reading */
 #define TTMSKALLWRITE  (1ULL<<30)        /* bit mask of all commands of writing */
 #define TTMSKALLMANAGE (1ULL<<31)        /* bit mask of all commands of managing */
+#define TTMSKBATCH     (1ULL<<32)        /* bit mask of batch command */
+#define TTMSKITERPAGE  (1ULL<<33)        /* bit mask of iterpage command */
+#define TTMSKCAS       (1ULL<<34)        /* bit mask of cas command */
+#define DEFSHEDMASK    (TTMSKALLWRITE | TTMSKEXT | TTMSKALLMANAGE)  /* default shedding mask */
+
+enum {                                   /* enumeration for protocols */
+  PROTBIN,                               /* original binary protocol */
+  PROTMC,                                /* memcached protocol */
+  PROTHTTP,                              /* HTTP */
+  PROTNUM                                /* number of protocols */
+};
 
 typedef struct {                         // type of structure of logging opaque object
   int fd;
 } LOGARG;
 
+typedef struct {                         // type of structure of version table of records
+  pthread_mutex_t mtxs[VERMTXNUM];
+  TCMAP *stamps[VERMTXNUM];
+  uint64_t floors[VERMTXNUM];
+  uint64_t clock;
+  uint64_t floor;
+} VERTAB;
+
+typedef struct {                         // type of structure of expiration times
+  pthread_mutex_t mtxs[TTLMTXNUM];
+  TCMAP *xts[TTLMTXNUM];
+  TCTREE *idxs[TTLMTXNUM];
+  int64_t num;
+  TCHDB *hdb;
+} TTLTAB;
+
+typedef struct {                         // type of structure of the hook of modified records
+  VERTAB *vtab;
+  TTLTAB *ttab;
+} MODARG;
+
 typedef struct {                         // type of structure of master synchronous object
   char host[TTADDRBUFSIZ];
   int port;
@@ -82,6 +133,7 @@ typedef struct {                         // type of structure of master synchron
   bool delay;
   bool started;
   bool exit;
+  int zcodec;
 } REPLARG;
 
 typedef struct {                         // type of structure of periodic command
@@ -93,6 +145,42 @@ typedef struct {                         // type of structure of periodic comman
   void *scrext;
 } EXTPCARG;
 
+typedef struct {                         // type of structure of replication session
+  int fd;
+  TCULRD *ulrd;
+  uint32_t sid;
+  TCXSTR *obuf;
+  int off;
+  double stime;
+  bool err;
+  int zcodec;
+  int zthres;
+} REPLSESS;
+
+typedef struct {                         // type of structure of replication streamer
+  pthread_t thid;
+  bool alive;
+  bool term;
+  TCULOG *ulog;
+  pthread_mutex_t mtx;
+  TCLIST *sesss;
+  uint64_t zinsum;
+  uint64_t zoutsum;
+} STRMARG;
+
+typedef struct {                         // type of structure of iterator of a connection
+  int omode;
+  bool init;
+  int part;
+  int pnum;
+  BDBCUR *cur;
+  uint64_t pos;
+  int64_t end;
+  char *lbuf;
+  int lsiz;
+  int lasiz;
+} ITERCUR;
+
 typedef struct {                         // type of structure of task opaque object
   uint64_t mask;
   TCADB *adb;
@@ -101,8 +189,37 @@ typedef struct {                         // type of structure of task opaque obj
   REPLARG *sarg;
   pthread_mutex_t rmtxs[RECMTXNUM];
   void **screxts;
+  STRMARG *strm;
+  uint64_t shed;
+  uint64_t shednums[PROTNUM];
+  uint64_t zinsum;
+  uint64_t zoutsum;
+  pthread_mutex_t *itermtx;
+  ITERCUR *itercur;
+  VERTAB *vtab;
+  TTLTAB *ttab;
 } TASKARG;
 
+typedef struct {                         // type of structure of Bloom filter builder
+  pthread_t thid;
+  bool alive;
+  bool term;
+  TASKARG *targ;
+  TTBLOOM *bloom;
+} BLOOMARG;
+
+typedef struct {                         // type of structure of vectored response
+  TTARENA *arena;
+  TCXSTR *head;
+  TCXSTR *vals;
+  TCXSTR *cuts;
+} RESVEC;
+
+typedef struct {                         // type of structure of a key of multiple retrieval
+  const char *kbuf;
+  int ksiz;
+} MGETKEY;
+
 
 /* global variables */
 const char *g_progname = NULL;           // program name
@@ -110,6 +227,7 @@ double g_starttime = 0.0;                // start time
 TTSERV *g_serv = NULL;                   // server object
 int g_loglevel = TTLOGINFO;              // whether to log debug information
 bool g_restart = false;                  // restart flag
+bool g_handover = false;                 // handover flag
 
 
 /* function prototypes */
@@ -118,29 +236,107 @@ static void usage(void);
 static uint64_t getcmdmask(const char *expr);
 static void sigtermhandler(int signum);
 static void sigchldhandler(int signum);
-static int proc(const char *dbname, const char *host, int port, int thnum, int tout,
-                bool dmn, const char *pidpath, bool kl, const char *logpath,
-                const char *ulogpath, uint64_t ulim, bool uas, uint32_t sid,
-                const char *mhost, int mport, const char *rtspath, const char *extpath,
-                const TCLIST *extpcs, uint64_t mask);
+static int proc(const char *dbname, const char *host, int port, int thnum, int thmax,
+                int rnum, bool uring, bool shm, int qhigh, int qlow, int tout, bool dmn,
+                const char *pidpath, bool kl, bool hand, const char *logpath,
+                const char *ulogpath, uint64_t ulim, bool uas, uint32_t sid, const char *mhost,
+                int mport, int mcomp, const char *rtspath, const char *extpath,
+                const TCLIST *extpcs, uint64_t mask, uint64_t shed, int64_t bnum,
+                uint64_t csiz);
 static void do_log(int level, const char *msg, void *opq);
 static void do_slave(void *opq);
 static void do_extpc(void *opq);
+static void do_ttlreap(void *opq);
+static void *do_stream(void *opq);
+static void *do_bloom(void *opq);
+static void replsessdel(REPLSESS *sess);
 static void do_task(TTSOCK *sock, void *opq, TTREQ *req);
-static char **tokenize(char *str, int *np);
+static int do_frame(const char *buf, int size, void *opq);
+static int framebin(const char *buf, int size);
+static int frametext(const char *buf, int size);
+static int framenum(const char *ptr);
+static int frametokens(const char *buf, const char *ep, const char **tokens, int *tsizs, int max);
+static uint64_t framemask(const char *buf, int size, int *pp);
+static bool do_shed(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static uint32_t recmtxidx(const char *kbuf, int ksiz);
+static VERTAB *vertabnew(void);
+static void vertabdel(VERTAB *vtab);
+static int verslot(const char *kbuf, int ksiz);
+static int verlock(VERTAB *vtab, const char *kbuf, int ksiz);
+static uint64_t verunlock(VERTAB *vtab, int slot, const char *kbuf, int ksiz, bool mod);
+static uint64_t verstamp(VERTAB *vtab, int slot, const char *kbuf, int ksiz);
+static uint64_t vertoken(VERTAB *vtab, const char *kbuf, int ksiz);
+static void verexpire(VERTAB *vtab);
+static void recmod(void *opq, const void *kbuf, int ksiz, int phase, int64_t xt);
+static void verlockops(VERTAB *vtab, const TCULOP *ops, int onum, bool *lcks);
+static void verunlockops(VERTAB *vtab, const TCULOP *ops, int onum, bool *lcks);
+static TTLTAB *ttltabnew(TCADB *adb);
+static void ttltabdel(TTLTAB *ttab);
+static int64_t ttlget(TTLTAB *ttab, const char *kbuf, int ksiz);
+static void ttlset(TTLTAB *ttab, const char *kbuf, int ksiz, int64_t xt);
+static bool ttlexpired(TTLTAB *ttab, const char *kbuf, int ksiz);
+static void ttlclear(TTLTAB *ttab);
+static int64_t ttlmcxt(const char *str);
+static bool ttlpurge(TASKARG *arg, const char *kbuf, int ksiz);
+static char *recget(TASKARG *arg, const char *kbuf, int ksiz, int *sp);
+static int recvsiz(TASKARG *arg, const char *kbuf, int ksiz);
+static bool recput(TASKARG *arg, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                   int64_t xt);
+static bool recputkeep(TASKARG *arg, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                       int64_t xt);
+static bool recputcat(TASKARG *arg, const char *kbuf, int ksiz, const char *vbuf, int vsiz);
+static bool recout(TASKARG *arg, const char *kbuf, int ksiz);
+static int recaddint(TASKARG *arg, const char *kbuf, int ksiz, int num);
+static double recadddouble(TASKARG *arg, const char *kbuf, int ksiz, double num);
+static int reccas(TASKARG *arg, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                  uint64_t ver, int64_t xt, uint64_t *verp);
+static RESVEC *resvecnew(TTARENA *arena);
+static void resvecaddval(RESVEC *resv, char *vbuf, int vsiz);
+static bool resvecsend(RESVEC *resv, TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static char *compframe(int codec, const char *ptr, int size, int *sp);
+static bool sendres(TTSOCK *sock, TASKARG *arg, TTREQ *req, struct iovec *iov, int iovcnt);
+static MGETKEY *mgetkeys(TTSOCK *sock, TTARENA *arena, int rnum, int *np);
+static int mgetkeycmp(const void *a, const void *b);
+static int mgetkeycmpid(const void *a, const void *b);
+static int mgetsort(MGETKEY *keys, int knum, TCADB *adb);
+static bool strmflush(TTSOCK *sock, TASKARG *arg, TTREQ *req, TCXSTR *xstr,
+                      char *vbuf, int vsiz);
+static bool strmchunk(TTSOCK *sock, TASKARG *arg, TTREQ *req, TCXSTR *xstr, uint8_t code,
+                      int *np, char *vbuf, int vsiz);
+static bool strmrec(TTSOCK *sock, TASKARG *arg, TTREQ *req, TCXSTR *xstr, int *np,
+                    const char *kbuf, int ksiz, char *vbuf, int vsiz);
+static int fwmkeycmp(const char *abuf, int asiz, const char *bbuf, int bsiz);
+static TCLIST *fwmrecskeys(TASKARG *arg, const char *pbuf, int psiz,
+                           const char *sbuf, int ssiz, int max, bool desc, bool *mp);
+static ITERCUR *itercurnew(TCADB *adb);
+static void itercurdel(ITERCUR *cur);
+static void do_conndel(void *data, void *opq);
+static ITERCUR *itercurget(TASKARG *arg, TTREQ *req, bool *lp);
+static bool itercurinit(ITERCUR *cur, TCADB *adb, int part, int pnum);
+static bool itercurnext(ITERCUR *cur, TCADB *adb, TCXSTR *kxstr, TCXSTR *vxstr, bool cont);
+static bool itercurfetch(ITERCUR *cur, TCADB *adb, TCXSTR *kxstr, TCXSTR *vxstr, bool cont);
+static bool itercursync(ITERCUR *cur, TCADB *adb, bool store);
+static void itercurkeep(ITERCUR *cur, const char *kbuf, int ksiz);
 static void do_put(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_putkeep(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_putcat(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_putshl(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_putttl(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_putnr(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_cas(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_batch(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_out(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_get(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_gets(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_mget(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_mgetstrm(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_vsiz(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_iterinit(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_iternext(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_iterpage(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_iterpart(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_fwmkeys(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_fwmrecs(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_addint(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_adddouble(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_ext(TTSOCK *sock, TASKARG *arg, TTREQ *req);
@@ -154,9 +350,12 @@ static void do_size(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_stat(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_misc(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_repl(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_shm(TTSOCK *sock, TASKARG *arg, TTREQ *req);
+static void do_comp(TTSOCK *sock, TASKARG *arg, TTREQ *req);
 static void do_mc_set(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
 static void do_mc_add(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
 static void do_mc_replace(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
+static void do_mc_cas(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
 static void do_mc_get(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
 static void do_mc_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
 static void do_mc_incr(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
@@ -172,8 +371,10 @@ static void do_http_post(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const
 static void do_http_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const char *uri);
 static void do_ext_addrepl(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
 static void do_ext_delrepl(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum);
-bool ttservmodifytimedhandler( const char * host, int port, const char * rtspath,TTSERV * serv);
-bool ttservdeltimedhandler( const char * host, int port, const char * rtspath,TTSERV * serv);
+bool ttservmodifytimedhandler(const char *host, int port, const char *rtspath, TTSERV *serv,
+                              void (*do_timed)(void *));
+bool ttservdeltimedhandler(const char *host, int port, const char *rtspath, TTSERV *serv,
+                           void (*do_timed)(void *));
 
 
 /* main routine */
@@ -191,14 +392,25 @@ int main(int argc, char **argv){
   TCLIST *extpcs = NULL;
   int port = DEFPORT;
   int thnum = DEFTHNUM;
+  int thmax = 0;
+  int rnum = 1;
+  bool uring = false;
+  bool shm = false;
+  int qhigh = 0;
+  int qlow = 0;
   int tout = 0;
   bool dmn = false;
   bool kl = false;
+  bool hand = false;
   uint64_t ulim = 0;
   bool uas = false;
   uint32_t sid = 0;
   int mport = DEFPORT;
+  int mcomp = TTZNONE;
   uint64_t mask = 0;
+  uint64_t shed = 0;
+  int64_t bnum = -1;
+  uint64_t csiz = 0;
   for(int i = 1; i < argc; i++){
     if(!dbname && argv[i][0] == '-'){
       if(!strcmp(argv[i], "-host")){
@@ -210,6 +422,25 @@ int main(int argc, char **argv){
       } else if(!strcmp(argv[i], "-thnum")){
         if(++i >= argc) usage();
         thnum = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-thmax")){
+        if(++i >= argc) usage();
+        thmax = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-reactors")){
+        if(++i >= argc) usage();
+        rnum = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-uring")){
+        uring = true;
+      } else if(!strcmp(argv[i], "-shm")){
+        shm = true;
+      } else if(!strcmp(argv[i], "-qhigh")){
+        if(++i >= argc) usage();
+        qhigh = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-qlow")){
+        if(++i >= argc) usage();
+        qlow = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-shed")){
+        if(++i >= argc) usage();
+        shed |= getcmdmask(argv[i]);
       } else if(!strcmp(argv[i], "-tout")){
         if(++i >= argc) usage();
         tout = tcatoi(argv[i]);
@@ -220,6 +451,8 @@ int main(int argc, char **argv){
         pidpath = argv[i];
       } else if(!strcmp(argv[i], "-kl")){
         kl = true;
+      } else if(!strcmp(argv[i], "-hand")){
+        hand = true;
       } else if(!strcmp(argv[i], "-log")){
         if(++i >= argc) usage();
         logpath = argv[i];
@@ -244,6 +477,15 @@ int main(int argc, char **argv){
       } else if(!strcmp(argv[i], "-mport")){
         if(++i >= argc) usage();
         mport = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-mcomp")){
+        if(++i >= argc) usage();
+        if(!tcstricmp(argv[i], "deflate")){
+          mcomp = TTZDEFLATE;
+        } else if(!tcstricmp(argv[i], "bzip")){
+          mcomp = TTZBZIP;
+        } else {
+          usage();
+        }
       } else if(!strcmp(argv[i], "-rts")){
         if(++i >= argc) usage();
         rtspath = argv[i];
@@ -256,6 +498,13 @@ int main(int argc, char **argv){
         tclistpush2(extpcs, argv[i]);
         if(++i >= argc) usage();
         tclistpush2(extpcs, argv[i]);
+      } else if(!strcmp(argv[i], "-bloom")){
+        if(++i >= argc) usage();
+        bnum = tcatoix(argv[i]);
+        if(bnum < 0) usage();
+      } else if(!strcmp(argv[i], "-cache")){
+        if(++i >= argc) usage();
+        csiz = tcatoix(argv[i]);
       } else if(!strcmp(argv[i], "-mask")){
         if(++i >= argc) usage();
         mask |= getcmdmask(argv[i]);
@@ -277,7 +526,7 @@ int main(int argc, char **argv){
     }
   }
   if(!dbname) dbname = "*";
-  if(thnum < 1 || mport < 1) usage();
+  if(thnum < 1 || rnum < 1 || mport < 1) usage();
   if(dmn && !pidpath) pidpath = DEFPIDPATH;
   if(sid < 1){
     sid = port;
@@ -290,9 +539,11 @@ int main(int argc, char **argv){
     sid = sid & INT_MAX;
   }
   if(!rtspath) rtspath = DEFRTSPATH;
+  if(shed == 0) shed = DEFSHEDMASK;
   g_serv = ttservnew();
-  int rv = proc(dbname, host, port, thnum, tout, dmn, pidpath, kl, logpath,
-                ulogpath, ulim, uas, sid, mhost, mport, rtspath, extpath, extpcs, mask);
+  int rv = proc(dbname, host, port, thnum, thmax, rnum, uring, shm, qhigh, qlow, tout, dmn,
+                pidpath, kl, hand, logpath, ulogpath, ulim, uas, sid, mhost, mport, mcomp, rtspath,
+                extpath, extpcs, mask, shed, bnum, csiz);
   ttservdel(g_serv);
   if(extpcs) tclistdel(extpcs);
   return rv;
@@ -304,10 +555,12 @@ static void usage(void){
   fprintf(stderr, "%s: the server of Tokyo Tyrant\n", g_progname);
   fprintf(stderr, "\n");
   fprintf(stderr, "usage:\n");
-  fprintf(stderr, "  %s [-host name] [-port num] [-thnum num] [-tout num]"
-          " [-dmn] [-pid path] [-kl] [-log path] [-ld|-le] [-ulog path] [-ulim num] [-uas]"
-          " [-sid num] [-mhost name] [-mport num] [-rts path] [-ext path] [-extpc name period]"
-          " [-mask expr] [-unmask expr] [dbname]\n", g_progname);
+  fprintf(stderr, "  %s [-host name] [-port num] [-thnum num] [-thmax num] [-reactors num]"
+          " [-uring] [-shm] [-qhigh num] [-qlow num] [-shed expr] [-tout num]"
+          " [-dmn] [-pid path] [-kl|-hand] [-log path] [-ld|-le] [-ulog path] [-ulim num] [-uas]"
+          " [-sid num] [-mhost name] [-mport num] [-mcomp name] [-rts path] [-ext path]"
+          " [-extpc name period] [-bloom num] [-cache num] [-mask expr] [-unmask expr]"
+          " [dbname]\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
 }
@@ -331,6 +584,10 @@ static uint64_t getcmdmask(const char *expr){
       mask |= TTMSKPUTSHL;
     } else if(!tcstricmp(name, "putnr")){
       mask |= TTMSKPUTNR;
+    } else if(!tcstricmp(name, "batch")){
+      mask |= TTMSKBATCH;
+    } else if(!tcstricmp(name, "cas")){
+      mask |= TTMSKCAS;
     } else if(!tcstricmp(name, "out")){
       mask |= TTMSKOUT;
     } else if(!tcstricmp(name, "get")){
@@ -343,6 +600,8 @@ static uint64_t getcmdmask(const char *expr){
       mask |= TTMSKITERINIT;
     } else if(!tcstricmp(name, "iternext")){
       mask |= TTMSKITERNEXT;
+    } else if(!tcstricmp(name, "iterpage")){
+      mask |= TTMSKITERPAGE;
     } else if(!tcstricmp(name, "fwmkeys")){
       mask |= TTMSKFWMKEYS;
     } else if(!tcstricmp(name, "addint")){
@@ -396,8 +655,19 @@ static uint64_t getcmdmask(const char *expr){
 
 /* handle termination signals */
 static void sigtermhandler(int signum){
-  if(signum == SIGHUP) g_restart = true;
-  ttservkill(g_serv);
+  if(signum == SIGHUP){
+    if(g_handover) return;
+    g_restart = true;
+    ttservhold(g_serv);
+  } else if(signum == SIGUSR2){
+    g_restart = false;
+    g_handover = true;
+    ttservhold(g_serv);
+  } else {
+    g_restart = false;
+    g_handover = false;
+    ttservkill(g_serv);
+  }
 }
 
 
@@ -408,11 +678,13 @@ static void sigchldhandler(int signum){
 
 
 /* perform the command */
-static int proc(const char *dbname, const char *host, int port, int thnum, int tout,
-                bool dmn, const char *pidpath, bool kl, const char *logpath,
-                const char *ulogpath, uint64_t ulim, bool uas, uint32_t sid,
-                const char *mhost, int mport, const char *rtspath, const char *extpath,
-                const TCLIST *extpcs, uint64_t mask){
+static int proc(const char *dbname, const char *host, int port, int thnum, int thmax,
+                int rnum, bool uring, bool shm, int qhigh, int qlow, int tout, bool dmn,
+                const char *pidpath, bool kl, bool hand, const char *logpath,
+                const char *ulogpath, uint64_t ulim, bool uas, uint32_t sid, const char *mhost,
+                int mport, int mcomp, const char *rtspath, const char *extpath,
+                const TCLIST *extpcs, uint64_t mask, uint64_t shed, int64_t bnum,
+                uint64_t csiz){
   LOGARG larg;
   larg.fd = 1;
   ttservsetloghandler(g_serv, do_log, &larg);
@@ -469,6 +741,32 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
       }
       numstr = tcreadfile(pidpath, -1, NULL);
     }
+    if(numstr && hand){
+      int64_t pid = tcatoi(numstr);
+      tcfree(numstr);
+      char *hpath = tcsprintf("%s%s", pidpath, HANDSUFFIX);
+      ttservlog(g_serv, TTLOGINFO,
+                "taking over the process %lld with SIGUSR2", (long long)pid);
+      unlink(hpath);
+      int hfd = ttopenservsockunix(hpath);
+      if(hfd != -1){
+        if(kill(pid, SIGUSR2) != 0){
+          ttservlog(g_serv, TTLOGERROR, "kill failed");
+        } else if(!ttservtakeover(g_serv, hfd, HANDWAIT)){
+          ttservlog(g_serv, TTLOGERROR, "ttservtakeover failed");
+        }
+        close(hfd);
+        unlink(hpath);
+      } else {
+        ttservlog(g_serv, TTLOGERROR, "ttopenservsockunix failed");
+      }
+      tcfree(hpath);
+      int cnt = 0;
+      while((numstr = tcreadfile(pidpath, -1, NULL)) != NULL && ++cnt < 100){
+        tcfree(numstr);
+        usleep(1000 * 100);
+      }
+    }
     if(numstr){
       int64_t pid = tcatoi(numstr);
       tcfree(numstr);
@@ -524,10 +822,53 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
       ttservlog(g_serv, TTLOGERROR, "tculogopen failed");
     }
   }
+  TTBLOOM *bloom = NULL;
+  if(bnum >= 0){
+    bloom = ttbloomnew(tclmax(bnum, tcadbrnum(adb)));
+    ttservlog(g_serv, TTLOGSYSTEM, "Bloom filter configuration: size=%llu",
+              (unsigned long long)ttbloomsize(bloom));
+    tculogsetbloom(ulog, bloom);
+  }
+  TTCACHE *cache = NULL;
+  int omode = tcadbomode(adb);
+  if(csiz > 0 && (omode == ADBOMDB || omode == ADBONDB)){
+    ttservlog(g_serv, TTLOGINFO, "record cache is not used for on-memory database");
+  } else if(csiz > 0){
+    cache = ttcachenew(csiz);
+    ttservlog(g_serv, TTLOGSYSTEM, "record cache configuration: limit=%llu",
+              (unsigned long long)csiz);
+    tculogsetcache(ulog, cache);
+  }
   ttservtune(g_serv, thnum, tout);
+  if(thmax > thnum){
+    ttservlog(g_serv, TTLOGSYSTEM, "worker pool configuration: min=%d max=%d", thnum, thmax);
+    ttservtunepool(g_serv, thmax, 0, 0);
+  } else {
+    thmax = thnum;
+  }
+  if(rnum > 1){
+    ttservlog(g_serv, TTLOGSYSTEM, "reactor configuration: number=%d", rnum);
+    ttservsetreactors(g_serv, rnum);
+  }
+  if(uring){
+    ttservlog(g_serv, TTLOGSYSTEM, "event backend configuration: io_uring");
+    ttservseturing(g_serv, true);
+  }
+  if(shm){
+    ttservlog(g_serv, TTLOGSYSTEM, "shared memory transport configuration: max=%d", thmax);
+    ttservsetshm(g_serv, thmax);
+  }
+  if(qhigh > 0){
+    ttservtunequeue(g_serv, qhigh, qlow);
+    ttservlog(g_serv, TTLOGSYSTEM, "admission control configuration: high=%d low=%d shed=%llx",
+              g_serv->qhigh, g_serv->qlow, (unsigned long long)shed);
+  }
   if(mhost)
     ttservlog(g_serv, TTLOGSYSTEM, "replication configuration: host=%s port=%d", mhost, mport);
-  void *screxts[thnum];
+  pthread_mutex_t itermtx;
+  if(pthread_mutex_init(&itermtx, NULL) != 0)
+    ttservlog(g_serv, TTLOGERROR, "pthread_mutex_init failed");
+  void *screxts[thmax];
   TCMDB *scrstash = NULL;
   pthread_mutex_t *scrlcks = NULL;
   if(extpath){
@@ -545,12 +886,12 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
       pthread_mutexattr_destroy(&attr);
     }
     bool screrr = false;
-    for(int i = 0; i < thnum; i++){
+    for(int i = 0; i < thmax; i++){
       screxts[i] = NULL;
     }
-    for(int i = 0; i < thnum; i++){
-      screxts[i] = scrextnew(screxts, thnum, i, extpath, adb, ulog, sid, scrstash,
-                             scrlcks, RECMTXNUM, do_log, &larg);
+    for(int i = 0; i < thmax; i++){
+      screxts[i] = scrextnew(screxts, thmax, i, extpath, adb, ulog, sid, scrstash,
+                             scrlcks, RECMTXNUM, &itermtx, do_log, &larg);
       if(!screxts[i]) screrr = true;
     }
     if(screrr){
@@ -558,12 +899,18 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
       ttservlog(g_serv, TTLOGERROR, "scrextnew failed");
     }
   } else {
-    for(int i = 0; i < thnum; i++){
+    for(int i = 0; i < thmax; i++){
       screxts[i] = NULL;
     }
   }
   if(mask != 0)
     ttservlog(g_serv, TTLOGSYSTEM, "command bit mask: 0x%llx", (unsigned long long)mask);
+  VERTAB *vtab = vertabnew();
+  TTLTAB *ttab = ttltabnew(adb);
+  MODARG marg;
+  marg.vtab = vtab;
+  marg.ttab = ttab;
+  tculogsetmod(ulog, recmod, &marg);
   REPLARG sarg;
   snprintf(sarg.host, TTADDRBUFSIZ, "%s", mhost ? mhost : "");
   sarg.port = mport;
@@ -576,6 +923,7 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
   sarg.recon = false;
   sarg.delay=false;
   sarg.exit=false;
+  sarg.zcodec = mcomp;
   if(!(mask & TTMSKSLAVE)) ttservaddtimedhandler(g_serv, 1.0, do_slave, &sarg);
 
   REPLARG sarg2;
@@ -590,6 +938,7 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
   sarg2.recon = false;
   sarg2.delay=false;
   sarg2.exit=false;
+  sarg2.zcodec = mcomp;
   if(!(mask & TTMSKSLAVE)) ttservaddtimedhandler_delay(g_serv, 1.0, do_slave, &sarg2);
 
   REPLARG sarg3;
@@ -604,6 +953,7 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
   sarg3.recon = false;
   sarg3.delay=false;
   sarg3.exit=false;
+  sarg3.zcodec = mcomp;
   if(!(mask & TTMSKSLAVE)) ttservaddtimedhandler_delay(g_serv, 1.0, do_slave, &sarg3);
 
   REPLARG sarg4;
@@ -618,6 +968,7 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
   sarg4.recon = false;
   sarg4.delay=false;
   sarg4.exit=false;
+  sarg4.zcodec = mcomp;
   if(!(mask & TTMSKSLAVE)) ttservaddtimedhandler_delay(g_serv, 1.0, do_slave, &sarg4);
 
 
@@ -635,8 +986,8 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
       pcarg->ulog = ulog;
       pcarg->sid = sid;
       pcarg->sarg = &sarg;
-      pcarg->scrext = scrextnew(screxts, thnum, thnum + i, extpath, adb, ulog, sid, scrstash,
-                                scrlcks, RECMTXNUM, do_log, &larg);
+      pcarg->scrext = scrextnew(screxts, thmax, thmax + i, extpath, adb, ulog, sid, scrstash,
+                                scrlcks, RECMTXNUM, &itermtx, do_log, &larg);
       if(pcarg->scrext){
         if(*name && period > 0) ttservaddtimedhandler(g_serv, period, do_extpc, pcarg);
       } else {
@@ -656,7 +1007,51 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
       ttservlog(g_serv, TTLOGERROR, "pthread_mutex_init failed");
   }
   targ.screxts = screxts;
+  STRMARG strm;
+  strm.alive = false;
+  strm.term = false;
+  strm.ulog = ulog;
+  if(pthread_mutex_init(&strm.mtx, NULL) != 0)
+    ttservlog(g_serv, TTLOGERROR, "pthread_mutex_init failed");
+  strm.sesss = tclistnew();
+  strm.zinsum = 0;
+  strm.zoutsum = 0;
+  if(ulogpath){
+    if(pthread_create(&strm.thid, NULL, do_stream, &strm) == 0){
+      strm.alive = true;
+    } else {
+      err = true;
+      ttservlog(g_serv, TTLOGERROR, "pthread_create (do_stream) failed");
+    }
+  }
+  targ.strm = &strm;
+  targ.shed = shed;
+  for(int i = 0; i < PROTNUM; i++){
+    targ.shednums[i] = 0;
+  }
+  targ.zinsum = 0;
+  targ.zoutsum = 0;
+  targ.itermtx = &itermtx;
+  targ.itercur = itercurnew(adb);
+  targ.vtab = vtab;
+  targ.ttab = ttab;
+  BLOOMARG barg;
+  barg.alive = false;
+  barg.term = false;
+  barg.targ = &targ;
+  barg.bloom = bloom;
+  if(bloom){
+    if(pthread_create(&barg.thid, NULL, do_bloom, &barg) == 0){
+      barg.alive = true;
+    } else {
+      err = true;
+      ttservlog(g_serv, TTLOGERROR, "pthread_create (do_bloom) failed");
+    }
+  }
+  ttservaddtimedhandler(g_serv, TTLREAPFREQ, do_ttlreap, &targ);
   ttservsettaskhandler(g_serv, do_task, &targ);
+  ttservsetframehandler(g_serv, do_frame, NULL);
+  ttservsetconndelhandler(g_serv, do_conndel, NULL);
   if(larg.fd != 1){
     close(larg.fd);
     larg.fd = 1;
@@ -666,6 +1061,7 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
     if(logpath){
       int fd = open(logpath, O_WRONLY | O_APPEND | O_CREAT, 00644);
       if(fd != -1){
+        if(larg.fd != 1) close(larg.fd);
         larg.fd = fd;
       } else {
         err = true;
@@ -673,13 +1069,34 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
       }
     }
     if(signal(SIGTERM, sigtermhandler) == SIG_ERR || signal(SIGINT, sigtermhandler) == SIG_ERR ||
-       signal(SIGHUP, sigtermhandler) == SIG_ERR || signal(SIGPIPE, SIG_IGN) == SIG_ERR ||
-       signal(SIGCHLD, sigchldhandler) == SIG_ERR){
+       signal(SIGHUP, sigtermhandler) == SIG_ERR || signal(SIGUSR2, sigtermhandler) == SIG_ERR ||
+       signal(SIGPIPE, SIG_IGN) == SIG_ERR || signal(SIGCHLD, sigchldhandler) == SIG_ERR){
       err = true;
       ttservlog(g_serv, TTLOGERROR, "signal failed");
     }
     if(!ttservstart(g_serv)) err = true;
   } while(g_restart);
+  if(strm.alive){
+    strm.term = true;
+    tculogwake(ulog);
+    if(pthread_join(strm.thid, NULL) != 0){
+      err = true;
+      ttservlog(g_serv, TTLOGERROR, "pthread_join failed");
+    }
+  }
+  if(barg.alive){
+    barg.term = true;
+    if(pthread_join(barg.thid, NULL) != 0){
+      err = true;
+      ttservlog(g_serv, TTLOGERROR, "pthread_join failed");
+    }
+  }
+  for(int i = 0; i < tclistnum(strm.sesss); i++){
+    replsessdel(*(REPLSESS **)tclistval2(strm.sesss, i));
+  }
+  tclistdel(strm.sesss);
+  if(pthread_mutex_destroy(&strm.mtx) != 0)
+    ttservlog(g_serv, TTLOGERROR, "pthread_mutex_destroy failed");
   if(pcargs){
     for(int i = 0; i < pcnum; i++){
       EXTPCARG *pcarg = pcargs + i;
@@ -690,11 +1107,15 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
     }
     tcfree(pcargs);
   }
+  itercurdel(targ.itercur);
+  tculogsetmod(ulog, NULL, NULL);
+  ttltabdel(ttab);
+  vertabdel(vtab);
   for(int i = 0; i < RECMTXNUM; i++){
     if(pthread_mutex_destroy(targ.rmtxs + i) != 0)
       ttservlog(g_serv, TTLOGERROR, "pthread_mutex_destroy failed");
   }
-  for(int i = 0; i < thnum; i++){
+  for(int i = 0; i < thmax; i++){
     if(!screxts[i]) continue;
     if(!scrextdel(screxts[i])){
       err = true;
@@ -709,11 +1130,15 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
     tcfree(scrlcks);
   }
   if(scrstash) tcmdbdel(scrstash);
+  if(pthread_mutex_destroy(&itermtx) != 0)
+    ttservlog(g_serv, TTLOGERROR, "pthread_mutex_destroy failed");
   if(ulogpath && !tculogclose(ulog)){
     err = true;
     ttservlog(g_serv, TTLOGERROR, "tculogclose failed");
   }
   tculogdel(ulog);
+  if(cache) ttcachedel(cache);
+  if(bloom) ttbloomdel(bloom);
   if(!tcadbclose(adb)){
     err = true;
     ttservlog(g_serv, TTLOGERROR, "tcadbclose failed");
@@ -723,6 +1148,24 @@ static int proc(const char *dbname, const char *host, int port, int thnum, int t
     err = true;
     ttservlog(g_serv, TTLOGERROR, "unlink failed");
   }
+  if(g_handover){
+    int hfd = -1;
+    if(pidpath){
+      char *hpath = tcsprintf("%s%s", pidpath, HANDSUFFIX);
+      hfd = ttopensockunix(hpath);
+      tcfree(hpath);
+    }
+    if(hfd != -1){
+      if(!ttservhandover(g_serv, hfd)){
+        err = true;
+        ttservlog(g_serv, TTLOGERROR, "ttservhandover failed");
+      }
+      close(hfd);
+    } else {
+      err = true;
+      ttservlog(g_serv, TTLOGERROR, "ttopensockunix failed");
+    }
+  }
   ttservlog(g_serv, TTLOGSYSTEM, "--------- logging finished [%d] --------", pid);
   if(logpath && close(larg.fd) == -1) err = true;
   return err ? 1 : 0;
@@ -748,13 +1191,11 @@ static void do_slave(void *opq){
   TCULOG *ulog = arg->ulog;
   uint32_t sid = arg->sid;
   if(arg->exit){
-        printf("exit becaues arg->exit is true\n");
-        pthread_mutex_unlock(&g_serv->tmtx);
-        pthread_exit(NULL);
-        return ;
+    ttservlog(g_serv, TTLOGDEBUG, "do_slave: stopped");
+    return;
   }
-  fprintf(stderr,"do_slave:%s,port:%d,rtspath:%s\n",arg->host,arg->port,arg->rtspath);
   if(arg->host[0] == '\0' || arg->port < 1) return;
+  ttservlog(g_serv, TTLOGDEBUG, "do_slave: replicating %s:%d", arg->host, arg->port);
   int rtsfd = open(arg->rtspath, O_RDWR | O_CREAT, 00644);
   if(rtsfd == -1){
     ttservlog(g_serv, TTLOGERROR, "do_slave: open failed");
@@ -773,7 +1214,10 @@ static void do_slave(void *opq){
     arg->rts = strtoll(rtsbuf, NULL, 10);
   TCREPL *repl = tcreplnew();
   pthread_cleanup_push((void (*)(void *))tcrepldel, repl);
+  if(arg->zcodec != TTZNONE) tcreplsetcomp(repl, arg->zcodec, 0);
   if(tcreplopen(repl, arg->host, arg->port, arg->rts + 1, sid)){
+    if(arg->zcodec != TTZNONE && repl->zcodec == TTZNONE)
+      ttservlog(g_serv, TTLOGERROR, "do_slave: the master rejected compression");
     ttservlog(g_serv, TTLOGINFO, "replicating from %s:%d after %llu",
               arg->host, arg->port, (unsigned long long)arg->rts);
     arg->fail = false;
@@ -825,9 +1269,221 @@ static void do_extpc(void *opq){
 }
 
 
+/* reap expired records in the order of their expiration times */
+static void do_ttlreap(void *opq){
+  TASKARG *arg = (TASKARG *)opq;
+  TTLTAB *ttab = arg->ttab;
+  if(__atomic_load_n(&ttab->num, __ATOMIC_ACQUIRE) < 1) return;
+  int64_t now = tctime();
+  TCLIST *keys = tclistnew();
+  for(int i = 0; i < TTLMTXNUM && tclistnum(keys) < TTLREAPMAX; i++){
+    if(pthread_mutex_lock(ttab->mtxs + i) != 0){
+      ttservlog(g_serv, TTLOGERROR, "do_ttlreap: pthread_mutex_lock failed");
+      continue;
+    }
+    TCTREE *idx = ttab->idxs[i];
+    tctreeiterinit(idx);
+    const char *ibuf;
+    int isiz;
+    while(tclistnum(keys) < TTLREAPMAX && (ibuf = tctreeiternext(idx, &isiz)) != NULL){
+      uint64_t llnum;
+      memcpy(&llnum, ibuf, sizeof(llnum));
+      if((int64_t)TTNTOHLL(llnum) > now) break;
+      tclistpush(keys, ibuf + sizeof(llnum), isiz - sizeof(llnum));
+    }
+    pthread_mutex_unlock(ttab->mtxs + i);
+  }
+  int num = 0;
+  for(int i = 0; i < tclistnum(keys); i++){
+    int ksiz;
+    const char *kbuf = tclistval(keys, i, &ksiz);
+    int slot = verlock(arg->vtab, kbuf, ksiz);
+    bool mod = ttlpurge(arg, kbuf, ksiz);
+    verunlock(arg->vtab, slot, kbuf, ksiz, mod);
+    if(mod) num++;
+  }
+  tclistdel(keys);
+  if(num > 0) ttservlog(g_serv, TTLOGDEBUG, "do_ttlreap: %d records expired", num);
+}
+
+
+/* add the keys of the existing records to the Bloom filter */
+static void *do_bloom(void *opq){
+  BLOOMARG *barg = (BLOOMARG *)opq;
+  TASKARG *arg = barg->targ;
+  TCADB *adb = arg->adb;
+  ITERCUR *cur = itercurnew(adb);
+  bool lock = cur->omode != ADBOBDB && cur->omode != ADBOFDB;
+  bool whole = lock && cur->omode != ADBOHDB && cur->omode != ADBOTDB && cur->omode != ADBONDB;
+  TCXSTR *kxstr = tcxstrnew();
+  int64_t num = 0;
+  bool end = false;
+  bool err = false;
+  if(whole && pthread_mutex_lock(arg->itermtx) != 0){
+    ttservlog(g_serv, TTLOGERROR, "do_bloom: pthread_mutex_lock failed");
+    whole = false;
+    err = true;
+  }
+  if(!err && !itercurinit(cur, adb, 0, 1)){
+    ttservlog(g_serv, TTLOGERROR, "do_bloom: itercurinit failed");
+    err = true;
+  }
+  while(!err && !end && !barg->term){
+    if(lock && !whole && pthread_mutex_lock(arg->itermtx) != 0){
+      ttservlog(g_serv, TTLOGERROR, "do_bloom: pthread_mutex_lock failed");
+      err = true;
+      break;
+    }
+    bool cont = whole && num > 0;
+    for(int i = 0; i < BLOOMSCANUNIT; i++){
+      if(!itercurnext(cur, adb, kxstr, NULL, cont)){
+        end = true;
+        break;
+      }
+      cont = true;
+      ttbloomadd(barg->bloom, tcxstrptr(kxstr), tcxstrsize(kxstr));
+      num++;
+    }
+    if(lock && !whole && pthread_mutex_unlock(arg->itermtx) != 0)
+      ttservlog(g_serv, TTLOGERROR, "do_bloom: pthread_mutex_unlock failed");
+  }
+  if(whole && pthread_mutex_unlock(arg->itermtx) != 0)
+    ttservlog(g_serv, TTLOGERROR, "do_bloom: pthread_mutex_unlock failed");
+  if(end){
+    ttbloomsetready(barg->bloom);
+    ttservlog(g_serv, TTLOGSYSTEM, "Bloom filter built: keys=%lld", (long long)num);
+  }
+  tcxstrdel(kxstr);
+  itercurdel(cur);
+  return NULL;
+}
+
+
+/* stream update logs to replication slaves */
+static void *do_stream(void *opq){
+  STRMARG *strm = (STRMARG *)opq;
+  TCULOG *ulog = strm->ulog;
+  TCLIST *sesss = tclistnew();
+  char stack[TTIOBUFSIZ];
+  while(!strm->term){
+    if(pthread_mutex_lock(&strm->mtx) == 0){
+      for(int i = 0; i < tclistnum(strm->sesss); i++){
+        tclistpush(sesss, tclistval2(strm->sesss, i), sizeof(REPLSESS *));
+      }
+      tclistclear(strm->sesss);
+      pthread_mutex_unlock(&strm->mtx);
+    }
+    int snum = tclistnum(sesss);
+    struct pollfd pfds[snum + 1];
+    double now = tctime();
+    bool busy = false;
+    bool more = false;
+    for(int i = 0; i < snum; i++){
+      REPLSESS *sess = *(REPLSESS **)tclistval2(sesss, i);
+      if(sess->off >= tcxstrsize(sess->obuf)){
+        tcxstrclear(sess->obuf);
+        sess->off = 0;
+        const char *rbuf;
+        int rsiz;
+        uint64_t rts;
+        uint32_t rsid;
+        while(tcxstrsize(sess->obuf) < REPLBUFSIZ &&
+              (rbuf = tculrdread(sess->ulrd, &rsiz, &rts, &rsid)) != NULL){
+          if(rsid == sess->sid) continue;
+          unsigned char *wp = (unsigned char *)stack;
+          *(wp++) = TCULMAGICNUM;
+          uint64_t llnum = TTHTONLL(rts);
+          memcpy(wp, &llnum, sizeof(llnum));
+          wp += sizeof(llnum);
+          uint32_t lnum = TTHTONL(rsid);
+          memcpy(wp, &lnum, sizeof(lnum));
+          wp += sizeof(lnum);
+          lnum = TTHTONL(rsiz);
+          memcpy(wp, &lnum, sizeof(lnum));
+          wp += sizeof(lnum);
+          tcxstrcat(sess->obuf, stack, wp - (unsigned char *)stack);
+          tcxstrcat(sess->obuf, rbuf, rsiz);
+        }
+        if(tcxstrsize(sess->obuf) >= REPLBUFSIZ) more = true;
+        if(tcxstrsize(sess->obuf) < 1 && now - sess->stime >= REPLNOPFREQ){
+          *(unsigned char *)stack = TCULMAGICNOP;
+          tcxstrcat(sess->obuf, stack, sizeof(uint8_t));
+        }
+        int osiz = tcxstrsize(sess->obuf);
+        if(sess->zcodec != TTZNONE && osiz >= sess->zthres){
+          int zsiz;
+          char *zbuf = compframe(sess->zcodec, tcxstrptr(sess->obuf), osiz, &zsiz);
+          if(zbuf){
+            tcxstrclear(sess->obuf);
+            tcxstrcat(sess->obuf, zbuf, zsiz);
+            tcfree(zbuf);
+            strm->zinsum += osiz;
+            strm->zoutsum += zsiz;
+          }
+        }
+      }
+      int size = tcxstrsize(sess->obuf);
+      if(sess->off < size){
+        int wb = send(sess->fd, (char *)tcxstrptr(sess->obuf) + sess->off, size - sess->off,
+                      MSG_DONTWAIT);
+        if(wb > 0){
+          sess->off += wb;
+          sess->stime = now;
+        } else if(wb == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+          sess->err = true;
+          ttservlog(g_serv, TTLOGINFO, "do_stream: response failed");
+        }
+      }
+      pfds[i].fd = sess->fd;
+      pfds[i].events = POLLIN;
+      pfds[i].revents = 0;
+      if(sess->off < size){
+        pfds[i].events |= POLLOUT;
+        busy = true;
+      }
+    }
+    if(snum > 0 && poll(pfds, snum, (busy && !more) ? REPLBUSYWAIT : 0) > 0){
+      for(int i = 0; i < snum; i++){
+        if(!(pfds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        REPLSESS *sess = *(REPLSESS **)tclistval2(sesss, i);
+        int rb = recv(sess->fd, stack, TTIOBUFSIZ, MSG_DONTWAIT);
+        if(rb == 0 || (rb == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+          sess->err = true;
+          ttservlog(g_serv, TTLOGINFO, "do_stream: connection closed");
+        }
+      }
+    }
+    for(int i = snum - 1; i >= 0; i--){
+      REPLSESS *sess = *(REPLSESS **)tclistval2(sesss, i);
+      if(!sess->err) continue;
+      int ssiz;
+      tcfree(tclistremove(sesss, i, &ssiz));
+      ttservlog(g_serv, TTLOGINFO, "do_stream: session finished: sid=%u", sess->sid);
+      replsessdel(sess);
+    }
+    if(!busy && !more) tculogwait(ulog);
+  }
+  for(int i = 0; i < tclistnum(sesss); i++){
+    replsessdel(*(REPLSESS **)tclistval2(sesss, i));
+  }
+  tclistdel(sesss);
+  return NULL;
+}
+
+
+/* delete a replication session */
+static void replsessdel(REPLSESS *sess){
+  close(sess->fd);
+  tcxstrdel(sess->obuf);
+  tculrddel(sess->ulrd);
+  tcfree(sess);
+}
+
+
 /* handle a task and dispatch it */
 static void do_task(TTSOCK *sock, void *opq, TTREQ *req){
   TASKARG *arg = (TASKARG *)opq;
+  if(req->shed && do_shed(sock, arg, req)) return;
   int c = ttsockgetc(sock);
   if(c == TTMAGICNUM){
     switch(ttsockgetc(sock)){
@@ -843,18 +1499,33 @@ static void do_task(TTSOCK *sock, void *opq, TTREQ *req){
     case TTCMDPUTSHL:
       do_putshl(sock, arg, req);
       break;
+    case TTCMDPUTTTL:
+      do_putttl(sock, arg, req);
+      break;
     case TTCMDPUTNR:
       do_putnr(sock, arg, req);
       break;
+    case TTCMDCAS:
+      do_cas(sock, arg, req);
+      break;
+    case TTCMDBATCH:
+      do_batch(sock, arg, req);
+      break;
     case TTCMDOUT:
       do_out(sock, arg, req);
       break;
     case TTCMDGET:
       do_get(sock, arg, req);
       break;
+    case TTCMDGETS:
+      do_gets(sock, arg, req);
+      break;
     case TTCMDMGET:
       do_mget(sock, arg, req);
       break;
+    case TTCMDMGETSTRM:
+      do_mgetstrm(sock, arg, req);
+      break;
     case TTCMDVSIZ:
       do_vsiz(sock, arg, req);
       break;
@@ -864,9 +1535,18 @@ static void do_task(TTSOCK *sock, void *opq, TTREQ *req){
     case TTCMDITERNEXT:
       do_iternext(sock, arg, req);
       break;
+    case TTCMDITERPAGE:
+      do_iterpage(sock, arg, req);
+      break;
+    case TTCMDITERPART:
+      do_iterpart(sock, arg, req);
+      break;
     case TTCMDFWMKEYS:
       do_fwmkeys(sock, arg, req);
       break;
+    case TTCMDFWMRECS:
+      do_fwmrecs(sock, arg, req);
+      break;
     case TTCMDADDINT:
       do_addint(sock, arg, req);
       break;
@@ -906,16 +1586,21 @@ static void do_task(TTSOCK *sock, void *opq, TTREQ *req){
     case TTCMDREPL:
       do_repl(sock, arg, req);
       break;
+    case TTCMDSHM:
+      do_shm(sock, arg, req);
+      break;
+    case TTCMDCOMP:
+      do_comp(sock, arg, req);
+      break;
     default:
       ttservlog(g_serv, TTLOGINFO, "unknown command");
       break;
     }
   } else {
     ttsockungetc(sock, c);
-    char *line = ttsockgets2(sock);
-    if(line){
-      int tnum;
-      char **tokens = tokenize(line, &tnum);
+    int tnum;
+    char **tokens = ttsockgettokens(sock, &tnum);
+    if(tokens){
       if(tnum > 0){
         const char *cmd = tokens[0];
         if(!strcmp(cmd, "set")){
@@ -926,6 +1611,8 @@ static void do_task(TTSOCK *sock, void *opq, TTREQ *req){
           do_mc_replace(sock, arg, req, tokens, tnum);
         } else if(!strcmp(cmd, "get") || !strcmp(cmd, "gets")){
           do_mc_get(sock, arg, req, tokens, tnum);
+        } else if(!strcmp(cmd, "cas")){
+          do_mc_cas(sock, arg, req, tokens, tnum);
         } else if(!strcmp(cmd, "delete")){
           do_mc_delete(sock, arg, req, tokens, tnum);
         } else if(!strcmp(cmd,"addrepl")){
@@ -964,169 +1651,1552 @@ static void do_task(TTSOCK *sock, void *opq, TTREQ *req){
           }
         }
       }
-      tcfree(tokens);
-      tcfree(line);
     }
   }
 }
 
 
-/* tokenize a string */
-static char **tokenize(char *str, int *np){
-  int anum = TOKENUNIT;
-  char **tokens = tcmalloc(sizeof(*tokens) * anum);
-  int tnum = 0;
-  while(*str == ' ' || *str == '\t'){
-    str++;
+/* check whether a request is complete */
+static int do_frame(const char *buf, int size, void *opq){
+  if(size < 1) return 0;
+  if(*(unsigned char *)buf == TTMAGICNUM) return framebin(buf, size);
+  return frametext(buf, size);
+}
+
+
+/* check whether a request of the binary protocol is complete */
+static int framebin(const char *buf, int size){
+  if(size < 2) return 0;
+  int hsiz = 2;
+  int soffs[3];
+  int snum = 0;
+  int loff = -1;
+  int boff = -1;
+  switch(*(unsigned char *)(buf + 1)){
+  case TTCMDPUT:
+  case TTCMDPUTKEEP:
+  case TTCMDPUTCAT:
+  case TTCMDPUTNR:
+    hsiz = 10;
+    soffs[snum++] = 2;
+    soffs[snum++] = 6;
+    break;
+  case TTCMDPUTSHL:
+  case TTCMDPUTTTL:
+    hsiz = 14;
+    soffs[snum++] = 2;
+    soffs[snum++] = 6;
+    break;
+  case TTCMDCAS:
+    hsiz = 10 + sizeof(uint64_t);
+    soffs[snum++] = 2;
+    soffs[snum++] = 6;
+    break;
+  case TTCMDOUT:
+  case TTCMDGET:
+  case TTCMDGETS:
+  case TTCMDVSIZ:
+  case TTCMDCOPY:
+    hsiz = 6;
+    soffs[snum++] = 2;
+    break;
+  case TTCMDMGET:
+  case TTCMDMGETSTRM:
+    hsiz = 6;
+    loff = 2;
+    break;
+  case TTCMDBATCH:
+    hsiz = 6;
+    boff = 2;
+    break;
+  case TTCMDITERINIT:
+  case TTCMDITERNEXT:
+  case TTCMDSYNC:
+  case TTCMDVANISH:
+  case TTCMDRNUM:
+  case TTCMDSIZE:
+  case TTCMDSTAT:
+    break;
+  case TTCMDITERPAGE:
+    hsiz = 6;
+    break;
+  case TTCMDITERPART:
+    hsiz = 10;
+    break;
+  case TTCMDFWMKEYS:
+  case TTCMDADDINT:
+  case TTCMDSETMST:
+    hsiz = 10;
+    soffs[snum++] = 2;
+    break;
+  case TTCMDFWMRECS:
+    hsiz = 18;
+    soffs[snum++] = 2;
+    soffs[snum++] = 6;
+    break;
+  case TTCMDADDDOUBLE:
+    hsiz = 6 + sizeof(uint64_t) * 2;
+    soffs[snum++] = 2;
+    break;
+  case TTCMDEXT:
+    hsiz = 18;
+    soffs[snum++] = 2;
+    soffs[snum++] = 10;
+    soffs[snum++] = 14;
+    break;
+  case TTCMDRESTORE:
+    hsiz = 14;
+    soffs[snum++] = 2;
+    break;
+  case TTCMDMISC:
+    hsiz = 14;
+    soffs[snum++] = 2;
+    loff = 10;
+    break;
+  case TTCMDREPL:
+    hsiz = 14;
+    break;
+  case TTCMDSHM:
+    break;
+  case TTCMDCOMP:
+    hsiz = 10;
+    break;
+  default:
+    return -1;
   }
-  while(*str != '\0'){
-    if(tnum >= anum){
-      anum *= 2;
-      tokens = tcrealloc(tokens, sizeof(*tokens) * anum);
-    }
-    tokens[tnum++] = str;
-    while(*str != '\0' && *str != ' ' && *str != '\t'){
-      str++;
+  if(size < hsiz) return 0;
+  int64_t fsiz = hsiz;
+  for(int i = 0; i < snum; i++){
+    int num = framenum(buf + soffs[i]);
+    if(num < 0) return -1;
+    fsiz += num;
+  }
+  if(fsiz > MAXFRAMESIZ) return -2;
+  if(loff >= 0){
+    int rnum = framenum(buf + loff);
+    if(rnum < 0 || rnum > MAXARGNUM) return -1;
+    for(int i = 0; i < rnum; i++){
+      if(fsiz + sizeof(uint32_t) > size) return 0;
+      int num = framenum(buf + fsiz);
+      if(num < 0) return -1;
+      fsiz += sizeof(uint32_t) + num;
+      if(fsiz > MAXFRAMESIZ) return -2;
     }
-    while(*str == ' ' || *str == '\t'){
-      *(str++) = '\0';
+  }
+  if(boff >= 0){
+    int rnum = framenum(buf + boff);
+    if(rnum < 0 || rnum > MAXARGNUM) return -1;
+    for(int i = 0; i < rnum; i++){
+      if(fsiz + sizeof(uint8_t) + sizeof(uint32_t) * 2 > size) return 0;
+      int ksiz = framenum(buf + fsiz + sizeof(uint8_t));
+      int vsiz = framenum(buf + fsiz + sizeof(uint8_t) + sizeof(uint32_t));
+      if(ksiz < 0 || vsiz < 0) return -1;
+      fsiz += sizeof(uint8_t) + sizeof(uint32_t) * 2 + ksiz + vsiz;
+      if(fsiz > MAXFRAMESIZ) return -2;
     }
   }
-  *np = tnum;
-  return tokens;
+  return (fsiz > size) ? 0 : fsiz;
 }
 
 
-/* get the mutex index of a record */
-static uint32_t recmtxidx(const char *kbuf, int ksiz){
-  uint32_t hash = 725;
-  while(ksiz--){
-    hash = hash * 29 + *(uint8_t *)kbuf++;
+/* check whether a request of the memcached protocol or the HTTP is complete */
+static int frametext(const char *buf, int size){
+  const char *ep = memchr(buf, '\n', size);
+  if(!ep) return (size < MAXARGSIZ) ? 0 : -1;
+  const char *tokens[5];
+  int tsizs[5];
+  int tnum = frametokens(buf, ep, tokens, tsizs, 5);
+  int lsiz = ep - buf + 1;
+  if(tnum >= 5 && ((tsizs[0] == 3 && !memcmp(tokens[0], "set", 3)) ||
+                   (tsizs[0] == 3 && !memcmp(tokens[0], "add", 3)) ||
+                   (tsizs[0] == 7 && !memcmp(tokens[0], "replace", 7)) ||
+                   (tsizs[0] == 3 && !memcmp(tokens[0], "cas", 3)))){
+    char numbuf[NUMBUFSIZ];
+    int nsiz = tclmin(tsizs[4], NUMBUFSIZ - 1);
+    memcpy(numbuf, tokens[4], nsiz);
+    numbuf[nsiz] = '\0';
+    int64_t vsiz = tclmax(tcatoi(numbuf), 0);
+    if(vsiz > MAXARGSIZ) return -1;
+    int64_t fsiz = lsiz + vsiz + 2;
+    return (fsiz > size) ? 0 : fsiz;
   }
-  return hash % RECMTXNUM;
+  if(tnum < 3 || tsizs[2] < 7 || memcmp(tokens[2], "HTTP/1.", 7)) return lsiz;
+  bool body = (tsizs[0] == 3 && !memcmp(tokens[0], "PUT", 3)) ||
+    (tsizs[0] == 4 && !memcmp(tokens[0], "POST", 4));
+  int64_t vsiz = 0;
+  const char *end = buf + size;
+  const char *rp = ep + 1;
+  while(true){
+    if(rp - buf > MAXARGSIZ) return -2;
+    ep = memchr(rp, '\n', end - rp);
+    if(!ep) return (size < MAXARGSIZ) ? 0 : -1;
+    int hsiz = ep - rp;
+    if(hsiz > 0 && rp[hsiz-1] == '\r') hsiz--;
+    if(hsiz < 1) break;
+    if(body && hsiz > 15 && tcstrifwm(rp, "content-length:")){
+      const char *pv = rp + 15;
+      while(*pv == ' ' || *pv == '\t'){
+        pv++;
+      }
+      char numbuf[NUMBUFSIZ];
+      int nsiz = tclmin(rp + hsiz - pv, NUMBUFSIZ - 1);
+      memcpy(numbuf, pv, nsiz);
+      numbuf[nsiz] = '\0';
+      vsiz = tclmax(tcatoi(numbuf), 0);
+      if(vsiz > MAXARGSIZ) return -1;
+    }
+    rp = ep + 1;
+  }
+  int64_t fsiz = ep + 1 - buf + vsiz;
+  return (fsiz > size) ? 0 : fsiz;
 }
 
 
-/* handle the put command */
-static void do_put(TTSOCK *sock, TASKARG *arg, TTREQ *req){
-  ttservlog(g_serv, TTLOGDEBUG, "doing put command");
-  uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
-  int ksiz = ttsockgetint32(sock);
-  int vsiz = ttsockgetint32(sock);
-  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ){
-    ttservlog(g_serv, TTLOGINFO, "do_put: invalid parameters");
-    return;
-  }
-  int rsiz = ksiz + vsiz;
-  char stack[TTIOBUFSIZ];
-  char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
-  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
-    uint8_t code = 0;
-    if(mask & (TTMSKPUT | TTMSKALLORG | TTMSKALLWRITE)){
-      code = 1;
-      ttservlog(g_serv, TTLOGINFO, "do_put: forbidden");
-    } else if(!tculogadbput(ulog, sid, adb, buf, ksiz, buf + ksiz, vsiz)){
-      code = 1;
-      ttservlog(g_serv, TTLOGERROR, "do_put: operation failed");
+/* get a size field of a request of the binary protocol */
+static int framenum(const char *ptr){
+  uint32_t num;
+  memcpy(&num, ptr, sizeof(num));
+  num = TTNTOHL(num);
+  return (num > MAXARGSIZ) ? -1 : num;
+}
+
+
+/* split the first line of a request into tokens */
+static int frametokens(const char *buf, const char *ep, const char **tokens, int *tsizs, int max){
+  int tnum = 0;
+  const char *rp = buf;
+  while(tnum < max){
+    while(rp < ep && (*rp == ' ' || *rp == '\t' || *rp == '\r')){
+      rp++;
     }
-    if(ttsocksend(sock, &code, sizeof(code))){
-      req->keep = true;
-    } else {
-      ttservlog(g_serv, TTLOGINFO, "do_put: response failed");
+    if(rp >= ep) break;
+    tokens[tnum] = rp;
+    while(rp < ep && *rp != ' ' && *rp != '\t' && *rp != '\r'){
+      rp++;
     }
-  } else {
-    ttservlog(g_serv, TTLOGINFO, "do_put: invalid entity");
+    tsizs[tnum] = rp - tokens[tnum];
+    tnum++;
   }
-  pthread_cleanup_pop(1);
+  return tnum;
 }
 
 
-/* handle the putkeep command */
-static void do_putkeep(TTSOCK *sock, TASKARG *arg, TTREQ *req){
-  ttservlog(g_serv, TTLOGDEBUG, "doing putkeep command");
-  uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
-  int ksiz = ttsockgetint32(sock);
-  int vsiz = ttsockgetint32(sock);
-  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ){
-    ttservlog(g_serv, TTLOGINFO, "do_putkeep: invalid parameters");
-    return;
-  }
-  int rsiz = ksiz + vsiz;
-  char stack[TTIOBUFSIZ];
-  char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
-  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
-    uint8_t code = 0;
-    if(mask & (TTMSKPUTKEEP | TTMSKALLORG | TTMSKALLWRITE)){
-      code = 1;
-      ttservlog(g_serv, TTLOGINFO, "do_putkeep: forbidden");
-    } else if(!tculogadbputkeep(ulog, sid, adb, buf, ksiz, buf + ksiz, vsiz)){
-      code = 1;
+/* get the command mask of a complete request */
+static uint64_t framemask(const char *buf, int size, int *pp){
+  if(*(unsigned char *)buf == TTMAGICNUM){
+    *pp = PROTBIN;
+    switch(*(unsigned char *)(buf + 1)){
+    case TTCMDPUT: return TTMSKPUT | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDPUTKEEP: return TTMSKPUTKEEP | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDPUTCAT: return TTMSKPUTCAT | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDPUTSHL: return TTMSKPUTSHL | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDPUTTTL: return TTMSKPUT | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDPUTNR: return TTMSKPUTNR | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDCAS: return TTMSKCAS | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDBATCH: return TTMSKBATCH | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDOUT: return TTMSKOUT | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDGET: return TTMSKGET | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDGETS: return TTMSKGET | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDMGET: return TTMSKMGET | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDMGETSTRM: return TTMSKMGET | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDVSIZ: return TTMSKVSIZ | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDITERINIT: return TTMSKITERINIT | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDITERNEXT: return TTMSKITERNEXT | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDITERPAGE: return TTMSKITERPAGE | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDITERPART: return TTMSKITERINIT | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDFWMKEYS: return TTMSKFWMKEYS | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDFWMRECS: return TTMSKFWMKEYS | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDADDINT: return TTMSKADDINT | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDADDDOUBLE: return TTMSKADDDOUBLE | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDEXT: return TTMSKEXT | TTMSKALLORG;
+    case TTCMDSYNC: return TTMSKSYNC | TTMSKALLORG | TTMSKALLMANAGE;
+    case TTCMDVANISH: return TTMSKVANISH | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDCOPY: return TTMSKCOPY | TTMSKALLORG | TTMSKALLMANAGE;
+    case TTCMDRESTORE: return TTMSKRESTORE | TTMSKALLORG | TTMSKALLMANAGE;
+    case TTCMDSETMST: return TTMSKSETMST | TTMSKALLORG | TTMSKALLMANAGE;
+    case TTCMDRNUM: return TTMSKRNUM | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDSIZE: return TTMSKSIZE | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDSTAT: return TTMSKSTAT | TTMSKALLORG | TTMSKALLREAD;
+    case TTCMDMISC: return TTMSKMISC | TTMSKALLORG | TTMSKALLWRITE;
+    case TTCMDSHM: return TTMSKALLORG;
+    case TTCMDCOMP: return TTMSKALLORG;
     }
-    if(ttsocksend(sock, &code, sizeof(code))){
-      req->keep = true;
-    } else {
-      ttservlog(g_serv, TTLOGINFO, "do_putkeep: response failed");
+    return 0;
+  }
+  const char *tokens[3];
+  int tsizs[3];
+  int tnum = frametokens(buf, buf + size, tokens, tsizs, 3);
+  if(tnum < 1) return 0;
+  const char *cmd = tokens[0];
+  int csiz = tsizs[0];
+  if(tnum > 2 && tsizs[2] >= 7 && !memcmp(tokens[2], "HTTP/1.", 7)){
+    *pp = PROTHTTP;
+    if(csiz == 3 && !memcmp(cmd, "GET", 3)) return TTMSKGET | TTMSKALLHTTP | TTMSKALLREAD;
+    if(csiz == 4 && !memcmp(cmd, "HEAD", 4)) return TTMSKVSIZ | TTMSKALLHTTP | TTMSKALLREAD;
+    if(csiz == 3 && !memcmp(cmd, "PUT", 3)) return TTMSKPUT | TTMSKALLHTTP | TTMSKALLWRITE;
+    if(csiz == 4 && !memcmp(cmd, "POST", 4)) return TTMSKEXT | TTMSKALLHTTP;
+    if(csiz == 6 && !memcmp(cmd, "DELETE", 6)) return TTMSKOUT | TTMSKALLHTTP | TTMSKALLWRITE;
+    return 0;
+  }
+  *pp = PROTMC;
+  if((csiz == 3 && !memcmp(cmd, "set", 3)) || (csiz == 7 && !memcmp(cmd, "replace", 7)))
+    return TTMSKPUT | TTMSKALLMC | TTMSKALLWRITE;
+  if(csiz == 3 && !memcmp(cmd, "add", 3)) return TTMSKPUTKEEP | TTMSKALLMC | TTMSKALLWRITE;
+  if(csiz == 3 && !memcmp(cmd, "cas", 3)) return TTMSKCAS | TTMSKALLMC | TTMSKALLWRITE;
+  if((csiz == 3 && !memcmp(cmd, "get", 3)) || (csiz == 4 && !memcmp(cmd, "gets", 4)))
+    return TTMSKGET | TTMSKALLMC | TTMSKALLREAD;
+  if(csiz == 6 && !memcmp(cmd, "delete", 6)) return TTMSKOUT | TTMSKALLMC | TTMSKALLWRITE;
+  if((csiz == 4 && !memcmp(cmd, "incr", 4)) || (csiz == 4 && !memcmp(cmd, "decr", 4)))
+    return TTMSKADDINT | TTMSKALLMC | TTMSKALLWRITE;
+  if((csiz == 5 && !memcmp(cmd, "stats", 5)) || (csiz == 7 && !memcmp(cmd, "version", 7)))
+    return TTMSKSTAT | TTMSKALLMC | TTMSKALLREAD;
+  if(csiz == 9 && !memcmp(cmd, "flush_all", 9)) return TTMSKVANISH | TTMSKALLMC | TTMSKALLWRITE;
+  return 0;
+}
+
+
+/* reject a request of low priority while the server is overloaded */
+static bool do_shed(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  int psiz;
+  const char *pbuf = ttsockpeek(sock, &psiz);
+  int fsiz = do_frame(pbuf, psiz, NULL);
+  if(fsiz < 1) return false;
+  int prot = PROTBIN;
+  if(!(framemask(pbuf, fsiz, &prot) & arg->shed)) return false;
+  char stack[LINEBUFSIZ];
+  int len = 0;
+  bool keep = true;
+  if(prot == PROTBIN){
+    uint8_t cmd = *(unsigned char *)(pbuf + 1);
+    stack[len++] = TTCODEBUSY;
+    if(cmd == TTCMDMGET || cmd == TTCMDMGETSTRM || cmd == TTCMDFWMRECS || cmd == TTCMDMISC){
+      memset(stack + len, 0, sizeof(uint32_t));
+      len += sizeof(uint32_t);
     }
+  } else if(prot == PROTMC){
+    const char *ep = memchr(pbuf, '\n', fsiz);
+    const char *tokens[8];
+    int tsizs[8];
+    int tnum = frametokens(pbuf, ep, tokens, tsizs, 8);
+    if(tnum < 1 || tsizs[tnum-1] != 7 || memcmp(tokens[tnum-1], "noreply", 7))
+      len = sprintf(stack, "SERVER_ERROR busy\r\n");
   } else {
-    ttservlog(g_serv, TTLOGINFO, "do_putkeep: invalid entity");
+    const char *tokens[3];
+    int tsizs[3];
+    frametokens(pbuf, memchr(pbuf, '\n', fsiz), tokens, tsizs, 3);
+    keep = tcatoi(tokens[2] + 7) >= 1;
+    char *wp = stack;
+    wp += sprintf(wp, "HTTP/1.1 503 Service Unavailable\r\n");
+    wp += sprintf(wp, "Content-Type: text/plain\r\n");
+    wp += sprintf(wp, "Content-Length: %d\r\n", (int)strlen("Busy\n"));
+    wp += sprintf(wp, "Retry-After: 1\r\n");
+    if(!keep) wp += sprintf(wp, "Connection: close\r\n");
+    wp += sprintf(wp, "\r\n");
+    wp += sprintf(wp, "Busy\n");
+    len = wp - stack;
   }
-  pthread_cleanup_pop(1);
+  __atomic_add_fetch(arg->shednums + prot, 1, __ATOMIC_RELAXED);
+  ttservlog(g_serv, TTLOGDEBUG, "do_shed: request shed");
+  if(!ttsockskip(sock, fsiz)) return true;
+  if(len < 1 || ttsocksend(sock, stack, len)){
+    req->keep = keep;
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_shed: response failed");
+  }
+  return true;
 }
 
 
-/* handle the putcat command */
-static void do_putcat(TTSOCK *sock, TASKARG *arg, TTREQ *req){
-  ttservlog(g_serv, TTLOGDEBUG, "doing putcat command");
-  uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
-  int ksiz = ttsockgetint32(sock);
-  int vsiz = ttsockgetint32(sock);
-  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ){
-    ttservlog(g_serv, TTLOGINFO, "do_putcat: invalid parameters");
-    return;
+/* get the mutex index of a record */
+static uint32_t recmtxidx(const char *kbuf, int ksiz){
+  uint32_t hash = 725;
+  while(ksiz--){
+    hash = hash * 29 + *(uint8_t *)kbuf++;
   }
-  int rsiz = ksiz + vsiz;
-  char stack[TTIOBUFSIZ];
-  char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
-  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
-    uint8_t code = 0;
-    if(mask & (TTMSKPUTCAT | TTMSKALLORG | TTMSKALLWRITE)){
-      code = 1;
-      ttservlog(g_serv, TTLOGINFO, "do_putcat: forbidden");
-    } else if(!tculogadbputcat(ulog, sid, adb, buf, ksiz, buf + ksiz, vsiz)){
-      code = 1;
-      ttservlog(g_serv, TTLOGERROR, "do_putcat: operation failed");
-    }
-    if(ttsocksend(sock, &code, sizeof(code))){
-      req->keep = true;
-    } else {
-      ttservlog(g_serv, TTLOGINFO, "do_putcat: response failed");
-    }
-  } else {
-    ttservlog(g_serv, TTLOGINFO, "do_putcat: invalid entity");
+  return hash % RECMTXNUM;
+}
+
+
+/* create a version table of records */
+static VERTAB *vertabnew(void){
+  VERTAB *vtab = tcmalloc(sizeof(*vtab));
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  vtab->clock = (uint64_t)(tctime() * 1000000);
+  vtab->floor = vtab->clock;
+  for(int i = 0; i < VERMTXNUM; i++){
+    if(pthread_mutex_init(vtab->mtxs + i, &attr) != 0)
+      ttservlog(g_serv, TTLOGERROR, "pthread_mutex_init failed");
+    vtab->stamps[i] = tcmapnew2(VERSHARDMAX * 2 + 1);
+    vtab->floors[i] = vtab->clock;
   }
-  pthread_cleanup_pop(1);
+  pthread_mutexattr_destroy(&attr);
+  return vtab;
 }
 
 
-/* handle the putshl command */
+/* delete a version table of records */
+static void vertabdel(VERTAB *vtab){
+  for(int i = 0; i < VERMTXNUM; i++){
+    tcmapdel(vtab->stamps[i]);
+    if(pthread_mutex_destroy(vtab->mtxs + i) != 0)
+      ttservlog(g_serv, TTLOGERROR, "pthread_mutex_destroy failed");
+  }
+  tcfree(vtab);
+}
+
+
+/* get the version shard of a record */
+static int verslot(const char *kbuf, int ksiz){
+  uint32_t hash = 2166136261U;
+  while(ksiz--){
+    hash = (hash ^ *(uint8_t *)kbuf++) * 16777619U;
+  }
+  return hash % VERMTXNUM;
+}
+
+
+/* lock the version shard of a record */
+static int verlock(VERTAB *vtab, const char *kbuf, int ksiz){
+  int slot = verslot(kbuf, ksiz);
+  if(pthread_mutex_lock(vtab->mtxs + slot) != 0){
+    ttservlog(g_serv, TTLOGERROR, "verlock: pthread_mutex_lock failed");
+    return -1;
+  }
+  return slot;
+}
+
+
+/* unlock the version shard of a record and stamp the record if it was modified */
+static uint64_t verunlock(VERTAB *vtab, int slot, const char *kbuf, int ksiz, bool mod){
+  if(slot < 0) return 0;
+  uint64_t ver = mod ? verstamp(vtab, slot, kbuf, ksiz) : 0;
+  pthread_mutex_unlock(vtab->mtxs + slot);
+  return ver;
+}
+
+
+/* stamp a new version on a record in its locked shard */
+static uint64_t verstamp(VERTAB *vtab, int slot, const char *kbuf, int ksiz){
+  TCMAP *stamps = vtab->stamps[slot];
+  uint64_t ver = __atomic_add_fetch(&vtab->clock, 1, __ATOMIC_SEQ_CST);
+  tcmapput3(stamps, kbuf, ksiz, &ver, sizeof(ver));
+  while(tcmaprnum(stamps) > VERSHARDMAX){
+    tcmapiterinit(stamps);
+    int osiz;
+    const char *obuf = tcmapiternext(stamps, &osiz);
+    int vsiz;
+    const uint64_t *vp = tcmapget(stamps, obuf, osiz, &vsiz);
+    vtab->floors[slot] = *vp;
+    tcmapout(stamps, obuf, osiz);
+  }
+  return ver;
+}
+
+
+/* get the version token of a record */
+static uint64_t vertoken(VERTAB *vtab, const char *kbuf, int ksiz){
+  int slot = verlock(vtab, kbuf, ksiz);
+  if(slot < 0) return 0;
+  int vsiz;
+  const uint64_t *vp = tcmapget(vtab->stamps[slot], kbuf, ksiz, &vsiz);
+  uint64_t ver = vp ? *vp : vtab->floors[slot];
+  pthread_mutex_unlock(vtab->mtxs + slot);
+  uint64_t floor = __atomic_load_n(&vtab->floor, __ATOMIC_ACQUIRE);
+  return ver > floor ? ver : floor;
+}
+
+
+/* invalidate the version tokens of all records */
+static void verexpire(VERTAB *vtab){
+  uint64_t ver = __atomic_add_fetch(&vtab->clock, 1, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&vtab->floor, ver, __ATOMIC_RELEASE);
+}
+
+
+/* stamp the versions and update the expiration times of records modified through the update log */
+static void recmod(void *opq, const void *kbuf, int ksiz, int phase, int64_t xt){
+  MODARG *marg = opq;
+  VERTAB *vtab = marg->vtab;
+  if(ksiz < 0){
+    if(xt == 0) ttlclear(marg->ttab);
+    verexpire(vtab);
+    return;
+  }
+  int slot;
+  switch(phase){
+    case TCULMODBEGIN:
+      verlock(vtab, kbuf, ksiz);
+      break;
+    case TCULMODEND:
+      ttlset(marg->ttab, kbuf, ksiz, xt);
+      verunlock(vtab, verslot(kbuf, ksiz), kbuf, ksiz, true);
+      break;
+    default:
+      slot = verlock(vtab, kbuf, ksiz);
+      ttlset(marg->ttab, kbuf, ksiz, xt);
+      verunlock(vtab, slot, kbuf, ksiz, true);
+      break;
+  }
+}
+
+
+/* lock the version shards of a batch of records in ascending order */
+static void verlockops(VERTAB *vtab, const TCULOP *ops, int onum, bool *lcks){
+  for(int i = 0; i < VERMTXNUM; i++){
+    lcks[i] = false;
+  }
+  for(int i = 0; i < onum; i++){
+    lcks[verslot(ops[i].kbuf, ops[i].ksiz)] = true;
+  }
+  for(int i = 0; i < VERMTXNUM; i++){
+    if(lcks[i] && pthread_mutex_lock(vtab->mtxs + i) != 0){
+      lcks[i] = false;
+      ttservlog(g_serv, TTLOGERROR, "verlockops: pthread_mutex_lock failed");
+    }
+  }
+}
+
+
+/* unlock the version shards of a batch of records and stamp the modified ones */
+static void verunlockops(VERTAB *vtab, const TCULOP *ops, int onum, bool *lcks){
+  for(int i = 0; i < onum; i++){
+    if(!ops[i].ok) continue;
+    int slot = verslot(ops[i].kbuf, ops[i].ksiz);
+    if(lcks[slot]) verstamp(vtab, slot, ops[i].kbuf, ops[i].ksiz);
+  }
+  for(int i = VERMTXNUM - 1; i >= 0; i--){
+    if(lcks[i]) pthread_mutex_unlock(vtab->mtxs + i);
+  }
+}
+
+
+/* create an expiration table, which is stored beside the database file if there is one */
+static TTLTAB *ttltabnew(TCADB *adb){
+  TTLTAB *ttab = tcmalloc(sizeof(*ttab));
+  for(int i = 0; i < TTLMTXNUM; i++){
+    if(pthread_mutex_init(ttab->mtxs + i, NULL) != 0)
+      ttservlog(g_serv, TTLOGERROR, "pthread_mutex_init failed");
+    ttab->xts[i] = tcmapnew2(TTLMTXNUM);
+    ttab->idxs[i] = tctreenew();
+  }
+  ttab->num = 0;
+  ttab->hdb = NULL;
+  const char *path = tcadbpath(adb);
+  if(!path || *path == '*' || *path == '+') return ttab;
+  char *xpath = tcsprintf("%s.ttl", path);
+  TCHDB *hdb = tchdbnew();
+  tchdbsetmutex(hdb);
+  if(!tchdbopen(hdb, xpath, HDBOWRITER | HDBOCREAT)){
+    ttservlog(g_serv, TTLOGERROR, "tchdbopen failed: %s", xpath);
+    tchdbdel(hdb);
+    tcfree(xpath);
+    return ttab;
+  }
+  tcfree(xpath);
+  TCLIST *keys = tclistnew();
+  TCXSTR *kxstr = tcxstrnew();
+  TCXSTR *vxstr = tcxstrnew();
+  tchdbiterinit(hdb);
+  while(tchdbiternext3(hdb, kxstr, vxstr)){
+    const char *kbuf = tcxstrptr(kxstr);
+    int ksiz = tcxstrsize(kxstr);
+    uint64_t llnum;
+    if(tcxstrsize(vxstr) != sizeof(llnum) || tcadbvsiz(adb, kbuf, ksiz) < 0){
+      tclistpush(keys, kbuf, ksiz);
+      continue;
+    }
+    memcpy(&llnum, tcxstrptr(vxstr), sizeof(llnum));
+    ttlset(ttab, kbuf, ksiz, (int64_t)TTNTOHLL(llnum));
+  }
+  tcxstrdel(vxstr);
+  tcxstrdel(kxstr);
+  for(int i = 0; i < tclistnum(keys); i++){
+    int ksiz;
+    const char *kbuf = tclistval(keys, i, &ksiz);
+    tchdbout(hdb, kbuf, ksiz);
+  }
+  tclistdel(keys);
+  ttab->hdb = hdb;
+  ttservlog(g_serv, TTLOGSYSTEM, "expiration table loaded: records=%lld", (long long)ttab->num);
+  return ttab;
+}
+
+
+/* delete an expiration table */
+static void ttltabdel(TTLTAB *ttab){
+  if(ttab->hdb){
+    if(!tchdbclose(ttab->hdb)) ttservlog(g_serv, TTLOGERROR, "tchdbclose failed");
+    tchdbdel(ttab->hdb);
+  }
+  for(int i = TTLMTXNUM - 1; i >= 0; i--){
+    tctreedel(ttab->idxs[i]);
+    tcmapdel(ttab->xts[i]);
+    if(pthread_mutex_destroy(ttab->mtxs + i) != 0)
+      ttservlog(g_serv, TTLOGERROR, "pthread_mutex_destroy failed");
+  }
+  tcfree(ttab);
+}
+
+
+/* get the expiration time of a record, or 0 if it does not expire */
+static int64_t ttlget(TTLTAB *ttab, const char *kbuf, int ksiz){
+  if(__atomic_load_n(&ttab->num, __ATOMIC_ACQUIRE) < 1) return 0;
+  int idx = verslot(kbuf, ksiz) % TTLMTXNUM;
+  if(pthread_mutex_lock(ttab->mtxs + idx) != 0){
+    ttservlog(g_serv, TTLOGERROR, "ttlget: pthread_mutex_lock failed");
+    return 0;
+  }
+  int64_t xt = 0;
+  int xsiz;
+  const char *xbuf = tcmapget(ttab->xts[idx], kbuf, ksiz, &xsiz);
+  if(xbuf && xsiz == sizeof(xt)) memcpy(&xt, xbuf, sizeof(xt));
+  pthread_mutex_unlock(ttab->mtxs + idx);
+  return xt;
+}
+
+
+/* set the expiration time of a record, where 0 means no expiration and a negative value keeps
+   the current one */
+static void ttlset(TTLTAB *ttab, const char *kbuf, int ksiz, int64_t xt){
+  if(xt < 0 || (xt == 0 && __atomic_load_n(&ttab->num, __ATOMIC_ACQUIRE) < 1)) return;
+  int idx = verslot(kbuf, ksiz) % TTLMTXNUM;
+  if(pthread_mutex_lock(ttab->mtxs + idx) != 0){
+    ttservlog(g_serv, TTLOGERROR, "ttlset: pthread_mutex_lock failed");
+    return;
+  }
+  TCMAP *xts = ttab->xts[idx];
+  TCTREE *tree = ttab->idxs[idx];
+  int isiz = sizeof(uint64_t) + ksiz;
+  char stack[TTIOBUFSIZ];
+  char *ibuf = (isiz < TTIOBUFSIZ) ? stack : tcmalloc(isiz);
+  memcpy(ibuf + sizeof(uint64_t), kbuf, ksiz);
+  uint64_t llnum;
+  int xsiz;
+  const char *xbuf = tcmapget(xts, kbuf, ksiz, &xsiz);
+  if(xbuf){
+    int64_t oxt;
+    memcpy(&oxt, xbuf, sizeof(oxt));
+    llnum = TTHTONLL((uint64_t)oxt);
+    memcpy(ibuf, &llnum, sizeof(llnum));
+    tctreeout(tree, ibuf, isiz);
+    if(xt == 0){
+      tcmapout(xts, kbuf, ksiz);
+      __atomic_sub_fetch(&ttab->num, 1, __ATOMIC_RELEASE);
+      if(ttab->hdb) tchdbout(ttab->hdb, kbuf, ksiz);
+    }
+  }
+  if(xt > 0){
+    tcmapput(xts, kbuf, ksiz, &xt, sizeof(xt));
+    llnum = TTHTONLL((uint64_t)xt);
+    memcpy(ibuf, &llnum, sizeof(llnum));
+    tctreeput(tree, ibuf, isiz, "", 0);
+    if(!xbuf) __atomic_add_fetch(&ttab->num, 1, __ATOMIC_RELEASE);
+    if(ttab->hdb) tchdbput(ttab->hdb, kbuf, ksiz, &llnum, sizeof(llnum));
+  }
+  if(ibuf != stack) tcfree(ibuf);
+  pthread_mutex_unlock(ttab->mtxs + idx);
+}
+
+
+/* check whether a record has expired */
+static bool ttlexpired(TTLTAB *ttab, const char *kbuf, int ksiz){
+  int64_t xt = ttlget(ttab, kbuf, ksiz);
+  return xt > 0 && xt <= (int64_t)tctime();
+}
+
+
+/* clear the expiration times of all records */
+static void ttlclear(TTLTAB *ttab){
+  for(int i = 0; i < TTLMTXNUM; i++){
+    if(pthread_mutex_lock(ttab->mtxs + i) != 0){
+      ttservlog(g_serv, TTLOGERROR, "ttlclear: pthread_mutex_lock failed");
+      continue;
+    }
+    __atomic_sub_fetch(&ttab->num, tcmaprnum(ttab->xts[i]), __ATOMIC_RELEASE);
+    tcmapclear(ttab->xts[i]);
+    tctreeclear(ttab->idxs[i]);
+    pthread_mutex_unlock(ttab->mtxs + i);
+  }
+  if(ttab->hdb) tchdbvanish(ttab->hdb);
+}
+
+
+/* get the expiration time from the exptime token of the memcached protocol */
+static int64_t ttlmcxt(const char *str){
+  int64_t num = tcatoi(str);
+  if(num == 0) return 0;
+  if(num < 0) return 1;
+  if(num <= TTLRELMAX) return (int64_t)tctime() + num;
+  return num;
+}
+
+
+/* remove a record if it has expired, while the version slot of the record is locked */
+static bool ttlpurge(TASKARG *arg, const char *kbuf, int ksiz){
+  if(!ttlexpired(arg->ttab, kbuf, ksiz)) return false;
+  return tculogadbout(arg->ulog, arg->sid, arg->adb, kbuf, ksiz) ||
+    tcadbvsiz(arg->adb, kbuf, ksiz) < 0;
+}
+
+
+/* retrieve a record unless it has expired or the Bloom filter rules it out */
+static char *recget(TASKARG *arg, const char *kbuf, int ksiz, int *sp){
+  TTBLOOM *bloom = arg->ulog->bloom;
+  if(bloom && !ttbloomcheck(bloom, kbuf, ksiz)) return NULL;
+  if(ttlexpired(arg->ttab, kbuf, ksiz)) return NULL;
+  TTCACHE *cache = arg->ulog->cache;
+  uint64_t gen = 0;
+  char *vbuf;
+  if(cache && (vbuf = ttcacheget(cache, kbuf, ksiz, sp, &gen)) != NULL) return vbuf;
+  vbuf = tcadbget(arg->adb, kbuf, ksiz, sp);
+  if(vbuf){
+    if(cache) ttcacheput(cache, kbuf, ksiz, vbuf, *sp, gen);
+  } else if(bloom){
+    ttbloomfalse(bloom);
+  }
+  return vbuf;
+}
+
+
+/* get the size of the value of a record unless it has expired or the Bloom filter rules it out */
+static int recvsiz(TASKARG *arg, const char *kbuf, int ksiz){
+  TTBLOOM *bloom = arg->ulog->bloom;
+  if(bloom && !ttbloomcheck(bloom, kbuf, ksiz)) return -1;
+  if(ttlexpired(arg->ttab, kbuf, ksiz)) return -1;
+  int vsiz = tcadbvsiz(arg->adb, kbuf, ksiz);
+  if(vsiz < 0 && bloom) ttbloomfalse(bloom);
+  return vsiz;
+}
+
+
+/* store a record with an expiration time and stamp its version, where a negative expiration time
+   keeps the current one */
+static bool recput(TASKARG *arg, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                   int64_t xt){
+  int slot = verlock(arg->vtab, kbuf, ksiz);
+  bool mod = ttlpurge(arg, kbuf, ksiz);
+  if(xt < 0) xt = ttlget(arg->ttab, kbuf, ksiz);
+  bool rv = tculogadbput(arg->ulog, arg->sid, arg->adb, kbuf, ksiz, vbuf, vsiz);
+  if(rv && xt > 0) tculogputxt(arg->ulog, arg->sid, kbuf, ksiz, xt);
+  verunlock(arg->vtab, slot, kbuf, ksiz, rv || mod);
+  return rv;
+}
+
+
+/* store a new record with an expiration time and stamp its version */
+static bool recputkeep(TASKARG *arg, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                       int64_t xt){
+  int slot = verlock(arg->vtab, kbuf, ksiz);
+  bool mod = ttlpurge(arg, kbuf, ksiz);
+  bool rv = tculogadbputkeep(arg->ulog, arg->sid, arg->adb, kbuf, ksiz, vbuf, vsiz);
+  if(rv && xt > 0) tculogputxt(arg->ulog, arg->sid, kbuf, ksiz, xt);
+  verunlock(arg->vtab, slot, kbuf, ksiz, rv || mod);
+  return rv;
+}
+
+
+/* concatenate a value at the end of a record and stamp its version */
+static bool recputcat(TASKARG *arg, const char *kbuf, int ksiz, const char *vbuf, int vsiz){
+  int slot = verlock(arg->vtab, kbuf, ksiz);
+  bool mod = ttlpurge(arg, kbuf, ksiz);
+  bool rv = tculogadbputcat(arg->ulog, arg->sid, arg->adb, kbuf, ksiz, vbuf, vsiz);
+  verunlock(arg->vtab, slot, kbuf, ksiz, rv || mod);
+  return rv;
+}
+
+
+/* remove a record and stamp its version */
+static bool recout(TASKARG *arg, const char *kbuf, int ksiz){
+  int slot = verlock(arg->vtab, kbuf, ksiz);
+  bool mod = ttlpurge(arg, kbuf, ksiz);
+  bool rv = tculogadbout(arg->ulog, arg->sid, arg->adb, kbuf, ksiz);
+  verunlock(arg->vtab, slot, kbuf, ksiz, rv || mod);
+  return rv;
+}
+
+
+/* add an integer to a record and stamp its version */
+static int recaddint(TASKARG *arg, const char *kbuf, int ksiz, int num){
+  int slot = verlock(arg->vtab, kbuf, ksiz);
+  bool mod = ttlpurge(arg, kbuf, ksiz);
+  int rv = tculogadbaddint(arg->ulog, arg->sid, arg->adb, kbuf, ksiz, num);
+  verunlock(arg->vtab, slot, kbuf, ksiz, rv != INT_MIN || mod);
+  return rv;
+}
+
+
+/* add a real number to a record and stamp its version */
+static double recadddouble(TASKARG *arg, const char *kbuf, int ksiz, double num){
+  int slot = verlock(arg->vtab, kbuf, ksiz);
+  bool mod = ttlpurge(arg, kbuf, ksiz);
+  double rv = tculogadbadddouble(arg->ulog, arg->sid, arg->adb, kbuf, ksiz, num);
+  verunlock(arg->vtab, slot, kbuf, ksiz, !isnan(rv) || mod);
+  return rv;
+}
+
+
+/* store a record only if its version token is not changed since it was fetched */
+static int reccas(TASKARG *arg, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                  uint64_t ver, int64_t xt, uint64_t *verp){
+  *verp = 0;
+  int slot = verlock(arg->vtab, kbuf, ksiz);
+  if(slot < 0) return -1;
+  bool mod = ttlpurge(arg, kbuf, ksiz);
+  if(xt < 0) xt = ttlget(arg->ttab, kbuf, ksiz);
+  int rv;
+  if(tcadbvsiz(arg->adb, kbuf, ksiz) < 0){
+    rv = 2;
+  } else if(vertoken(arg->vtab, kbuf, ksiz) != ver){
+    rv = 1;
+  } else if(tculogadbput(arg->ulog, arg->sid, arg->adb, kbuf, ksiz, vbuf, vsiz)){
+    if(xt > 0) tculogputxt(arg->ulog, arg->sid, kbuf, ksiz, xt);
+    rv = 0;
+  } else {
+    rv = -1;
+  }
+  *verp = verunlock(arg->vtab, slot, kbuf, ksiz, rv == 0 || mod);
+  return rv;
+}
+
+
+/* create a vectored response object, which is valid until the arena is reset */
+static RESVEC *resvecnew(TTARENA *arena){
+  RESVEC *resv = ttarenaalloc(arena, sizeof(*resv));
+  resv->arena = arena;
+  resv->head = ttarenaxstr(arena);
+  resv->vals = ttarenaxstr(arena);
+  resv->cuts = ttarenaxstr(arena);
+  return resv;
+}
+
+
+/* add a value to a vectored response object */
+static void resvecaddval(RESVEC *resv, char *vbuf, int vsiz){
+  if(vsiz <= RESVCOPYMAX){
+    tcxstrcat(resv->head, vbuf, vsiz);
+    tcfree(vbuf);
+    return;
+  }
+  ttarenaown(resv->arena, vbuf);
+  int off = tcxstrsize(resv->head);
+  tcxstrcat(resv->cuts, &off, sizeof(off));
+  struct iovec val;
+  val.iov_base = vbuf;
+  val.iov_len = vsiz;
+  tcxstrcat(resv->vals, &val, sizeof(val));
+}
+
+
+/* send a vectored response object, never compressed if the request object is `NULL' */
+static bool resvecsend(RESVEC *resv, TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  const char *hbuf = tcxstrptr(resv->head);
+  int hsiz = tcxstrsize(resv->head);
+  const int *cuts = tcxstrptr(resv->cuts);
+  int cnum = tcxstrsize(resv->cuts) / sizeof(*cuts);
+  const struct iovec *vals = tcxstrptr(resv->vals);
+  struct iovec *iov = ttarenaalloc(resv->arena, sizeof(*iov) * (cnum * 2 + 1));
+  int inum = 0;
+  int off = 0;
+  for(int i = 0; i < cnum; i++){
+    if(cuts[i] > off){
+      iov[inum].iov_base = (char *)hbuf + off;
+      iov[inum].iov_len = cuts[i] - off;
+      inum++;
+      off = cuts[i];
+    }
+    iov[inum++] = vals[i];
+  }
+  if(hsiz > off){
+    iov[inum].iov_base = (char *)hbuf + off;
+    iov[inum].iov_len = hsiz - off;
+    inum++;
+  }
+  return sendres(sock, arg, req, iov, inum);
+}
+
+
+/* compress a response into a compressed frame */
+static char *compframe(int codec, const char *ptr, int size, int *sp){
+  int zsiz;
+  char *zbuf = ttcompress(codec, ptr, size, &zsiz);
+  if(!zbuf) return NULL;
+  if(zsiz + COMPHEADSIZ >= size){
+    tcfree(zbuf);
+    return NULL;
+  }
+  char *buf = tcmalloc(zsiz + COMPHEADSIZ);
+  unsigned char *wp = (unsigned char *)buf;
+  *(wp++) = TTCODECOMP;
+  *(wp++) = codec;
+  uint32_t num;
+  num = TTHTONL((uint32_t)size);
+  memcpy(wp, &num, sizeof(num));
+  wp += sizeof(num);
+  num = TTHTONL((uint32_t)zsiz);
+  memcpy(wp, &num, sizeof(num));
+  wp += sizeof(num);
+  memcpy(wp, zbuf, zsiz);
+  tcfree(zbuf);
+  *sp = zsiz + COMPHEADSIZ;
+  return buf;
+}
+
+
+/* send a response, compressed if the connection has agreed on it */
+static bool sendres(TTSOCK *sock, TASKARG *arg, TTREQ *req, struct iovec *iov, int iovcnt){
+  uint32_t copts = req ? ttservconnopts(g_serv, req->cfd) : 0;
+  int codec = copts & 0xff;
+  if(codec == TTZNONE) return ttsocksendv(sock, iov, iovcnt);
+  int size = 0;
+  for(int i = 0; i < iovcnt; i++){
+    size += iov[i].iov_len;
+  }
+  if(size < (int)(copts >> 8)) return ttsocksendv(sock, iov, iovcnt);
+  char *buf;
+  if(iovcnt == 1){
+    buf = iov[0].iov_base;
+  } else {
+    buf = tcmalloc(size);
+    char *wp = buf;
+    for(int i = 0; i < iovcnt; i++){
+      memcpy(wp, iov[i].iov_base, iov[i].iov_len);
+      wp += iov[i].iov_len;
+    }
+  }
+  int zsiz;
+  char *zbuf = compframe(codec, buf, size, &zsiz);
+  if(buf != iov[0].iov_base) tcfree(buf);
+  if(!zbuf) return ttsocksendv(sock, iov, iovcnt);
+  __atomic_add_fetch(&arg->zinsum, size, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&arg->zoutsum, zsiz, __ATOMIC_RELAXED);
+  bool rv;
+  pthread_cleanup_push(free, zbuf);
+  rv = ttsocksend(sock, zbuf, zsiz);
+  pthread_cleanup_pop(1);
+  return rv;
+}
+
+
+/* read the keys of a multiple retrieval */
+static MGETKEY *mgetkeys(TTSOCK *sock, TTARENA *arena, int rnum, int *np){
+  MGETKEY *keys = ttarenaalloc(arena, sizeof(*keys) * rnum);
+  int knum = 0;
+  for(int i = 0; i < rnum; i++){
+    int ksiz = ttsockgetint32(sock);
+    if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ) break;
+    char *buf = ttarenaalloc(arena, ksiz + 1);
+    if(ttsockrecv(sock, buf, ksiz)){
+      buf[ksiz] = '\0';
+      keys[knum].kbuf = buf;
+      keys[knum].ksiz = ksiz;
+      knum++;
+    }
+  }
+  *np = knum;
+  return keys;
+}
+
+
+/* compare two keys of a multiple retrieval in the lexical order */
+static int mgetkeycmp(const void *a, const void *b){
+  const MGETKEY *ka = a;
+  const MGETKEY *kb = b;
+  int rv = memcmp(ka->kbuf, kb->kbuf, tclmin(ka->ksiz, kb->ksiz));
+  if(rv != 0) return rv;
+  return (ka->ksiz > kb->ksiz) - (ka->ksiz < kb->ksiz);
+}
+
+
+/* compare two keys of a multiple retrieval in the order of record IDs */
+static int mgetkeycmpid(const void *a, const void *b){
+  int64_t ida = tcatoi(((const MGETKEY *)a)->kbuf);
+  int64_t idb = tcatoi(((const MGETKEY *)b)->kbuf);
+  if(ida != idb) return (ida > idb) ? 1 : -1;
+  return mgetkeycmp(a, b);
+}
+
+
+/* sort the keys of a multiple retrieval in the order of locality and remove duplication */
+static int mgetsort(MGETKEY *keys, int knum, TCADB *adb){
+  if(knum < 2) return knum;
+  int (*cmp)(const void *, const void *) =
+    (tcadbomode(adb) == ADBOFDB) ? mgetkeycmpid : mgetkeycmp;
+  qsort(keys, knum, sizeof(*keys), cmp);
+  int nnum = 1;
+  for(int i = 1; i < knum; i++){
+    if(cmp(keys + i, keys + nnum - 1) != 0) keys[nnum++] = keys[i];
+  }
+  return nnum;
+}
+
+
+/* send a chunk of a streamed response with an optional value and clear the chunk */
+static bool strmflush(TTSOCK *sock, TASKARG *arg, TTREQ *req, TCXSTR *xstr,
+                      char *vbuf, int vsiz){
+  struct iovec iov[2];
+  iov[0].iov_base = (char *)tcxstrptr(xstr);
+  iov[0].iov_len = tcxstrsize(xstr);
+  int inum = 1;
+  if(vbuf){
+    iov[1].iov_base = vbuf;
+    iov[1].iov_len = vsiz;
+    inum++;
+  }
+  bool rv = sendres(sock, arg, req, iov, inum);
+  tcxstrclear(xstr);
+  return rv;
+}
+
+
+/* send a chunk of a streamed record response and begin the next one */
+static bool strmchunk(TTSOCK *sock, TASKARG *arg, TTREQ *req, TCXSTR *xstr, uint8_t code,
+                      int *np, char *vbuf, int vsiz){
+  char *wp = (char *)tcxstrptr(xstr);
+  *(uint8_t *)wp = code;
+  uint32_t num = TTHTONL((uint32_t)*np);
+  memcpy(wp + sizeof(uint8_t), &num, sizeof(num));
+  bool rv = strmflush(sock, arg, req, xstr, vbuf, vsiz);
+  char head[sizeof(uint8_t)+sizeof(uint32_t)];
+  memset(head, 0, sizeof(head));
+  tcxstrcat(xstr, head, sizeof(head));
+  *np = 0;
+  return rv;
+}
+
+
+/* add a record to a streamed record response and send the chunk when it is full */
+static bool strmrec(TTSOCK *sock, TASKARG *arg, TTREQ *req, TCXSTR *xstr, int *np,
+                    const char *kbuf, int ksiz, char *vbuf, int vsiz){
+  uint32_t num = TTHTONL((uint32_t)ksiz);
+  tcxstrcat(xstr, &num, sizeof(num));
+  num = TTHTONL((uint32_t)vsiz);
+  tcxstrcat(xstr, &num, sizeof(num));
+  tcxstrcat(xstr, kbuf, ksiz);
+  (*np)++;
+  if(vsiz > RESVCOPYMAX) return strmchunk(sock, arg, req, xstr, TTCODEMORE, np, vbuf, vsiz);
+  tcxstrcat(xstr, vbuf, vsiz);
+  if(tcxstrsize(xstr) >= RESCHUNKSIZ) return strmchunk(sock, arg, req, xstr, TTCODEMORE, np, NULL, 0);
+  return true;
+}
+
+
+/* compare two keys in the lexical order of a forward matching range */
+static int fwmkeycmp(const char *abuf, int asiz, const char *bbuf, int bsiz){
+  int rv = memcmp(abuf, bbuf, tclmin(asiz, bsiz));
+  if(rv != 0) return rv;
+  return asiz - bsiz;
+}
+
+
+/* get the keys of a forward matching range in the order of the database */
+static TCLIST *fwmrecskeys(TASKARG *arg, const char *pbuf, int psiz,
+                           const char *sbuf, int ssiz, int max, bool desc, bool *mp){
+  TCADB *adb = arg->adb;
+  TCLIST *keys = tclistnew();
+  *mp = false;
+  if(max < 0) max = INT_MAX;
+  if(max < 1) return keys;
+  int64_t tsiz = 0;
+  switch(tcadbomode(adb)){
+    case ADBOBDB: {
+      BDBCUR *cur = tcbdbcurnew(tcadbreveal(adb));
+      const char *bbuf = NULL;
+      int bsiz = 0;
+      char *nbuf = NULL;
+      bool ok;
+      if(!desc){
+        bool after = ssiz > 0 && fwmkeycmp(sbuf, ssiz, pbuf, psiz) >= 0;
+        bbuf = after ? sbuf : pbuf;
+        bsiz = after ? ssiz : psiz;
+        ok = tcbdbcurjump(cur, bbuf, bsiz);
+        if(!after) bbuf = NULL;
+      } else {
+        nbuf = tcmemdup(pbuf, psiz);
+        int nsiz = psiz;
+        while(nsiz > 0 && ((unsigned char *)nbuf)[nsiz-1] == 0xff) nsiz--;
+        if(nsiz > 0) nbuf[nsiz-1]++;
+        if(ssiz > 0 && (nsiz < 1 || fwmkeycmp(sbuf, ssiz, nbuf, nsiz) < 0)){
+          bbuf = sbuf;
+          bsiz = ssiz;
+        } else if(nsiz > 0){
+          bbuf = nbuf;
+          bsiz = nsiz;
+        }
+        ok = bbuf ? tcbdbcurjumpback(cur, bbuf, bsiz) : tcbdbcurlast(cur);
+      }
+      while(ok && tclistnum(keys) < max && tsiz <= RESSIZMAX){
+        int ksiz;
+        const char *kbuf = tcbdbcurkey3(cur, &ksiz);
+        if(!kbuf || ksiz < psiz || memcmp(kbuf, pbuf, psiz)) break;
+        if(!bbuf || ksiz != bsiz || memcmp(kbuf, bbuf, ksiz)){
+          TCLISTPUSH(keys, kbuf, ksiz);
+          tsiz += ksiz;
+        }
+        ok = desc ? tcbdbcurprev(cur) : tcbdbcurnext(cur);
+      }
+      if(ok){
+        int ksiz;
+        const char *kbuf = tcbdbcurkey3(cur, &ksiz);
+        if(kbuf && ksiz >= psiz && !memcmp(kbuf, pbuf, psiz)) *mp = true;
+      }
+      tcfree(nbuf);
+      tcbdbcurdel(cur);
+      break;
+    }
+    case ADBONDB: {
+      TCNDB *ndb = tcadbreveal(adb);
+      bool after = ssiz > 0 && fwmkeycmp(sbuf, ssiz, pbuf, psiz) >= 0;
+      if(desc && ssiz > 0 && !after) break;
+      if(pthread_mutex_lock(arg->itermtx) != 0){
+        ttservlog(g_serv, TTLOGERROR, "fwmrecskeys: pthread_mutex_lock failed");
+        break;
+      }
+      if(!desc && after){
+        tcndbiterinit2(ndb, sbuf, ssiz);
+      } else {
+        tcndbiterinit2(ndb, pbuf, psiz);
+      }
+      int ksiz;
+      char *kbuf;
+      while((kbuf = tcndbiternext(ndb, &ksiz)) != NULL){
+        if(ksiz < psiz || memcmp(kbuf, pbuf, psiz)){
+          tcfree(kbuf);
+          break;
+        }
+        if(desc){
+          if(ssiz > 0 && fwmkeycmp(kbuf, ksiz, sbuf, ssiz) >= 0){
+            tcfree(kbuf);
+            break;
+          }
+          TCLISTPUSH(keys, kbuf, ksiz);
+          tsiz += ksiz;
+          while(tclistnum(keys) > max || (tsiz > RESSIZMAX && tclistnum(keys) > 1)){
+            int osiz;
+            char *obuf = tclistshift(keys, &osiz);
+            tsiz -= osiz;
+            tcfree(obuf);
+            *mp = true;
+          }
+        } else if(!after || ksiz != ssiz || memcmp(kbuf, sbuf, ksiz)){
+          TCLISTPUSH(keys, kbuf, ksiz);
+          tsiz += ksiz;
+          if(tclistnum(keys) >= max || tsiz > RESSIZMAX){
+            tcfree(kbuf);
+            kbuf = tcndbiternext(ndb, &ksiz);
+            if(kbuf && ksiz >= psiz && !memcmp(kbuf, pbuf, psiz)) *mp = true;
+            tcfree(kbuf);
+            break;
+          }
+        }
+        tcfree(kbuf);
+      }
+      if(pthread_mutex_unlock(arg->itermtx) != 0)
+        ttservlog(g_serv, TTLOGERROR, "fwmrecskeys: pthread_mutex_unlock failed");
+      if(desc) tclistinvert(keys);
+      break;
+    }
+    default: {
+      TCLIST *fkeys = tcadbfwmkeys(adb, pbuf, psiz, -1);
+      tclistsort(fkeys);
+      int fnum = tclistnum(fkeys);
+      int i;
+      for(i = 0; i < fnum && tclistnum(keys) < max && tsiz <= RESSIZMAX; i++){
+        int ksiz;
+        const char *kbuf = tclistval(fkeys, desc ? fnum - i - 1 : i, &ksiz);
+        if(ssiz > 0){
+          int cmp = fwmkeycmp(kbuf, ksiz, sbuf, ssiz);
+          if(desc ? cmp >= 0 : cmp <= 0) continue;
+        }
+        TCLISTPUSH(keys, kbuf, ksiz);
+        tsiz += ksiz;
+      }
+      if(i < fnum) *mp = true;
+      tclistdel(fkeys);
+      break;
+    }
+  }
+  return keys;
+}
+
+
+/* create an iterator of a connection */
+static ITERCUR *itercurnew(TCADB *adb){
+  ITERCUR *cur = tcmalloc(sizeof(*cur));
+  cur->omode = tcadbomode(adb);
+  cur->init = false;
+  cur->part = 0;
+  cur->pnum = 1;
+  cur->cur = NULL;
+  cur->pos = 0;
+  cur->end = FDBIDMAX;
+  cur->lbuf = NULL;
+  cur->lsiz = -1;
+  cur->lasiz = 0;
+  return cur;
+}
+
+
+/* delete an iterator of a connection */
+static void itercurdel(ITERCUR *cur){
+  if(cur->cur) tcbdbcurdel(cur->cur);
+  tcfree(cur->lbuf);
+  tcfree(cur);
+}
+
+
+/* release the data of a connection */
+static void do_conndel(void *data, void *opq){
+  itercurdel(data);
+}
+
+
+/* get the iterator of the connection of a request, which should be locked if `*lp' is true */
+static ITERCUR *itercurget(TASKARG *arg, TTREQ *req, bool *lp){
+  ITERCUR *cur = (req->cfd >= 0) ? ttservconndata(g_serv, req->cfd) : arg->itercur;
+  if(!cur){
+    cur = itercurnew(arg->adb);
+    if(!ttservsetconndata(g_serv, req->cfd, cur)){
+      itercurdel(cur);
+      cur = arg->itercur;
+    }
+  }
+  *lp = cur == arg->itercur || (cur->omode != ADBOBDB && cur->omode != ADBOFDB);
+  return cur;
+}
+
+
+/* initialize an iterator of a connection over a partition of the key space, which is supported
+   only by the fixed-length database because the others can not be split without scanning all */
+static bool itercurinit(ITERCUR *cur, TCADB *adb, int part, int pnum){
+  if(pnum > 1 && cur->omode != ADBOFDB) return false;
+  bool err = false;
+  cur->init = false;
+  cur->part = part;
+  cur->pnum = pnum;
+  cur->end = FDBIDMAX;
+  cur->lsiz = -1;
+  switch(cur->omode){
+    case ADBOHDB:
+      if(!tchdbiterinit(tcadbreveal(adb)) || !itercursync(cur, adb, false)) err = true;
+      break;
+    case ADBOBDB:
+      if(!cur->cur) cur->cur = tcbdbcurnew(tcadbreveal(adb));
+      break;
+    case ADBOFDB:
+      cur->pos = 1;
+      if(pnum > 1){
+        TCFDB *fdb = tcadbreveal(adb);
+        uint64_t min = (fdb->min > 0) ? fdb->min : 1;
+        uint64_t span = (fdb->max >= min) ? fdb->max - min + 1 : 0;
+        if(part > 0) cur->pos = min + span * part / pnum;
+        if(part < pnum - 1) cur->end = min + span * (part + 1) / pnum - 1;
+      }
+      break;
+    case ADBOTDB:
+      if(!tctdbiterinit(tcadbreveal(adb)) || !itercursync(cur, adb, false)) err = true;
+      break;
+    case ADBOMDB:
+    case ADBONDB:
+      break;
+    default:
+      if(!tcadbiterinit(adb)) err = true;
+      break;
+  }
+  cur->init = !err;
+  return !err;
+}
+
+
+/* get the next record of an iterator of a connection, resuming the current position if `cont' */
+static bool itercurnext(ITERCUR *cur, TCADB *adb, TCXSTR *kxstr, TCXSTR *vxstr, bool cont){
+  if(!cur->init) return false;
+  return itercurfetch(cur, adb, kxstr, vxstr, cont);
+}
+
+
+/* fetch the next record of an iterator of a connection regardless of the partition */
+static bool itercurfetch(ITERCUR *cur, TCADB *adb, TCXSTR *kxstr, TCXSTR *vxstr, bool cont){
+  tcxstrclear(kxstr);
+  if(vxstr) tcxstrclear(vxstr);
+  bool ok = false;
+  char *kbuf, *vbuf;
+  int ksiz, vsiz;
+  switch(cur->omode){
+    case ADBOHDB: {
+      TCHDB *hdb = tcadbreveal(adb);
+      if(!itercursync(cur, adb, true)) break;
+      if(vxstr){
+        ok = tchdbiternext3(hdb, kxstr, vxstr);
+      } else if((kbuf = tchdbiternext(hdb, &ksiz)) != NULL){
+        tcxstrcat(kxstr, kbuf, ksiz);
+        tcfree(kbuf);
+        ok = true;
+      }
+      if(!itercursync(cur, adb, false)) ok = false;
+      break;
+    }
+    case ADBOBDB: {
+      BDBCUR *bcur = cur->cur;
+      if(cont){
+        ok = tcbdbcurnext(bcur);
+      } else if(cur->lsiz < 0){
+        ok = tcbdbcurfirst(bcur);
+      } else {
+        ok = tcbdbcurjump(bcur, cur->lbuf, cur->lsiz);
+      }
+      while(ok){
+        tcxstrclear(kxstr);
+        if(vxstr){
+          tcxstrclear(vxstr);
+          ok = tcbdbcurrec(bcur, kxstr, vxstr);
+        } else if((kbuf = tcbdbcurkey(bcur, &ksiz)) != NULL){
+          tcxstrcat(kxstr, kbuf, ksiz);
+          tcfree(kbuf);
+        } else {
+          ok = false;
+        }
+        if(!ok || cont || cur->lsiz < 0 || tcxstrsize(kxstr) != cur->lsiz ||
+           memcmp(tcxstrptr(kxstr), cur->lbuf, cur->lsiz)) break;
+        ok = tcbdbcurnext(bcur);
+      }
+      break;
+    }
+    case ADBOFDB: {
+      TCFDB *fdb = tcadbreveal(adb);
+      while(!ok){
+        int inum;
+        if(cur->end != FDBIDMAX && (int64_t)cur->pos > cur->end) break;
+        uint64_t *ids = tcfdbrange(fdb, cur->pos, cur->end, 1, &inum);
+        uint64_t id = (inum > 0) ? ids[0] : 0;
+        tcfree(ids);
+        if(id < 1) break;
+        cur->pos = id + 1;
+        if(vxstr){
+          if(!(vbuf = tcfdbget(fdb, id, &vsiz))) continue;
+          tcxstrcat(vxstr, vbuf, vsiz);
+          tcfree(vbuf);
+        }
+        char numbuf[NUMBUFSIZ];
+        ksiz = sprintf(numbuf, "%llu", (unsigned long long)id);
+        tcxstrcat(kxstr, numbuf, ksiz);
+        ok = true;
+      }
+      break;
+    }
+    case ADBOTDB: {
+      TCTDB *tdb = tcadbreveal(adb);
+      while(!ok){
+        if(!itercursync(cur, adb, true)) break;
+        kbuf = tctdbiternext(tdb, &ksiz);
+        if(!itercursync(cur, adb, false)){
+          tcfree(kbuf);
+          break;
+        }
+        if(!kbuf) break;
+        if(vxstr && (vbuf = tcadbget(adb, kbuf, ksiz, &vsiz)) != NULL){
+          tcxstrcat(vxstr, vbuf, vsiz);
+          tcfree(vbuf);
+          ok = true;
+        } else if(!vxstr){
+          ok = true;
+        }
+        if(ok) tcxstrcat(kxstr, kbuf, ksiz);
+        tcfree(kbuf);
+      }
+      break;
+    }
+    default: {
+      TCMDB *mdb = (cur->omode == ADBOMDB) ? tcadbreveal(adb) : NULL;
+      TCNDB *ndb = (cur->omode == ADBONDB) ? tcadbreveal(adb) : NULL;
+      bool skip = false;
+      if(!cont && (mdb || ndb)){
+        if(cur->lsiz < 0){
+          if(mdb){
+            tcmdbiterinit(mdb);
+          } else {
+            tcndbiterinit(ndb);
+          }
+        } else if(ndb){
+          tcndbiterinit2(ndb, cur->lbuf, cur->lsiz);
+          skip = true;
+        } else if(tcmdbvsiz(mdb, cur->lbuf, cur->lsiz) >= 0){
+          tcmdbiterinit2(mdb, cur->lbuf, cur->lsiz);
+          skip = true;
+        } else {
+          break;
+        }
+      }
+      while(!ok){
+        if(mdb){
+          kbuf = tcmdbiternext(mdb, &ksiz);
+        } else if(ndb){
+          kbuf = tcndbiternext(ndb, &ksiz);
+        } else {
+          kbuf = tcadbiternext(adb, &ksiz);
+        }
+        if(!kbuf) break;
+        if(skip && ksiz == cur->lsiz && !memcmp(kbuf, cur->lbuf, ksiz)){
+          skip = false;
+          tcfree(kbuf);
+          continue;
+        }
+        skip = false;
+        if(vxstr && (vbuf = tcadbget(adb, kbuf, ksiz, &vsiz)) != NULL){
+          tcxstrcat(vxstr, vbuf, vsiz);
+          tcfree(vbuf);
+          ok = true;
+        } else if(!vxstr){
+          ok = true;
+        }
+        if(ok) tcxstrcat(kxstr, kbuf, ksiz);
+        tcfree(kbuf);
+      }
+      break;
+    }
+  }
+  if(ok) itercurkeep(cur, tcxstrptr(kxstr), tcxstrsize(kxstr));
+  return ok;
+}
+
+
+/* store the position of an iterator of a connection into the iterator of a hash or table
+   database, or load it back, under the lock of the methods of the database */
+static bool itercursync(ITERCUR *cur, TCADB *adb, bool store){
+  TCHDB *hdb;
+  pthread_rwlock_t *mmtx;
+  if(cur->omode == ADBOTDB){
+    TCTDB *tdb = tcadbreveal(adb);
+    hdb = tdb->hdb;
+    mmtx = tdb->mmtx;
+  } else {
+    hdb = tcadbreveal(adb);
+    mmtx = hdb->mmtx;
+  }
+  if(mmtx && pthread_rwlock_wrlock(mmtx) != 0){
+    ttservlog(g_serv, TTLOGERROR, "itercursync: pthread_rwlock_wrlock failed");
+    return false;
+  }
+  if(store){
+    hdb->iter = cur->pos;
+  } else {
+    cur->pos = hdb->iter;
+  }
+  if(mmtx) pthread_rwlock_unlock(mmtx);
+  return true;
+}
+
+
+/* remember the last key of an iterator of a connection */
+static void itercurkeep(ITERCUR *cur, const char *kbuf, int ksiz){
+  if(ksiz >= cur->lasiz){
+    cur->lasiz = ksiz + 1;
+    cur->lbuf = tcrealloc(cur->lbuf, cur->lasiz);
+  }
+  memcpy(cur->lbuf, kbuf, ksiz);
+  cur->lsiz = ksiz;
+}
+
+/* handle the put command */
+static void do_put(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing put command");
+  uint64_t mask = arg->mask;
+  int ksiz = ttsockgetint32(sock);
+  int vsiz = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ){
+    ttservlog(g_serv, TTLOGINFO, "do_put: invalid parameters");
+    return;
+  }
+  int rsiz = ksiz + vsiz;
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
+  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
+    uint8_t code = 0;
+    if(mask & (TTMSKPUT | TTMSKALLORG | TTMSKALLWRITE)){
+      code = 1;
+      ttservlog(g_serv, TTLOGINFO, "do_put: forbidden");
+    } else if(!recput(arg, buf, ksiz, buf + ksiz, vsiz, 0)){
+      code = 1;
+      ttservlog(g_serv, TTLOGERROR, "do_put: operation failed");
+    }
+    if(ttsocksend(sock, &code, sizeof(code))){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_put: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_put: invalid entity");
+  }
+}
+
+
+/* handle the putkeep command */
+static void do_putkeep(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing putkeep command");
+  uint64_t mask = arg->mask;
+  int ksiz = ttsockgetint32(sock);
+  int vsiz = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ){
+    ttservlog(g_serv, TTLOGINFO, "do_putkeep: invalid parameters");
+    return;
+  }
+  int rsiz = ksiz + vsiz;
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
+  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
+    uint8_t code = 0;
+    if(mask & (TTMSKPUTKEEP | TTMSKALLORG | TTMSKALLWRITE)){
+      code = 1;
+      ttservlog(g_serv, TTLOGINFO, "do_putkeep: forbidden");
+    } else if(!recputkeep(arg, buf, ksiz, buf + ksiz, vsiz, 0)){
+      code = 1;
+    }
+    if(ttsocksend(sock, &code, sizeof(code))){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_putkeep: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_putkeep: invalid entity");
+  }
+}
+
+
+/* handle the putcat command */
+static void do_putcat(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing putcat command");
+  uint64_t mask = arg->mask;
+  int ksiz = ttsockgetint32(sock);
+  int vsiz = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ){
+    ttservlog(g_serv, TTLOGINFO, "do_putcat: invalid parameters");
+    return;
+  }
+  int rsiz = ksiz + vsiz;
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
+  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
+    uint8_t code = 0;
+    if(mask & (TTMSKPUTCAT | TTMSKALLORG | TTMSKALLWRITE)){
+      code = 1;
+      ttservlog(g_serv, TTLOGINFO, "do_putcat: forbidden");
+    } else if(!recputcat(arg, buf, ksiz, buf + ksiz, vsiz)){
+      code = 1;
+      ttservlog(g_serv, TTLOGERROR, "do_putcat: operation failed");
+    }
+    if(ttsocksend(sock, &code, sizeof(code))){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_putcat: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_putcat: invalid entity");
+  }
+}
+
+
+/* handle the putshl command */
 static void do_putshl(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing putshl command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   pthread_mutex_t *rmtxs = arg->rmtxs;
   int ksiz = ttsockgetint32(sock);
   int vsiz = ttsockgetint32(sock);
@@ -1137,9 +3207,7 @@ static void do_putshl(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     return;
   }
   int rsiz = ksiz + vsiz;
-  char stack[TTIOBUFSIZ];
-  char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
   if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
     uint8_t code = 0;
     int mtxidx = recmtxidx(buf, ksiz);
@@ -1148,7 +3216,7 @@ static void do_putshl(TTSOCK *sock, TASKARG *arg, TTREQ *req){
       ttservlog(g_serv, TTLOGINFO, "do_putshl: forbidden");
     } else if(pthread_mutex_lock(rmtxs + mtxidx) == 0){
       int osiz;
-      char *obuf = tcadbget(adb, buf, ksiz, &osiz);
+      char *obuf = recget(arg, buf, ksiz, &osiz);
       if(obuf){
         obuf = tcrealloc(obuf, osiz + vsiz);
         memcpy(obuf + osiz, buf + ksiz, vsiz);
@@ -1167,7 +3235,7 @@ static void do_putshl(TTSOCK *sock, TASKARG *arg, TTREQ *req){
         nbuf = obuf + osiz - width;
         nsiz = width;
       }
-      if(!tculogadbput(ulog, sid, adb, buf, ksiz, nbuf, nsiz)){
+      if(!recput(arg, buf, ksiz, nbuf, nsiz, -1)){
         code = 1;
         ttservlog(g_serv, TTLOGERROR, "do_putshl: operation failed");
       }
@@ -1186,7 +3254,41 @@ static void do_putshl(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_putshl: invalid entity");
   }
-  pthread_cleanup_pop(1);
+}
+
+
+/* handle the putttl command */
+static void do_putttl(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing putttl command");
+  uint64_t mask = arg->mask;
+  int ksiz = ttsockgetint32(sock);
+  int vsiz = ttsockgetint32(sock);
+  int ttl = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ ||
+     ttl < 0){
+    ttservlog(g_serv, TTLOGINFO, "do_putttl: invalid parameters");
+    return;
+  }
+  int rsiz = ksiz + vsiz;
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
+  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
+    uint8_t code = 0;
+    int64_t xt = (ttl > 0) ? (int64_t)tctime() + ttl : 0;
+    if(mask & (TTMSKPUT | TTMSKALLORG | TTMSKALLWRITE)){
+      code = 1;
+      ttservlog(g_serv, TTLOGINFO, "do_putttl: forbidden");
+    } else if(!recput(arg, buf, ksiz, buf + ksiz, vsiz, xt)){
+      code = 1;
+      ttservlog(g_serv, TTLOGERROR, "do_putttl: operation failed");
+    }
+    if(ttsocksend(sock, &code, sizeof(code))){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_putttl: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_putttl: invalid entity");
+  }
 }
 
 
@@ -1194,9 +3296,6 @@ static void do_putshl(TTSOCK *sock, TASKARG *arg, TTREQ *req){
 static void do_putnr(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing putnr command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   int ksiz = ttsockgetint32(sock);
   int vsiz = ttsockgetint32(sock);
   if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ){
@@ -1204,15 +3303,13 @@ static void do_putnr(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     return;
   }
   int rsiz = ksiz + vsiz;
-  char stack[TTIOBUFSIZ];
-  char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
   if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
     uint8_t code = 0;
     if(mask & (TTMSKPUTNR | TTMSKALLORG | TTMSKALLWRITE)){
       code = 1;
       ttservlog(g_serv, TTLOGINFO, "do_putnr: forbidden");
-    } else if(!tculogadbput(ulog, sid, adb, buf, ksiz, buf + ksiz, vsiz)){
+    } else if(!recput(arg, buf, ksiz, buf + ksiz, vsiz, 0)){
       code = 1;
       ttservlog(g_serv, TTLOGERROR, "do_putnr: operation failed");
     }
@@ -1220,31 +3317,167 @@ static void do_putnr(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_putnr: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
-/* handle the out command */
-static void do_out(TTSOCK *sock, TASKARG *arg, TTREQ *req){
-  ttservlog(g_serv, TTLOGDEBUG, "doing out command");
+/* handle the cas command */
+static void do_cas(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing cas command");
+  uint64_t mask = arg->mask;
+  int ksiz = ttsockgetint32(sock);
+  int vsiz = ttsockgetint32(sock);
+  uint64_t ver = ttsockgetint64(sock);
+  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ){
+    ttservlog(g_serv, TTLOGINFO, "do_cas: invalid parameters");
+    return;
+  }
+  int rsiz = ksiz + vsiz;
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
+  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
+    char stack[sizeof(uint8_t)+sizeof(uint64_t)];
+    int len = sizeof(uint8_t);
+    if(mask & (TTMSKCAS | TTMSKALLORG | TTMSKALLWRITE)){
+      *stack = 3;
+      ttservlog(g_serv, TTLOGINFO, "do_cas: forbidden");
+    } else {
+      uint64_t nver;
+      int rv = reccas(arg, buf, ksiz, buf + ksiz, vsiz, ver, -1, &nver);
+      if(rv == 0){
+        *stack = 0;
+        uint64_t llnum = TTHTONLL(nver);
+        memcpy(stack + sizeof(uint8_t), &llnum, sizeof(uint64_t));
+        len += sizeof(uint64_t);
+      } else if(rv > 0){
+        *stack = rv;
+      } else {
+        *stack = 3;
+        ttservlog(g_serv, TTLOGERROR, "do_cas: operation failed");
+      }
+    }
+    if(ttsocksend(sock, stack, len)){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_cas: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_cas: invalid entity");
+  }
+}
+
+
+/* handle the batch command */
+static void do_batch(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing batch command");
   uint64_t mask = arg->mask;
   TCADB *adb = arg->adb;
   TCULOG *ulog = arg->ulog;
   uint32_t sid = arg->sid;
+  int rnum = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || rnum < 0 || rnum > MAXARGNUM){
+    ttservlog(g_serv, TTLOGINFO, "do_batch: invalid parameters");
+    return;
+  }
+  bool forbid = mask & (TTMSKBATCH | TTMSKALLORG | TTMSKALLWRITE);
+  bool reject = forbid;
+  TCULOP *ops = ttarenaalloc(req->arena, sizeof(*ops) * rnum);
+  int onum = 0;
+  while(onum < rnum){
+    int cmd = ttsockgetc(sock);
+    int ksiz = ttsockgetint32(sock);
+    int vsiz = ttsockgetint32(sock);
+    if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ || vsiz < 0 || vsiz > MAXARGSIZ)
+      break;
+    char *buf = ttarenaalloc(req->arena, ksiz + vsiz + 1);
+    if(!ttsockrecv(sock, buf, ksiz + vsiz)) break;
+    TCULOP *op = ops + onum++;
+    op->cmd = cmd;
+    op->kbuf = buf;
+    op->ksiz = ksiz;
+    op->vbuf = buf + ksiz;
+    op->vsiz = vsiz;
+    op->num = 0;
+    uint64_t omask;
+    switch(cmd){
+    case TTCMDPUT: omask = TTMSKPUT; break;
+    case TTCMDPUTKEEP: omask = TTMSKPUTKEEP; break;
+    case TTCMDPUTCAT: omask = TTMSKPUTCAT; break;
+    case TTCMDOUT: omask = TTMSKOUT; break;
+    case TTCMDADDINT: omask = TTMSKADDINT; break;
+    default: omask = 0; reject = true; break;
+    }
+    if(cmd == TTCMDADDINT){
+      if(vsiz == sizeof(uint32_t)){
+        uint32_t num;
+        memcpy(&num, op->vbuf, sizeof(num));
+        op->num = (int32_t)TTNTOHL(num);
+      } else {
+        reject = true;
+      }
+    }
+    if(mask & omask) reject = true;
+  }
+  if(onum == rnum && !ttsockcheckend(sock) && reject){
+    ttservlog(g_serv, TTLOGINFO, forbid ? "do_batch: forbidden" : "do_batch: invalid operation");
+    TCXSTR *xstr = ttarenaxstr(req->arena);
+    uint8_t code = 1;
+    tcxstrcat(xstr, &code, sizeof(code));
+    uint32_t num = TTHTONL((uint32_t)onum);
+    tcxstrcat(xstr, &num, sizeof(num));
+    num = 0;
+    for(int i = 0; i < onum; i++){
+      tcxstrcat(xstr, &code, sizeof(code));
+      tcxstrcat(xstr, &num, sizeof(num));
+    }
+    if(ttsocksend(sock, tcxstrptr(xstr), tcxstrsize(xstr))){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_batch: response failed");
+    }
+  } else if(onum == rnum && !ttsockcheckend(sock)){
+    bool lcks[VERMTXNUM];
+    verlockops(arg->vtab, ops, onum, lcks);
+    for(int i = 0; i < onum; i++){
+      ttlpurge(arg, ops[i].kbuf, ops[i].ksiz);
+    }
+    uint8_t code = tculogadbbatch(ulog, sid, adb, ops, onum) ? 0 : 1;
+    verunlockops(arg->vtab, ops, onum, lcks);
+    TCXSTR *xstr = ttarenaxstr(req->arena);
+    tcxstrcat(xstr, &code, sizeof(code));
+    uint32_t num = TTHTONL((uint32_t)onum);
+    tcxstrcat(xstr, &num, sizeof(num));
+    for(int i = 0; i < onum; i++){
+      code = ops[i].ok ? 0 : 1;
+      tcxstrcat(xstr, &code, sizeof(code));
+      num = TTHTONL((uint32_t)((ops[i].cmd == TTCMDADDINT && ops[i].ok) ? ops[i].rnum : 0));
+      tcxstrcat(xstr, &num, sizeof(num));
+    }
+    if(ttsocksend(sock, tcxstrptr(xstr), tcxstrsize(xstr))){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_batch: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_batch: invalid entity");
+  }
+}
+
+
+/* handle the out command */
+static void do_out(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing out command");
+  uint64_t mask = arg->mask;
   int ksiz = ttsockgetint32(sock);
   if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ){
     ttservlog(g_serv, TTLOGINFO, "do_out: invalid parameters");
     return;
   }
-  char stack[TTIOBUFSIZ];
-  char *buf = (ksiz < TTIOBUFSIZ) ? stack : tcmalloc(ksiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, ksiz + 1);
   if(ttsockrecv(sock, buf, ksiz) && !ttsockcheckend(sock)){
     uint8_t code = 0;
     if(mask & (TTMSKOUT | TTMSKALLORG | TTMSKALLWRITE)){
       code = 1;
       ttservlog(g_serv, TTLOGINFO, "do_out: forbidden");
-    } else if(!tculogadbout(ulog, sid, adb, buf, ksiz)){
+    } else if(!recout(arg, buf, ksiz)){
       code = 1;
     }
     if(ttsocksend(sock, &code, sizeof(code))){
@@ -1255,7 +3488,6 @@ static void do_out(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_out: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -1263,15 +3495,12 @@ static void do_out(TTSOCK *sock, TASKARG *arg, TTREQ *req){
 static void do_get(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing get command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
   int ksiz = ttsockgetint32(sock);
   if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ){
     ttservlog(g_serv, TTLOGINFO, "do_get: invalid parameters");
     return;
   }
-  char stack[TTIOBUFSIZ];
-  char *buf = (ksiz < TTIOBUFSIZ) ? stack : tcmalloc(ksiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, ksiz + 1);
   if(ttsockrecv(sock, buf, ksiz) && !ttsockcheckend(sock)){
     char *vbuf;
     int vsiz;
@@ -1280,24 +3509,25 @@ static void do_get(TTSOCK *sock, TASKARG *arg, TTREQ *req){
       vsiz = 0;
       ttservlog(g_serv, TTLOGINFO, "do_get: forbidden");
     } else {
-      vbuf = tcadbget(adb, buf, ksiz, &vsiz);
+      vbuf = recget(arg, buf, ksiz, &vsiz);
     }
     if(vbuf){
-      int rsiz = vsiz + sizeof(uint8_t) + sizeof(uint32_t);
-      char *rbuf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz);
-      pthread_cleanup_push(free, (rbuf == stack) ? NULL : rbuf);
-      *rbuf = 0;
+      ttarenaown(req->arena, vbuf);
+      char head[sizeof(uint8_t)+sizeof(uint32_t)];
+      *head = 0;
       uint32_t num;
       num = TTHTONL((uint32_t)vsiz);
-      memcpy(rbuf + sizeof(uint8_t), &num, sizeof(uint32_t));
-      memcpy(rbuf + sizeof(uint8_t) + sizeof(uint32_t), vbuf, vsiz);
-      tcfree(vbuf);
-      if(ttsocksend(sock, rbuf, rsiz)){
+      memcpy(head + sizeof(uint8_t), &num, sizeof(uint32_t));
+      struct iovec iov[2];
+      iov[0].iov_base = head;
+      iov[0].iov_len = sizeof(head);
+      iov[1].iov_base = vbuf;
+      iov[1].iov_len = vsiz;
+      if(sendres(sock, arg, req, iov, 2)){
         req->keep = true;
       } else {
         ttservlog(g_serv, TTLOGINFO, "do_get: response failed");
       }
-      pthread_cleanup_pop(1);
     } else {
       uint8_t code = 1;
       if(ttsocksend(sock, &code, sizeof(code))){
@@ -1309,7 +3539,61 @@ static void do_get(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_get: invalid entity");
   }
-  pthread_cleanup_pop(1);
+}
+
+
+/* handle the gets command */
+static void do_gets(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing gets command");
+  uint64_t mask = arg->mask;
+  int ksiz = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ){
+    ttservlog(g_serv, TTLOGINFO, "do_gets: invalid parameters");
+    return;
+  }
+  char *buf = ttarenaalloc(req->arena, ksiz + 1);
+  if(ttsockrecv(sock, buf, ksiz) && !ttsockcheckend(sock)){
+    char *vbuf;
+    int vsiz;
+    uint64_t ver = 0;
+    if(mask & (TTMSKGET | TTMSKALLORG | TTMSKALLREAD)){
+      vbuf = NULL;
+      vsiz = 0;
+      ttservlog(g_serv, TTLOGINFO, "do_gets: forbidden");
+    } else {
+      ver = vertoken(arg->vtab, buf, ksiz);
+      vbuf = recget(arg, buf, ksiz, &vsiz);
+    }
+    if(vbuf){
+      ttarenaown(req->arena, vbuf);
+      char head[sizeof(uint8_t)+sizeof(uint32_t)+sizeof(uint64_t)];
+      *head = 0;
+      uint32_t num;
+      num = TTHTONL((uint32_t)vsiz);
+      memcpy(head + sizeof(uint8_t), &num, sizeof(uint32_t));
+      uint64_t llnum = TTHTONLL(ver);
+      memcpy(head + sizeof(uint8_t) + sizeof(uint32_t), &llnum, sizeof(uint64_t));
+      struct iovec iov[2];
+      iov[0].iov_base = head;
+      iov[0].iov_len = sizeof(head);
+      iov[1].iov_base = vbuf;
+      iov[1].iov_len = vsiz;
+      if(sendres(sock, arg, req, iov, 2)){
+        req->keep = true;
+      } else {
+        ttservlog(g_serv, TTLOGINFO, "do_gets: response failed");
+      }
+    } else {
+      uint8_t code = 1;
+      if(ttsocksend(sock, &code, sizeof(code))){
+        req->keep = true;
+      } else {
+        ttservlog(g_serv, TTLOGINFO, "do_gets: response failed");
+      }
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_gets: invalid entity");
+  }
 }
 
 
@@ -1323,20 +3607,12 @@ static void do_mget(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     ttservlog(g_serv, TTLOGINFO, "do_mget: invalid parameters");
     return;
   }
-  TCLIST *keys = tclistnew2(rnum);
-  pthread_cleanup_push((void (*)(void *))tclistdel, keys);
-  char stack[TTIOBUFSIZ];
-  for(int i = 0; i < rnum; i++){
-    int ksiz = ttsockgetint32(sock);
-    if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ) break;
-    char *buf = (ksiz < TTIOBUFSIZ) ? stack : tcmalloc(ksiz + 1);
-    pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
-    if(ttsockrecv(sock, buf, ksiz)) tclistpush(keys, buf, ksiz);
-    pthread_cleanup_pop(1);
-  }
+  int knum;
+  MGETKEY *keys = mgetkeys(sock, req->arena, rnum, &knum);
   if(!ttsockcheckend(sock)){
-    TCXSTR *xstr = tcxstrnew();
-    pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+    knum = mgetsort(keys, knum, adb);
+    RESVEC *resv = resvecnew(req->arena);
+    TCXSTR *xstr = resv->head;
     uint8_t code = 0;
     tcxstrcat(xstr, &code, sizeof(code));
     uint32_t num = 0;
@@ -1345,35 +3621,102 @@ static void do_mget(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     if(mask & (TTMSKMGET | TTMSKALLORG | TTMSKALLREAD)){
       ttservlog(g_serv, TTLOGINFO, "do_mget: forbidden");
     } else {
-      for(int i = 0; i < tclistnum(keys); i++){
-        int ksiz;
-        const char *kbuf = tclistval(keys, i, &ksiz);
+      int64_t tsiz = 0;
+      for(int i = 0; i < knum; i++){
+        const char *kbuf = keys[i].kbuf;
+        int ksiz = keys[i].ksiz;
         int vsiz;
-        char *vbuf = tcadbget(adb, kbuf, ksiz, &vsiz);
+        char *vbuf = recget(arg, kbuf, ksiz, &vsiz);
         if(vbuf){
+          tsiz += ksiz + vsiz;
+          if(tsiz > RESSIZMAX){
+            tcfree(vbuf);
+            tcxstrclear(xstr);
+            tcxstrclear(resv->vals);
+            tcxstrclear(resv->cuts);
+            code = 1;
+            tcxstrcat(xstr, &code, sizeof(code));
+            num = 0;
+            tcxstrcat(xstr, &num, sizeof(num));
+            rnum = 0;
+            ttservlog(g_serv, TTLOGINFO, "do_mget: response too large");
+            break;
+          }
           num = TTHTONL((uint32_t)ksiz);
           tcxstrcat(xstr, &num, sizeof(num));
           num = TTHTONL((uint32_t)vsiz);
           tcxstrcat(xstr, &num, sizeof(num));
           tcxstrcat(xstr, kbuf, ksiz);
-          tcxstrcat(xstr, vbuf, vsiz);
-          tcfree(vbuf);
+          resvecaddval(resv, vbuf, vsiz);
           rnum++;
         }
       }
     }
     num = TTHTONL((uint32_t)rnum);
     *(uint32_t *)((char *)tcxstrptr(xstr) + sizeof(code)) = num;
-    if(ttsocksend(sock, tcxstrptr(xstr), tcxstrsize(xstr))){
+    if(resvecsend(resv, sock, arg, req)){
       req->keep = true;
     } else {
       ttservlog(g_serv, TTLOGINFO, "do_mget: response failed");
     }
-    pthread_cleanup_pop(1);
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_mget: invalid entity");
   }
-  pthread_cleanup_pop(1);
+}
+
+
+/* handle the mgetstrm command */
+static void do_mgetstrm(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing mgetstrm command");
+  uint64_t mask = arg->mask;
+  TCADB *adb = arg->adb;
+  int rnum = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || rnum < 0 || rnum > MAXARGNUM){
+    ttservlog(g_serv, TTLOGINFO, "do_mgetstrm: invalid parameters");
+    return;
+  }
+  int knum;
+  MGETKEY *keys = mgetkeys(sock, req->arena, rnum, &knum);
+  if(!ttsockcheckend(sock)){
+    knum = mgetsort(keys, knum, adb);
+    TCXSTR *xstr = ttarenaxstr(req->arena);
+    char head[sizeof(uint8_t)+sizeof(uint32_t)];
+    memset(head, 0, sizeof(head));
+    tcxstrcat(xstr, head, sizeof(head));
+    uint8_t code = 0;
+    rnum = 0;
+    bool err = false;
+    if(mask & (TTMSKMGET | TTMSKALLORG | TTMSKALLREAD)){
+      code = 1;
+      ttservlog(g_serv, TTLOGINFO, "do_mgetstrm: forbidden");
+    } else {
+      int64_t tsiz = 0;
+      for(int i = 0; !err && i < knum; i++){
+        const char *kbuf = keys[i].kbuf;
+        int ksiz = keys[i].ksiz;
+        int vsiz;
+        char *vbuf = recget(arg, kbuf, ksiz, &vsiz);
+        if(!vbuf) continue;
+        tsiz += ksiz + vsiz;
+        if(tsiz > RESSIZMAX){
+          tcfree(vbuf);
+          code = 1;
+          ttservlog(g_serv, TTLOGINFO, "do_mgetstrm: response too large");
+          break;
+        }
+        if(!strmrec(sock, arg, req, xstr, &rnum, kbuf, ksiz, vbuf, vsiz)) err = true;
+        tcfree(vbuf);
+      }
+    }
+    if(!err && !strmchunk(sock, arg, req, xstr, code, &rnum, NULL, 0)) err = true;
+    if(!err){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_mgetstrm: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_mgetstrm: invalid entity");
+  }
 }
 
 
@@ -1381,22 +3724,20 @@ static void do_mget(TTSOCK *sock, TASKARG *arg, TTREQ *req){
 static void do_vsiz(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing vsiz command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
   int ksiz = ttsockgetint32(sock);
   if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ){
     ttservlog(g_serv, TTLOGINFO, "do_vsiz: invalid parameters");
     return;
   }
   char stack[TTIOBUFSIZ];
-  char *buf = (ksiz < TTIOBUFSIZ) ? stack : tcmalloc(ksiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, ksiz + 1);
   if(ttsockrecv(sock, buf, ksiz) && !ttsockcheckend(sock)){
     int vsiz;
     if(mask & (TTMSKVSIZ | TTMSKALLORG | TTMSKALLREAD)){
       vsiz = -1;
       ttservlog(g_serv, TTLOGINFO, "do_vsiz: forbidden");
     } else {
-      vsiz = tcadbvsiz(adb, buf, ksiz);
+      vsiz = recvsiz(arg, buf, ksiz);
     }
     if(vsiz >= 0){
       *stack = 0;
@@ -1419,27 +3760,78 @@ static void do_vsiz(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_vsiz: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
-/* handle the iterinit command */
-static void do_iterinit(TTSOCK *sock, TASKARG *arg, TTREQ *req){
-  ttservlog(g_serv, TTLOGDEBUG, "doing iterinit command");
+/* handle the iterinit command */
+static void do_iterinit(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing iterinit command");
+  uint64_t mask = arg->mask;
+  TCADB *adb = arg->adb;
+  uint8_t code = 0;
+  if(mask & (TTMSKITERINIT | TTMSKALLORG | TTMSKALLREAD)){
+    code = 1;
+    ttservlog(g_serv, TTLOGINFO, "do_iterinit: forbidden");
+  } else {
+    bool lock;
+    ITERCUR *cur = itercurget(arg, req, &lock);
+    if(lock && pthread_mutex_lock(arg->itermtx) != 0){
+      code = 1;
+      ttservlog(g_serv, TTLOGERROR, "do_iterinit: pthread_mutex_lock failed");
+    } else {
+      if(!itercurinit(cur, adb, 0, 1)){
+        code = 1;
+        ttservlog(g_serv, TTLOGERROR, "do_iterinit: operation failed");
+      }
+      if(lock && pthread_mutex_unlock(arg->itermtx) != 0)
+        ttservlog(g_serv, TTLOGERROR, "do_iterinit: pthread_mutex_unlock failed");
+    }
+  }
+  if(ttsocksend(sock, &code, sizeof(code))){
+    req->keep = true;
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_iterinit: response failed");
+  }
+}
+
+
+/* handle the iterpart command */
+static void do_iterpart(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing iterpart command");
   uint64_t mask = arg->mask;
   TCADB *adb = arg->adb;
+  int part = ttsockgetint32(sock);
+  int pnum = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || pnum < 1 || pnum > MAXARGNUM || part < 0 || part >= pnum){
+    ttservlog(g_serv, TTLOGINFO, "do_iterpart: invalid parameters");
+    return;
+  }
   uint8_t code = 0;
   if(mask & (TTMSKITERINIT | TTMSKALLORG | TTMSKALLREAD)){
     code = 1;
-    ttservlog(g_serv, TTLOGINFO, "do_iterinit: forbidden");
-  } else if(!tcadbiterinit(adb)){
-    code = 1;
-    ttservlog(g_serv, TTLOGERROR, "do_iterinit: operation failed");
+    ttservlog(g_serv, TTLOGINFO, "do_iterpart: forbidden");
+  } else {
+    bool lock;
+    ITERCUR *cur = itercurget(arg, req, &lock);
+    if(lock && pthread_mutex_lock(arg->itermtx) != 0){
+      code = 1;
+      ttservlog(g_serv, TTLOGERROR, "do_iterpart: pthread_mutex_lock failed");
+    } else {
+      if(pnum > 1 && cur->omode != ADBOFDB){
+        code = 1;
+        ttservlog(g_serv, TTLOGINFO, "do_iterpart: not supported by the database");
+      } else if(!itercurinit(cur, adb, part, pnum)){
+        code = 1;
+        ttservlog(g_serv, TTLOGERROR, "do_iterpart: operation failed");
+      }
+      if(lock && pthread_mutex_unlock(arg->itermtx) != 0)
+        ttservlog(g_serv, TTLOGERROR, "do_iterpart: pthread_mutex_unlock failed");
+    }
   }
   if(ttsocksend(sock, &code, sizeof(code))){
     req->keep = true;
   } else {
-    ttservlog(g_serv, TTLOGINFO, "do_iterinit: response failed");
+    ttservlog(g_serv, TTLOGINFO, "do_iterpart: response failed");
   }
 }
 
@@ -1449,32 +3841,41 @@ static void do_iternext(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing iternext command");
   uint64_t mask = arg->mask;
   TCADB *adb = arg->adb;
-  int vsiz;
-  char *vbuf;
+  TCXSTR *kxstr = ttarenaxstr(req->arena);
+  bool ok = false;
   if(mask & (TTMSKITERNEXT | TTMSKALLORG | TTMSKALLREAD)){
-    vbuf = NULL;
-    vsiz = 0;
     ttservlog(g_serv, TTLOGINFO, "do_iternext: forbidden");
   } else {
-    vbuf = tcadbiternext(adb, &vsiz);
+    bool lock;
+    ITERCUR *cur = itercurget(arg, req, &lock);
+    if(lock && pthread_mutex_lock(arg->itermtx) != 0){
+      ttservlog(g_serv, TTLOGERROR, "do_iternext: pthread_mutex_lock failed");
+    } else {
+      ok = itercurnext(cur, adb, kxstr, NULL, false);
+      while(ok && ttlexpired(arg->ttab, tcxstrptr(kxstr), tcxstrsize(kxstr))){
+        ok = itercurnext(cur, adb, kxstr, NULL, true);
+      }
+      if(lock && pthread_mutex_unlock(arg->itermtx) != 0)
+        ttservlog(g_serv, TTLOGERROR, "do_iternext: pthread_mutex_unlock failed");
+    }
   }
-  if(vbuf){
-    int rsiz = vsiz + sizeof(uint8_t) + sizeof(uint32_t);
-    char stack[TTIOBUFSIZ];
-    char *rbuf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz);
-    pthread_cleanup_push(free, (rbuf == stack) ? NULL : rbuf);
-    *rbuf = 0;
+  if(ok){
+    int vsiz = tcxstrsize(kxstr);
+    char head[sizeof(uint8_t)+sizeof(uint32_t)];
+    *head = 0;
     uint32_t num;
     num = TTHTONL((uint32_t)vsiz);
-    memcpy(rbuf + sizeof(uint8_t), &num, sizeof(uint32_t));
-    memcpy(rbuf + sizeof(uint8_t) + sizeof(uint32_t), vbuf, vsiz);
-    tcfree(vbuf);
-    if(ttsocksend(sock, rbuf, rsiz)){
+    memcpy(head + sizeof(uint8_t), &num, sizeof(uint32_t));
+    struct iovec iov[2];
+    iov[0].iov_base = head;
+    iov[0].iov_len = sizeof(head);
+    iov[1].iov_base = (char *)tcxstrptr(kxstr);
+    iov[1].iov_len = vsiz;
+    if(sendres(sock, arg, req, iov, 2)){
       req->keep = true;
     } else {
       ttservlog(g_serv, TTLOGINFO, "do_iternext: response failed");
     }
-    pthread_cleanup_pop(1);
   } else {
     uint8_t code = 1;
     if(ttsocksend(sock, &code, sizeof(code))){
@@ -1486,6 +3887,74 @@ static void do_iternext(TTSOCK *sock, TASKARG *arg, TTREQ *req){
 }
 
 
+/* handle the iterpage command */
+static void do_iterpage(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing iterpage command");
+  uint64_t mask = arg->mask;
+  TCADB *adb = arg->adb;
+  int max = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || max < 0){
+    ttservlog(g_serv, TTLOGINFO, "do_iterpage: invalid parameters");
+    return;
+  }
+  if(max > MAXARGNUM) max = MAXARGNUM;
+  RESVEC *resv = resvecnew(req->arena);
+  TCXSTR *xstr = resv->head;
+  uint8_t code = 0;
+  tcxstrcat(xstr, &code, sizeof(code));
+  uint32_t num = 0;
+  tcxstrcat(xstr, &num, sizeof(num));
+  int rnum = 0;
+  if(mask & (TTMSKITERPAGE | TTMSKALLORG | TTMSKALLREAD)){
+    code = 1;
+    ttservlog(g_serv, TTLOGINFO, "do_iterpage: forbidden");
+  } else {
+    bool lock;
+    ITERCUR *cur = itercurget(arg, req, &lock);
+    if(lock && pthread_mutex_lock(arg->itermtx) != 0){
+      code = 1;
+      ttservlog(g_serv, TTLOGERROR, "do_iterpage: pthread_mutex_lock failed");
+    } else if(!cur->init){
+      code = 1;
+      ttservlog(g_serv, TTLOGINFO, "do_iterpage: not initialized");
+      if(lock && pthread_mutex_unlock(arg->itermtx) != 0)
+        ttservlog(g_serv, TTLOGERROR, "do_iterpage: pthread_mutex_unlock failed");
+    } else {
+      TCXSTR *kxstr = ttarenaxstr(req->arena);
+      TCXSTR *vxstr = ttarenaxstr(req->arena);
+      bool cont = false;
+      while(rnum < max && tcxstrsize(xstr) < MAXARGSIZ &&
+            itercurnext(cur, adb, kxstr, vxstr, cont)){
+        cont = true;
+        if(ttlexpired(arg->ttab, tcxstrptr(kxstr), tcxstrsize(kxstr))) continue;
+        num = TTHTONL((uint32_t)tcxstrsize(kxstr));
+        tcxstrcat(xstr, &num, sizeof(num));
+        num = TTHTONL((uint32_t)tcxstrsize(vxstr));
+        tcxstrcat(xstr, &num, sizeof(num));
+        tcxstrcat(xstr, tcxstrptr(kxstr), tcxstrsize(kxstr));
+        tcxstrcat(xstr, tcxstrptr(vxstr), tcxstrsize(vxstr));
+        rnum++;
+      }
+      if(lock && pthread_mutex_unlock(arg->itermtx) != 0)
+        ttservlog(g_serv, TTLOGERROR, "do_iterpage: pthread_mutex_unlock failed");
+    }
+  }
+  bool rv;
+  if(code == 0){
+    num = TTHTONL((uint32_t)rnum);
+    *(uint32_t *)((char *)tcxstrptr(xstr) + sizeof(code)) = num;
+    rv = resvecsend(resv, sock, arg, req);
+  } else {
+    rv = ttsocksend(sock, &code, sizeof(code));
+  }
+  if(rv){
+    req->keep = true;
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_iterpage: response failed");
+  }
+}
+
+
 /* handle the fwmkeys command */
 static void do_fwmkeys(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing fwmkeys command");
@@ -1497,14 +3966,11 @@ static void do_fwmkeys(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     ttservlog(g_serv, TTLOGINFO, "do_fwmkeys: invalid parameters");
     return;
   }
-  char stack[TTIOBUFSIZ];
-  char *buf = (psiz < TTIOBUFSIZ) ? stack : tcmalloc(psiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, psiz + 1);
   if(ttsockrecv(sock, buf, psiz) && !ttsockcheckend(sock)){
     TCLIST *keys = tcadbfwmkeys(adb, buf, psiz, max);
     pthread_cleanup_push((void (*)(void *))tclistdel, keys);
-    TCXSTR *xstr = tcxstrnew();
-    pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+    TCXSTR *xstr = ttarenaxstr(req->arena);
     uint8_t code = 0;
     tcxstrcat(xstr, &code, sizeof(code));
     uint32_t num = 0;
@@ -1516,6 +3982,7 @@ static void do_fwmkeys(TTSOCK *sock, TASKARG *arg, TTREQ *req){
       for(int i = 0; i < tclistnum(keys); i++){
         int ksiz;
         const char *kbuf = tclistval(keys, i, &ksiz);
+        if(ttlexpired(arg->ttab, kbuf, ksiz)) continue;
         num = TTHTONL((uint32_t)ksiz);
         tcxstrcat(xstr, &num, sizeof(num));
         tcxstrcat(xstr, kbuf, ksiz);
@@ -1524,17 +3991,91 @@ static void do_fwmkeys(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     }
     num = TTHTONL((uint32_t)knum);
     *(uint32_t *)((char *)tcxstrptr(xstr) + sizeof(code)) = num;
-    if(ttsocksend(sock, tcxstrptr(xstr), tcxstrsize(xstr))){
+    struct iovec iov;
+    iov.iov_base = (char *)tcxstrptr(xstr);
+    iov.iov_len = tcxstrsize(xstr);
+    if(sendres(sock, arg, req, &iov, 1)){
       req->keep = true;
     } else {
       ttservlog(g_serv, TTLOGINFO, "do_fwmkeys: response failed");
     }
     pthread_cleanup_pop(1);
-    pthread_cleanup_pop(1);
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_fwmkeys: invalid entity");
   }
-  pthread_cleanup_pop(1);
+}
+
+
+/* handle the fwmrecs command */
+static void do_fwmrecs(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGDEBUG, "doing fwmrecs command");
+  uint64_t mask = arg->mask;
+  int psiz = ttsockgetint32(sock);
+  int ssiz = ttsockgetint32(sock);
+  int max = ttsockgetint32(sock);
+  int opts = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || psiz < 0 || psiz > MAXARGSIZ || ssiz < 0 || ssiz > MAXARGSIZ){
+    ttservlog(g_serv, TTLOGINFO, "do_fwmrecs: invalid parameters");
+    return;
+  }
+  int rsiz = psiz + ssiz;
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
+  if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
+    const char *pbuf = buf;
+    const char *sbuf = buf + psiz;
+    TCXSTR *xstr = ttarenaxstr(req->arena);
+    char head[sizeof(uint8_t)+sizeof(uint32_t)];
+    memset(head, 0, sizeof(head));
+    tcxstrcat(xstr, head, sizeof(head));
+    uint8_t code = 0;
+    int rnum = 0;
+    bool err = false;
+    if(mask & (TTMSKFWMKEYS | TTMSKALLORG | TTMSKALLREAD)){
+      code = 1;
+      ttservlog(g_serv, TTLOGINFO, "do_fwmrecs: forbidden");
+    } else {
+      bool more;
+      TCLIST *keys = fwmrecskeys(arg, pbuf, psiz, sbuf, ssiz, max, opts & RDBFWMDESC, &more);
+      pthread_cleanup_push((void (*)(void *))tclistdel, keys);
+      int knum = tclistnum(keys);
+      int64_t tsiz = 0;
+      int i;
+      for(i = 0; !err && i < knum; i++){
+        int ksiz;
+        const char *kbuf = tclistval(keys, i, &ksiz);
+        int vsiz;
+        char *vbuf = recget(arg, kbuf, ksiz, &vsiz);
+        if(!vbuf) continue;
+        tsiz += ksiz + vsiz;
+        if(tsiz > RESSIZMAX && i > 0){
+          tcfree(vbuf);
+          more = true;
+          break;
+        }
+        if(!strmrec(sock, arg, req, xstr, &rnum, kbuf, ksiz, vbuf, vsiz)) err = true;
+        tcfree(vbuf);
+      }
+      if(more && i > 0){
+        int ksiz;
+        const char *kbuf = tclistval(keys, i - 1, &ksiz);
+        uint32_t num = TTHTONL((uint32_t)ksiz);
+        tcxstrcat(xstr, &num, sizeof(num));
+        tcxstrcat(xstr, kbuf, ksiz);
+      } else {
+        uint32_t num = TTHTONL((uint32_t)-1);
+        tcxstrcat(xstr, &num, sizeof(num));
+      }
+      pthread_cleanup_pop(1);
+    }
+    if(!err && !strmchunk(sock, arg, req, xstr, code, &rnum, NULL, 0)) err = true;
+    if(!err){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_fwmrecs: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_fwmrecs: invalid entity");
+  }
 }
 
 
@@ -1542,9 +4083,6 @@ static void do_fwmkeys(TTSOCK *sock, TASKARG *arg, TTREQ *req){
 static void do_addint(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing addint command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   int ksiz = ttsockgetint32(sock);
   int anum = ttsockgetint32(sock);
   if(ttsockcheckend(sock) || ksiz < 0 || ksiz > MAXARGSIZ){
@@ -1552,15 +4090,14 @@ static void do_addint(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     return;
   }
   char stack[TTIOBUFSIZ];
-  char *buf = (ksiz < TTIOBUFSIZ) ? stack : tcmalloc(ksiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, ksiz + 1);
   if(ttsockrecv(sock, buf, ksiz) && !ttsockcheckend(sock)){
     int snum;
     if(mask & (TTMSKADDINT | TTMSKALLORG | TTMSKALLWRITE)){
       snum = INT_MIN;
       ttservlog(g_serv, TTLOGINFO, "do_addint: forbidden");
     } else {
-      snum = tculogadbaddint(ulog, sid, adb, buf, ksiz, anum);
+      snum = recaddint(arg, buf, ksiz, anum);
     }
     if(snum != INT_MIN){
       *stack = 0;
@@ -1583,7 +4120,6 @@ static void do_addint(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_addint: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -1591,9 +4127,6 @@ static void do_addint(TTSOCK *sock, TASKARG *arg, TTREQ *req){
 static void do_adddouble(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing adddouble command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   int ksiz = ttsockgetint32(sock);
   char abuf[sizeof(uint64_t)*2];
   if(!ttsockrecv(sock, abuf, sizeof(abuf)) || ttsockcheckend(sock) ||
@@ -1603,15 +4136,14 @@ static void do_adddouble(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   }
   double anum = ttunpackdouble(abuf);
   char stack[TTIOBUFSIZ];
-  char *buf = (ksiz < TTIOBUFSIZ) ? stack : tcmalloc(ksiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, ksiz + 1);
   if(ttsockrecv(sock, buf, ksiz) && !ttsockcheckend(sock)){
     double snum;
     if(mask & (TTMSKADDDOUBLE | TTMSKALLORG | TTMSKALLWRITE)){
       snum = nan("");
       ttservlog(g_serv, TTLOGINFO, "do_adddouble: forbidden");
     } else {
-      snum = tculogadbadddouble(ulog, sid, adb, buf, ksiz, anum);
+      snum = recadddouble(arg, buf, ksiz, anum);
     }
     if(!isnan(snum)){
       *stack = 0;
@@ -1633,7 +4165,6 @@ static void do_adddouble(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_adddouble: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -1642,7 +4173,7 @@ static void do_ext(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   ttservlog(g_serv, TTLOGDEBUG, "doing ext command");
   uint64_t mask = arg->mask;
   pthread_mutex_t *rmtxs = arg->rmtxs;
-  void *scr = arg->screxts[req->idx];
+  void *scr = (req->idx >= 0) ? arg->screxts[req->idx] : NULL;
   int nsiz = ttsockgetint32(sock);
   int opts = ttsockgetint32(sock);
   int ksiz = ttsockgetint32(sock);
@@ -1653,9 +4184,7 @@ static void do_ext(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     return;
   }
   int rsiz = nsiz + ksiz + vsiz;
-  char stack[TTIOBUFSIZ];
-  char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, rsiz + 1);
   if(ttsockrecv(sock, buf, rsiz) && !ttsockcheckend(sock)){
     char name[TTADDRBUFSIZ];
     memcpy(name, buf, nsiz);
@@ -1701,8 +4230,7 @@ static void do_ext(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     }
     if(xbuf){
       int rsiz = xsiz + sizeof(uint8_t) + sizeof(uint32_t);
-      char *rbuf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz);
-      pthread_cleanup_push(free, (rbuf == stack) ? NULL : rbuf);
+      char *rbuf = ttarenaalloc(req->arena, rsiz);
       *rbuf = 0;
       uint32_t num;
       num = TTHTONL((uint32_t)xsiz);
@@ -1714,7 +4242,6 @@ static void do_ext(TTSOCK *sock, TASKARG *arg, TTREQ *req){
       } else {
         ttservlog(g_serv, TTLOGINFO, "do_ext: response failed");
       }
-      pthread_cleanup_pop(1);
     } else {
       uint8_t code = 1;
       if(ttsocksend(sock, &code, sizeof(code))){
@@ -1726,7 +4253,6 @@ static void do_ext(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_ext: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -1784,9 +4310,7 @@ static void do_copy(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     ttservlog(g_serv, TTLOGINFO, "do_copy: invalid parameters");
     return;
   }
-  char stack[TTIOBUFSIZ];
-  char *buf = (psiz < TTIOBUFSIZ) ? stack : tcmalloc(psiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, psiz + 1);
   if(ttsockrecv(sock, buf, psiz) && !ttsockcheckend(sock)){
     buf[psiz] = '\0';
     uint8_t code = 0;
@@ -1805,7 +4329,6 @@ static void do_copy(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_copy: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -1821,9 +4344,7 @@ static void do_restore(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     ttservlog(g_serv, TTLOGINFO, "do_restore: invalid parameters");
     return;
   }
-  char stack[TTIOBUFSIZ];
-  char *buf = (psiz < TTIOBUFSIZ) ? stack : tcmalloc(psiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, psiz + 1);
   if(ttsockrecv(sock, buf, psiz) && !ttsockcheckend(sock)){
     buf[psiz] = '\0';
     bool con = true;
@@ -1847,7 +4368,6 @@ static void do_restore(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_restore: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -1862,9 +4382,7 @@ static void do_setmst(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     ttservlog(g_serv, TTLOGINFO, "do_setmst: invalid parameters");
     return;
   }
-  char stack[TTIOBUFSIZ];
-  char *buf = (hsiz < TTIOBUFSIZ) ? stack : tcmalloc(hsiz + 1);
-  pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+  char *buf = ttarenaalloc(req->arena, hsiz + 1);
   if(ttsockrecv(sock, buf, hsiz) && !ttsockcheckend(sock)){
     buf[hsiz] = '\0';
     uint8_t code = 0;
@@ -1884,7 +4402,6 @@ static void do_setmst(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_setmst: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -1962,6 +4479,8 @@ static void do_stat(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     case ADBOTDB: wp += sprintf(wp, "type\ttable\n"); break;
     }
     wp += sprintf(wp, "rnum\t%llu\n", (unsigned long long)tcadbrnum(adb));
+    wp += sprintf(wp, "xnum\t%lld\n",
+                  (long long)__atomic_load_n(&arg->ttab->num, __ATOMIC_ACQUIRE));
     wp += sprintf(wp, "size\t%llu\n", (unsigned long long)tcadbsize(adb));
     wp += sprintf(wp, "bigend\t%d\n", TTBIGEND);
     if(sarg->host[0] != '\0'){
@@ -1972,6 +4491,55 @@ static void do_stat(TTSOCK *sock, TASKARG *arg, TTREQ *req){
       wp += sprintf(wp, "delay\t%.6f\n", delay >= 0 ? delay : 0.0);
     }
     wp += sprintf(wp, "fd\t%d\n", sock->fd);
+    wp += sprintf(wp, "thnum\t%d\n", g_serv->thcur);
+    wp += sprintf(wp, "thspawn\t%llu\n", (unsigned long long)g_serv->spawnnum);
+    wp += sprintf(wp, "thretire\t%llu\n", (unsigned long long)g_serv->retirenum);
+    uint64_t waitnum = g_serv->waitnum;
+    wp += sprintf(wp, "qwait_avg\t%.6f\n",
+                  waitnum > 0 ? g_serv->waitsum / 1000000.0 / waitnum : 0.0);
+    wp += sprintf(wp, "qwait_max\t%.6f\n", g_serv->waitmax / 1000000.0);
+    wp += sprintf(wp, "evbackend\t%s\n", g_serv->uringnum > 0 ? "io_uring" : "epoll");
+    wp += sprintf(wp, "evsyscall\t%llu\n", (unsigned long long)g_serv->evsysnum);
+    wp += sprintf(wp, "deferred\t%llu\n", (unsigned long long)g_serv->defernum);
+    uint64_t firenum = g_serv->firenum;
+    wp += sprintf(wp, "timer_fires\t%llu\n", (unsigned long long)firenum);
+    wp += sprintf(wp, "timer_jitter_avg\t%.6f\n",
+                  firenum > 0 ? g_serv->jitsum / 1000000.0 / firenum : 0.0);
+    wp += sprintf(wp, "timer_jitter_max\t%.6f\n", g_serv->jitmax / 1000000.0);
+    wp += sprintf(wp, "shm_sessions\t%llu\n", (unsigned long long)g_serv->shmnum);
+    uint64_t zinsum = arg->zinsum;
+    wp += sprintf(wp, "comp_in\t%llu\n", (unsigned long long)zinsum);
+    wp += sprintf(wp, "comp_out\t%llu\n", (unsigned long long)arg->zoutsum);
+    wp += sprintf(wp, "comp_ratio\t%.6f\n",
+                  zinsum > 0 ? (double)arg->zoutsum / zinsum : 1.0);
+    STRMARG *strm = arg->strm;
+    zinsum = strm->zinsum;
+    wp += sprintf(wp, "comp_repl_ratio\t%.6f\n",
+                  zinsum > 0 ? (double)strm->zoutsum / zinsum : 1.0);
+    TTBLOOM *bloom = arg->ulog->bloom;
+    if(bloom){
+      uint64_t nnum = __atomic_load_n(&bloom->nnum, __ATOMIC_RELAXED);
+      uint64_t fnum = __atomic_load_n(&bloom->fnum, __ATOMIC_RELAXED);
+      wp += sprintf(wp, "bloom_size\t%llu\n", (unsigned long long)ttbloomsize(bloom));
+      wp += sprintf(wp, "bloom_ready\t%d\n", __atomic_load_n(&bloom->ready, __ATOMIC_ACQUIRE));
+      wp += sprintf(wp, "bloom_neg\t%llu\n", (unsigned long long)nnum);
+      wp += sprintf(wp, "bloom_fp\t%llu\n", (unsigned long long)fnum);
+      wp += sprintf(wp, "bloom_fp_rate\t%.6f\n",
+                    nnum + fnum > 0 ? (double)fnum / (nnum + fnum) : 0.0);
+    }
+    TTCACHE *cache = arg->ulog->cache;
+    if(cache){
+      wp += sprintf(wp, "cache_size\t%llu\n", (unsigned long long)ttcachesize(cache));
+      wp += sprintf(wp, "cache_hit\t%llu\n",
+                    (unsigned long long)__atomic_load_n(&cache->hnum, __ATOMIC_RELAXED));
+      wp += sprintf(wp, "cache_miss\t%llu\n",
+                    (unsigned long long)__atomic_load_n(&cache->mnum, __ATOMIC_RELAXED));
+      wp += sprintf(wp, "cache_evict\t%llu\n",
+                    (unsigned long long)__atomic_load_n(&cache->vnum, __ATOMIC_RELAXED));
+    }
+    wp += sprintf(wp, "shed_bin\t%llu\n", (unsigned long long)arg->shednums[PROTBIN]);
+    wp += sprintf(wp, "shed_mc\t%llu\n", (unsigned long long)arg->shednums[PROTMC]);
+    wp += sprintf(wp, "shed_http\t%llu\n", (unsigned long long)arg->shednums[PROTHTTP]);
     wp += sprintf(wp, "loadavg\t%.6f\n", ttgetloadavg());
     wp += sprintf(wp, "ru_real\t%.6f\n", now - g_starttime);
     struct rusage ubuf;
@@ -2017,18 +4585,14 @@ static void do_misc(TTSOCK *sock, TASKARG *arg, TTREQ *req){
   name[nsiz] = '\0';
   TCLIST *args = tclistnew2(rnum);
   pthread_cleanup_push((void (*)(void *))tclistdel, args);
-  char stack[TTIOBUFSIZ];
   for(int i = 0; i < rnum; i++){
     int rsiz = ttsockgetint32(sock);
     if(ttsockcheckend(sock) || rsiz < 0 || rsiz > MAXARGSIZ) break;
-    char *buf = (rsiz < TTIOBUFSIZ) ? stack : tcmalloc(rsiz + 1);
-    pthread_cleanup_push(free, (buf == stack) ? NULL : buf);
+    char *buf = ttarenaalloc(req->arena, rsiz + 1);
     if(ttsockrecv(sock, buf, rsiz)) tclistpush(args, buf, rsiz);
-    pthread_cleanup_pop(1);
   }
   if(!ttsockcheckend(sock)){
-    TCXSTR *xstr = tcxstrnew();
-    pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+    TCXSTR *xstr = ttarenaxstr(req->arena);
     uint8_t code = 0;
     tcxstrcat(xstr, &code, sizeof(code));
     uint32_t num = 0;
@@ -2037,8 +4601,18 @@ static void do_misc(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     if(mask & (TTMSKMISC | TTMSKALLORG | TTMSKALLWRITE)){
       ttservlog(g_serv, TTLOGINFO, "do_misc: forbidden");
     } else {
+      if(opts & RDBMONOULOG) tculogbloommisc(ulog, name, args);
+      bool iter = tcstrfwm(name, "iter");
+      if(iter && pthread_mutex_lock(arg->itermtx) != 0)
+        ttservlog(g_serv, TTLOGERROR, "do_misc: pthread_mutex_lock failed");
       TCLIST *res = (opts & RDBMONOULOG) ?
         tcadbmisc(adb, name, args) : tculogadbmisc(ulog, sid, adb, name, args);
+      if(iter && pthread_mutex_unlock(arg->itermtx) != 0)
+        ttservlog(g_serv, TTLOGERROR, "do_misc: pthread_mutex_unlock failed");
+      if(opts & RDBMONOULOG){
+        tculogcachemisc(ulog, name, args);
+        tculogmodmisc(ulog, name, args);
+      }
       if(res){
         for(int i = 0; i < tclistnum(res); i++){
           int esiz;
@@ -2055,12 +4629,14 @@ static void do_misc(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     }
     num = TTHTONL((uint32_t)rnum);
     *(uint32_t *)((char *)tcxstrptr(xstr) + sizeof(code)) = num;
-    if(ttsocksend(sock, tcxstrptr(xstr), tcxstrsize(xstr))){
+    struct iovec iov;
+    iov.iov_base = (char *)tcxstrptr(xstr);
+    iov.iov_len = tcxstrsize(xstr);
+    if(sendres(sock, arg, req, &iov, 1)){
       req->keep = true;
     } else {
       ttservlog(g_serv, TTLOGINFO, "do_misc: response failed");
     }
-    pthread_cleanup_pop(1);
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_misc: invalid entity");
   }
@@ -2083,56 +4659,106 @@ static void do_repl(TTSOCK *sock, TASKARG *arg, TTREQ *req){
     ttservlog(g_serv, TTLOGINFO, "do_repl: forbidden");
     return;
   }
+  STRMARG *strm = arg->strm;
   TCULRD *ulrd = tculrdnew(ulog, ts);
-  if(ulrd){
-    pthread_cleanup_push((void (*)(void *))tculrddel, ulrd);
-    bool err = false;
-    bool idle = true;
-    const char *rbuf;
-    int rsiz;
-    uint64_t rts;
-    uint32_t rsid;
-    char stack[TTIOBUFSIZ];
-    while(!err && !ttserviskilled(g_serv)){
-      ttsocksetlife(sock, UINT_MAX);
-      req->mtime = tctime() + UINT_MAX;
-      if(idle){
-        *(unsigned char *)stack = TCULMAGICNOP;
-        if(!ttsocksend(sock, stack, sizeof(uint8_t))){
-          err = true;
-          ttservlog(g_serv, TTLOGINFO, "do_repl: connection closed");
-        }
-      }
-      tculrdwait(ulrd);
-      idle = true;
-      while(!err && (rbuf = tculrdread(ulrd, &rsiz, &rts, &rsid)) != NULL){
-        idle = false;
-        if(rsid == sid) continue;
-        int msiz = sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t) * 2 + rsiz;
-        char *mbuf = (msiz < TTIOBUFSIZ) ? stack : tcmalloc(msiz);
-        pthread_cleanup_push(free, (mbuf == stack) ? NULL : mbuf);
-        unsigned char *wp = (unsigned char *)mbuf;
-        *(wp++) = TCULMAGICNUM;
-        uint64_t llnum = TTHTONLL(rts);
-        memcpy(wp, &llnum, sizeof(llnum));
-        wp += sizeof(llnum);
-        uint32_t lnum = TTHTONL(rsid);
-        memcpy(wp, &lnum, sizeof(lnum));
-        wp += sizeof(lnum);
-        lnum = TTHTONL(rsiz);
-        memcpy(wp, &lnum, sizeof(lnum));
-        wp += sizeof(lnum);
-        memcpy(wp, rbuf, rsiz);
-        if(!ttsocksend(sock, mbuf, msiz)){
-          err = true;
-          ttservlog(g_serv, TTLOGINFO, "do_repl: response failed");
-        }
-        pthread_cleanup_pop(1);
-      }
-    }
-    pthread_cleanup_pop(1);
-  } else {
+  if(!ulrd){
     ttservlog(g_serv, TTLOGERROR, "do_repl: tculrdnew failed");
+    return;
+  }
+  if(!strm->alive){
+    tculrddel(ulrd);
+    ttservlog(g_serv, TTLOGERROR, "do_repl: the streamer is not running");
+    return;
+  }
+  int fd = dup(sock->fd);
+  if(fd == -1){
+    tculrddel(ulrd);
+    ttservlog(g_serv, TTLOGERROR, "do_repl: dup failed");
+    return;
+  }
+  REPLSESS *sess = tcmalloc(sizeof(*sess));
+  sess->fd = fd;
+  sess->ulrd = ulrd;
+  sess->sid = sid;
+  sess->obuf = tcxstrnew();
+  sess->off = 0;
+  sess->stime = 0;
+  sess->err = false;
+  uint32_t copts = ttservconnopts(g_serv, req->cfd);
+  sess->zcodec = copts & 0xff;
+  sess->zthres = copts >> 8;
+  if(pthread_mutex_lock(&strm->mtx) != 0){
+    replsessdel(sess);
+    ttservlog(g_serv, TTLOGERROR, "do_repl: pthread_mutex_lock failed");
+    return;
+  }
+  tclistpush(strm->sesss, &sess, sizeof(sess));
+  pthread_mutex_unlock(&strm->mtx);
+  if(!tculogwake(ulog)) ttservlog(g_serv, TTLOGERROR, "do_repl: tculogwake failed");
+  ttservlog(g_serv, TTLOGINFO, "do_repl: session started: sid=%u", sess->sid);
+}
+
+
+/* handle the shm command */
+static void do_shm(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGINFO, "doing shm command");
+  uint64_t mask = arg->mask;
+  char buf[sizeof(uint8_t)+sizeof(uint32_t)+TTADDRBUFSIZ];
+  char *name = buf + sizeof(uint8_t) + sizeof(uint32_t);
+  *name = '\0';
+  uint8_t code = 0;
+  if(mask & TTMSKALLORG){
+    code = 1;
+    ttservlog(g_serv, TTLOGINFO, "do_shm: forbidden");
+  } else if(!ttservopenshm(g_serv, req->cfd, name)){
+    code = 1;
+    ttservlog(g_serv, TTLOGINFO, "do_shm: ttservopenshm failed");
+  }
+  int nsiz = (code == 0) ? strlen(name) : 0;
+  *buf = code;
+  uint32_t num = TTHTONL((uint32_t)nsiz);
+  memcpy(buf + sizeof(uint8_t), &num, sizeof(num));
+  if(ttsocksend(sock, buf, sizeof(uint8_t) + sizeof(uint32_t) + nsiz)){
+    req->keep = true;
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_shm: response failed");
+  }
+}
+
+
+/* handle the comp command */
+static void do_comp(TTSOCK *sock, TASKARG *arg, TTREQ *req){
+  ttservlog(g_serv, TTLOGINFO, "doing comp command");
+  uint64_t mask = arg->mask;
+  int codec = ttsockgetint32(sock);
+  int thres = ttsockgetint32(sock);
+  if(ttsockcheckend(sock)){
+    ttservlog(g_serv, TTLOGINFO, "do_comp: invalid parameters");
+    return;
+  }
+  uint8_t code = 0;
+  int zsiz;
+  char *zbuf;
+  if(mask & TTMSKALLORG){
+    code = 1;
+    ttservlog(g_serv, TTLOGINFO, "do_comp: forbidden");
+  } else if(req->cfd < 0){
+    code = 1;
+    ttservlog(g_serv, TTLOGINFO, "do_comp: not supported by the transport");
+  } else if(codec == TTZNONE){
+    ttservsetconnopts(g_serv, req->cfd, 0);
+  } else if(codec > 0 && codec <= 0xff && (zbuf = ttcompress(codec, "", 0, &zsiz)) != NULL){
+    tcfree(zbuf);
+    thres = tclmin(tclmax(thres, COMPTHRESMIN), COMPTHRESMAX);
+    ttservsetconnopts(g_serv, req->cfd, ((uint32_t)thres << 8) | codec);
+  } else {
+    code = 1;
+    ttservlog(g_serv, TTLOGINFO, "do_comp: unsupported codec: %d", codec);
+  }
+  if(ttsocksend(sock, &code, sizeof(code))){
+    req->keep = true;
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_comp: response failed");
   }
 }
 static void do_ext_delrepl(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum){
@@ -2147,7 +4773,7 @@ static void do_ext_delrepl(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens
   int port = atoi(tokens[2]);
   const char * rptpath = tokens[3];
     req->keep=true;
-  ttservdeltimedhandler(host,port,rptpath,g_serv);
+  ttservdeltimedhandler(host,port,rptpath,g_serv,do_slave);
   if(!nr)
       ttsockprintf(sock,"OK\n");
 }
@@ -2165,7 +4791,7 @@ void do_ext_addrepl(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int t
   char * rptpath = tokens[3];
 
     req->keep=true;
-  ttservmodifytimedhandler(host,port,rptpath,g_serv);
+  ttservmodifytimedhandler(host,port,rptpath,g_serv,do_slave);
   if(!nr)
       ttsockprintf(sock,"OK\n");
 }
@@ -2178,22 +4804,18 @@ static void do_mc_set(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int
   }
   bool nr = tnum > 5 && !strcmp(tokens[5], "noreply");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   const char *kbuf = tokens[1];
   int ksiz = strlen(kbuf);
   int vsiz = tclmax(tcatoi(tokens[4]), 0);
   char stack[TTIOBUFSIZ];
-  char *vbuf = (vsiz < TTIOBUFSIZ) ? stack : tcmalloc(vsiz + 1);
-  pthread_cleanup_push(free, (vbuf == stack) ? NULL : vbuf);
+  char *vbuf = ttarenaalloc(req->arena, vsiz + 1);
   if(ttsockrecv(sock, vbuf, vsiz) && ttsockgetc(sock) == '\r' && ttsockgetc(sock) == '\n' &&
      !ttsockcheckend(sock)){
     int len;
     if(mask & (TTMSKPUT | TTMSKALLMC | TTMSKALLWRITE)){
       len = sprintf(stack, "CLIENT_ERROR forbidden\r\n");
       ttservlog(g_serv, TTLOGINFO, "do_mc_set: forbidden");
-    } else if(tculogadbput(ulog, sid, adb, kbuf, ksiz, vbuf, vsiz)){
+    } else if(recput(arg, kbuf, ksiz, vbuf, vsiz, ttlmcxt(tokens[3]))){
       len = sprintf(stack, "STORED\r\n");
     } else {
       len = sprintf(stack, "SERVER_ERROR unexpected\r\n");
@@ -2207,7 +4829,6 @@ static void do_mc_set(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_mc_set: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -2215,9 +4836,6 @@ static void do_mc_set(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int
 static void do_mc_add(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum){
   ttservlog(g_serv, TTLOGDEBUG, "doing mc_add command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   if(tnum < 5){
     ttsockprintf(sock, "CLIENT_ERROR error\r\n");
     return;
@@ -2227,15 +4845,14 @@ static void do_mc_add(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int
   int ksiz = strlen(kbuf);
   int vsiz = tclmax(tcatoi(tokens[4]), 0);
   char stack[TTIOBUFSIZ];
-  char *vbuf = (vsiz < TTIOBUFSIZ) ? stack : tcmalloc(vsiz + 1);
-  pthread_cleanup_push(free, (vbuf == stack) ? NULL : vbuf);
+  char *vbuf = ttarenaalloc(req->arena, vsiz + 1);
   if(ttsockrecv(sock, vbuf, vsiz) && ttsockgetc(sock) == '\r' && ttsockgetc(sock) == '\n' &&
      !ttsockcheckend(sock)){
     int len;
     if(mask & (TTMSKPUTKEEP | TTMSKALLMC | TTMSKALLWRITE)){
       len = sprintf(stack, "CLIENT_ERROR forbidden\r\n");
       ttservlog(g_serv, TTLOGINFO, "do_mc_add: forbidden");
-    } else if(tculogadbputkeep(ulog, sid, adb, kbuf, ksiz, vbuf, vsiz)){
+    } else if(recputkeep(arg, kbuf, ksiz, vbuf, vsiz, ttlmcxt(tokens[3]))){
       len = sprintf(stack, "STORED\r\n");
     } else {
       len = sprintf(stack, "NOT_STORED\r\n");
@@ -2248,7 +4865,6 @@ static void do_mc_add(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_mc_add: invalid entity");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -2256,9 +4872,6 @@ static void do_mc_add(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int
 static void do_mc_replace(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum){
   ttservlog(g_serv, TTLOGDEBUG, "doing mc_replace command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   if(tnum < 5){
     ttsockprintf(sock, "CLIENT_ERROR error\r\n");
     return;
@@ -2268,16 +4881,15 @@ static void do_mc_replace(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens,
   int ksiz = strlen(kbuf);
   int vsiz = tclmax(tcatoi(tokens[4]), 0);
   char stack[TTIOBUFSIZ];
-  char *vbuf = (vsiz < TTIOBUFSIZ) ? stack : tcmalloc(vsiz + 1);
-  pthread_cleanup_push(free, (vbuf == stack) ? NULL : vbuf);
+  char *vbuf = ttarenaalloc(req->arena, vsiz + 1);
   if(ttsockrecv(sock, vbuf, vsiz) && ttsockgetc(sock) == '\r' && ttsockgetc(sock) == '\n' &&
      !ttsockcheckend(sock)){
     int len;
     if(mask & (TTMSKPUT | TTMSKALLMC | TTMSKALLWRITE)){
       len = sprintf(stack, "CLIENT_ERROR forbidden\r\n");
       ttservlog(g_serv, TTLOGINFO, "do_mc_replace: forbidden");
-    } else if(tcadbvsiz(adb, kbuf, ksiz) >= 0 &&
-              tculogadbput(ulog, sid, adb, kbuf, ksiz, vbuf, vsiz)){
+    } else if(recvsiz(arg, kbuf, ksiz) >= 0 &&
+              recput(arg, kbuf, ksiz, vbuf, vsiz, ttlmcxt(tokens[3]))){
       len = sprintf(stack, "STORED\r\n");
     } else {
       len = sprintf(stack, "NOT_STORED\r\n");
@@ -2290,7 +4902,56 @@ static void do_mc_replace(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens,
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_mc_replace: invalid entity");
   }
-  pthread_cleanup_pop(1);
+}
+
+
+/* handle the memcached cas command */
+static void do_mc_cas(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum){
+  ttservlog(g_serv, TTLOGDEBUG, "doing mc_cas command");
+  uint64_t mask = arg->mask;
+  if(tnum < 6){
+    ttsockprintf(sock, "CLIENT_ERROR error\r\n");
+    return;
+  }
+  bool nr = tnum > 6 && !strcmp(tokens[6], "noreply");
+  const char *kbuf = tokens[1];
+  int ksiz = strlen(kbuf);
+  int vsiz = tclmax(tcatoi(tokens[4]), 0);
+  uint64_t ver = strtoull(tokens[5], NULL, 10);
+  char stack[TTIOBUFSIZ];
+  char *vbuf = ttarenaalloc(req->arena, vsiz + 1);
+  if(ttsockrecv(sock, vbuf, vsiz) && ttsockgetc(sock) == '\r' && ttsockgetc(sock) == '\n' &&
+     !ttsockcheckend(sock)){
+    int len;
+    if(mask & (TTMSKCAS | TTMSKALLMC | TTMSKALLWRITE)){
+      len = sprintf(stack, "CLIENT_ERROR forbidden\r\n");
+      ttservlog(g_serv, TTLOGINFO, "do_mc_cas: forbidden");
+    } else {
+      uint64_t nver;
+      switch(reccas(arg, kbuf, ksiz, vbuf, vsiz, ver, ttlmcxt(tokens[3]), &nver)){
+      case 0:
+        len = sprintf(stack, "STORED\r\n");
+        break;
+      case 1:
+        len = sprintf(stack, "EXISTS\r\n");
+        break;
+      case 2:
+        len = sprintf(stack, "NOT_FOUND\r\n");
+        break;
+      default:
+        len = sprintf(stack, "SERVER_ERROR unexpected\r\n");
+        ttservlog(g_serv, TTLOGERROR, "do_mc_cas: operation failed");
+        break;
+      }
+    }
+    if(nr || ttsocksend(sock, stack, len)){
+      req->keep = true;
+    } else {
+      ttservlog(g_serv, TTLOGINFO, "do_mc_cas: response failed");
+    }
+  } else {
+    ttservlog(g_serv, TTLOGINFO, "do_mc_cas: invalid entity");
+  }
 }
 
 
@@ -2303,34 +4964,65 @@ static void do_mc_get(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int
     ttsockprintf(sock, "CLIENT_ERROR error\r\n");
     return;
   }
-  TCXSTR *xstr = tcxstrnew();
-  pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+  bool cas = !strcmp(tokens[0], "gets");
+  MGETKEY *keys = ttarenaalloc(req->arena, sizeof(*keys) * (tnum - 1));
   for(int i = 1; i < tnum; i++){
-    const char *kbuf = tokens[i];
-    int ksiz = strlen(kbuf);
+    keys[i-1].kbuf = tokens[i];
+    keys[i-1].ksiz = strlen(tokens[i]);
+  }
+  int knum = mgetsort(keys, tnum - 1, adb);
+  TCXSTR *xstr = ttarenaxstr(req->arena);
+  bool err = false;
+  int64_t tsiz = 0;
+  for(int i = 0; !err && i < knum; i++){
+    const char *kbuf = keys[i].kbuf;
+    int ksiz = keys[i].ksiz;
     int vsiz;
     char *vbuf;
+    uint64_t ver = 0;
     if(mask & (TTMSKGET | TTMSKALLMC | TTMSKALLREAD)){
       vbuf = NULL;
       vsiz = 0;
       ttservlog(g_serv, TTLOGINFO, "do_mc_get: forbidden");
     } else {
-      vbuf = tcadbget(adb, kbuf, ksiz, &vsiz);
+      if(cas) ver = vertoken(arg->vtab, kbuf, ksiz);
+      vbuf = recget(arg, kbuf, ksiz, &vsiz);
     }
-    if(vbuf){
+    if(!vbuf) continue;
+    tsiz += ksiz + vsiz;
+    if(tsiz > RESSIZMAX){
+      tcfree(vbuf);
+      ttservlog(g_serv, TTLOGINFO, "do_mc_get: response too large");
+      break;
+    }
+    if(cas){
+      tcxstrprintf(xstr, "VALUE %s 0 %d %llu\r\n", kbuf, vsiz, (unsigned long long)ver);
+    } else {
       tcxstrprintf(xstr, "VALUE %s 0 %d\r\n", kbuf, vsiz);
+    }
+    if(vsiz <= RESVCOPYMAX){
       tcxstrcat(xstr, vbuf, vsiz);
-      tcxstrcat(xstr, "\r\n", 2);
-      tcfree(vbuf);
+    } else if(!strmflush(sock, arg, NULL, xstr, vbuf, vsiz)){
+      err = true;
+    }
+    tcfree(vbuf);
+    tcxstrcat(xstr, "\r\n", 2);
+    if(!err && tcxstrsize(xstr) >= RESCHUNKSIZ && !strmflush(sock, arg, NULL, xstr, NULL, 0))
+      err = true;
+  }
+  if(!err){
+    if(tsiz > RESSIZMAX){
+      tcxstrprintf(xstr, "SERVER_ERROR response too large\r\n");
+    } else {
+      tcxstrprintf(xstr, "END\r\n");
     }
+    if(!strmflush(sock, arg, NULL, xstr, NULL, 0)) err = true;
   }
-  tcxstrprintf(xstr, "END\r\n");
-  if(ttsocksend(sock, tcxstrptr(xstr), tcxstrsize(xstr))){
+  if(!err){
     req->keep = true;
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_mc_get: response failed");
   }
-  pthread_cleanup_pop(1);
 }
 
 
@@ -2338,9 +5030,6 @@ static void do_mc_get(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int
 static void do_mc_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum){
   ttservlog(g_serv, TTLOGDEBUG, "doing mc_delete command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   if(tnum < 2){
     ttsockprintf(sock, "CLIENT_ERROR error\r\n");
     return;
@@ -2354,7 +5043,7 @@ static void do_mc_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens,
   if(mask & (TTMSKOUT | TTMSKALLMC | TTMSKALLWRITE)){
     len = sprintf(stack, "CLIENT_ERROR forbidden\r\n");
     ttservlog(g_serv, TTLOGINFO, "do_mc_delete: forbidden");
-  } else if(tculogadbout(ulog, sid, adb, kbuf, ksiz)){
+  } else if(recout(arg, kbuf, ksiz)){
     len = sprintf(stack, "DELETED\r\n");
   } else {
     len = sprintf(stack, "NOT_FOUND\r\n");
@@ -2371,9 +5060,6 @@ static void do_mc_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens,
 static void do_mc_incr(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum){
   ttservlog(g_serv, TTLOGDEBUG, "doing mc_incr command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   pthread_mutex_t *rmtxs = arg->rmtxs;
   if(tnum < 3){
     ttsockprintf(sock, "CLIENT_ERROR error\r\n");
@@ -2396,12 +5082,12 @@ static void do_mc_incr(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, in
       return;
     }
     int vsiz;
-    char *vbuf = tcadbget(adb, kbuf, ksiz, &vsiz);
+    char *vbuf = recget(arg, kbuf, ksiz, &vsiz);
     if(vbuf){
       num += strtoll(vbuf, NULL, 10);
       if(num < 0) num = 0;
       len = sprintf(stack, "%lld", (long long)num);
-      if(tculogadbput(ulog, sid, adb, kbuf, ksiz, stack, len)){
+      if(recput(arg, kbuf, ksiz, stack, len, -1)){
         len = sprintf(stack, "%lld\r\n", (long long)num);
       } else {
         len = sprintf(stack, "SERVER_ERROR unexpected\r\n");
@@ -2426,9 +5112,6 @@ static void do_mc_incr(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, in
 static void do_mc_decr(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, int tnum){
   ttservlog(g_serv, TTLOGDEBUG, "doing mc_decr command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   pthread_mutex_t *rmtxs = arg->rmtxs;
   if(tnum < 3){
     ttsockprintf(sock, "CLIENT_ERROR error\r\n");
@@ -2451,12 +5134,12 @@ static void do_mc_decr(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, in
       return;
     }
     int vsiz;
-    char *vbuf = tcadbget(adb, kbuf, ksiz, &vsiz);
+    char *vbuf = recget(arg, kbuf, ksiz, &vsiz);
     if(vbuf){
       num += strtoll(vbuf, NULL, 10);
       if(num < 0) num = 0;
       len = sprintf(stack, "%lld", (long long)num);
-      if(tculogadbput(ulog, sid, adb, kbuf, ksiz, stack, len)){
+      if(recput(arg, kbuf, ksiz, stack, len, -1)){
         len = sprintf(stack, "%lld\r\n", (long long)num);
       } else {
         len = sprintf(stack, "SERVER_ERROR unexpected\r\n");
@@ -2570,7 +5253,6 @@ static void do_mc_quit(TTSOCK *sock, TASKARG *arg, TTREQ *req, char **tokens, in
 static void do_http_get(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const char *uri){
   ttservlog(g_serv, TTLOGDEBUG, "doing http_get command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
   bool keep = ver >= 1;
   char line[LINEBUFSIZ];
   while(ttsockgets(sock, line, LINEBUFSIZ) && *line != '\0'){
@@ -2591,9 +5273,8 @@ static void do_http_get(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
   if(*uri == '/') uri++;
   int ksiz;
   char *kbuf = tcurldecode(uri, &ksiz);
-  pthread_cleanup_push(free, kbuf);
-  TCXSTR *xstr = tcxstrnew();
-  pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+  ttarenaown(req->arena, kbuf);
+  TCXSTR *xstr = ttarenaxstr(req->arena);
   if(mask & (TTMSKGET | TTMSKALLHTTP | TTMSKALLREAD)){
     int len = sprintf(line, "Forbidden\n");
     tcxstrprintf(xstr, "HTTP/1.1 403 Forbidden\r\n");
@@ -2604,7 +5285,7 @@ static void do_http_get(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
     ttservlog(g_serv, TTLOGINFO, "do_http_get: forbidden");
   } else {
     int vsiz;
-    char *vbuf = tcadbget(adb, kbuf, ksiz, &vsiz);
+    char *vbuf = recget(arg, kbuf, ksiz, &vsiz);
     if(vbuf){
       tcxstrprintf(xstr, "HTTP/1.1 200 OK\r\n");
       tcxstrprintf(xstr, "Content-Type: application/octet-stream\r\n");
@@ -2626,8 +5307,6 @@ static void do_http_get(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_http_get: response failed");
   }
-  pthread_cleanup_pop(1);
-  pthread_cleanup_pop(1);
 }
 
 
@@ -2635,7 +5314,6 @@ static void do_http_get(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
 static void do_http_head(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const char *uri){
   ttservlog(g_serv, TTLOGDEBUG, "doing http_head command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
   bool keep = ver >= 1;
   char line[LINEBUFSIZ];
   while(ttsockgets(sock, line, LINEBUFSIZ) && *line != '\0'){
@@ -2656,15 +5334,14 @@ static void do_http_head(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const
   if(*uri == '/') uri++;
   int ksiz;
   char *kbuf = tcurldecode(uri, &ksiz);
-  pthread_cleanup_push(free, kbuf);
-  TCXSTR *xstr = tcxstrnew();
-  pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+  ttarenaown(req->arena, kbuf);
+  TCXSTR *xstr = ttarenaxstr(req->arena);
   if(mask & (TTMSKVSIZ | TTMSKALLHTTP | TTMSKALLREAD)){
     tcxstrprintf(xstr, "HTTP/1.1 403 Forbidden\r\n");
     tcxstrprintf(xstr, "\r\n");
     ttservlog(g_serv, TTLOGINFO, "do_http_head: forbidden");
   } else {
-    int vsiz = tcadbvsiz(adb, kbuf, ksiz);
+    int vsiz = recvsiz(arg, kbuf, ksiz);
     if(vsiz >= 0){
       tcxstrprintf(xstr, "HTTP/1.1 200 OK\r\n");
       tcxstrprintf(xstr, "Content-Type: application/octet-stream\r\n");
@@ -2680,8 +5357,6 @@ static void do_http_head(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_http_head: response failed");
   }
-  pthread_cleanup_pop(1);
-  pthread_cleanup_pop(1);
 }
 
 
@@ -2689,9 +5364,6 @@ static void do_http_head(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const
 static void do_http_put(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const char *uri){
   ttservlog(g_serv, TTLOGDEBUG, "doing http_put command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   bool keep = ver >= 1;
   int vsiz = 0;
   int pdmode = 0;
@@ -2718,13 +5390,10 @@ static void do_http_put(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
   if(*uri == '/') uri++;
   int ksiz;
   char *kbuf = tcurldecode(uri, &ksiz);
-  pthread_cleanup_push(free, kbuf);
-  char stack[TTIOBUFSIZ];
-  char *vbuf = (vsiz < TTIOBUFSIZ) ? stack : tcmalloc(vsiz + 1);
-  pthread_cleanup_push(free, (vbuf == stack) ? NULL : vbuf);
+  ttarenaown(req->arena, kbuf);
+  char *vbuf = ttarenaalloc(req->arena, (vsiz > 0) ? vsiz + 1 : 1);
   if(vsiz >= 0 && ttsockrecv(sock, vbuf, vsiz) && !ttsockcheckend(sock)){
-    TCXSTR *xstr = tcxstrnew();
-    pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+    TCXSTR *xstr = ttarenaxstr(req->arena);
     if(mask & (TTMSKPUT | TTMSKALLHTTP | TTMSKALLWRITE)){
       int len = sprintf(line, "Forbidden\n");
       tcxstrprintf(xstr, "HTTP/1.1 403 Forbidden\r\n");
@@ -2736,7 +5405,7 @@ static void do_http_put(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
     } else {
       switch(pdmode){
       case 1:
-        if(tculogadbputkeep(ulog, sid, adb, kbuf, ksiz, vbuf, vsiz)){
+        if(recputkeep(arg, kbuf, ksiz, vbuf, vsiz, 0)){
           int len = sprintf(line, "Created\n");
           tcxstrprintf(xstr, "HTTP/1.1 201 Created\r\n");
           tcxstrprintf(xstr, "Content-Type: text/plain\r\n");
@@ -2753,7 +5422,7 @@ static void do_http_put(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
         }
         break;
       case 2:
-        if(tculogadbputcat(ulog, sid, adb, kbuf, ksiz, vbuf, vsiz)){
+        if(recputcat(arg, kbuf, ksiz, vbuf, vsiz)){
           int len = sprintf(line, "Created\n");
           tcxstrprintf(xstr, "HTTP/1.1 201 Created\r\n");
           tcxstrprintf(xstr, "Content-Type: text/plain\r\n");
@@ -2771,7 +5440,7 @@ static void do_http_put(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
         }
         break;
       default:
-        if(tculogadbput(ulog, sid, adb, kbuf, ksiz, vbuf, vsiz)){
+        if(recput(arg, kbuf, ksiz, vbuf, vsiz, 0)){
           int len = sprintf(line, "Created\n");
           tcxstrprintf(xstr, "HTTP/1.1 201 Created\r\n");
           tcxstrprintf(xstr, "Content-Type: text/plain\r\n");
@@ -2794,12 +5463,9 @@ static void do_http_put(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const c
     } else {
       ttservlog(g_serv, TTLOGINFO, "do_http_put: response failed");
     }
-    pthread_cleanup_pop(1);
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_http_put: invalid entity");
   }
-  pthread_cleanup_pop(1);
-  pthread_cleanup_pop(1);
 }
 
 
@@ -2808,7 +5474,7 @@ static void do_http_post(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const
   ttservlog(g_serv, TTLOGDEBUG, "doing http_post command");
   uint64_t mask = arg->mask;
   pthread_mutex_t *rmtxs = arg->rmtxs;
-  void *scr = arg->screxts[req->idx];
+  void *scr = (req->idx >= 0) ? arg->screxts[req->idx] : NULL;
   bool keep = ver >= 1;
   int vsiz = 0;
   char name[LINEBUFSIZ/4+1];
@@ -2840,13 +5506,10 @@ static void do_http_post(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const
   if(*uri == '/') uri++;
   int ksiz;
   char *kbuf = tcurldecode(uri, &ksiz);
-  pthread_cleanup_push(free, kbuf);
-  char stack[TTIOBUFSIZ];
-  char *vbuf = (vsiz < TTIOBUFSIZ) ? stack : tcmalloc(vsiz + 1);
-  pthread_cleanup_push(free, (vbuf == stack) ? NULL : vbuf);
+  ttarenaown(req->arena, kbuf);
+  char *vbuf = ttarenaalloc(req->arena, (vsiz > 0) ? vsiz + 1 : 1);
   if(vsiz >= 0 && ttsockrecv(sock, vbuf, vsiz) && !ttsockcheckend(sock)){
-    TCXSTR *xstr = tcxstrnew();
-    pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+    TCXSTR *xstr = ttarenaxstr(req->arena);
     if(mask & (TTMSKEXT | TTMSKALLHTTP)){
       int len = sprintf(line, "Forbidden\n");
       tcxstrprintf(xstr, "HTTP/1.1 403 Forbidden\r\n");
@@ -2912,12 +5575,9 @@ static void do_http_post(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const
     } else {
       ttservlog(g_serv, TTLOGINFO, "do_http_post: response failed");
     }
-    pthread_cleanup_pop(1);
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_http_post: invalid entity");
   }
-  pthread_cleanup_pop(1);
-  pthread_cleanup_pop(1);
 }
 
 
@@ -2925,9 +5585,6 @@ static void do_http_post(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const
 static void do_http_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, const char *uri){
   ttservlog(g_serv, TTLOGDEBUG, "doing http_delete command");
   uint64_t mask = arg->mask;
-  TCADB *adb = arg->adb;
-  TCULOG *ulog = arg->ulog;
-  uint32_t sid = arg->sid;
   bool keep = ver >= 1;
   char line[LINEBUFSIZ];
   while(ttsockgets(sock, line, LINEBUFSIZ) && *line != '\0'){
@@ -2948,9 +5605,8 @@ static void do_http_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, cons
   if(*uri == '/') uri++;
   int ksiz;
   char *kbuf = tcurldecode(uri, &ksiz);
-  pthread_cleanup_push(free, kbuf);
-  TCXSTR *xstr = tcxstrnew();
-  pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
+  ttarenaown(req->arena, kbuf);
+  TCXSTR *xstr = ttarenaxstr(req->arena);
   if(mask & (TTMSKOUT | TTMSKALLHTTP | TTMSKALLWRITE)){
     int len = sprintf(line, "Forbidden\n");
     tcxstrprintf(xstr, "HTTP/1.1 403 Forbidden\r\n");
@@ -2960,7 +5616,7 @@ static void do_http_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, cons
     tcxstrcat(xstr, line, len);
     ttservlog(g_serv, TTLOGINFO, "do_http_delete: forbidden");
   } else {
-    if(tculogadbout(ulog, sid, adb, kbuf, ksiz)){
+    if(recout(arg, kbuf, ksiz)){
       int len = sprintf(line, "OK\n");
       tcxstrprintf(xstr, "HTTP/1.1 200 OK\r\n");
       tcxstrprintf(xstr, "Content-Type: text/plain\r\n");
@@ -2981,8 +5637,6 @@ static void do_http_delete(TTSOCK *sock, TASKARG *arg, TTREQ *req, int ver, cons
   } else {
     ttservlog(g_serv, TTLOGINFO, "do_http_delete: response failed");
   }
-  pthread_cleanup_pop(1);
-  pthread_cleanup_pop(1);
 }
 
 
@@ -25,6 +25,40 @@ typedef struct {                         // type of structure for read thread
   int rnum;
 } TARGREAD;
 
+typedef struct {                         // type of structure for replication timer
+  char host[TTADDRBUFSIZ];               // laid out as the replication argument of the server
+  int port;
+  char rtspath[TTADDRBUFSIZ];
+  uint64_t rts;
+  TCADB *adb;
+  TCULOG *ulog;
+  uint32_t sid;
+  bool fail;
+  bool recon;
+  bool delay;
+  bool started;
+  bool exit;
+} TARGREPL;
+
+typedef struct {                         // type of structure for timer test
+  TARGREPL repl;
+  TTSERV *serv;
+  pthread_mutex_t mtx;
+  int *order;
+  int onum;
+  int rcnt;
+  int before;
+  int stopped;
+  int after;
+  bool mok;
+  bool dok;
+} TARGTIMER;
+
+typedef struct {                         // type of structure for one-shot timer
+  TARGTIMER *ttarg;
+  int id;
+} TARGONCE;
+
 
 /* global variables */
 const char *g_progname;                  // program name
@@ -38,9 +72,21 @@ static void eprint(TCULOG *ulog, const char *func);
 static int runwrite(int argc, char **argv);
 static int runread(int argc, char **argv);
 static int runthread(int argc, char **argv);
+static int runtimer(int argc, char **argv);
 static int procwrite(const char *base, int rnum, int64_t limsiz, bool as);
 static int procread(const char *base, uint64_t ts, bool pm);
 static int procthread(const char *base, int tnum, int rnum, int64_t limsiz, bool as);
+static int proctimer(const char *path, int rnum);
+static void dotimerlog(int level, const char *msg, void *opq);
+static void dotimeronce(void *opq);
+static void dotimerrepl(void *opq);
+static void dotimerstart(void *opq);
+static void dotimerstop(void *opq);
+static void dotimerkill(void *opq);
+bool ttservmodifytimedhandler(const char *host, int port, const char *rtspath, TTSERV *serv,
+                              void (*do_timed)(void *));
+bool ttservdeltimedhandler(const char *host, int port, const char *rtspath, TTSERV *serv,
+                           void (*do_timed)(void *));
 
 
 /* main routine */
@@ -55,6 +101,8 @@ int main(int argc, char **argv){
     rv = runread(argc, argv);
   } else if(!strcmp(argv[1], "thread")){
     rv = runthread(argc, argv);
+  } else if(!strcmp(argv[1], "timer")){
+    rv = runtimer(argc, argv);
   } else {
     usage();
   }
@@ -70,6 +118,7 @@ static void usage(void){
   fprintf(stderr, "  %s write [-lim num] [-as] base rnum\n", g_progname);
   fprintf(stderr, "  %s read [-ts num] [-pm] base\n", g_progname);
   fprintf(stderr, "  %s thread [-lim num] [-as] base tnum rnum\n", g_progname);
+  fprintf(stderr, "  %s timer path rnum\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
 }
@@ -186,6 +235,29 @@ static int runthread(int argc, char **argv){
 }
 
 
+/* parse arguments of timer command */
+static int runtimer(int argc, char **argv){
+  char *path = NULL;
+  char *rstr = NULL;
+  for(int i = 2; i < argc; i++){
+    if(!path && argv[i][0] == '-'){
+      usage();
+    } else if(!path){
+      path = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!path || !rstr) usage();
+  int rnum = tcatoi(rstr);
+  if(rnum < 1) usage();
+  int rv = proctimer(path, rnum);
+  return rv;
+}
+
+
 /* perform write command */
 static int procwrite(const char *base, int rnum, int64_t limsiz, bool as){
   iprintf("<Writing Test>\n  base=%s  rnum=%d  limsiz=%lld  as=%d\n\n",
@@ -368,4 +440,120 @@ static int procthread(const char *base, int tnum, int rnum, int64_t limsiz, bool
 
 
 
+/* perform timer command */
+static int proctimer(const char *path, int rnum){
+  iprintf("<Timer Test>\n  path=%s  rnum=%d\n\n", path, rnum);
+  bool err = false;
+  double stime = tctime();
+  TARGTIMER ttarg;
+  memset(&ttarg, 0, sizeof(ttarg));
+  ttarg.serv = ttservnew();
+  if(pthread_mutex_init(&ttarg.mtx, NULL) != 0){
+    eprint(NULL, "pthread_mutex_init");
+    err = true;
+  }
+  ttarg.order = tcmalloc(sizeof(*ttarg.order) * rnum);
+  TARGONCE *oargs = tcmalloc(sizeof(*oargs) * rnum);
+  ttservsetloghandler(ttarg.serv, dotimerlog, NULL);
+  if(!ttservconf(ttarg.serv, path, 0)){
+    eprint(NULL, "ttservconf");
+    err = true;
+  }
+  for(int i = 0; i < rnum; i++){
+    oargs[i].ttarg = &ttarg;
+    oargs[i].id = i;
+    ttservaddtimer(ttarg.serv, 0.02 * (rnum - i), 0.0, dotimeronce, oargs + i);
+  }
+  ttservaddtimedhandler_delay(ttarg.serv, 0.05, dotimerrepl, &ttarg);
+  double base = 0.02 * rnum + 0.2;
+  ttservaddtimer(ttarg.serv, base, 0.0, dotimerstart, &ttarg);
+  ttservaddtimer(ttarg.serv, base + 0.5, 0.0, dotimerstop, &ttarg);
+  ttservaddtimer(ttarg.serv, base + 1.0, 0.0, dotimerkill, &ttarg);
+  if(!err && !ttservstart(ttarg.serv)){
+    eprint(NULL, "ttservstart");
+    err = true;
+  }
+  if(!err){
+    if(ttarg.onum != rnum){
+      eprint(NULL, "one-shot timers");
+      err = true;
+    }
+    for(int i = 0; i < ttarg.onum; i++){
+      if(ttarg.order[i] != rnum - i - 1){
+        eprint(NULL, "order of timers");
+        err = true;
+        break;
+      }
+    }
+    if(ttarg.before != 0 || !ttarg.mok || ttarg.stopped < 1){
+      eprint(NULL, "ttservmodifytimedhandler");
+      err = true;
+    }
+    if(!ttarg.dok || ttarg.after > ttarg.stopped + 1){
+      eprint(NULL, "ttservdeltimedhandler");
+      err = true;
+    }
+    iprintf("fired: %d  stopped: %d  after: %d\n", ttarg.onum, ttarg.stopped, ttarg.after);
+  }
+  ttservdel(ttarg.serv);
+  tcfree(oargs);
+  tcfree(ttarg.order);
+  pthread_mutex_destroy(&ttarg.mtx);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* print error messages of the server of timer command */
+static void dotimerlog(int level, const char *msg, void *opq){
+  if(level == TTLOGERROR || level == TTLOGSYSTEM) fprintf(stderr, "%s: %s\n", g_progname, msg);
+}
+
+
+/* record the order of a one-shot timer */
+static void dotimeronce(void *opq){
+  TARGONCE *oarg = opq;
+  TARGTIMER *ttarg = oarg->ttarg;
+  if(pthread_mutex_lock(&ttarg->mtx) != 0) return;
+  ttarg->order[ttarg->onum++] = oarg->id;
+  pthread_mutex_unlock(&ttarg->mtx);
+}
+
+
+/* count calls of the replication timer */
+static void dotimerrepl(void *opq){
+  TARGTIMER *ttarg = opq;
+  if(ttarg->repl.exit) return;
+  __atomic_add_fetch(&ttarg->rcnt, 1, __ATOMIC_SEQ_CST);
+}
+
+
+/* start the replication timer */
+static void dotimerstart(void *opq){
+  TARGTIMER *ttarg = opq;
+  ttarg->before = __atomic_load_n(&ttarg->rcnt, __ATOMIC_SEQ_CST);
+  ttarg->mok = ttservmodifytimedhandler("localhost", 1978, "ttultest.rts", ttarg->serv,
+                                        dotimerrepl);
+}
+
+
+/* stop the replication timer */
+static void dotimerstop(void *opq){
+  TARGTIMER *ttarg = opq;
+  ttarg->dok = ttservdeltimedhandler("localhost", 1978, "ttultest.rts", ttarg->serv,
+                                     dotimerrepl);
+  ttarg->stopped = __atomic_load_n(&ttarg->rcnt, __ATOMIC_SEQ_CST);
+}
+
+
+/* terminate the server of timer command */
+static void dotimerkill(void *opq){
+  TARGTIMER *ttarg = opq;
+  ttarg->after = __atomic_load_n(&ttarg->rcnt, __ATOMIC_SEQ_CST);
+  ttservkill(ttarg->serv);
+}
+
+
+
 // END OF FILE
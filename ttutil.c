@@ -17,6 +17,7 @@
 #include "ttutil.h"
 #include "myconf.h"
 #include <tculog.h>
+#include "ttpriv.h"
 
 
 
@@ -31,8 +32,72 @@
 #define SOCKCNCTTIMEO  5.0               // timeout of the connect call of socket
 #define SOCKLINEBUFSIZ 4096              // size of a line buffer of socket
 #define SOCKLINEMAXSIZ (16*1024*1024)    // maximum size of a line of socket
+#define SOCKIOVUNIT    16                // unit number of regions of a vectored send
+#define SOCKTOKENUNIT  256               // unit number of tokens of a line of socket
+#define SOCKIOVMAX     1024              // maximum number of regions of a writev call
 #define HTTPBODYMAXSIZ (256*1024*1024)   // maximum size of the entity body of HTTP
 #define TRILLIONNUM    1000000000000     // trillion number
+#define SHMMAGIC       0x54545348        // magic number of a shared memory segment
+#define SHMPREFIX      "/ttshm-"         // prefix of the name of a shared memory segment
+#define SHMRINGSIZ     (256*1024)        // size of the data region of each ring
+#define SHMSPINNUM     4096              // number of spins before sleeping on a ring
+#define SHMWAITMAX     1.0               // maximum seconds of a sleep on a ring
+#define ARENACHUNKSIZ  (256*1024)        // size of a chunk of small regions of an arena
+#define ARENACHUNKKEEP 4                 // number of chunks retained by an arena
+#define ARENASMALLMAX  (32*1024)         // maximum size of a small region of an arena
+#define ARENACLASSMIN  16                // bit width of the smallest size class of an arena
+#define ARENACLASSNUM  10                // number of size classes of large regions of an arena
+#define ARENAKEEPSIZ   (8*1024*1024)     // maximum size of free blocks retained by an arena
+#define ARENAXSTRMAX   (1024*1024)       // maximum size of a string object retained by an arena
+#define ARENAHEADSIZ   32                // size of the header of a block of an arena
+#define ARENAALIGN     16                // alignment of a region of an arena
+#define BLOOMDEFNUM    (1024*1024)       // default expected number of keys of a Bloom filter
+#define BLOOMKEYBITS   10                // number of bits for each key of a Bloom filter
+#define BLOOMBLKWORDS  8                 // number of words of a block of a Bloom filter
+#define BLOOMHASHNUM   7                 // number of bits set for each key of a Bloom filter
+#define BLOOMALIGN     64                // alignment of the blocks of a Bloom filter
+#define CACHESHARDNUM  64                // number of shards of a record cache
+#define CACHERECOVH    64                // overhead size of each record of a record cache
+#define CACHERECDIV    8                 // divisor of the shard size for the largest record
+
+typedef struct {                         // type of structure for a ring of shared memory
+  uint32_t head;                         // reading position
+  uint32_t rwait;                        // whether the reader is sleeping
+  char hpad[56];                         // padding to separate the reader and the writer
+  uint32_t tail;                         // writing position
+  uint32_t wwait;                        // whether the writer is sleeping
+  char tpad[56];                         // padding to separate the rings
+} TTSHMRING;
+
+typedef struct {                         // type of structure for the header of shared memory
+  uint32_t magic;                        // magic number
+  uint32_t rsiz;                         // size of the data region of each ring
+  uint32_t closed[2];                    // closed flags of the client and the server
+  char pad[48];                          // padding to separate the rings
+  TTSHMRING rings[2];                    // rings of requests and responses
+} TTSHMHEAD;
+
+typedef struct _TTARENABLK {             // type of structure for a block of an arena
+  struct _TTARENABLK *next;              // next block in the same list
+  size_t size;                           // size of the data region
+  int cls;                               // size class or -1 for an unclassified block
+} TTARENABLK;
+
+typedef struct _TTCACHEREC {             // type of structure for a record of a record cache
+  struct _TTCACHEREC *prev;              // previous record on the clock
+  struct _TTCACHEREC *next;              // next record on the clock
+  int ksiz;                              // size of the key
+  int vsiz;                              // size of the value
+  bool ref;                              // whether the record has been referred to
+} TTCACHEREC;
+
+typedef struct {                         // type of structure for a shard of a record cache
+  pthread_mutex_t mtx;                   // mutex for the shard
+  TCMAP *recs;                           // map of the keys and the records
+  TTCACHEREC *hand;                      // hand of the clock
+  uint64_t size;                         // total size of the records
+  uint64_t gen;                          // generation counted up by invalidation
+} TTCACHESHARD;
 
 typedef struct {                         // type of structure of master synchronous object
   char host[TTADDRBUFSIZ];
@@ -49,6 +114,18 @@ typedef struct {                         // type of structure of master synchron
   bool exit;
 } REPLARG;
 
+
+/* private function prototypes */
+static bool ttsockwritev(TTSOCK *sock, struct iovec *iov, int iovcnt);
+static int ttsockreadline(TTSOCK *sock);
+static int ttshmread(TTSHM *shm, char *buf, int size, double dl);
+static bool ttshmwrite(TTSHM *shm, const char *buf, int size, double dl);
+static int ttshmwaitword(TTSHM *shm, uint32_t *word, uint32_t val, uint32_t *flag, double dl);
+static bool ttshmalive(TTSHM *shm);
+static uint64_t ttkeyhash(const void *kbuf, int ksiz);
+static void ttcacheunlink(TTCACHESHARD *shard, TTCACHEREC *rec);
+
+
 /* String containing the version information. */
 const char *ttversion = _TT_VERSION;
 
@@ -171,6 +248,13 @@ int ttopensockunix(const char *path){
 
 /* Open a server socket of TCP/IP stream to clients. */
 int ttopenservsock(const char *addr, int port){
+  assert(port >= 0);
+  return ttopenservsock2(addr, port, false);
+}
+
+
+/* Open a server socket of TCP/IP stream to clients, which can be shared by other sockets. */
+int ttopenservsock2(const char *addr, int port, bool share){
   assert(port >= 0);
   struct sockaddr_in sain;
   memset(&sain, 0, sizeof(sain));
@@ -185,6 +269,17 @@ int ttopenservsock(const char *addr, int port){
     close(fd);
     return -1;
   }
+  if(share){
+#if defined(SO_REUSEPORT)
+    if(setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (char *)&optint, sizeof(optint)) != 0){
+      close(fd);
+      return -1;
+    }
+#else
+    close(fd);
+    return -1;
+#endif
+  }
   if(bind(fd, (struct sockaddr *)&sain, sizeof(sain)) != 0 ||
      listen(fd, SOMAXCONN) != 0){
     close(fd);
@@ -283,10 +378,20 @@ TTSOCK *ttsocknew(int fd){
   assert(fd >= 0);
   TTSOCK *sock = tcmalloc(sizeof(*sock));
   sock->fd = fd;
+  sock->bp = sock->buf;
   sock->rp = sock->buf;
   sock->ep = sock->buf;
   sock->end = false;
   sock->dl = HUGE_VAL;
+  sock->obuf = NULL;
+  sock->osiz = 0;
+  sock->coal = false;
+  sock->lbuf = NULL;
+  sock->lbsiz = 0;
+  sock->tokens = NULL;
+  sock->tanum = 0;
+  sock->shm = NULL;
+  sock->zbuf = NULL;
   return sock;
 }
 
@@ -294,6 +399,11 @@ TTSOCK *ttsocknew(int fd){
 /* Delete a socket object. */
 void ttsockdel(TTSOCK *sock){
   assert(sock);
+  if(sock->shm) ttshmdel(sock->shm);
+  tcfree(sock->zbuf);
+  tcfree(sock->tokens);
+  tcfree(sock->lbuf);
+  tcfree(sock->obuf);
   tcfree(sock);
 }
 
@@ -305,9 +415,155 @@ void ttsocksetlife(TTSOCK *sock, double lifetime){
 }
 
 
+/* Set the output coalescing mode of a socket object. */
+void ttsocksetcoalesce(TTSOCK *sock, bool coal){
+  assert(sock);
+  if(coal && !sock->obuf) sock->obuf = tcmalloc(TTIOBUFSIZ);
+  sock->coal = coal;
+}
+
+
+/* Bind a socket object to a shared memory transport. */
+void ttsocksetshm(TTSOCK *sock, TTSHM *shm){
+  assert(sock && shm);
+  if(sock->shm) ttshmdel(sock->shm);
+  sock->shm = shm;
+}
+
+
+/* Create a shared memory transport as a server. */
+TTSHM *ttshmnew(int fd){
+  assert(fd >= 0);
+#if defined(TTUSEFUTEX)
+  static uint32_t seq = 0;
+  char name[TTADDRBUFSIZ];
+  snprintf(name, sizeof(name), "%s%d-%u-%x", SHMPREFIX, (int)getpid(),
+           __atomic_add_fetch(&seq, 1, __ATOMIC_RELAXED), (unsigned int)(tctime() * 1000000));
+  int sfd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 00600);
+  if(sfd == -1) return NULL;
+  size_t msiz = sizeof(TTSHMHEAD) + SHMRINGSIZ * 2;
+  if(ftruncate(sfd, msiz) != 0){
+    close(sfd);
+    shm_unlink(name);
+    return NULL;
+  }
+  void *map = mmap(NULL, msiz, PROT_READ | PROT_WRITE, MAP_SHARED, sfd, 0);
+  close(sfd);
+  if(map == MAP_FAILED){
+    shm_unlink(name);
+    return NULL;
+  }
+  TTSHMHEAD *head = map;
+  head->rsiz = SHMRINGSIZ;
+  __atomic_store_n(&head->magic, SHMMAGIC, __ATOMIC_RELEASE);
+  TTSHM *shm = tcmalloc(sizeof(*shm));
+  snprintf(shm->name, sizeof(shm->name), "%s", name);
+  shm->map = map;
+  shm->msiz = msiz;
+  shm->irng = head->rings + 0;
+  shm->orng = head->rings + 1;
+  shm->ibuf = (char *)map + sizeof(*head);
+  shm->obuf = shm->ibuf + SHMRINGSIZ;
+  shm->rsiz = SHMRINGSIZ;
+  shm->side = 1;
+  shm->fd = fd;
+  return shm;
+#else
+  errno = ENOTSUP;
+  return NULL;
+#endif
+}
+
+
+/* Attach to a shared memory transport as a client. */
+TTSHM *ttshmopen(int fd, const char *name){
+  assert(fd >= 0 && name);
+#if defined(TTUSEFUTEX)
+  int plen = sizeof(SHMPREFIX) - 1;
+  if(strncmp(name, SHMPREFIX, plen) || strchr(name + plen, '/') ||
+     strlen(name) >= TTADDRBUFSIZ) return NULL;
+  int sfd = shm_open(name, O_RDWR, 0);
+  if(sfd == -1) return NULL;
+  shm_unlink(name);
+  struct stat sbuf;
+  if(fstat(sfd, &sbuf) != 0 || sbuf.st_size != sizeof(TTSHMHEAD) + SHMRINGSIZ * 2){
+    close(sfd);
+    return NULL;
+  }
+  size_t msiz = sbuf.st_size;
+  void *map = mmap(NULL, msiz, PROT_READ | PROT_WRITE, MAP_SHARED, sfd, 0);
+  close(sfd);
+  if(map == MAP_FAILED) return NULL;
+  TTSHMHEAD *head = map;
+  if(__atomic_load_n(&head->magic, __ATOMIC_ACQUIRE) != SHMMAGIC || head->rsiz != SHMRINGSIZ){
+    munmap(map, msiz);
+    return NULL;
+  }
+  TTSHM *shm = tcmalloc(sizeof(*shm));
+  shm->name[0] = '\0';
+  shm->map = map;
+  shm->msiz = msiz;
+  shm->orng = head->rings + 0;
+  shm->irng = head->rings + 1;
+  shm->obuf = (char *)map + sizeof(*head);
+  shm->ibuf = shm->obuf + SHMRINGSIZ;
+  shm->rsiz = SHMRINGSIZ;
+  shm->side = 0;
+  shm->fd = fd;
+  return shm;
+#else
+  errno = ENOTSUP;
+  return NULL;
+#endif
+}
+
+
+/* Delete a shared memory transport object. */
+void ttshmdel(TTSHM *shm){
+  assert(shm);
+#if defined(TTUSEFUTEX)
+  TTSHMHEAD *head = shm->map;
+  TTSHMRING *irng = shm->irng;
+  TTSHMRING *orng = shm->orng;
+  __atomic_store_n(head->closed + shm->side, 1, __ATOMIC_SEQ_CST);
+  syscall(SYS_futex, &orng->tail, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+  syscall(SYS_futex, &irng->head, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+  munmap(shm->map, shm->msiz);
+  if(shm->name[0] != '\0') shm_unlink(shm->name);
+#endif
+  tcfree(shm);
+}
+
+
+/* Wait for input of a shared memory transport. */
+int ttshmwait(TTSHM *shm, int ms){
+  assert(shm && ms >= 0);
+  TTSHMRING *ring = shm->irng;
+  uint32_t head = ring->head;
+  return ttshmwaitword(shm, &ring->tail, head, &ring->rwait, tctime() + ms / 1000.0);
+}
+
+
 /* Send data by a socket. */
 bool ttsocksend(TTSOCK *sock, const void *buf, int size){
   assert(sock && buf && size >= 0);
+  if(sock->coal){
+    if(sock->ep > sock->rp && sock->osiz + size <= TTIOBUFSIZ){
+      memcpy(sock->obuf + sock->osiz, buf, size);
+      sock->osiz += size;
+      return true;
+    }
+    if(sock->osiz > 0){
+      struct iovec iov[2];
+      iov[0].iov_base = sock->obuf;
+      iov[0].iov_len = sock->osiz;
+      iov[1].iov_base = (void *)buf;
+      iov[1].iov_len = size;
+      sock->osiz = 0;
+      return ttsockwritev(sock, iov, 2);
+    }
+  }
+  if(sock->shm) return ttshmwrite(sock->shm, buf, size, sock->dl);
   const char *rp = buf;
   do {
     int ocs = PTHREAD_CANCEL_DISABLE;
@@ -331,6 +587,52 @@ bool ttsocksend(TTSOCK *sock, const void *buf, int size){
 }
 
 
+/* Send vectored data by a socket. */
+bool ttsocksendv(TTSOCK *sock, const struct iovec *iov, int iovcnt){
+  assert(sock && iov && iovcnt >= 0);
+  if(sock->coal && sock->ep > sock->rp){
+    size_t size = 0;
+    for(int i = 0; i < iovcnt; i++){
+      size += iov[i].iov_len;
+    }
+    if(sock->osiz + size <= TTIOBUFSIZ){
+      for(int i = 0; i < iovcnt; i++){
+        memcpy(sock->obuf + sock->osiz, iov[i].iov_base, iov[i].iov_len);
+        sock->osiz += iov[i].iov_len;
+      }
+      return true;
+    }
+  }
+  bool err = false;
+  int onum = (sock->coal && sock->osiz > 0) ? 1 : 0;
+  struct iovec stack[SOCKIOVUNIT];
+  struct iovec *vec = (iovcnt + onum <= SOCKIOVUNIT) ? stack :
+    tcmalloc(sizeof(*vec) * (iovcnt + onum));
+  pthread_cleanup_push(free, (vec == stack) ? NULL : vec);
+  if(onum > 0){
+    vec[0].iov_base = sock->obuf;
+    vec[0].iov_len = sock->osiz;
+    sock->osiz = 0;
+  }
+  memcpy(vec + onum, iov, sizeof(*iov) * iovcnt);
+  if(!ttsockwritev(sock, vec, iovcnt + onum)) err = true;
+  pthread_cleanup_pop(1);
+  return !err;
+}
+
+
+/* Write the coalesced output of a socket. */
+bool ttsockflush(TTSOCK *sock){
+  assert(sock);
+  if(sock->osiz < 1) return true;
+  struct iovec iov[1];
+  iov[0].iov_base = sock->obuf;
+  iov[0].iov_len = sock->osiz;
+  sock->osiz = 0;
+  return ttsockwritev(sock, iov, 1);
+}
+
+
 /* Send formatted data by a socket. */
 bool ttsockprintf(TTSOCK *sock, const char *format, ...){
   assert(sock && format);
@@ -447,6 +749,40 @@ bool ttsockrecv(TTSOCK *sock, char *buf, int size){
   }
   bool err = false;
   char *wp = buf;
+  int rsiz = sock->ep - sock->rp;
+  memcpy(wp, sock->rp, rsiz);
+  wp += rsiz;
+  size -= rsiz;
+  sock->rp = sock->ep;
+  if(size >= TTIOBUFSIZ){
+    if(sock->osiz > 0 && !ttsockflush(sock)){
+      sock->end = true;
+      return false;
+    }
+    sock->bp = sock->buf;
+    sock->rp = sock->buf;
+    sock->ep = sock->buf;
+    while(size > 0){
+      int ocs = PTHREAD_CANCEL_DISABLE;
+      pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &ocs);
+      int rv = sock->shm ? ttshmread(sock->shm, wp, size, sock->dl) :
+        recv(sock->fd, wp, size, MSG_WAITALL);
+      pthread_setcancelstate(ocs, NULL);
+      if(rv > 0){
+        wp += rv;
+        size -= rv;
+      } else if(rv == 0){
+        err = true;
+        break;
+      } else if((errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) ||
+                tctime() > sock->dl){
+        err = true;
+        break;
+      }
+    }
+    if(err) sock->end = true;
+    return !err;
+  }
   while(size > 0){
     int c = ttsockgetc(sock);
     if(c == -1){
@@ -455,6 +791,12 @@ bool ttsockrecv(TTSOCK *sock, char *buf, int size){
     }
     *(wp++) = c;
     size--;
+    rsiz = sock->ep - sock->rp;
+    if(rsiz > size) rsiz = size;
+    memcpy(wp, sock->rp, rsiz);
+    sock->rp += rsiz;
+    wp += rsiz;
+    size -= rsiz;
   }
   return !err;
 }
@@ -464,12 +806,18 @@ bool ttsockrecv(TTSOCK *sock, char *buf, int size){
 int ttsockgetc(TTSOCK *sock){
   assert(sock);
   if(sock->rp < sock->ep) return *(unsigned char *)(sock->rp++);
+  if(sock->osiz > 0 && !ttsockflush(sock)){
+    sock->end = true;
+    return -1;
+  }
   do {
     int ocs = PTHREAD_CANCEL_DISABLE;
     pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &ocs);
-    int rv = recv(sock->fd, sock->buf, TTIOBUFSIZ, 0);
+    int rv = sock->shm ? ttshmread(sock->shm, sock->buf, TTIOBUFSIZ, sock->dl) :
+      recv(sock->fd, sock->buf, TTIOBUFSIZ, 0);
     pthread_setcancelstate(ocs, NULL);
     if(rv > 0){
+      sock->bp = sock->buf;
       sock->rp = sock->buf + 1;
       sock->ep = sock->buf + rv;
       return *(unsigned char *)sock->buf;
@@ -486,7 +834,7 @@ int ttsockgetc(TTSOCK *sock){
 /* Push a character back to a socket. */
 void ttsockungetc(TTSOCK *sock, int c){
   assert(sock);
-  if(sock->rp <= sock->buf) return;
+  if(sock->rp <= sock->bp) return;
   sock->rp--;
   *(unsigned char *)sock->rp = c;
 }
@@ -499,15 +847,30 @@ bool ttsockgets(TTSOCK *sock, char *buf, int size){
   size--;
   char *wp = buf;
   while(size > 0){
-    int c = ttsockgetc(sock);
-    if(c == '\n') break;
-    if(c == -1){
-      err = true;
-      break;
+    if(sock->rp >= sock->ep){
+      if(ttsockgetc(sock) == -1){
+        err = true;
+        break;
+      }
+      sock->rp--;
+    }
+    char *nl = memchr(sock->rp, '\n', sock->ep - sock->rp);
+    const char *rp = sock->rp;
+    const char *ep = nl ? nl : sock->ep;
+    while(rp < ep && size > 0){
+      if(*rp != '\r'){
+        *(wp++) = *rp;
+        size--;
+      }
+      rp++;
+    }
+    while(rp < ep && *rp == '\r'){
+      rp++;
     }
-    if(c != '\r'){
-      *(wp++) = c;
-      size--;
+    sock->rp = (char *)rp;
+    if(nl && rp == nl){
+      sock->rp++;
+      break;
     }
   }
   *wp = '\0';
@@ -518,29 +881,85 @@ bool ttsockgets(TTSOCK *sock, char *buf, int size){
 /* Receive one line by a socket into allocated buffer. */
 char *ttsockgets2(TTSOCK *sock){
   assert(sock);
-  bool err = false;
-  TCXSTR *xstr = tcxstrnew3(SOCKLINEBUFSIZ);
-  pthread_cleanup_push((void (*)(void *))tcxstrdel, xstr);
-  int size = 0;
-  while(true){
-    int c = ttsockgetc(sock);
-    if(c == '\n') break;
-    if(c == -1){
-      err = true;
-      break;
+  int lsiz = ttsockreadline(sock);
+  if(lsiz < 0) return NULL;
+  return tcmemdup(sock->lbuf, lsiz);
+}
+
+
+/* Receive one line by a socket and split it into tokens. */
+char **ttsockgettokens(TTSOCK *sock, int *np){
+  assert(sock && np);
+  int lsiz = ttsockreadline(sock);
+  if(lsiz < 0) return NULL;
+  if(!sock->tokens){
+    sock->tanum = SOCKTOKENUNIT;
+    sock->tokens = tcmalloc(sizeof(*sock->tokens) * sock->tanum);
+  }
+  int tnum = 0;
+  char *str = sock->lbuf;
+  char *ep = str + lsiz;
+  while(str < ep){
+    while(str < ep && (*str == ' ' || *str == '\t')){
+      *(str++) = '\0';
     }
-    if(c != '\r'){
-      unsigned char b = c;
-      tcxstrcat(xstr, &b, sizeof(b));
-      size++;
-      if(size >= SOCKLINEMAXSIZ){
-        err = true;
-        break;
-      }
+    if(str >= ep) break;
+    if(tnum >= sock->tanum){
+      sock->tanum *= 2;
+      sock->tokens = tcrealloc(sock->tokens, sizeof(*sock->tokens) * sock->tanum);
+    }
+    sock->tokens[tnum++] = str;
+    while(str < ep && *str != ' ' && *str != '\t'){
+      str++;
     }
   }
-  pthread_cleanup_pop(0);
-  return tcxstrtomalloc(xstr);
+  *np = tnum;
+  return sock->tokens;
+}
+
+
+/* Expand a compressed frame at the head of the input of a socket. */
+bool ttsockexpand(TTSOCK *sock){
+  assert(sock);
+  int c = ttsockgetc(sock);
+  if(c == -1) return false;
+  if(c != TTCODECOMP){
+    ttsockungetc(sock, c);
+    return true;
+  }
+  int codec = ttsockgetc(sock);
+  int rsiz = ttsockgetint32(sock);
+  int zsiz = ttsockgetint32(sock);
+  if(ttsockcheckend(sock) || rsiz < 0 || rsiz > INT_MAX - TTIOBUFSIZ - 1 || zsiz < 0){
+    sock->end = true;
+    return false;
+  }
+  char stack[TTIOBUFSIZ];
+  char *zbuf = (zsiz < TTIOBUFSIZ) ? stack : tcmalloc(zsiz);
+  bool err = false;
+  int xsiz;
+  char *xbuf = NULL;
+  if(ttsockrecv(sock, zbuf, zsiz)){
+    xbuf = ttdecompress(codec, zbuf, zsiz, &xsiz);
+    if(!xbuf || xsiz != rsiz) err = true;
+  } else {
+    err = true;
+  }
+  if(zbuf != stack) tcfree(zbuf);
+  if(err){
+    tcfree(xbuf);
+    sock->end = true;
+    return false;
+  }
+  int lsiz = sock->ep - sock->rp;
+  xbuf = tcrealloc(xbuf, xsiz + lsiz + 1);
+  memcpy(xbuf + xsiz, sock->rp, lsiz);
+  tcfree(sock->zbuf);
+  sock->zbuf = xbuf;
+  sock->bp = xbuf;
+  sock->rp = xbuf;
+  sock->ep = xbuf + xsiz + lsiz;
+  return true;
 }
 
 
@@ -577,6 +996,32 @@ int ttsockcheckpfsiz(TTSOCK *sock){
 }
 
 
+/* Get the prefetched data in a socket without consuming it. */
+const char *ttsockpeek(TTSOCK *sock, int *sp){
+  assert(sock && sp);
+  *sp = sock->end ? 0 : sock->ep - sock->rp;
+  return sock->rp;
+}
+
+
+/* Skip data received by a socket. */
+bool ttsockskip(TTSOCK *sock, int size){
+  assert(sock && size >= 0);
+  if(sock->rp + size <= sock->ep){
+    sock->rp += size;
+    return true;
+  }
+  while(size > 0){
+    if(ttsockgetc(sock) == -1) return false;
+    size--;
+    int step = tclmin(sock->ep - sock->rp, size);
+    sock->rp += step;
+    size -= step;
+  }
+  return true;
+}
+
+
 /* Fetch the resource of a URL by HTTP. */
 int tthttpfetch(const char *url, TCMAP *reqheads, TCMAP *resheads, TCXSTR *resbody){
   assert(url);
@@ -800,258 +1245,2291 @@ double ttunpackdouble(const char *buf){
 }
 
 
-
-/*************************************************************************************************
- * server utilities
- *************************************************************************************************/
-
-
-#define TTADDRBUFSIZ   1024              // size of an address buffer
-#define TTDEFTHNUM     5                 // default number of threads
-#define TTEVENTMAX     256               // maximum number of events
-#define TTWAITREQUEST  200               // waiting milliseconds for requests
-#define TTWAITWORKER   100               // waiting milliseconds for finish of workers
+/* Compress a serial object. */
+char *ttcompress(int codec, const char *ptr, int size, int *sp){
+  assert(ptr && size >= 0 && sp);
+  switch(codec){
+  case TTZDEFLATE: return tcdeflate(ptr, size, sp);
+  case TTZBZIP: return tcbzipencode(ptr, size, sp);
+  }
+  return NULL;
+}
 
 
-/* private function prototypes */
-static void *ttservtimer(void *argp);
-static void ttservtask(TTSOCK *sock, TTREQ *req);
-static void *ttservdeqtasks(void *argp);
+/* Decompress a serial object compressed by `ttcompress'. */
+char *ttdecompress(int codec, const char *ptr, int size, int *sp){
+  assert(ptr && size >= 0 && sp);
+  switch(codec){
+  case TTZDEFLATE: return tcinflate(ptr, size, sp);
+  case TTZBZIP: return tcbzipdecode(ptr, size, sp);
+  }
+  return NULL;
+}
 
 
-/* Create a server object. */
-TTSERV *ttservnew(void){
-  TTSERV *serv = tcmalloc(sizeof(*serv));
-  serv->host[0] = '\0';
-  serv->addr[0] = '\0';
-  serv->port = 0;
-  serv->queue = tclistnew();
-  if(pthread_mutex_init(&serv->qmtx, NULL) != 0) tcmyfatal("pthread_mutex_init failed");
-  if(pthread_cond_init(&serv->qcnd, NULL) != 0) tcmyfatal("pthread_cond_init failed");
-  if(pthread_mutex_init(&serv->tmtx, NULL) != 0) tcmyfatal("pthread_mutex_init failed");
-  if(pthread_cond_init(&serv->tcnd, NULL) != 0) tcmyfatal("pthread_cond_init failed");
-  serv->thnum = TTDEFTHNUM;
-  serv->timeout = 0;
-  serv->term = false;
-  serv->do_log = NULL;
-  serv->opq_log = NULL;
-  serv->timernum = 0;
-  serv->do_task = NULL;
-  serv->opq_task = NULL;
-  return serv;
+/* Create a buffer arena object. */
+TTARENA *ttarenanew(void){
+  TTARENA *arena = tcmalloc(sizeof(*arena));
+  arena->chunks = NULL;
+  arena->cur = NULL;
+  arena->off = 0;
+  arena->used = NULL;
+  arena->frees = tcmalloc(sizeof(*arena->frees) * ARENACLASSNUM);
+  for(int i = 0; i < ARENACLASSNUM; i++){
+    arena->frees[i] = NULL;
+  }
+  arena->fsiz = 0;
+  arena->xstrs = NULL;
+  arena->xnum = 0;
+  arena->xused = 0;
+  arena->owns = NULL;
+  arena->onum = 0;
+  arena->oanum = 0;
+  return arena;
 }
 
 
-/* Delete a server object. */
-void ttservdel(TTSERV *serv){
-  assert(serv);
-  pthread_cond_destroy(&serv->tcnd);
-  pthread_mutex_destroy(&serv->tmtx);
-  pthread_cond_destroy(&serv->qcnd);
-  pthread_mutex_destroy(&serv->qmtx);
-  tclistdel(serv->queue);
-  tcfree(serv);
+/* Delete a buffer arena object. */
+void ttarenadel(TTARENA *arena){
+  assert(arena);
+  ttarenareset(arena);
+  TTARENABLK *blk = arena->chunks;
+  while(blk){
+    TTARENABLK *next = blk->next;
+    tcfree(blk);
+    blk = next;
+  }
+  for(int i = 0; i < ARENACLASSNUM; i++){
+    blk = arena->frees[i];
+    while(blk){
+      TTARENABLK *next = blk->next;
+      tcfree(blk);
+      blk = next;
+    }
+  }
+  for(int i = 0; i < arena->xnum; i++){
+    tcxstrdel(arena->xstrs[i]);
+  }
+  tcfree(arena->xstrs);
+  tcfree(arena->owns);
+  tcfree(arena->frees);
+  tcfree(arena);
 }
 
 
-/* Configure a server object. */
-bool ttservconf(TTSERV *serv, const char *host, int port){
-  assert(serv);
-  bool err = false;
-  if(port < 1){
-    if(!host || host[0] == '\0'){
-      err = true;
-      serv->addr[0] = '\0';
-      ttservlog(serv, TTLOGERROR, "invalid socket path");
+/* Allocate a region in a buffer arena object. */
+void *ttarenaalloc(TTARENA *arena, size_t size){
+  assert(arena);
+  if(size < 1) size = 1;
+  if(size <= ARENASMALLMAX){
+    size = (size + ARENAALIGN - 1) & ~(size_t)(ARENAALIGN - 1);
+    TTARENABLK *chunk = arena->cur;
+    if(!chunk || arena->off + size > chunk->size){
+      TTARENABLK *next = chunk ? chunk->next : arena->chunks;
+      if(!next){
+        next = tcmalloc(ARENACHUNKSIZ);
+        next->next = NULL;
+        next->size = ARENACHUNKSIZ;
+        next->cls = -1;
+        if(chunk){
+          chunk->next = next;
+        } else {
+          arena->chunks = next;
+        }
+      }
+      arena->cur = chunk = next;
+      arena->off = ARENAHEADSIZ;
     }
+    char *ptr = (char *)chunk + arena->off;
+    arena->off += size;
+    return ptr;
+  }
+  int cls = 0;
+  size_t bsiz = (size_t)1 << ARENACLASSMIN;
+  while(cls < ARENACLASSNUM && bsiz < size){
+    bsiz <<= 1;
+    cls++;
+  }
+  TTARENABLK *blk;
+  if(cls >= ARENACLASSNUM){
+    blk = tcmalloc(ARENAHEADSIZ + size);
+    blk->size = size;
+    blk->cls = -1;
+  } else if(arena->frees[cls]){
+    blk = arena->frees[cls];
+    arena->frees[cls] = blk->next;
+    arena->fsiz -= blk->size;
   } else {
-    if(host && !ttgethostaddr(host, serv->addr)){
-      err = true;
-      serv->addr[0] = '\0';
-      ttservlog(serv, TTLOGERROR, "ttgethostaddr failed");
-    }
+    blk = tcmalloc(ARENAHEADSIZ + bsiz);
+    blk->size = bsiz;
+    blk->cls = cls;
   }
-  snprintf(serv->host, sizeof(serv->host), "%s", host ? host : "");
-  serv->port = port;
-  return !err;
+  blk->next = arena->used;
+  arena->used = blk;
+  return (char *)blk + ARENAHEADSIZ;
 }
 
 
-/* Set tuning parameters of a server object. */
-void ttservtune(TTSERV *serv, int thnum, double timeout){
-  assert(serv && thnum > 0);
-  serv->thnum = thnum;
-  serv->timeout = timeout;
+/* Get a string object from the pool of a buffer arena object. */
+TCXSTR *ttarenaxstr(TTARENA *arena){
+  assert(arena);
+  if(arena->xused >= arena->xnum){
+    arena->xstrs = tcrealloc(arena->xstrs, sizeof(*arena->xstrs) * (arena->xnum + 1));
+    arena->xstrs[arena->xnum++] = tcxstrnew();
+  }
+  return arena->xstrs[arena->xused++];
 }
 
 
-/* Set the logging handler of a server object. */
-void ttservsetloghandler(TTSERV *serv, void (*do_log)(int, const char *, void *), void *opq){
-  assert(serv && do_log);
-  serv->do_log = do_log;
-  serv->opq_log = opq;
+/* Hand over a region allocated with `malloc' to a buffer arena object. */
+void ttarenaown(TTARENA *arena, void *ptr){
+  assert(arena);
+  if(!ptr) return;
+  if(arena->onum >= arena->oanum){
+    arena->oanum = arena->oanum * 2 + SOCKIOVUNIT;
+    arena->owns = tcrealloc(arena->owns, sizeof(*arena->owns) * arena->oanum);
+  }
+  arena->owns[arena->onum++] = ptr;
 }
-/* Add a timed handler to a server object. */
-bool ttservmodifytimedhandler( const char * host, int port, const char * rtspath,TTSERV * serv)
-{
-  assert(serv );
-    bool err=false;
-  for(int i = 0; i < serv->timernum; i++){
-    TTTIMER *timer = serv->timers + i;
-    if(!timer->started){
-        printf("timer %d not started,try to started\n",i);
-        timer->alive= false;
-        timer->serv = serv;
-        REPLARG * sarg;
-        sarg=(REPLARG *)timer->opq_timed;
-        snprintf(sarg->host, TTADDRBUFSIZ, "%s", host ? host : "");
-        sarg->port = port;
-        snprintf(sarg->rtspath, TTADDRBUFSIZ, "%s", rtspath? rtspath: "");
-        sarg->exit= false;
-        timer->alive = true;
-        timer->started=true;
-        if(pthread_create(&(timer->thid), NULL, ttservtimer, timer) == 0){
-          ttservlog(serv, TTLOGINFO, "timer thread %d started", i + 1);
-          printf("timer %d  started success!\n",i);
-          return true;
-        } else {
-          timer->alive = false;
-          timer->started= false;
-          printf("pthread_create (ttservtimer) failed\n");
-          ttservlog(serv, TTLOGERROR, "pthread_create (ttservtimer) failed");
-          err = true;
-          return false;
-        }
+
+
+/* Reset a buffer arena object. */
+void ttarenareset(TTARENA *arena){
+  assert(arena);
+  for(int i = 0; i < arena->onum; i++){
+    tcfree(arena->owns[i]);
+  }
+  arena->onum = 0;
+  for(int i = 0; i < arena->xused; i++){
+    if(tcxstrsize(arena->xstrs[i]) > ARENAXSTRMAX){
+      tcxstrdel(arena->xstrs[i]);
+      arena->xstrs[i] = tcxstrnew();
+    } else {
+      tcxstrclear(arena->xstrs[i]);
     }
   }
-}
-/* Add a timed handler to a server object. */
-bool ttservdeltimedhandler( const char * host, int port, const char * rtspath,TTSERV * serv)
-{
-  assert(serv);
-    bool err=false;
-    int cal=-99;
-    for(int i = 0; i < serv->timernum; i++){
-        TTTIMER *timer = serv->timers + i;
-        if(timer->started){
-            timer->alive= false;
-            timer->serv = serv;
-            REPLARG * sarg;
-            sarg=(REPLARG *)timer->opq_timed;
-            if(sarg->port!=port) continue;
-            if(strcmp(sarg->host,host)) continue;
-            if(strcmp(sarg->rtspath,rtspath)) continue;
-            printf("new started repl:[%s,%d,%s] found \n",sarg->host,sarg->port,sarg->rtspath);
-            //cal=pthread_cancel(timer->thid);
-            sarg->exit=true;
-            timer->alive = false;
-            timer->started= false;
-        }
+  arena->xused = 0;
+  TTARENABLK *blk = arena->used;
+  while(blk){
+    TTARENABLK *next = blk->next;
+    if(blk->cls >= 0 && arena->fsiz + blk->size <= ARENAKEEPSIZ){
+      blk->next = arena->frees[blk->cls];
+      arena->frees[blk->cls] = blk;
+      arena->fsiz += blk->size;
+    } else {
+      tcfree(blk);
+    }
+    blk = next;
+  }
+  arena->used = NULL;
+  arena->cur = NULL;
+  arena->off = 0;
+  blk = arena->chunks;
+  for(int i = 1; blk && i < ARENACHUNKKEEP; i++){
+    blk = blk->next;
+  }
+  if(blk){
+    TTARENABLK *rest = blk->next;
+    blk->next = NULL;
+    while(rest){
+      TTARENABLK *next = rest->next;
+      tcfree(rest);
+      rest = next;
     }
+  }
 }
 
-/* Add a timed handler to a server object. */
-void ttservaddtimedhandler(TTSERV *serv, double freq, void (*do_timed)(void *), void *opq){
-  assert(serv && freq >= 0.0 && do_timed);
-  if(serv->timernum >= TTTIMERMAX - 1) return;
-  TTTIMER *timer = serv->timers + serv->timernum;
-  timer->freq_timed = freq;
-  timer->do_timed = do_timed;
-  timer->opq_timed = opq;
-  timer->delay=false;
-  timer->started=false;
-  serv->timernum++;
+
+/* Create a Bloom filter object. */
+TTBLOOM *ttbloomnew(int64_t num){
+  if(num < 1) num = BLOOMDEFNUM;
+  TTBLOOM *bloom = tcmalloc(sizeof(*bloom));
+  uint64_t bbits = BLOOMBLKWORDS * sizeof(uint64_t) * 8;
+  bloom->bnum = ((uint64_t)num * BLOOMKEYBITS + bbits - 1) / bbits;
+  if(bloom->bnum < 1) bloom->bnum = 1;
+  size_t size = bloom->bnum * BLOOMBLKWORDS * sizeof(uint64_t);
+  void *blocks;
+  if(posix_memalign(&blocks, BLOOMALIGN, size) != 0) tcmyfatal("out of memory");
+  memset(blocks, 0, size);
+  bloom->blocks = blocks;
+  bloom->ready = false;
+  bloom->nnum = 0;
+  bloom->fnum = 0;
+  return bloom;
 }
 
-/* Add a timed handler to a server object. */
-void ttservaddtimedhandler_delay(TTSERV *serv, double freq, void (*do_timed)(void *), void *opq){
-  assert(serv && freq >= 0.0 && do_timed);
-  if(serv->timernum >= TTTIMERMAX - 1) return;
-  TTTIMER *timer = serv->timers + serv->timernum;
-  timer->freq_timed = freq;
-  timer->do_timed = do_timed;
-  timer->opq_timed = opq;
-  timer->delay=true;
-  timer->started=false;
-  serv->timernum++;
+
+/* Delete a Bloom filter object. */
+void ttbloomdel(TTBLOOM *bloom){
+  assert(bloom);
+  free(bloom->blocks);
+  tcfree(bloom);
 }
 
-/* Set the response handler of a server object. */
-void ttservsettaskhandler(TTSERV *serv, void (*do_task)(TTSOCK *, void *, TTREQ *), void *opq){
-  assert(serv && do_task);
-  serv->do_task = do_task;
-  serv->opq_task = opq;
+
+/* Add a key to a Bloom filter object. */
+void ttbloomadd(TTBLOOM *bloom, const void *kbuf, int ksiz){
+  assert(bloom && kbuf && ksiz >= 0);
+  uint64_t hash = ttkeyhash(kbuf, ksiz);
+  uint64_t *block = bloom->blocks + (hash % bloom->bnum) * BLOOMBLKWORDS;
+  hash = (hash ^ (hash >> 31)) * 0x94d049bb133111ebULL;
+  for(int i = 0; i < BLOOMHASHNUM; i++){
+    int bit = (hash >> (i * 9)) & 0x1ff;
+    __atomic_fetch_or(block + (bit >> 6), 1ULL << (bit & 0x3f), __ATOMIC_RELEASE);
+  }
 }
 
 
-/* Start the service of a server object. */
-bool ttservstart(TTSERV *serv){
-  assert(serv);
-  int lfd;
-  if(serv->port < 1){
-    lfd = ttopenservsockunix(serv->host);
-    if(lfd == -1){
-      ttservlog(serv, TTLOGERROR, "ttopenservsockunix failed");
-      return false;
-    }
-  } else {
-    lfd = ttopenservsock(serv->addr[0] != '\0' ? serv->addr : NULL, serv->port);
-    if(lfd == -1){
-      ttservlog(serv, TTLOGERROR, "ttopenservsock failed");
+/* Check whether a key may be in a Bloom filter object. */
+bool ttbloomcheck(TTBLOOM *bloom, const void *kbuf, int ksiz){
+  assert(bloom && kbuf && ksiz >= 0);
+  if(!__atomic_load_n(&bloom->ready, __ATOMIC_ACQUIRE)) return true;
+  uint64_t hash = ttkeyhash(kbuf, ksiz);
+  uint64_t *block = bloom->blocks + (hash % bloom->bnum) * BLOOMBLKWORDS;
+  hash = (hash ^ (hash >> 31)) * 0x94d049bb133111ebULL;
+  for(int i = 0; i < BLOOMHASHNUM; i++){
+    int bit = (hash >> (i * 9)) & 0x1ff;
+    if(!(__atomic_load_n(block + (bit >> 6), __ATOMIC_ACQUIRE) & (1ULL << (bit & 0x3f)))){
+      __atomic_add_fetch(&bloom->nnum, 1, __ATOMIC_RELAXED);
       return false;
     }
   }
-  int epfd = epoll_create(TTEVENTMAX);
-  if(epfd == -1){
-    close(lfd);
-    ttservlog(serv, TTLOGERROR, "epoll_create failed");
-    return false;
-  }
+  return true;
+}
+
+
+/* Count a false positive answer of a Bloom filter object. */
+void ttbloomfalse(TTBLOOM *bloom){
+  assert(bloom);
+  if(__atomic_load_n(&bloom->ready, __ATOMIC_RELAXED))
+    __atomic_add_fetch(&bloom->fnum, 1, __ATOMIC_RELAXED);
+}
+
+
+/* Mark a Bloom filter object as ready. */
+void ttbloomsetready(TTBLOOM *bloom){
+  assert(bloom);
+  __atomic_store_n(&bloom->ready, true, __ATOMIC_RELEASE);
+}
+
+
+/* Get the size of the memory used by a Bloom filter object. */
+uint64_t ttbloomsize(TTBLOOM *bloom){
+  assert(bloom);
+  return bloom->bnum * BLOOMBLKWORDS * sizeof(uint64_t);
+}
+
+
+/* Create a record cache object. */
+TTCACHE *ttcachenew(uint64_t limsiz){
+  TTCACHE *cache = tcmalloc(sizeof(*cache));
+  TTCACHESHARD *shards = tcmalloc(sizeof(*shards) * CACHESHARDNUM);
+  for(int i = 0; i < CACHESHARDNUM; i++){
+    TTCACHESHARD *shard = shards + i;
+    if(pthread_mutex_init(&shard->mtx, NULL) != 0) tcmyfatal("pthread_mutex_init failed");
+    shard->recs = tcmapnew();
+    shard->hand = NULL;
+    shard->size = 0;
+    shard->gen = 0;
+  }
+  cache->shards = shards;
+  cache->snum = CACHESHARDNUM;
+  cache->limsiz = limsiz / CACHESHARDNUM;
+  cache->hnum = 0;
+  cache->mnum = 0;
+  cache->vnum = 0;
+  return cache;
+}
+
+
+/* Delete a record cache object. */
+void ttcachedel(TTCACHE *cache){
+  assert(cache);
+  ttcacheclear(cache);
+  TTCACHESHARD *shards = cache->shards;
+  for(int i = 0; i < cache->snum; i++){
+    tcmapdel(shards[i].recs);
+    pthread_mutex_destroy(&shards[i].mtx);
+  }
+  tcfree(shards);
+  tcfree(cache);
+}
+
+
+/* Retrieve a record in a record cache object. */
+char *ttcacheget(TTCACHE *cache, const void *kbuf, int ksiz, int *sp, uint64_t *genp){
+  assert(cache && kbuf && ksiz >= 0 && sp && genp);
+  TTCACHESHARD *shard = (TTCACHESHARD *)cache->shards + ttkeyhash(kbuf, ksiz) % cache->snum;
+  if(pthread_mutex_lock(&shard->mtx) != 0) return NULL;
+  char *vbuf = NULL;
+  int psiz;
+  const char *pbuf = tcmapget(shard->recs, kbuf, ksiz, &psiz);
+  if(pbuf){
+    TTCACHEREC *rec;
+    memcpy(&rec, pbuf, sizeof(rec));
+    rec->ref = true;
+    vbuf = tcmemdup((char *)(rec + 1) + rec->ksiz, rec->vsiz);
+    *sp = rec->vsiz;
+  } else {
+    *genp = shard->gen;
+  }
+  pthread_mutex_unlock(&shard->mtx);
+  __atomic_add_fetch(vbuf ? &cache->hnum : &cache->mnum, 1, __ATOMIC_RELAXED);
+  return vbuf;
+}
+
+
+/* Store a record into a record cache object. */
+void ttcacheput(TTCACHE *cache, const void *kbuf, int ksiz, const void *vbuf, int vsiz,
+                uint64_t gen){
+  assert(cache && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t rsiz = sizeof(TTCACHEREC) + ksiz * 2 + vsiz + CACHERECOVH;
+  if(rsiz > cache->limsiz / CACHERECDIV) return;
+  TTCACHESHARD *shard = (TTCACHESHARD *)cache->shards + ttkeyhash(kbuf, ksiz) % cache->snum;
+  if(pthread_mutex_lock(&shard->mtx) != 0) return;
+  int psiz;
+  if(shard->gen != gen || tcmapget(shard->recs, kbuf, ksiz, &psiz)){
+    pthread_mutex_unlock(&shard->mtx);
+    return;
+  }
+  int vnum = 0;
+  while(shard->hand && shard->size + rsiz > cache->limsiz){
+    TTCACHEREC *rec = shard->hand;
+    if(rec->ref){
+      rec->ref = false;
+      shard->hand = rec->next;
+    } else {
+      ttcacheunlink(shard, rec);
+      vnum++;
+    }
+  }
+  TTCACHEREC *rec = tcmalloc(sizeof(*rec) + ksiz + vsiz);
+  rec->ksiz = ksiz;
+  rec->vsiz = vsiz;
+  rec->ref = false;
+  memcpy(rec + 1, kbuf, ksiz);
+  memcpy((char *)(rec + 1) + ksiz, vbuf, vsiz);
+  if(shard->hand){
+    rec->next = shard->hand;
+    rec->prev = shard->hand->prev;
+    rec->prev->next = rec;
+    rec->next->prev = rec;
+  } else {
+    rec->prev = rec;
+    rec->next = rec;
+    shard->hand = rec;
+  }
+  tcmapput(shard->recs, kbuf, ksiz, &rec, sizeof(rec));
+  shard->size += rsiz;
+  pthread_mutex_unlock(&shard->mtx);
+  if(vnum > 0) __atomic_add_fetch(&cache->vnum, vnum, __ATOMIC_RELAXED);
+}
+
+
+/* Remove a record of a record cache object. */
+void ttcacheout(TTCACHE *cache, const void *kbuf, int ksiz){
+  assert(cache && kbuf && ksiz >= 0);
+  TTCACHESHARD *shard = (TTCACHESHARD *)cache->shards + ttkeyhash(kbuf, ksiz) % cache->snum;
+  if(pthread_mutex_lock(&shard->mtx) != 0) return;
+  shard->gen++;
+  int psiz;
+  const char *pbuf = tcmapget(shard->recs, kbuf, ksiz, &psiz);
+  if(pbuf){
+    TTCACHEREC *rec;
+    memcpy(&rec, pbuf, sizeof(rec));
+    ttcacheunlink(shard, rec);
+  }
+  pthread_mutex_unlock(&shard->mtx);
+}
+
+
+/* Remove all records of a record cache object. */
+void ttcacheclear(TTCACHE *cache){
+  assert(cache);
+  TTCACHESHARD *shards = cache->shards;
+  for(int i = 0; i < cache->snum; i++){
+    TTCACHESHARD *shard = shards + i;
+    if(pthread_mutex_lock(&shard->mtx) != 0) continue;
+    shard->gen++;
+    while(shard->hand){
+      ttcacheunlink(shard, shard->hand);
+    }
+    pthread_mutex_unlock(&shard->mtx);
+  }
+}
+
+
+/* Get the total size of the records of a record cache object. */
+uint64_t ttcachesize(TTCACHE *cache){
+  assert(cache);
+  TTCACHESHARD *shards = cache->shards;
+  uint64_t size = 0;
+  for(int i = 0; i < cache->snum; i++){
+    size += __atomic_load_n(&shards[i].size, __ATOMIC_RELAXED);
+  }
+  return size;
+}
+
+
+
+/* Write vectored data by a socket.
+   `sock' specifies the socket object.
+   `iov' specifies the array of the regions to write.  It is modified as written.
+   `iovcnt' specifies the number of the regions.
+   If successful, the return value is true, else, it is false. */
+static bool ttsockwritev(TTSOCK *sock, struct iovec *iov, int iovcnt){
+  if(sock->shm){
+    for(int i = 0; i < iovcnt; i++){
+      if(!ttshmwrite(sock->shm, iov[i].iov_base, iov[i].iov_len, sock->dl)) return false;
+    }
+    return true;
+  }
+  while(iovcnt > 0){
+    int ocs = PTHREAD_CANCEL_DISABLE;
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &ocs);
+    ssize_t wb = writev(sock->fd, iov, (iovcnt < SOCKIOVMAX) ? iovcnt : SOCKIOVMAX);
+    pthread_setcancelstate(ocs, NULL);
+    if(wb == -1){
+      if(errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) return false;
+      if(tctime() > sock->dl) return false;
+      continue;
+    }
+    while(iovcnt > 0 && wb >= (ssize_t)iov->iov_len){
+      wb -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if(iovcnt > 0){
+      iov->iov_base = (char *)iov->iov_base + wb;
+      iov->iov_len -= wb;
+    }
+  }
+  return true;
+}
+
+
+
+/* Receive one line by a socket into the line buffer of the socket.
+   `sock' specifies the socket object.
+   The return value is the size of the line or -1 on failure.
+   Linefeed and carriage returns are removed and the line is terminated by zero code. */
+static int ttsockreadline(TTSOCK *sock){
+  if(!sock->lbuf){
+    sock->lbsiz = SOCKLINEBUFSIZ;
+    sock->lbuf = tcmalloc(sock->lbsiz);
+  }
+  int lsiz = 0;
+  while(true){
+    if(sock->rp >= sock->ep){
+      if(ttsockgetc(sock) == -1) return -1;
+      sock->rp--;
+    }
+    int rsiz = sock->ep - sock->rp;
+    char *nl = memchr(sock->rp, '\n', rsiz);
+    int csiz = nl ? nl - sock->rp : rsiz;
+    if(lsiz + csiz >= SOCKLINEMAXSIZ){
+      sock->end = true;
+      return -1;
+    }
+    if(lsiz + csiz >= sock->lbsiz){
+      while(lsiz + csiz >= sock->lbsiz){
+        sock->lbsiz *= 2;
+      }
+      sock->lbuf = tcrealloc(sock->lbuf, sock->lbsiz);
+    }
+    memcpy(sock->lbuf + lsiz, sock->rp, csiz);
+    lsiz += csiz;
+    sock->rp += csiz;
+    if(nl){
+      sock->rp++;
+      break;
+    }
+  }
+  char *cr = memchr(sock->lbuf, '\r', lsiz);
+  if(cr){
+    char *wp = cr;
+    for(const char *rp = cr; rp < sock->lbuf + lsiz; rp++){
+      if(*rp != '\r') *(wp++) = *rp;
+    }
+    lsiz = wp - sock->lbuf;
+  }
+  sock->lbuf[lsiz] = '\0';
+  return lsiz;
+}
+
+
+
+/* Read data from the ring of input of a shared memory transport.
+   `shm' specifies the shared memory transport object.
+   `buf' specifies the pointer to the region into which the data is read.
+   `size' specifies the maximum size of the data.
+   `dl' specifies the deadline time.
+   The return value is the size of the read data, 0 if the peer is closed, or -1 on timeout. */
+static int ttshmread(TTSHM *shm, char *buf, int size, double dl){
+#if defined(TTUSEFUTEX)
+  TTSHMRING *ring = shm->irng;
+  uint32_t head = ring->head;
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  if(tail == head){
+    int rv = ttshmwaitword(shm, &ring->tail, head, &ring->rwait, dl);
+    if(rv < 1) return rv;
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  }
+  uint32_t rsiz = tail - head;
+  if(rsiz > (uint32_t)size) rsiz = size;
+  uint32_t off = head & (shm->rsiz - 1);
+  uint32_t fsiz = shm->rsiz - off;
+  if(fsiz > rsiz) fsiz = rsiz;
+  memcpy(buf, shm->ibuf + off, fsiz);
+  memcpy(buf + fsiz, shm->ibuf, rsiz - fsiz);
+  __atomic_store_n(&ring->head, head + rsiz, __ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&ring->wwait, __ATOMIC_SEQ_CST))
+    syscall(SYS_futex, &ring->head, FUTEX_WAKE, 1, NULL, NULL, 0);
+  return rsiz;
+#else
+  return 0;
+#endif
+}
+
+
+/* Write data into the ring of output of a shared memory transport.
+   `shm' specifies the shared memory transport object.
+   `buf' specifies the pointer to the region of the data.
+   `size' specifies the size of the data.
+   `dl' specifies the deadline time.
+   If successful, the return value is true, else, it is false. */
+static bool ttshmwrite(TTSHM *shm, const char *buf, int size, double dl){
+#if defined(TTUSEFUTEX)
+  TTSHMRING *ring = shm->orng;
+  TTSHMHEAD *head = shm->map;
+  if(__atomic_load_n(head->closed + !shm->side, __ATOMIC_ACQUIRE)) return false;
+  uint32_t tail = ring->tail;
+  while(size > 0){
+    uint32_t rhead = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t wsiz = shm->rsiz - (tail - rhead);
+    if(wsiz < 1){
+      if(ttshmwaitword(shm, &ring->head, rhead, &ring->wwait, dl) < 1) return false;
+      continue;
+    }
+    if(wsiz > (uint32_t)size) wsiz = size;
+    uint32_t off = tail & (shm->rsiz - 1);
+    uint32_t fsiz = shm->rsiz - off;
+    if(fsiz > wsiz) fsiz = wsiz;
+    memcpy(shm->obuf + off, buf, fsiz);
+    memcpy(shm->obuf, buf + fsiz, wsiz - fsiz);
+    tail += wsiz;
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&ring->rwait, __ATOMIC_SEQ_CST))
+      syscall(SYS_futex, &ring->tail, FUTEX_WAKE, 1, NULL, NULL, 0);
+    buf += wsiz;
+    size -= wsiz;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+/* Wait for a position of a ring of a shared memory transport to be moved by the peer.
+   `shm' specifies the shared memory transport object.
+   `word' specifies the pointer to the position.
+   `val' specifies the value observed before waiting.
+   `flag' specifies the pointer to the sleeping flag of the waiting side.
+   `dl' specifies the deadline time.
+   The return value is 1 if the position is moved, 0 if the peer is closed, or -1 on timeout.
+   The caller spins for a while and then sleeps on the futex of the position. */
+static int ttshmwaitword(TTSHM *shm, uint32_t *word, uint32_t val, uint32_t *flag, double dl){
+#if defined(TTUSEFUTEX)
+  for(int i = 0; i < SHMSPINNUM; i++){
+    if(__atomic_load_n(word, __ATOMIC_ACQUIRE) != val) return 1;
+  }
+  TTSHMHEAD *head = shm->map;
+  bool check = false;
+  while(true){
+    __atomic_store_n(flag, 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(word, __ATOMIC_SEQ_CST) != val){
+      __atomic_store_n(flag, 0, __ATOMIC_RELAXED);
+      return 1;
+    }
+    if(__atomic_load_n(head->closed + !shm->side, __ATOMIC_SEQ_CST) ||
+       (check && !ttshmalive(shm))){
+      __atomic_store_n(flag, 0, __ATOMIC_RELAXED);
+      return 0;
+    }
+    double now = tctime();
+    if(now > dl){
+      __atomic_store_n(flag, 0, __ATOMIC_RELAXED);
+      errno = EAGAIN;
+      return -1;
+    }
+    double sec = dl - now;
+    if(sec > SHMWAITMAX) sec = SHMWAITMAX;
+    struct timespec ts;
+    ts.tv_sec = (time_t)sec;
+    ts.tv_nsec = (long)((sec - ts.tv_sec) * 1000000000);
+    check = syscall(SYS_futex, word, FUTEX_WAIT, val, &ts, NULL, 0) == -1 &&
+      errno == ETIMEDOUT;
+    __atomic_store_n(flag, 0, __ATOMIC_RELAXED);
+  }
+#else
+  return 0;
+#endif
+}
+
+
+/* Check whether the peer of a shared memory transport is alive.
+   `shm' specifies the shared memory transport object.
+   The return value is true if the connection with the peer is not hung up, else, it is
+   false. */
+static bool ttshmalive(TTSHM *shm){
+  struct pollfd pfd;
+  pfd.fd = shm->fd;
+  pfd.events = POLLIN | POLLRDHUP;
+  pfd.revents = 0;
+  if(poll(&pfd, 1, 0) < 1) return true;
+  return !(pfd.revents & (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL));
+}
+
+
+/* Get the hash value of a key of a Bloom filter or a record cache.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   The return value is the hash value. */
+static uint64_t ttkeyhash(const void *kbuf, int ksiz){
+  const unsigned char *rp = kbuf;
+  uint64_t hash = 14695981039346656037ULL;
+  while(ksiz-- > 0){
+    hash = (hash ^ *(rp++)) * 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+
+/* Remove a record from a shard of a record cache, while the shard is locked.
+   `shard' specifies the shard object.
+   `rec' specifies the record object. */
+static void ttcacheunlink(TTCACHESHARD *shard, TTCACHEREC *rec){
+  if(rec->next == rec){
+    shard->hand = NULL;
+  } else {
+    if(shard->hand == rec) shard->hand = rec->next;
+    rec->prev->next = rec->next;
+    rec->next->prev = rec->prev;
+  }
+  tcmapout(shard->recs, rec + 1, rec->ksiz);
+  shard->size -= sizeof(TTCACHEREC) + rec->ksiz * 2 + rec->vsiz + CACHERECOVH;
+  tcfree(rec);
+}
+
+
+
+/*************************************************************************************************
+ * server utilities
+ *************************************************************************************************/
+
+
+#define TTADDRBUFSIZ   1024              // size of an address buffer
+#define TTDEFTHNUM     5                 // default number of threads
+#define TTEVENTMAX     256               // maximum number of events
+#define TTWAITREQUEST  200               // waiting milliseconds for requests
+#define TTWAITWORKER   100               // waiting milliseconds for finish of workers
+#define TTDEFSPAWNWAIT 0.01              // default queue waiting seconds to spawn a worker
+#define TTDEFIDLETIME  30.0              // default idle seconds to retire a worker
+#define TTDEFPARTWAIT  30.0              // default waiting seconds for the rest of a request
+#define TTWAITHOLD     10000             // waiting milliseconds for finish of workers on hold
+#define TTCONNSLOTMAX  (1024*1024)       // maximum number of slots of connections
+#define TTWHEELTICK    0.001             // seconds of a tick of the timer wheel
+#define TTWHEELBITS    6                 // bits of the number of slots of each level
+#define TTWHEELSIZ     (1<<TTWHEELBITS)  // number of slots of each level of the timer wheel
+#define TTWHEELLEVEL   4                 // number of levels of the timer wheel
+#define TTWHEELWAIT    1.0               // maximum seconds of a sleep of the timer wheel
+#define TTEXECMIN      2                 // minimum number of executor threads of timers
+#define TTEXECMAX      16                // maximum number of executor threads of timers
+
+enum {                                   // enumeration for states of timers
+  TTTMIDLE,                              // not scheduled
+  TTTMWHEEL,                             // waiting in the wheel
+  TTTMREADY,                             // waiting for an executor
+  TTTMRUN,                               // running on an executor
+  TTTMDONE                               // finished as a one-shot timer
+};
+
+typedef struct {                         // type of structure for a timer wheel
+  TTTIMER *slots[TTWHEELLEVEL][TTWHEELSIZ];  // lists of timers of each slot of each level
+  uint64_t tick;                         // next tick to be processed
+  double base;                           // time of the tick zero
+  TTTIMER *rhead;                        // head of the queue of ready timers
+  TTTIMER *rtail;                        // tail of the queue of ready timers
+  pthread_cond_t xcnd;                   // condition variable for executors
+  pthread_t wthid;                       // thread ID of the wheel
+  pthread_t xthids[TTEXECMAX];           // thread IDs of executors
+  int xnum;                              // number of executors
+  int xidle;                             // number of idle executors
+} TTWHEEL;
+
+typedef struct _TTSHMSESS {              // type of structure for a shared memory session
+  TTSERV *serv;                          // server object
+  TTSHM *shm;                            // shared memory transport object
+  int cfd;                               // descriptor of the connection
+  int fd;                                // duplicated descriptor of the connection
+  pthread_t thid;                        // thread ID
+  TTREQ req;                             // request object
+  bool done;                             // whether the thread has finished
+  struct _TTSHMSESS *next;               // next session
+} TTSHMSESS;
+
+#if defined(TTUSEURING)
+
+#define TTURINGSIZ     256               // number of entries of an io_uring
+#define TTURACCEPT     1                 // tag of accepting requests of an io_uring
+#define TTURPOLL       2                 // tag of polling requests of an io_uring
+#define TTURWAKE       3                 // tag of waking requests of an io_uring
+#define TTURCANCEL     4                 // tag of canceling requests of an io_uring
+
+typedef struct {                         // type of structure for an io_uring
+  int fd;                                // file descriptor
+  void *sqmap;                           // mapped region of the submission queue
+  size_t sqmsiz;                         // size of the region of the submission queue
+  void *cqmap;                           // mapped region of the completion queue
+  size_t cqmsiz;                         // size of the region of the completion queue
+  struct io_uring_sqe *sqes;             // array of submission entries
+  size_t sqesiz;                         // size of the array of submission entries
+  uint32_t *sqhead;                      // head of the submission queue
+  uint32_t *sqtail;                      // tail of the submission queue
+  uint32_t *sqarray;                     // index array of the submission queue
+  uint32_t sqmask;                       // mask of the submission queue
+  uint32_t sqnum;                        // number of entries of the submission queue
+  uint32_t *cqhead;                      // head of the completion queue
+  uint32_t *cqtail;                      // tail of the completion queue
+  struct io_uring_cqe *cqes;             // array of completion entries
+  uint32_t cqmask;                       // mask of the completion queue
+  bool multi;                            // whether multishot accepting is supported
+  bool waking;                           // whether the waking request is armed
+} TTURING;
+
+#endif
+
+
+/* private function prototypes */
+static TTTIMER *ttservtimeradd(TTSERV *serv, double wait, double freq,
+                               void (*do_timed)(void *), void *opq, bool delay);
+static void ttservtimerarm(TTSERV *serv, TTTIMER *timer, double due);
+static bool ttservwheelopen(TTSERV *serv);
+static bool ttservwheelclose(TTSERV *serv);
+static void *ttservwheel(void *argp);
+static void *ttservexec(void *argp);
+static void *ttservshmtask(void *argp);
+static bool ttpeerislocal(int fd);
+static void ttservshmclose(TTSERV *serv);
+static void ttwheeladd(TTWHEEL *wheel, TTTIMER *timer);
+static void ttwheelput(TTWHEEL *wheel, TTTIMER *timer);
+static uint64_t ttwheelnext(TTWHEEL *wheel);
+static void ttwheeladvance(TTWHEEL *wheel, uint64_t now);
+static void ttservtask(TTSOCK *sock, TTREQ *req);
+static void *ttservdeqtasks(void *argp);
+static void *ttservreactor(void *argp);
+static bool ttservenqueue(TTQSLOT *slots, uint32_t *tailp, int fd);
+static int ttservdequeue(TTQSLOT *slots, uint32_t *headp, double *etp);
+static void ttservspawn(TTREACTOR *rct);
+static bool ttservretire(TTREACTOR *rct);
+static bool ttservqwake(TTREACTOR *rct, bool all);
+static bool ttservqpark(TTREACTOR *rct, uint32_t seq, int ms);
+static bool ttservrearm(TTREACTOR *rct, int fd);
+static void ttservabandon(TTREACTOR *rct, int fd);
+static bool ttservsweep(TTREACTOR *rct);
+static int ttservgather(TTSERV *serv, TTSOCK *sock);
+static void ttservpartkeep(TTPART **partp, TTSOCK *sock);
+static void ttservpartdel(TTPART **partp);
+static void ttservconnopen(TTSERV *serv);
+static void ttservconnmark(TTSERV *serv, int fd, bool on);
+static void ttservconndrop(TTREQ *req);
+static void ttservconnrelease(TTSERV *serv, int fd);
+static bool ttservrelease(TTSERV *serv, TTREACTOR *rcts, int rnum);
+static bool ttsendfd(int sfd, int fd, const void *buf, int size);
+static bool ttrecvfd(int sfd, int *fdp, void *buf, int size);
+#if defined(TTUSEURING)
+static TTURING *tturingnew(void);
+static void tturingdel(TTURING *ring);
+static struct io_uring_sqe *tturingsqe(TTURING *ring, TTSERV *serv);
+static bool tturingpoll(TTURING *ring, TTSERV *serv, int fd, uint64_t tag, bool multi);
+static bool tturingaccept(TTURING *ring, TTSERV *serv, int fd, bool multi);
+static bool tturingcancel(TTURING *ring, TTSERV *serv, int fd);
+static int tturingenter(TTURING *ring, TTSERV *serv, int wnum, int ms);
+static bool ttservreactoruring(TTREACTOR *rct);
+#endif
+
+
+/* Create a server object. */
+TTSERV *ttservnew(void){
+  TTSERV *serv = tcmalloc(sizeof(*serv));
+  serv->host[0] = '\0';
+  serv->addr[0] = '\0';
+  serv->port = 0;
+  if(pthread_mutex_init(&serv->tmtx, NULL) != 0) tcmyfatal("pthread_mutex_init failed");
+  if(pthread_cond_init(&serv->tcnd, NULL) != 0) tcmyfatal("pthread_cond_init failed");
+  serv->thnum = TTDEFTHNUM;
+  serv->thmax = 0;
+  serv->spawnwait = TTDEFSPAWNWAIT;
+  serv->idletime = TTDEFIDLETIME;
+  serv->rnum = 1;
+  serv->qhigh = 0;
+  serv->qlow = 0;
+  serv->uring = false;
+  serv->timeout = 0;
+  serv->term = false;
+  serv->do_log = NULL;
+  serv->opq_log = NULL;
+  serv->timers = NULL;
+  serv->timernum = 0;
+  serv->wheel = NULL;
+  serv->do_task = NULL;
+  serv->opq_task = NULL;
+  serv->do_frame = NULL;
+  serv->opq_frame = NULL;
+  serv->conns = NULL;
+  serv->copts = NULL;
+  serv->cdats = NULL;
+  serv->do_conndel = NULL;
+  serv->opq_conndel = NULL;
+  serv->parts = NULL;
+  serv->connmax = 0;
+  serv->hold = false;
+  serv->rcts = NULL;
+  serv->rctnum = 0;
+  serv->lfds = NULL;
+  serv->lfdnum = 0;
+  serv->cfds = NULL;
+  serv->cfdnum = 0;
+  serv->thcur = 0;
+  serv->spawnnum = 0;
+  serv->retirenum = 0;
+  serv->waitnum = 0;
+  serv->waitsum = 0;
+  serv->waitmax = 0;
+  serv->uringnum = 0;
+  serv->evsysnum = 0;
+  serv->defernum = 0;
+  serv->firenum = 0;
+  serv->jitsum = 0;
+  serv->jitmax = 0;
+  if(pthread_mutex_init(&serv->smtx, NULL) != 0) tcmyfatal("pthread_mutex_init failed");
+  serv->shms = NULL;
+  serv->shmnum = 0;
+  serv->shmmax = 0;
+  return serv;
+}
+
+
+/* Delete a server object. */
+void ttservdel(TTSERV *serv){
+  assert(serv);
+  serv->do_log = NULL;
+  ttservrelease(serv, serv->rcts, serv->rctnum);
+  for(int i = 0; i < serv->timernum; i++){
+    tcfree(serv->timers[i]);
+  }
+  tcfree(serv->timers);
+  ttservshmclose(serv);
+  pthread_mutex_destroy(&serv->smtx);
+  pthread_cond_destroy(&serv->tcnd);
+  pthread_mutex_destroy(&serv->tmtx);
+  tcfree(serv);
+}
+
+
+/* Configure a server object. */
+bool ttservconf(TTSERV *serv, const char *host, int port){
+  assert(serv);
+  bool err = false;
+  if(port < 1){
+    if(!host || host[0] == '\0'){
+      err = true;
+      serv->addr[0] = '\0';
+      ttservlog(serv, TTLOGERROR, "invalid socket path");
+    }
+  } else {
+    if(host && !ttgethostaddr(host, serv->addr)){
+      err = true;
+      serv->addr[0] = '\0';
+      ttservlog(serv, TTLOGERROR, "ttgethostaddr failed");
+    }
+  }
+  snprintf(serv->host, sizeof(serv->host), "%s", host ? host : "");
+  serv->port = port;
+  return !err;
+}
+
+
+/* Set tuning parameters of a server object. */
+void ttservtune(TTSERV *serv, int thnum, double timeout){
+  assert(serv && thnum > 0);
+  serv->thnum = thnum;
+  serv->timeout = timeout;
+}
+
+
+/* Set tuning parameters of the elastic worker pool of a server object. */
+void ttservtunepool(TTSERV *serv, int thmax, double spawnwait, double idletime){
+  assert(serv);
+  serv->thmax = thmax;
+  serv->spawnwait = spawnwait > 0 ? spawnwait : TTDEFSPAWNWAIT;
+  serv->idletime = idletime > 0 ? idletime : TTDEFIDLETIME;
+}
+
+
+/* Set the watermarks of the request queue of a server object. */
+void ttservtunequeue(TTSERV *serv, int qhigh, int qlow){
+  assert(serv);
+  qhigh = tclmin(qhigh, TTQUEUESIZ);
+  if(qlow < 1 || qlow >= qhigh) qlow = qhigh / 2;
+  serv->qhigh = tclmax(qhigh, 0);
+  serv->qlow = tclmax(qlow, 0);
+}
+
+
+/* Set the number of reactors of a server object. */
+void ttservsetreactors(TTSERV *serv, int rnum){
+  assert(serv && rnum > 0);
+  serv->rnum = rnum;
+}
+
+
+/* Set the event backend of a server object. */
+void ttservseturing(TTSERV *serv, bool uring){
+  assert(serv);
+  serv->uring = uring;
+}
+
+
+/* Set the maximum number of shared memory sessions of a server object. */
+void ttservsetshm(TTSERV *serv, int max){
+  assert(serv);
+  serv->shmmax = tclmax(max, 0);
+}
+
+
+/* Set the logging handler of a server object. */
+void ttservsetloghandler(TTSERV *serv, void (*do_log)(int, const char *, void *), void *opq){
+  assert(serv && do_log);
+  serv->do_log = do_log;
+  serv->opq_log = opq;
+}
+
+
+/* Start a stopped replication timer of a server object.
+   Only timers whose handler is `do_timed' are taken as replication timers, because the opaque
+   pointer of other timers is not a replication argument. */
+bool ttservmodifytimedhandler(const char *host, int port, const char *rtspath, TTSERV *serv,
+                              void (*do_timed)(void *)){
+  assert(serv && do_timed);
+  bool rv = false;
+  if(pthread_mutex_lock(&serv->tmtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+    return false;
+  }
+  for(int i = 0; i < serv->timernum; i++){
+    TTTIMER *timer = serv->timers[i];
+    if(timer->do_timed != do_timed || timer->started) continue;
+    REPLARG *sarg = timer->opq_timed;
+    snprintf(sarg->host, TTADDRBUFSIZ, "%s", host ? host : "");
+    sarg->port = port;
+    snprintf(sarg->rtspath, TTADDRBUFSIZ, "%s", rtspath ? rtspath : "");
+    sarg->exit = false;
+    timer->started = true;
+    ttservtimerarm(serv, timer, tctime() + timer->wait);
+    ttservlog(serv, TTLOGINFO, "timer %d started for %s:%d", i + 1, sarg->host, sarg->port);
+    rv = true;
+    break;
+  }
+  if(pthread_mutex_unlock(&serv->tmtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+    rv = false;
+  }
+  return rv;
+}
+
+
+/* Stop the replication timer of a master of a server object.
+   Only timers whose handler is `do_timed' are taken as replication timers. */
+bool ttservdeltimedhandler(const char *host, int port, const char *rtspath, TTSERV *serv,
+                           void (*do_timed)(void *)){
+  assert(host && rtspath && serv && do_timed);
+  if(pthread_mutex_lock(&serv->tmtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+    return false;
+  }
+  for(int i = 0; i < serv->timernum; i++){
+    TTTIMER *timer = serv->timers[i];
+    if(timer->do_timed != do_timed || !timer->started) continue;
+    REPLARG *sarg = timer->opq_timed;
+    if(sarg->port != port || strcmp(sarg->host, host) || strcmp(sarg->rtspath, rtspath)) continue;
+    sarg->exit = true;
+    timer->started = false;
+    ttservlog(serv, TTLOGINFO, "timer %d stopped for %s:%d", i + 1, sarg->host, sarg->port);
+  }
+  if(pthread_mutex_unlock(&serv->tmtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+    return false;
+  }
+  return true;
+}
+
+
+/* Add a timed handler to a server object. */
+void ttservaddtimedhandler(TTSERV *serv, double freq, void (*do_timed)(void *), void *opq){
+  assert(serv && freq >= 0.0 && do_timed);
+  ttservtimeradd(serv, freq, freq, do_timed, opq, false);
+}
+
+/* Add a timed handler to a server object. */
+void ttservaddtimedhandler_delay(TTSERV *serv, double freq, void (*do_timed)(void *), void *opq){
+  assert(serv && freq >= 0.0 && do_timed);
+  ttservtimeradd(serv, freq, freq, do_timed, opq, true);
+}
+
+
+/* Add a periodic or one-shot timer to a server object. */
+void ttservaddtimer(TTSERV *serv, double wait, double freq, void (*do_timed)(void *), void *opq){
+  assert(serv && wait >= 0.0 && do_timed);
+  ttservtimeradd(serv, wait, freq, do_timed, opq, false);
+}
+
+/* Set the response handler of a server object. */
+void ttservsettaskhandler(TTSERV *serv, void (*do_task)(TTSOCK *, void *, TTREQ *), void *opq){
+  assert(serv && do_task);
+  serv->do_task = do_task;
+  serv->opq_task = opq;
+}
+
+
+/* Set the framing handler of a server object. */
+void ttservsetframehandler(TTSERV *serv, int (*do_frame)(const char *, int, void *), void *opq){
+  assert(serv && do_frame);
+  serv->do_frame = do_frame;
+  serv->opq_frame = opq;
+}
+
+
+/* Set the handler to release data of connections of a server object. */
+void ttservsetconndelhandler(TTSERV *serv, void (*do_conndel)(void *, void *), void *opq){
+  assert(serv && do_conndel);
+  serv->do_conndel = do_conndel;
+  serv->opq_conndel = opq;
+}
+
+
+/* Start the service of a server object. */
+bool ttservstart(TTSERV *serv){
+  assert(serv);
+  int thnum = serv->thnum;
+  int thmax = tclmax(serv->thmax, thnum);
+  TTREACTOR *rcts = serv->rcts;
+  int rnum = serv->rctnum;
+  bool err = false;
+  if(rcts){
+    serv->rcts = NULL;
+    serv->rctnum = 0;
+    ttservlog(serv, TTLOGINFO, "held descriptors resumed");
+  } else {
+    rnum = serv->rnum;
+    if(rnum > 1 && serv->port < 1){
+      ttservlog(serv, TTLOGINFO, "warning: UNIX domain socket supports one reactor only");
+      rnum = 1;
+    }
+    if(serv->lfdnum > 0){
+      bool match = true;
+      for(int i = 0; i < serv->lfdnum; i++){
+        struct sockaddr_un saun;
+        memset(&saun, 0, sizeof(saun));
+        socklen_t slen = sizeof(saun);
+        if(getsockname(serv->lfds[i], (struct sockaddr *)&saun, &slen) != 0){
+          match = false;
+        } else if(serv->port < 1){
+          if(saun.sun_family != AF_UNIX) match = false;
+        } else {
+          struct sockaddr_in *sain = (struct sockaddr_in *)&saun;
+          if(sain->sin_family != AF_INET || ntohs(sain->sin_port) != serv->port) match = false;
+        }
+      }
+      if(match){
+        rnum = serv->lfdnum;
+      } else {
+        ttservlog(serv, TTLOGINFO, "warning: inherited listeners do not match the address");
+        for(int i = 0; i < serv->lfdnum; i++){
+          close(serv->lfds[i]);
+        }
+        tcfree(serv->lfds);
+        serv->lfds = NULL;
+        serv->lfdnum = 0;
+      }
+    }
+    if(rnum > thnum) rnum = thnum;
+    rcts = tcmalloc(sizeof(*rcts) * rnum);
+    for(int i = 0; i < rnum; i++){
+      TTREACTOR *rct = rcts + i;
+      rct->serv = serv;
+      rct->idx = i;
+      rct->lfd = -1;
+      rct->epfd = -1;
+      rct->qslots = tcmalloc(sizeof(*rct->qslots) * TTQUEUESIZ);
+      for(int j = 0; j < TTQUEUESIZ; j++){
+        rct->qslots[j].seq = j;
+        rct->qslots[j].fd = -1;
+      }
+      rct->qhead = 0;
+      rct->qtail = 0;
+      rct->qseq = 0;
+      rct->qshed = 0;
+      if(pthread_mutex_init(&rct->qmtx, NULL) != 0) tcmyfatal("pthread_mutex_init failed");
+      if(pthread_cond_init(&rct->qcnd, NULL) != 0) tcmyfatal("pthread_cond_init failed");
+      rct->uring = NULL;
+      rct->evfd = -1;
+      rct->rslots = tcmalloc(sizeof(*rct->rslots) * TTQUEUESIZ);
+      for(int j = 0; j < TTQUEUESIZ; j++){
+        rct->rslots[j].seq = j;
+        rct->rslots[j].fd = -1;
+      }
+      rct->rhead = 0;
+      rct->rtail = 0;
+      rct->rsleep = 0;
+    }
+    serv->uringnum = 0;
+#if !defined(TTUSEURING)
+    if(serv->uring) ttservlog(serv, TTLOGINFO, "warning: io_uring is not supported: using epoll");
+#endif
+    for(int i = 0; !err && i < rnum; i++){
+      TTREACTOR *rct = rcts + i;
+      if(i < serv->lfdnum){
+        rct->lfd = serv->lfds[i];
+        serv->lfds[i] = -1;
+      } else if(serv->port < 1){
+        rct->lfd = ttopenservsockunix(serv->host);
+        if(rct->lfd == -1){
+          err = true;
+          ttservlog(serv, TTLOGERROR, "ttopenservsockunix failed");
+        }
+      } else {
+        rct->lfd = ttopenservsock2(serv->addr[0] != '\0' ? serv->addr : NULL, serv->port,
+                                   rnum > 1);
+        if(rct->lfd == -1){
+          err = true;
+          ttservlog(serv, TTLOGERROR, "ttopenservsock failed");
+        }
+      }
+      if(!err){
+        rct->epfd = epoll_create(TTEVENTMAX);
+        if(rct->epfd == -1){
+          err = true;
+          ttservlog(serv, TTLOGERROR, "epoll_create failed");
+        }
+      }
+#if defined(TTUSEURING)
+      if(!err && serv->uring){
+        rct->evfd = eventfd(0, EFD_NONBLOCK);
+        if(rct->evfd != -1) rct->uring = tturingnew();
+        if(rct->uring){
+          serv->uringnum++;
+        } else {
+          ttservlog(serv, TTLOGINFO, "warning: io_uring is not available: using epoll");
+          if(rct->evfd != -1) close(rct->evfd);
+          rct->evfd = -1;
+        }
+      }
+#endif
+    }
+    for(int i = rnum; i < serv->lfdnum; i++){
+      if(serv->lfds[i] != -1) close(serv->lfds[i]);
+    }
+    tcfree(serv->lfds);
+    serv->lfds = NULL;
+    serv->lfdnum = 0;
+    if(err){
+      ttservrelease(serv, rcts, rnum);
+      return false;
+    }
+  }
+  ttservconnopen(serv);
+  TTREQ *reqs = tcmalloc(sizeof(*reqs) * thmax);
+  for(int i = 0; i < rnum; i++){
+    TTREACTOR *rct = rcts + i;
+    rct->alive = false;
+    rct->qidle = 0;
+    rct->lastwait = 0;
+    rct->wnum = 0;
+    rct->wmin = thnum / rnum + (i < thnum % rnum ? 1 : 0);
+    rct->wmax = thmax / rnum + (i < thmax % rnum ? 1 : 0);
+    rct->reqs = reqs;
+    rct->thnum = thmax;
+    rct->rnum = rnum;
+  }
+  if(serv->cfdnum > 0){
+    for(int i = 0; i < serv->cfdnum; i++){
+      TTREACTOR *rct = rcts + i % rnum;
+      int cfd = serv->cfds[i];
+      bool ok = false;
+      if(rct->uring){
+#if defined(TTUSEURING)
+        ok = tturingpoll(rct->uring, serv, cfd, TTURPOLL, false);
+#endif
+      } else {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.fd = cfd;
+        ok = epoll_ctl(rct->epfd, EPOLL_CTL_ADD, cfd, &ev) == 0;
+      }
+      if(!ok){
+        ttservconnmark(serv, cfd, false);
+        ttservpartdel(serv->parts + cfd);
+        close(cfd);
+        err = true;
+        ttservlog(serv, TTLOGERROR, "epoll_ctl failed");
+      }
+    }
+    ttservlog(serv, TTLOGINFO, "%d inherited connections resumed", serv->cfdnum);
+    tcfree(serv->cfds);
+    serv->cfds = NULL;
+    serv->cfdnum = 0;
+  }
   ttservlog(serv, TTLOGSYSTEM, "service started: %d", getpid());
+  if(!ttservwheelopen(serv)) err = true;
+  serv->thcur = 0;
+  for(int i = 0; i < thmax; i++){
+    TTREACTOR *rct = rcts + i % rnum;
+    reqs[i].alive = false;
+    reqs[i].serv = serv;
+    reqs[i].rct = rct;
+    reqs[i].epfd = rct->epfd;
+    reqs[i].mtime = tctime();
+    reqs[i].keep = false;
+    reqs[i].idx = i;
+    reqs[i].retired = false;
+    reqs[i].shed = false;
+    reqs[i].cfd = -1;
+    reqs[i].done = false;
+    reqs[i].arena = NULL;
+    if(i >= thnum) continue;
+    if(pthread_create(&reqs[i].thid, NULL, ttservdeqtasks, reqs + i) == 0){
+      reqs[i].alive = true;
+      rct->wnum++;
+      serv->thcur++;
+      ttservlog(serv, TTLOGINFO, "worker thread %d started", i + 1);
+    } else {
+      err = true;
+      ttservlog(serv, TTLOGERROR, "pthread_create (ttservdeqtasks) failed");
+    }
+  }
+  for(int i = 1; i < rnum; i++){
+    TTREACTOR *rct = rcts + i;
+    if(pthread_create(&rct->thid, NULL, ttservreactor, rct) == 0){
+      rct->alive = true;
+      ttservlog(serv, TTLOGINFO, "reactor thread %d started", i + 1);
+    } else {
+      err = true;
+      ttservlog(serv, TTLOGERROR, "pthread_create (ttservreactor) failed");
+    }
+  }
+  ttservlog(serv, TTLOGSYSTEM, "listening started");
+  if(ttservreactor(rcts) != NULL) err = true;
+  for(int i = 1; i < rnum; i++){
+    TTREACTOR *rct = rcts + i;
+    if(!rct->alive) continue;
+    void *rv;
+    if(pthread_join(rct->thid, &rv) == 0){
+      ttservlog(serv, TTLOGINFO, "reactor thread %d finished", i + 1);
+      if(rv) err = true;
+    } else {
+      err = true;
+      ttservlog(serv, TTLOGERROR, "pthread_join failed");
+    }
+  }
+  ttservlog(serv, TTLOGSYSTEM, "listening finished");
+  bool hold = serv->hold;
+  for(int i = 0; i < rnum; i++){
+    if(!ttservqwake(rcts + i, true)) err = true;
+  }
+  if(pthread_cond_broadcast(&serv->tcnd) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_cond_broadcast failed");
+  }
+  if(hold){
+    double dl = tctime() + TTWAITHOLD / 1000.0;
+    while(true){
+      bool busy = false;
+      for(int i = 0; i < thmax; i++){
+        if(reqs[i].alive && !__atomic_load_n(&reqs[i].done, __ATOMIC_ACQUIRE)) busy = true;
+      }
+      if(!busy || tctime() > dl) break;
+      usleep(TTWAITWORKER * 100);
+    }
+  } else {
+    usleep(TTWAITWORKER * 1000);
+  }
+  for(int i = 0; i < thmax; i++){
+    if(!reqs[i].alive) continue;
+    if(pthread_cancel(reqs[i].thid) == 0)
+      ttservlog(serv, TTLOGINFO, "worker thread %d was canceled", i + 1);
+    void *rv;
+    if(pthread_join(reqs[i].thid, &rv) == 0){
+      ttservlog(serv, TTLOGINFO, "worker thread %d finished", i + 1);
+      if(rv && rv != PTHREAD_CANCELED) err = true;
+    } else {
+      err = true;
+      ttservlog(serv, TTLOGERROR, "pthread_join failed");
+    }
+  }
+  if(hold){
+    int qnum = 0;
+    for(int i = 0; i < rnum; i++){
+      qnum += (int32_t)(rcts[i].qtail - rcts[i].qhead);
+    }
+    if(qnum > 0) ttservlog(serv, TTLOGINFO, "%d requests held", qnum);
+  } else {
+    int dnum = 0;
+    for(int i = 0; i < rnum; i++){
+      while(ttservdequeue(rcts[i].qslots, &rcts[i].qhead, NULL) != -1){
+        dnum++;
+      }
+    }
+    if(dnum > 0) ttservlog(serv, TTLOGINFO, "%d requests discarded", dnum);
+    for(int i = 0; i < rnum; i++){
+      int cfd;
+      while((cfd = ttservdequeue(rcts[i].rslots, &rcts[i].rhead, NULL)) != -1){
+        if(cfd >= serv->connmax) close(cfd);
+      }
+    }
+  }
+  ttservshmclose(serv);
+  if(!ttservwheelclose(serv)) err = true;
+  for(int i = 0; i < serv->connmax; i++){
+    ttservconnrelease(serv, i);
+  }
+  if(hold){
+    serv->rcts = rcts;
+    serv->rctnum = rnum;
+  } else if(!ttservrelease(serv, rcts, rnum)){
+    err = true;
+  }
+  tcfree(reqs);
+  serv->thcur = 0;
+  if(!hold && serv->port < 1 && unlink(serv->host) == -1){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "unlink failed");
+  }
+  ttservlog(serv, TTLOGSYSTEM, hold ? "service held" : "service finished");
+  serv->hold = false;
+  serv->term = false;
+  return !err;
+}
+
+
+/* Send the terminate signal to a server object. */
+bool ttservkill(TTSERV *serv){
+  assert(serv);
+  serv->hold = false;
+  serv->term = true;
+  return true;
+}
+
+
+/* Send the terminate signal to a server object holding its descriptors. */
+bool ttservhold(TTSERV *serv){
+  assert(serv);
+  serv->hold = true;
+  serv->term = true;
+  return true;
+}
+
+
+/* Hand the held descriptors of a server object over to another process. */
+bool ttservhandover(TTSERV *serv, int fd){
+  assert(serv && fd >= 0);
+  TTREACTOR *rcts = serv->rcts;
+  int rnum = serv->rctnum;
+  if(!rcts){
+    ttservlog(serv, TTLOGERROR, "no descriptor is held");
+    return false;
+  }
+  bool err = false;
+  int cnum = 0;
+  for(int i = 0; i < serv->connmax; i++){
+    if(!serv->conns[i]) continue;
+    struct stat sbuf;
+    if(fstat(i, &sbuf) == 0 && S_ISSOCK(sbuf.st_mode)){
+      cnum++;
+    } else {
+      serv->conns[i] = 0;
+    }
+  }
+  uint32_t head[2];
+  head[0] = rnum;
+  head[1] = cnum;
+  if(!ttsendfd(fd, -1, head, sizeof(head))) err = true;
+  for(int i = 0; !err && i < rnum; i++){
+    uint32_t psiz = 0;
+    if(!ttsendfd(fd, rcts[i].lfd, &psiz, sizeof(psiz))) err = true;
+  }
+  for(int i = 0; !err && i < serv->connmax; i++){
+    if(!serv->conns[i]) continue;
+    TTPART *part = serv->parts[i];
+    uint32_t psiz = part ? part->size : 0;
+    if(!ttsendfd(fd, i, &psiz, sizeof(psiz)) || (psiz > 0 && !tcwrite(fd, part->buf, psiz)))
+      err = true;
+  }
+  if(err){
+    ttservlog(serv, TTLOGERROR, "sendmsg failed");
+  } else {
+    ttservlog(serv, TTLOGINFO, "%d listeners and %d connections handed over", rnum, cnum);
+  }
+  if(!ttservrelease(serv, rcts, rnum)) err = true;
+  return !err;
+}
+
+
+/* Take over the descriptors handed over by another process to a server object. */
+bool ttservtakeover(TTSERV *serv, int fd, double timeout){
+  assert(serv && fd >= 0);
+  struct pollfd pfd;
+  memset(&pfd, 0, sizeof(pfd));
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  int rv;
+  do {
+    rv = poll(&pfd, 1, timeout > 0 ? timeout * 1000 : -1);
+  } while(rv == -1 && errno == EINTR);
+  if(rv < 1){
+    ttservlog(serv, TTLOGERROR, "the handover timed out");
+    return false;
+  }
+  int sfd = ttacceptsockunix(fd);
+  if(sfd == -1){
+    ttservlog(serv, TTLOGERROR, "ttacceptsockunix failed");
+    return false;
+  }
+  bool err = false;
+  uint32_t head[2];
+  int tfd;
+  if(!ttrecvfd(sfd, &tfd, head, sizeof(head)) || head[0] > TTCONNSLOTMAX ||
+     head[1] > TTCONNSLOTMAX){
+    head[0] = 0;
+    head[1] = 0;
+    err = true;
+  }
+  if(tfd != -1) close(tfd);
+  ttservconnopen(serv);
+  serv->lfds = tcrealloc(serv->lfds, sizeof(*serv->lfds) * (serv->lfdnum + head[0] + 1));
+  for(int i = 0; !err && i < (int)head[0]; i++){
+    uint32_t psiz;
+    if(ttrecvfd(sfd, &tfd, &psiz, sizeof(psiz)) && tfd != -1){
+      serv->lfds[serv->lfdnum++] = tfd;
+    } else {
+      err = true;
+    }
+  }
+  serv->cfds = tcrealloc(serv->cfds, sizeof(*serv->cfds) * (serv->cfdnum + head[1] + 1));
+  int cnum = 0;
+  for(int i = 0; !err && i < (int)head[1]; i++){
+    uint32_t psiz;
+    if(!ttrecvfd(sfd, &tfd, &psiz, sizeof(psiz))){
+      err = true;
+      break;
+    }
+    TTPART *part = NULL;
+    if(psiz > 0){
+      part = tcmalloc(sizeof(*part));
+      part->asiz = tclmax(psiz, TTIOBUFSIZ);
+      part->buf = tcmalloc(part->asiz);
+      part->size = psiz;
+      part->stime = tctime();
+      if(!tcread(sfd, part->buf, psiz)) err = true;
+    }
+    if(!err && tfd >= 0 && tfd < serv->connmax){
+      ttservconnmark(serv, tfd, true);
+      ttservpartdel(serv->parts + tfd);
+      serv->parts[tfd] = part;
+      serv->cfds[serv->cfdnum++] = tfd;
+      cnum++;
+    } else {
+      ttservpartdel(&part);
+      if(tfd != -1) close(tfd);
+    }
+  }
+  close(sfd);
+  if(err){
+    ttservlog(serv, TTLOGERROR, "recvmsg failed");
+  } else {
+    ttservlog(serv, TTLOGINFO, "%d listeners and %d connections taken over",
+              serv->lfdnum, cnum);
+  }
+  return !err;
+}
+
+
+/* Serve a client of a server object through a shared memory segment. */
+bool ttservopenshm(TTSERV *serv, int fd, char *name){
+  assert(serv && name);
+  if(fd < 0) return false;
+  if(serv->shmmax < 1){
+    ttservlog(serv, TTLOGINFO, "shared memory transport is disabled");
+    return false;
+  }
+  if(!ttpeerislocal(fd)){
+    ttservlog(serv, TTLOGINFO, "shared memory transport is refused for a remote peer");
+    return false;
+  }
+  if(pthread_mutex_lock(&serv->smtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+    return false;
+  }
+  int snum = 0;
+  bool held = false;
+  TTSHMSESS **sp = (TTSHMSESS **)&serv->shms;
+  while(*sp){
+    TTSHMSESS *cur = *sp;
+    if(__atomic_load_n(&cur->done, __ATOMIC_ACQUIRE)){
+      *sp = cur->next;
+      pthread_join(cur->thid, NULL);
+      tcfree(cur);
+    } else {
+      if(cur->cfd == fd) held = true;
+      snum++;
+      sp = &cur->next;
+    }
+  }
+  TTSHMSESS *sess = NULL;
+  bool err = false;
+  if(held){
+    err = true;
+    ttservlog(serv, TTLOGINFO, "the connection already has a shared memory session");
+  } else if(snum >= serv->shmmax){
+    err = true;
+    ttservlog(serv, TTLOGINFO, "too many shared memory sessions");
+  } else {
+    int sfd = dup(fd);
+    TTSHM *shm = (sfd != -1) ? ttshmnew(sfd) : NULL;
+    if(!shm){
+      err = true;
+      ttservlog(serv, TTLOGERROR, (sfd == -1) ? "dup failed" : "ttshmnew failed");
+      if(sfd != -1) close(sfd);
+    } else {
+      sess = tcmalloc(sizeof(*sess));
+      sess->serv = serv;
+      sess->shm = shm;
+      sess->cfd = fd;
+      sess->fd = sfd;
+      sess->done = false;
+      TTREQ *req = &sess->req;
+      memset(req, 0, sizeof(*req));
+      req->serv = serv;
+      req->rct = NULL;
+      req->epfd = -1;
+      req->idx = -1;
+      req->cfd = -1;
+      if(pthread_create(&sess->thid, NULL, ttservshmtask, sess) == 0){
+        snprintf(name, TTADDRBUFSIZ, "%s", shm->name);
+        sess->next = serv->shms;
+        serv->shms = sess;
+        serv->shmnum++;
+      } else {
+        err = true;
+        ttservlog(serv, TTLOGERROR, "pthread_create failed");
+        ttshmdel(shm);
+        close(sfd);
+        tcfree(sess);
+      }
+    }
+  }
+  if(pthread_mutex_unlock(&serv->smtx) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+  }
+  return !err;
+}
+
+
+/* Set the options of a connection of a server object. */
+void ttservsetconnopts(TTSERV *serv, int fd, uint32_t opts){
+  assert(serv);
+  if(fd < 0 || fd >= serv->connmax) return;
+  __atomic_store_n(serv->copts + fd, opts, __ATOMIC_RELAXED);
+}
+
+
+/* Get the options of a connection of a server object. */
+uint32_t ttservconnopts(TTSERV *serv, int fd){
+  assert(serv);
+  if(fd < 0 || fd >= serv->connmax) return 0;
+  return __atomic_load_n(serv->copts + fd, __ATOMIC_RELAXED);
+}
+
+
+/* Set the data of a connection of a server object. */
+bool ttservsetconndata(TTSERV *serv, int fd, void *data){
+  assert(serv);
+  if(fd < 0 || fd >= serv->connmax) return false;
+  void *odata = __atomic_exchange_n(serv->cdats + fd, data, __ATOMIC_ACQ_REL);
+  if(odata && odata != data && serv->do_conndel) serv->do_conndel(odata, serv->opq_conndel);
+  return true;
+}
+
+
+/* Get the data of a connection of a server object. */
+void *ttservconndata(TTSERV *serv, int fd){
+  assert(serv);
+  if(fd < 0 || fd >= serv->connmax) return NULL;
+  return __atomic_load_n(serv->cdats + fd, __ATOMIC_ACQUIRE);
+}
+
+
+/* Call the logging function of a server object. */
+void ttservlog(TTSERV *serv, int level, const char *format, ...){
+  assert(serv && format);
+  if(!serv->do_log) return;
+  char buf[TTIOBUFSIZ];
+  va_list ap;
+  va_start(ap, format);
+  vsnprintf(buf, TTIOBUFSIZ, format, ap);
+  va_end(ap);
+  serv->do_log(level, buf, serv->opq_log);
+}
+
+
+/* Check whether a server object is killed. */
+bool ttserviskilled(TTSERV *serv){
+  assert(serv);
+  return serv->term;
+}
+
+
+/* Register a timer to a server object.
+   `serv' specifies the server object.
+   `wait' specifies the waiting seconds before the first call.
+   `freq' specifies the frequency of execution in seconds.
+   `do_timed' specifies the pointer to a function to do with a event.
+   `opq' specifies the opaque pointer to be passed to the handler.
+   `delay' specifies whether the timer is not started until it is modified.
+   The return value is the timer object. */
+static TTTIMER *ttservtimeradd(TTSERV *serv, double wait, double freq,
+                               void (*do_timed)(void *), void *opq, bool delay){
+  TTTIMER *timer = tcmalloc(sizeof(*timer));
+  timer->serv = serv;
+  timer->freq_timed = freq;
+  timer->do_timed = do_timed;
+  timer->opq_timed = opq;
+  timer->delay = delay;
+  timer->started = !delay;
+  timer->wait = wait;
+  timer->once = freq <= 0.0;
+  timer->state = TTTMIDLE;
+  timer->due = 0.0;
+  timer->tick = 0;
+  timer->next = NULL;
+  if(pthread_mutex_lock(&serv->tmtx) != 0) tcmyfatal("pthread_mutex_lock failed");
+  int num = serv->timernum;
+  if((num & (num - 1)) == 0)
+    serv->timers = tcrealloc(serv->timers, sizeof(*serv->timers) * (num > 0 ? num * 2 : 1));
+  serv->timers[num] = timer;
+  serv->timernum++;
+  if(timer->started && serv->wheel) ttservtimerarm(serv, timer, tctime() + wait);
+  pthread_mutex_unlock(&serv->tmtx);
+  return timer;
+}
+
+
+/* Schedule the next call of a timer.
+   `serv' specifies the server object.
+   `timer' specifies the timer object.
+   `due' specifies the due time of the next call.
+   The mutex of the timers should be locked by the caller.  If the wheel is not running, the
+   timer is scheduled when it starts. */
+static void ttservtimerarm(TTSERV *serv, TTTIMER *timer, double due){
+  timer->due = due;
+  TTWHEEL *wheel = serv->wheel;
+  if(!wheel || timer->state != TTTMIDLE) return;
+  ttwheeladd(wheel, timer);
+  timer->state = TTTMWHEEL;
+  pthread_cond_signal(&serv->tcnd);
+}
+
+
+/* Start the timer wheel of a server object.
+   `serv' specifies the server object.
+   If successful, the return value is true, else, it is false. */
+static bool ttservwheelopen(TTSERV *serv){
+  bool err = false;
+  TTWHEEL *wheel = tcmalloc(sizeof(*wheel));
+  memset(wheel->slots, 0, sizeof(wheel->slots));
+  wheel->tick = 0;
+  wheel->base = tctime();
+  wheel->rhead = NULL;
+  wheel->rtail = NULL;
+  if(pthread_cond_init(&wheel->xcnd, NULL) != 0) tcmyfatal("pthread_cond_init failed");
+  wheel->xnum = 0;
+  wheel->xidle = 0;
+  if(pthread_mutex_lock(&serv->tmtx) != 0) tcmyfatal("pthread_mutex_lock failed");
+  serv->wheel = wheel;
+  double now = tctime();
+  for(int i = 0; i < serv->timernum; i++){
+    TTTIMER *timer = serv->timers[i];
+    if(!timer->delay) timer->started = true;
+    if(!timer->started || timer->state != TTTMIDLE) continue;
+    ttservtimerarm(serv, timer, timer->due > 0.0 ? timer->due : now + timer->wait);
+  }
+  if(pthread_create(&wheel->wthid, NULL, ttservwheel, serv) == 0){
+    ttservlog(serv, TTLOGINFO, "timer thread started");
+  } else {
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_create (ttservwheel) failed");
+  }
+  while(!err && wheel->xnum < TTEXECMIN){
+    if(pthread_create(wheel->xthids + wheel->xnum, NULL, ttservexec, serv) == 0){
+      wheel->xnum++;
+      ttservlog(serv, TTLOGINFO, "executor thread %d started", wheel->xnum);
+    } else {
+      err = true;
+      ttservlog(serv, TTLOGERROR, "pthread_create (ttservexec) failed");
+    }
+  }
+  pthread_mutex_unlock(&serv->tmtx);
+  return !err;
+}
+
+
+/* Stop the timer wheel of a server object.
+   `serv' specifies the server object.
+   If successful, the return value is true, else, it is false.
+   The server should be terminated before calling this function.  Executors running a long
+   handler are waited for. */
+static bool ttservwheelclose(TTSERV *serv){
+  TTWHEEL *wheel = serv->wheel;
+  if(!wheel) return true;
   bool err = false;
+  void *rv;
+  if(pthread_join(wheel->wthid, &rv) == 0){
+    ttservlog(serv, TTLOGINFO, "timer thread finished");
+    if(rv) err = true;
+  } else {
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_join failed");
+  }
+  if(pthread_mutex_lock(&serv->tmtx) != 0) tcmyfatal("pthread_mutex_lock failed");
+  pthread_cond_broadcast(&wheel->xcnd);
+  int xnum = wheel->xnum;
+  pthread_mutex_unlock(&serv->tmtx);
+  for(int i = 0; i < xnum; i++){
+    if(pthread_join(wheel->xthids[i], &rv) == 0){
+      ttservlog(serv, TTLOGINFO, "executor thread %d finished", i + 1);
+      if(rv) err = true;
+    } else {
+      err = true;
+      ttservlog(serv, TTLOGERROR, "pthread_join failed");
+    }
+  }
+  if(pthread_mutex_lock(&serv->tmtx) != 0) tcmyfatal("pthread_mutex_lock failed");
   for(int i = 0; i < serv->timernum; i++){
-    TTTIMER *timer = serv->timers + i;
-    if(!timer->delay){
-        timer->alive = false;
-        timer->serv = serv;
-        timer->started=true;
-        if(pthread_create(&(timer->thid), NULL, ttservtimer, timer) == 0){
-          ttservlog(serv, TTLOGINFO, "timer thread %d started", i + 1);
-          timer->alive = true;
+    TTTIMER *timer = serv->timers[i];
+    if(timer->state != TTTMDONE) timer->state = TTTMIDLE;
+    timer->next = NULL;
+  }
+  serv->wheel = NULL;
+  pthread_mutex_unlock(&serv->tmtx);
+  pthread_cond_destroy(&wheel->xcnd);
+  tcfree(wheel);
+  return !err;
+}
+
+
+/* Drive the timer wheel of a server object.
+   `argp' specifies the server object.
+   The return value is `NULL' on success and other on failure. */
+static void *ttservwheel(void *argp){
+  TTSERV *serv = argp;
+  TTWHEEL *wheel = serv->wheel;
+  bool err = false;
+  if(pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_setcancelstate failed");
+  }
+  if(pthread_mutex_lock(&serv->tmtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+    return "error";
+  }
+  while(!serv->term){
+    double now = tctime();
+    if(now >= wheel->base) ttwheeladvance(wheel, (now - wheel->base) / TTWHEELTICK);
+    if(wheel->rhead){
+      if(wheel->xidle < 1 && wheel->xnum < TTEXECMAX){
+        if(pthread_create(wheel->xthids + wheel->xnum, NULL, ttservexec, serv) == 0){
+          wheel->xnum++;
+          ttservlog(serv, TTLOGINFO, "executor thread %d started", wheel->xnum);
         } else {
-          ttservlog(serv, TTLOGERROR, "pthread_create (ttservtimer) failed");
-          err = true;
+          ttservlog(serv, TTLOGERROR, "pthread_create (ttservexec) failed");
         }
+      }
+      if(pthread_cond_broadcast(&wheel->xcnd) != 0){
+        err = true;
+        ttservlog(serv, TTLOGERROR, "pthread_cond_broadcast failed");
+        break;
+      }
+    }
+    uint64_t next = ttwheelnext(wheel);
+    double dl = now + TTWHEELWAIT;
+    if(next != UINT64_MAX && wheel->base + next * TTWHEELTICK < dl)
+      dl = wheel->base + next * TTWHEELTICK;
+    struct timespec ts;
+    ts.tv_sec = (time_t)dl;
+    ts.tv_nsec = (long)((dl - ts.tv_sec) * 1000000000);
+    if(ts.tv_nsec >= 1000000000){
+      ts.tv_nsec -= 1000000000;
+      ts.tv_sec++;
+    }
+    int code = pthread_cond_timedwait(&serv->tcnd, &serv->tmtx, &ts);
+    if(code != 0 && code != ETIMEDOUT && code != EINTR){
+      err = true;
+      ttservlog(serv, TTLOGERROR, "pthread_cond_timedwait failed");
+      break;
     }
   }
-  int thnum = serv->thnum;
-  TTREQ reqs[thnum];
-  for(int i = 0; i < thnum; i++){
-    reqs[i].alive = true;
-    reqs[i].serv = serv;
-    reqs[i].epfd = epfd;
-    reqs[i].mtime = tctime();
-    reqs[i].keep = false;
-    reqs[i].idx = i;
-    if(pthread_create(&reqs[i].thid, NULL, ttservdeqtasks, reqs + i) == 0){
-      ttservlog(serv, TTLOGINFO, "worker thread %d started", i + 1);
+  pthread_cond_broadcast(&wheel->xcnd);
+  if(pthread_mutex_unlock(&serv->tmtx) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+  }
+  return err ? "error" : NULL;
+}
+
+
+/* Call the timed functions of a server object.
+   `argp' specifies the server object.
+   The return value is `NULL' on success and other on failure. */
+static void *ttservexec(void *argp){
+  TTSERV *serv = argp;
+  TTWHEEL *wheel = serv->wheel;
+  bool err = false;
+  if(pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_setcancelstate failed");
+  }
+  if(pthread_mutex_lock(&serv->tmtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+    return "error";
+  }
+  while(!serv->term){
+    TTTIMER *timer = wheel->rhead;
+    if(!timer){
+      wheel->xidle++;
+      int code = pthread_cond_wait(&wheel->xcnd, &serv->tmtx);
+      wheel->xidle--;
+      if(code != 0){
+        err = true;
+        ttservlog(serv, TTLOGERROR, "pthread_cond_wait failed");
+        break;
+      }
+      continue;
+    }
+    wheel->rhead = timer->next;
+    if(!wheel->rhead) wheel->rtail = NULL;
+    timer->next = NULL;
+    timer->state = TTTMRUN;
+    if(pthread_mutex_unlock(&serv->tmtx) != 0){
+      ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+      return "error";
+    }
+    double stime = tctime();
+    uint64_t jit = stime > timer->due ? (stime - timer->due) * 1000000 : 0;
+    timer->do_timed(timer->opq_timed);
+    if(pthread_mutex_lock(&serv->tmtx) != 0){
+      ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+      return "error";
+    }
+    serv->firenum++;
+    serv->jitsum += jit;
+    if(jit > serv->jitmax) serv->jitmax = jit;
+    if(timer->once){
+      timer->state = TTTMDONE;
     } else {
-      reqs[i].alive = false;
-      err = true;
-      ttservlog(serv, TTLOGERROR, "pthread_create (ttservdeqtasks) failed");
+      timer->state = TTTMIDLE;
+      if(timer->started) ttservtimerarm(serv, timer, tctime() + timer->freq_timed);
+    }
+  }
+  if(pthread_mutex_unlock(&serv->tmtx) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+  }
+  return err ? "error" : NULL;
+}
+
+
+/* Check whether the peer of a connection is on the same host.
+   `fd' specifies the file descriptor of the connection.
+   The return value is true if the peer is connected through a UNIX domain socket or from the
+   loopback address, else, it is false. */
+static bool ttpeerislocal(int fd){
+  struct sockaddr_storage addr;
+  socklen_t alen = sizeof(addr);
+  if(getpeername(fd, (struct sockaddr *)&addr, &alen) != 0) return false;
+  if(addr.ss_family == AF_UNIX) return true;
+  if(addr.ss_family == AF_INET){
+    struct sockaddr_in *sain = (struct sockaddr_in *)&addr;
+    return (ntohl(sain->sin_addr.s_addr) >> 24) == 127;
+  }
+  if(addr.ss_family == AF_INET6){
+    struct in6_addr *ip = &((struct sockaddr_in6 *)&addr)->sin6_addr;
+    return IN6_IS_ADDR_LOOPBACK(ip) || (IN6_IS_ADDR_V4MAPPED(ip) && ip->s6_addr[12] == 127);
+  }
+  return false;
+}
+
+
+/* Serve a shared memory session of a server object.
+   `argp' specifies the session object.
+   The return value is `NULL' on success and other on failure. */
+static void *ttservshmtask(void *argp){
+  TTSHMSESS *sess = argp;
+  TTSERV *serv = sess->serv;
+  TTREQ *req = &sess->req;
+  bool err = false;
+  if(pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_setcancelstate failed");
+  }
+  sigset_t sigset;
+  sigemptyset(&sigset);
+  sigaddset(&sigset, SIGPIPE);
+  if(pthread_sigmask(SIG_BLOCK, &sigset, NULL) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_sigmask failed");
+  }
+  TTSOCK *sock = ttsocknew(sess->fd);
+  ttsocksetshm(sock, sess->shm);
+  ttsocksetcoalesce(sock, true);
+  req->arena = ttarenanew();
+  while(!serv->term){
+    if(sock->ep <= sock->rp){
+      int rv = ttshmwait(sess->shm, TTWAITREQUEST);
+      if(rv < 0) continue;
+      if(rv < 1) break;
+    }
+    ttsocksetlife(sock, serv->timeout > 0 ? serv->timeout : HUGE_VAL);
+    req->mtime = tctime();
+    req->keep = false;
+    ttservtask(sock, req);
+    ttarenareset(req->arena);
+    if(sock->end || !req->keep) break;
+    if(sock->ep <= sock->rp && !ttsockflush(sock)) break;
+  }
+  ttsockflush(sock);
+  ttsockdel(sock);
+  ttarenadel(req->arena);
+  req->arena = NULL;
+  if(close(sess->fd) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "close failed");
+  }
+  __atomic_store_n(&sess->done, true, __ATOMIC_RELEASE);
+  return err ? "error" : NULL;
+}
+
+
+/* Finish all shared memory sessions of a server object.
+   `serv' specifies the server object.
+   Sessions notice the termination flag within the waiting time for requests. */
+static void ttservshmclose(TTSERV *serv){
+  if(pthread_mutex_lock(&serv->smtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+    return;
+  }
+  TTSHMSESS *sess = serv->shms;
+  serv->shms = NULL;
+  if(pthread_mutex_unlock(&serv->smtx) != 0)
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+  int snum = 0;
+  while(sess){
+    TTSHMSESS *next = sess->next;
+    pthread_join(sess->thid, NULL);
+    tcfree(sess);
+    sess = next;
+    snum++;
+  }
+  if(snum > 0) ttservlog(serv, TTLOGINFO, "%d shared memory sessions finished", snum);
+}
+
+
+/* Insert a timer into a timer wheel.
+   `wheel' specifies the timer wheel object.
+   `timer' specifies the timer object whose due time is set. */
+static void ttwheeladd(TTWHEEL *wheel, TTTIMER *timer){
+  double ticks = (timer->due - wheel->base) / TTWHEELTICK;
+  uint64_t expire = ticks > 0.0 ? (uint64_t)ceil(ticks) : 0;
+  if(expire < wheel->tick) expire = wheel->tick;
+  timer->tick = expire;
+  ttwheelput(wheel, timer);
+}
+
+
+/* Put a timer into the slot of a timer wheel according to its tick.
+   `wheel' specifies the timer wheel object.
+   `timer' specifies the timer object.
+   A timer beyond the top level is put into the farthest slot and is cascaded again. */
+static void ttwheelput(TTWHEEL *wheel, TTTIMER *timer){
+  uint64_t expire = timer->tick > wheel->tick ? timer->tick : wheel->tick;
+  uint64_t delta = expire - wheel->tick;
+  uint64_t span = 1ULL << (TTWHEELBITS * TTWHEELLEVEL);
+  if(delta >= span) expire = wheel->tick + span - 1;
+  int level = 0;
+  while(level < TTWHEELLEVEL - 1 && delta >= 1ULL << (TTWHEELBITS * (level + 1))){
+    level++;
+  }
+  int idx = (expire >> (TTWHEELBITS * level)) & (TTWHEELSIZ - 1);
+  timer->next = wheel->slots[level][idx];
+  wheel->slots[level][idx] = timer;
+}
+
+
+/* Get the next tick when a timer wheel has something to do.
+   `wheel' specifies the timer wheel object.
+   The return value is the tick of the next expiration or cascade, or `UINT64_MAX' if the
+   wheel is empty. */
+static uint64_t ttwheelnext(TTWHEEL *wheel){
+  uint64_t next = UINT64_MAX;
+  for(int k = 0; k < TTWHEELSIZ; k++){
+    uint64_t tick = wheel->tick + k;
+    if(wheel->slots[0][tick&(TTWHEELSIZ-1)]){
+      next = tick;
+      break;
+    }
+  }
+  for(int level = 1; level < TTWHEELLEVEL; level++){
+    int shift = TTWHEELBITS * level;
+    uint64_t block = (wheel->tick + (1ULL << shift) - 1) >> shift;
+    for(int k = 0; k < TTWHEELSIZ; k++){
+      uint64_t tick = (block + k) << shift;
+      if(tick >= next) break;
+      if(wheel->slots[level][(block+k)&(TTWHEELSIZ-1)]){
+        next = tick;
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+
+/* Advance a timer wheel and move expired timers to the ready queue.
+   `wheel' specifies the timer wheel object.
+   `now' specifies the current tick. */
+static void ttwheeladvance(TTWHEEL *wheel, uint64_t now){
+  while(wheel->tick <= now){
+    uint64_t next = ttwheelnext(wheel);
+    if(next > now){
+      wheel->tick = now + 1;
+      break;
+    }
+    wheel->tick = next;
+    for(int level = 1; level < TTWHEELLEVEL; level++){
+      int shift = TTWHEELBITS * level;
+      if(next & ((1ULL << shift) - 1)) break;
+      int idx = (next >> shift) & (TTWHEELSIZ - 1);
+      TTTIMER *timer = wheel->slots[level][idx];
+      wheel->slots[level][idx] = NULL;
+      while(timer){
+        TTTIMER *tnext = timer->next;
+        ttwheelput(wheel, timer);
+        timer = tnext;
+      }
+    }
+    int idx = next & (TTWHEELSIZ - 1);
+    TTTIMER *timer = wheel->slots[0][idx];
+    wheel->slots[0][idx] = NULL;
+    while(timer){
+      TTTIMER *tnext = timer->next;
+      timer->next = NULL;
+      if(timer->started){
+        timer->state = TTTMREADY;
+        if(wheel->rtail){
+          wheel->rtail->next = timer;
+        } else {
+          wheel->rhead = timer;
+        }
+        wheel->rtail = timer;
+      } else {
+        timer->state = TTTMIDLE;
+      }
+      timer = tnext;
+    }
+    wheel->tick = next + 1;
+  }
+}
+
+
+/* Call the task function of a server object.
+   `req' specifies the request object.
+   `sock' specifies the socket object. */
+static void ttservtask(TTSOCK *sock, TTREQ *req){
+  TTSERV *serv = req->serv;
+  if(!serv->do_task) return;
+  serv->do_task(sock, serv->opq_task, req);
+}
+
+
+/* Dequeue tasks of a server object and dispatch them.
+   `argp' specifies the argument structure of the server object.
+   The return value is `NULL' on success and other on failure. */
+static void *ttservdeqtasks(void *argp){
+  TTREQ *req = argp;
+  TTSERV *serv = req->serv;
+  TTREACTOR *rct = req->rct;
+  bool err = false;
+  if(pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_setcancelstate failed");
+  }
+  sigset_t sigset;
+  sigemptyset(&sigset);
+  sigaddset(&sigset, SIGPIPE);
+  sigset_t oldsigset;
+  sigemptyset(&sigset);
+  if(pthread_sigmask(SIG_BLOCK, &sigset, &oldsigset) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_sigmask failed");
+  }
+  bool elastic = rct->wmax > rct->wmin;
+  double itime = tctime();
+  req->arena = ttarenanew();
+  pthread_cleanup_push((void (*)(void *))ttarenadel, req->arena);
+  while(!serv->term){
+    uint32_t seq = __atomic_load_n(&rct->qseq, __ATOMIC_SEQ_CST);
+    double etime;
+    int cfd = ttservdequeue(rct->qslots, &rct->qhead, &etime);
+    if(cfd != -1){
+      itime = tctime();
+      uint64_t wait = itime > etime ? (itime - etime) * 1000000 : 0;
+      __atomic_add_fetch(&serv->waitnum, 1, __ATOMIC_RELAXED);
+      __atomic_add_fetch(&serv->waitsum, wait, __ATOMIC_RELAXED);
+      uint64_t max = __atomic_load_n(&serv->waitmax, __ATOMIC_RELAXED);
+      while(wait > max && !__atomic_compare_exchange_n(&serv->waitmax, &max, wait, true,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+      if(elastic) __atomic_store_n(&rct->lastwait, wait, __ATOMIC_RELAXED);
+      if(serv->qhigh > 0){
+        int depth = (int32_t)(__atomic_load_n(&rct->qtail, __ATOMIC_ACQUIRE) -
+                              __atomic_load_n(&rct->qhead, __ATOMIC_ACQUIRE));
+        if(depth >= serv->qhigh){
+          __atomic_store_n(&rct->qshed, 1, __ATOMIC_RELAXED);
+        } else if(depth <= serv->qlow){
+          __atomic_store_n(&rct->qshed, 0, __ATOMIC_RELAXED);
+        }
+        req->shed = __atomic_load_n(&rct->qshed, __ATOMIC_RELAXED) != 0;
+      }
+      TTPART **partp = (serv->do_frame && cfd < serv->connmax) ? serv->parts + cfd : NULL;
+      req->cfd = cfd;
+      pthread_cleanup_push((void (*)(void *))close, (void *)(intptr_t)cfd);
+      pthread_cleanup_push((void (*)(void *))ttservconndrop, req);
+      TTSOCK *sock = ttsocknew(cfd);
+      pthread_cleanup_push((void (*)(void *))ttsockdel, sock);
+      ttsocksetcoalesce(sock, true);
+      int ready = partp ? ttservgather(serv, sock) : 1;
+      if(ready > 0){
+        bool reuse;
+        do {
+          if(serv->timeout > 0) ttsocksetlife(sock, serv->timeout);
+          req->mtime = tctime();
+          req->keep = false;
+          ttservtask(sock, req);
+          ttarenareset(req->arena);
+          reuse = false;
+          if(sock->end){
+            req->keep = false;
+          } else if(sock->ep > sock->rp){
+            int fsiz = partp ? serv->do_frame(sock->rp, sock->ep - sock->rp, serv->opq_frame) : 1;
+            if(fsiz == -2){
+              ttservlog(serv, TTLOGINFO, "too large request rejected");
+              req->keep = false;
+            } else {
+              reuse = fsiz != 0;
+            }
+          }
+        } while(reuse);
+        if(!ttsockflush(sock)) req->keep = false;
+        if(partp && req->keep) ttservpartkeep(partp, sock);
+      } else {
+        req->keep = ready == 0;
+      }
+      pthread_cleanup_pop(1);
+      pthread_cleanup_pop(0);
+      pthread_cleanup_pop(0);
+      if(req->keep){
+        if(!ttservrearm(rct, cfd)){
+          ttservconndrop(req);
+          close(cfd);
+          err = true;
+        }
+      } else {
+        ttservconndrop(req);
+        if(!rct->uring){
+          __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
+          if(epoll_ctl(req->epfd, EPOLL_CTL_DEL, cfd, NULL) != 0){
+            err = true;
+            ttservlog(serv, TTLOGERROR, "epoll_ctl failed");
+          }
+        }
+        if(!ttclosesock(cfd)){
+          err = true;
+          ttservlog(serv, TTLOGERROR, "close failed");
+        }
+        ttservlog(serv, TTLOGINFO, "connection finished");
+      }
+      req->cfd = -1;
+    } else {
+      if(!ttservqpark(rct, seq, TTWAITREQUEST)) err = true;
+      if(elastic && tctime() - itime > serv->idletime && ttservretire(rct)){
+        ttservlog(serv, TTLOGINFO, "worker thread %d retired", req->idx + 1);
+        __atomic_store_n(&req->retired, true, __ATOMIC_RELEASE);
+        break;
+      }
     }
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    pthread_testcancel();
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    req->mtime = tctime();
+  }
+  pthread_cleanup_pop(1);
+  req->arena = NULL;
+  if(pthread_sigmask(SIG_SETMASK, &oldsigset, NULL) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_sigmask failed");
   }
+  __atomic_store_n(&req->done, true, __ATOMIC_RELEASE);
+  return err ? "error" : NULL;
+}
+
+
+/* Accept connections and dispatch ready requests to the workers of a reactor.
+   `argp' specifies the reactor object.
+   The return value is `NULL' on success and other on failure. */
+static void *ttservreactor(void *argp){
+  TTREACTOR *rct = argp;
+  TTSERV *serv = rct->serv;
+#if defined(TTUSEURING)
+  if(rct->uring) return ttservreactoruring(rct) ? NULL : "error";
+#endif
+  int lfd = rct->lfd;
+  int epfd = rct->epfd;
+  bool err = false;
   struct epoll_event ev;
   memset(&ev, 0, sizeof(ev));
   ev.events = EPOLLIN;
   ev.data.fd = lfd;
-  if(epoll_ctl(epfd, EPOLL_CTL_ADD, lfd, &ev) != 0){
+  if(epoll_ctl(epfd, EPOLL_CTL_ADD, lfd, &ev) != 0 && errno != EEXIST){
     err = true;
     ttservlog(serv, TTLOGERROR, "epoll_ctl failed");
   }
-  ttservlog(serv, TTLOGSYSTEM, "listening started");
   while(!serv->term){
     struct epoll_event events[TTEVENTMAX];
+    __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
     int fdnum = epoll_wait(epfd, events, TTEVENTMAX, TTWAITREQUEST);
     if(fdnum != -1){
       for(int i = 0; i < fdnum; i++){
@@ -1059,6 +3537,7 @@ bool ttservstart(TTSERV *serv){
           char addr[TTADDRBUFSIZ];
           int port;
           int cfd;
+          __atomic_add_fetch(&serv->evsysnum, 2, __ATOMIC_RELAXED);  // accept and registration
           if(serv->port < 1){
             cfd = ttacceptsockunix(lfd);
             sprintf(addr, "(unix)");
@@ -1076,7 +3555,9 @@ bool ttservstart(TTSERV *serv){
             memset(&ev, 0, sizeof(ev));
             ev.events = EPOLLIN | EPOLLONESHOT;
             ev.data.fd = cfd;
+            ttservconnmark(serv, cfd, true);
             if(epoll_ctl(epfd, EPOLL_CTL_ADD, cfd, &ev) != 0){
+              ttservconnmark(serv, cfd, false);
               close(cfd);
               err = true;
               ttservlog(serv, TTLOGERROR, "epoll_ctl failed");
@@ -1087,20 +3568,13 @@ bool ttservstart(TTSERV *serv){
           }
         } else {
           int cfd = events[i].data.fd;
-          if(pthread_mutex_lock(&serv->qmtx) == 0){
-            tclistpush(serv->queue, &cfd, sizeof(cfd));
-            if(pthread_mutex_unlock(&serv->qmtx) != 0){
-              err = true;
-              ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
-            }
-            if(pthread_cond_signal(&serv->qcnd) != 0){
-              err = true;
-              ttservlog(serv, TTLOGERROR, "pthread_cond_signal failed");
-            }
-          } else {
-            err = true;
-            ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+          bool queued;
+          while(!(queued = ttservenqueue(rct->qslots, &rct->qtail, cfd)) && !serv->term){
+            if(!ttservqwake(rct, true)) err = true;
+            sched_yield();
           }
+          if(!queued) ttservabandon(rct, cfd);
+          if(!ttservqwake(rct, false)) err = true;
         }
       }
     } else {
@@ -1111,291 +3585,929 @@ bool ttservstart(TTSERV *serv){
         ttservlog(serv, TTLOGERROR, "epoll_wait failed");
       }
     }
-    if(serv->timeout > 0){
-      double ctime = tctime();
-      for(int i = 0; i < thnum; i++){
-        double itime = ctime - reqs[i].mtime;
-        if(itime > serv->timeout + TTWAITREQUEST / 1000.0 + SOCKRCVTIMEO + SOCKSNDTIMEO &&
-           pthread_cancel(reqs[i].thid) == 0){
-          ttservlog(serv, TTLOGINFO, "worker thread %d canceled by timeout", i + 1);
-          void *rv;
-          if(pthread_join(reqs[i].thid, &rv) == 0){
-            if(rv && rv != PTHREAD_CANCELED) err = true;
-            reqs[i].mtime = tctime();
-            if(pthread_create(&reqs[i].thid, NULL, ttservdeqtasks, reqs + i) != 0){
-              reqs[i].alive = false;
-              err = true;
-              ttservlog(serv, TTLOGERROR, "pthread_create (ttservdeqtasks) failed");
-            } else {
-              ttservlog(serv, TTLOGINFO, "worker thread %d started", i + 1);
-            }
-          } else {
+    if(!ttservsweep(rct)) err = true;
+  }
+  return err ? "error" : NULL;
+}
+
+
+/* Pass a keep-alive connection back to a reactor to wait for the next request.
+   `rct' specifies the reactor object.
+   `fd' specifies the file descriptor of the connection.
+   If successful, the return value is true, else, it is false. */
+static bool ttservrearm(TTREACTOR *rct, int fd){
+  TTSERV *serv = rct->serv;
+#if defined(TTUSEURING)
+  if(rct->uring){
+    while(!ttservenqueue(rct->rslots, &rct->rtail, fd)){
+      if(serv->term) return false;
+      sched_yield();
+    }
+    if(__atomic_exchange_n(&rct->rsleep, 0, __ATOMIC_SEQ_CST) != 0){
+      uint64_t num = 1;
+      __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
+      if(write(rct->evfd, &num, sizeof(num)) == -1 && errno != EAGAIN)
+        ttservlog(serv, TTLOGERROR, "write failed");
+    }
+    return true;
+  }
+#endif
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ev.data.fd = fd;
+  __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
+  if(epoll_ctl(rct->epfd, EPOLL_CTL_MOD, fd, &ev) != 0){
+    ttservlog(serv, TTLOGERROR, "epoll_ctl failed");
+    return false;
+  }
+  return true;
+}
+
+
+/* Give up a ready connection which cannot be queued because a server is terminating.
+   `rct' specifies the reactor object.
+   `fd' specifies the file descriptor of the connection.
+   If the descriptors are held for the restart, the connection is watched again by the reactor
+   so that it is served after the restart.  Otherwise, it is closed. */
+static void ttservabandon(TTREACTOR *rct, int fd){
+  TTSERV *serv = rct->serv;
+  if(serv->hold){
+    bool ok = false;
+    if(rct->uring){
+#if defined(TTUSEURING)
+      ok = tturingpoll(rct->uring, serv, fd, TTURPOLL, false);
+#endif
+    } else {
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN | EPOLLONESHOT;
+      ev.data.fd = fd;
+      __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
+      ok = epoll_ctl(rct->epfd, EPOLL_CTL_MOD, fd, &ev) == 0;
+    }
+    if(ok) return;
+  }
+  if(!rct->uring){
+    __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
+    epoll_ctl(rct->epfd, EPOLL_CTL_DEL, fd, NULL);
+  }
+  ttservconnmark(serv, fd, false);
+  ttservpartdel(fd < serv->connmax ? serv->parts + fd : NULL);
+  if(!ttclosesock(fd)) ttservlog(serv, TTLOGERROR, "close failed");
+  ttservlog(serv, TTLOGINFO, "connection closed by termination");
+}
+
+
+/* Spawn, retire, and cancel the workers of a reactor as needed.
+   `rct' specifies the reactor object.
+   If successful, the return value is true, else, it is false. */
+static bool ttservsweep(TTREACTOR *rct){
+  TTSERV *serv = rct->serv;
+  bool err = false;
+  if(rct->wmax > rct->wmin) ttservspawn(rct);
+  if(serv->timeout > 0){
+    TTREQ *reqs = rct->reqs;
+    double ctime = tctime();
+    for(int i = rct->idx; i < rct->thnum; i += rct->rnum){
+      if(!reqs[i].alive || __atomic_load_n(&reqs[i].retired, __ATOMIC_ACQUIRE)) continue;
+      double itime = ctime - reqs[i].mtime;
+      if(itime > serv->timeout + TTWAITREQUEST / 1000.0 + SOCKRCVTIMEO + SOCKSNDTIMEO &&
+         pthread_cancel(reqs[i].thid) == 0){
+        ttservlog(serv, TTLOGINFO, "worker thread %d canceled by timeout", i + 1);
+        void *rv;
+        if(pthread_join(reqs[i].thid, &rv) == 0){
+          if(rv && rv != PTHREAD_CANCELED) err = true;
+          reqs[i].mtime = tctime();
+          reqs[i].cfd = -1;
+          reqs[i].done = false;
+          if(pthread_create(&reqs[i].thid, NULL, ttservdeqtasks, reqs + i) != 0){
             reqs[i].alive = false;
             err = true;
-            ttservlog(serv, TTLOGERROR, "pthread_join failed");
+            ttservlog(serv, TTLOGERROR, "pthread_create (ttservdeqtasks) failed");
+          } else {
+            ttservlog(serv, TTLOGINFO, "worker thread %d started", i + 1);
           }
+        } else {
+          reqs[i].alive = false;
+          err = true;
+          ttservlog(serv, TTLOGERROR, "pthread_join failed");
         }
       }
     }
   }
-  ttservlog(serv, TTLOGSYSTEM, "listening finished");
-  if(pthread_cond_broadcast(&serv->qcnd) != 0){
-    err = true;
-    ttservlog(serv, TTLOGERROR, "pthread_cond_broadcast failed");
+  return !err;
+}
+
+
+/* Receive the data of a connection without blocking until a whole request arrives.
+   `serv' specifies the server object.
+   `sock' specifies the socket object of the connection.
+   The return value is 1 if a request is ready in the reading buffer of the socket, 0 if more
+   data is needed, or -1 if the connection should be closed.
+   Incomplete data is kept in the partial request of the connection until the next call.  It is
+   discarded if the request is too large or is not completed in time. */
+static int ttservgather(TTSERV *serv, TTSOCK *sock){
+  int fd = sock->fd;
+  TTPART *part = serv->parts[fd];
+  if(!part){
+    int rv;
+    do {
+      rv = recv(fd, sock->buf, TTIOBUFSIZ, MSG_DONTWAIT);
+    } while(rv == -1 && errno == EINTR);
+    if(rv < 1) return (rv == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 0 : -1;
+    sock->ep = sock->buf + rv;
+    int fsiz = serv->do_frame(sock->buf, rv, serv->opq_frame);
+    if(fsiz == -2){
+      ttservlog(serv, TTLOGINFO, "too large request rejected");
+      return -1;
+    }
+    if(fsiz != 0) return 1;
+    part = tcmalloc(sizeof(*part));
+    part->asiz = TTIOBUFSIZ * 2;
+    part->buf = tcmalloc(part->asiz);
+    memcpy(part->buf, sock->buf, rv);
+    part->size = rv;
+    part->stime = tctime();
+    serv->parts[fd] = part;
+    sock->ep = sock->buf;
+  }
+  while(true){
+    if(part->size >= part->asiz){
+      part->asiz *= 2;
+      part->buf = tcrealloc(part->buf, part->asiz);
+    }
+    int rv = recv(fd, part->buf + part->size, part->asiz - part->size, MSG_DONTWAIT);
+    if(rv > 0){
+      part->size += rv;
+      int fsiz = serv->do_frame(part->buf, part->size, serv->opq_frame);
+      if(fsiz == -2){
+        ttservlog(serv, TTLOGINFO, "too large request rejected");
+        return -1;
+      }
+      if(fsiz != 0){
+        sock->bp = part->buf;
+        sock->rp = part->buf;
+        sock->ep = part->buf + part->size;
+        return 1;
+      }
+    } else if(rv == 0){
+      return -1;
+    } else if(errno == EAGAIN || errno == EWOULDBLOCK){
+      break;
+    } else if(errno != EINTR){
+      return -1;
+    }
+  }
+  double wait = serv->timeout > 0 ? serv->timeout : TTDEFPARTWAIT;
+  if(tctime() - part->stime > wait){
+    ttservlog(serv, TTLOGINFO, "partial request timed out");
+    return -1;
   }
-  if(pthread_cond_broadcast(&serv->tcnd) != 0){
-    err = true;
-    ttservlog(serv, TTLOGERROR, "pthread_cond_broadcast failed");
+  __atomic_add_fetch(&serv->defernum, 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+
+/* Keep the unprocessed data of a socket as the partial request of the connection.
+   `partp' specifies the pointer to the variable of the partial request.
+   `sock' specifies the socket object of the connection. */
+static void ttservpartkeep(TTPART **partp, TTSOCK *sock){
+  int size = sock->end ? 0 : sock->ep - sock->rp;
+  TTPART *part = NULL;
+  if(size > 0){
+    part = tcmalloc(sizeof(*part));
+    part->asiz = tclmax(size, TTIOBUFSIZ);
+    part->buf = tcmalloc(part->asiz);
+    memcpy(part->buf, sock->rp, size);
+    part->size = size;
+    part->stime = tctime();
   }
-  usleep(TTWAITWORKER * 1000);
-  for(int i = 0; i < thnum; i++){
-    if(!reqs[i].alive) continue;
-    if(pthread_cancel(reqs[i].thid) == 0)
-      ttservlog(serv, TTLOGINFO, "worker thread %d was canceled", i + 1);
-    void *rv;
-    if(pthread_join(reqs[i].thid, &rv) == 0){
-      ttservlog(serv, TTLOGINFO, "worker thread %d finished", i + 1);
-      if(rv && rv != PTHREAD_CANCELED) err = true;
-    } else {
+  ttservpartdel(partp);
+  *partp = part;
+}
+
+
+/* Delete the partial request of a connection.
+   `partp' specifies the pointer to the variable of the partial request.  If it is `NULL', this
+   function has no effect. */
+static void ttservpartdel(TTPART **partp){
+  if(!partp || !*partp) return;
+  tcfree((*partp)->buf);
+  tcfree(*partp);
+  *partp = NULL;
+}
+
+
+/* Prepare the tables of connections of a server object.
+   `serv' specifies the server object.  If the tables exist already, this function has no
+   effect. */
+static void ttservconnopen(TTSERV *serv){
+  if(serv->conns) return;
+  struct rlimit rlbuf;
+  int connmax = TTCONNSLOTMAX;
+  if(getrlimit(RLIMIT_NOFILE, &rlbuf) == 0 && rlbuf.rlim_cur != RLIM_INFINITY &&
+     rlbuf.rlim_cur < connmax) connmax = rlbuf.rlim_cur;
+  serv->conns = tcmalloc(sizeof(*serv->conns) * connmax);
+  memset(serv->conns, 0, sizeof(*serv->conns) * connmax);
+  serv->copts = tcmalloc(sizeof(*serv->copts) * connmax);
+  memset(serv->copts, 0, sizeof(*serv->copts) * connmax);
+  serv->cdats = tcmalloc(sizeof(*serv->cdats) * connmax);
+  for(int i = 0; i < connmax; i++){
+    serv->cdats[i] = NULL;
+  }
+  serv->parts = tcmalloc(sizeof(*serv->parts) * connmax);
+  for(int i = 0; i < connmax; i++){
+    serv->parts[i] = NULL;
+  }
+  serv->connmax = connmax;
+}
+
+
+/* Mark a connection of a server object as open or closed.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the connection.
+   `on' specifies whether the connection is open. */
+static void ttservconnmark(TTSERV *serv, int fd, bool on){
+  if(fd < 0 || fd >= serv->connmax) return;
+  __atomic_store_n(serv->copts + fd, 0, __ATOMIC_RELAXED);
+  ttservconnrelease(serv, fd);
+  __atomic_store_n(serv->conns + fd, on ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+
+/* Forget the current connection of a worker before it is closed.
+   `req' specifies the request object of the worker. */
+static void ttservconndrop(TTREQ *req){
+  TTSERV *serv = req->serv;
+  int fd = req->cfd;
+  if(fd < 0 || fd >= serv->connmax) return;
+  ttservconnmark(serv, fd, false);
+  ttservpartdel(serv->parts + fd);
+}
+
+
+/* Release the data of a connection of a server object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the connection. */
+static void ttservconnrelease(TTSERV *serv, int fd){
+  void *data = __atomic_exchange_n(serv->cdats + fd, NULL, __ATOMIC_ACQ_REL);
+  if(data && serv->do_conndel) serv->do_conndel(data, serv->opq_conndel);
+}
+
+
+/* Close the reactors and the connections of a server object.
+   `serv' specifies the server object.
+   `rcts' specifies the array of the reactor objects.  It is released.  If it is `NULL', only
+   the connections are closed.
+   `rnum' specifies the number of the reactor objects.
+   If successful, the return value is true, else, it is false. */
+static bool ttservrelease(TTSERV *serv, TTREACTOR *rcts, int rnum){
+  bool err = false;
+  for(int i = 0; rcts && i < rnum; i++){
+    TTREACTOR *rct = rcts + i;
+#if defined(TTUSEURING)
+    if(rct->uring) tturingdel(rct->uring);
+#endif
+    if(rct->evfd != -1 && close(rct->evfd) != 0){
       err = true;
-      ttservlog(serv, TTLOGERROR, "pthread_join failed");
+      ttservlog(serv, TTLOGERROR, "close failed");
     }
-  }
-  if(tclistnum(serv->queue) > 0)
-    ttservlog(serv, TTLOGINFO, "%d requests discarded", tclistnum(serv->queue));
-  tclistclear(serv->queue);
-  for(int i = 0; i < serv->timernum; i++){
-    TTTIMER *timer = serv->timers + i;
-    if(!timer->alive) continue;
-    void *rv;
-    if(pthread_cancel(timer->thid) == 0)
-      ttservlog(serv, TTLOGINFO, "timer thread %d was canceled", i + 1);
-    if(pthread_join(timer->thid, &rv) == 0){
-      ttservlog(serv, TTLOGINFO, "timer thread %d finished", i + 1);
-      if(rv && rv != PTHREAD_CANCELED) err = true;
-    } else {
+    if(rct->epfd != -1 && epoll_close(rct->epfd) != 0){
       err = true;
-      ttservlog(serv, TTLOGERROR, "pthread_join failed");
+      ttservlog(serv, TTLOGERROR, "epoll_close failed");
+    }
+    if(rct->lfd != -1 && close(rct->lfd) != 0){
+      err = true;
+      ttservlog(serv, TTLOGERROR, "close failed");
     }
+    pthread_cond_destroy(&rct->qcnd);
+    pthread_mutex_destroy(&rct->qmtx);
+    tcfree(rct->rslots);
+    tcfree(rct->qslots);
   }
-  if(epoll_close(epfd) != 0){
-    err = true;
-    ttservlog(serv, TTLOGERROR, "epoll_close failed");
+  if(rcts){
+    tcfree(rcts);
+    if(rcts == serv->rcts){
+      serv->rcts = NULL;
+      serv->rctnum = 0;
+    }
   }
-  if(serv->port < 1 && unlink(serv->host) == -1){
-    err = true;
-    ttservlog(serv, TTLOGERROR, "unlink failed");
+  for(int i = 0; i < serv->lfdnum; i++){
+    if(serv->lfds[i] != -1) close(serv->lfds[i]);
   }
-  if(close(lfd) != 0){
-    err = true;
-    ttservlog(serv, TTLOGERROR, "close failed");
+  tcfree(serv->lfds);
+  serv->lfds = NULL;
+  serv->lfdnum = 0;
+  tcfree(serv->cfds);
+  serv->cfds = NULL;
+  serv->cfdnum = 0;
+  int cnum = 0;
+  for(int i = 0; i < serv->connmax; i++){
+    if(serv->conns[i]){
+      close(i);
+      cnum++;
+    }
+    ttservconnrelease(serv, i);
+    ttservpartdel(serv->parts + i);
   }
-  ttservlog(serv, TTLOGSYSTEM, "service finished");
-  serv->term = false;
+  if(cnum > 0) ttservlog(serv, TTLOGINFO, "%d connections closed", cnum);
+  tcfree(serv->parts);
+  tcfree(serv->cdats);
+  tcfree(serv->copts);
+  tcfree(serv->conns);
+  serv->parts = NULL;
+  serv->cdats = NULL;
+  serv->copts = NULL;
+  serv->conns = NULL;
+  serv->connmax = 0;
   return !err;
 }
 
 
-/* Send the terminate signal to a server object. */
-bool ttservkill(TTSERV *serv){
-  assert(serv);
-  serv->term = true;
-  return true;
+/* Send data with a file descriptor through a UNIX domain socket.
+   `sfd' specifies the file descriptor of the socket.
+   `fd' specifies the file descriptor to be sent.  If it is negative, no descriptor is sent.
+   `buf' specifies the pointer to the region of the data.
+   `size' specifies the size of the region.  It should be more than 0.
+   If successful, the return value is true, else, it is false. */
+static bool ttsendfd(int sfd, int fd, const void *buf, int size){
+  struct iovec iov;
+  iov.iov_base = (void *)buf;
+  iov.iov_len = size;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  char cbuf[CMSG_SPACE(sizeof(int))];
+  if(fd >= 0){
+    memset(cbuf, 0, sizeof(cbuf));
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  }
+  int rv;
+  do {
+    rv = sendmsg(sfd, &msg, 0);
+  } while(rv == -1 && errno == EINTR);
+  if(rv < 1) return false;
+  return rv >= size || tcwrite(sfd, (char *)buf + rv, size - rv);
 }
 
 
-/* Call the logging function of a server object. */
-void ttservlog(TTSERV *serv, int level, const char *format, ...){
-  assert(serv && format);
-  if(!serv->do_log) return;
-  char buf[TTIOBUFSIZ];
-  va_list ap;
-  va_start(ap, format);
-  vsnprintf(buf, TTIOBUFSIZ, format, ap);
-  va_end(ap);
-  serv->do_log(level, buf, serv->opq_log);
+/* Receive data with a file descriptor through a UNIX domain socket.
+   `sfd' specifies the file descriptor of the socket.
+   `fdp' specifies the pointer to the variable into which the received file descriptor is
+   assigned.  If no descriptor is received, -1 is assigned.
+   `buf' specifies the pointer to the region into which the data is written.
+   `size' specifies the size of the data to be received.  It should be more than 0.
+   If successful, the return value is true, else, it is false. */
+static bool ttrecvfd(int sfd, int *fdp, void *buf, int size){
+  *fdp = -1;
+  struct iovec iov;
+  iov.iov_base = buf;
+  iov.iov_len = size;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  char cbuf[CMSG_SPACE(sizeof(int))];
+  memset(cbuf, 0, sizeof(cbuf));
+  msg.msg_control = cbuf;
+  msg.msg_controllen = sizeof(cbuf);
+  int rv;
+  do {
+    rv = recvmsg(sfd, &msg, 0);
+  } while(rv == -1 && errno == EINTR);
+  if(rv < 1) return false;
+  for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+    if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+       cmsg->cmsg_len >= CMSG_LEN(sizeof(int))) memcpy(fdp, CMSG_DATA(cmsg), sizeof(int));
+  }
+  return rv >= size || tcread(sfd, (char *)buf + rv, size - rv);
 }
 
 
-/* Check whether a server object is killed. */
-bool ttserviskilled(TTSERV *serv){
-  assert(serv);
-  return serv->term;
+/* Add a file descriptor to a queue of a reactor.
+   `slots' specifies the ring of slots of the queue.
+   `tailp' specifies the pointer to the enqueue position of the queue.
+   `fd' specifies the file descriptor.
+   If successful, the return value is true, else, it is false because the queue is full.
+   The queue is a bounded ring with a sequence number per slot so that the listener and the
+   workers can pass descriptors without a lock nor any allocation. */
+static bool ttservenqueue(TTQSLOT *slots, uint32_t *tailp, int fd){
+  uint32_t pos = __atomic_load_n(tailp, __ATOMIC_RELAXED);
+  while(true){
+    TTQSLOT *slot = slots + (pos & (TTQUEUESIZ - 1));
+    uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    int32_t dif = (int32_t)(seq - pos);
+    if(dif == 0){
+      if(__atomic_compare_exchange_n(tailp, &pos, pos + 1, true,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+        slot->fd = fd;
+        slot->etime = tctime();
+        __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+        return true;
+      }
+    } else if(dif < 0){
+      return false;
+    } else {
+      pos = __atomic_load_n(tailp, __ATOMIC_RELAXED);
+    }
+  }
+  return false;
 }
 
 
-/* Call the timed function of a server object.
-   `argp' specifies the argument structure of the server object.
-   The return value is `NULL' on success and other on failure. */
-static void *ttservtimer(void *argp){
-  TTTIMER *timer = argp;
-  TTSERV *serv = timer->serv;
+/* Remove a file descriptor from a queue of a reactor.
+   `slots' specifies the ring of slots of the queue.
+   `headp' specifies the pointer to the dequeue position of the queue.
+   `etp' specifies the pointer to the variable into which the enqueued time is assigned.  If it
+   is `NULL', it is not used.
+   The return value is the file descriptor or -1 if the queue is empty. */
+static int ttservdequeue(TTQSLOT *slots, uint32_t *headp, double *etp){
+  uint32_t pos = __atomic_load_n(headp, __ATOMIC_RELAXED);
+  while(true){
+    TTQSLOT *slot = slots + (pos & (TTQUEUESIZ - 1));
+    uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    int32_t dif = (int32_t)(seq - (pos + 1));
+    if(dif == 0){
+      if(__atomic_compare_exchange_n(headp, &pos, pos + 1, true,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+        int fd = slot->fd;
+        if(etp) *etp = slot->etime;
+        __atomic_store_n(&slot->seq, pos + TTQUEUESIZ, __ATOMIC_RELEASE);
+        return fd;
+      }
+    } else if(dif < 0){
+      return -1;
+    } else {
+      pos = __atomic_load_n(headp, __ATOMIC_RELAXED);
+    }
+  }
+  return -1;
+}
+
+
+/* Join retired workers and spawn a worker if requests wait too long in a reactor.
+   `rct' specifies the reactor object. */
+static void ttservspawn(TTREACTOR *rct){
+  TTSERV *serv = rct->serv;
+  TTREQ *reqs = rct->reqs;
+  int fidx = -1;
+  for(int i = rct->idx; i < rct->thnum; i += rct->rnum){
+    TTREQ *req = reqs + i;
+    if(req->alive && __atomic_load_n(&req->retired, __ATOMIC_ACQUIRE)){
+      void *rv;
+      if(pthread_join(req->thid, &rv) == 0){
+        ttservlog(serv, TTLOGINFO, "worker thread %d finished", i + 1);
+      } else {
+        ttservlog(serv, TTLOGERROR, "pthread_join failed");
+      }
+      req->alive = false;
+      req->retired = false;
+      __atomic_add_fetch(&serv->retirenum, 1, __ATOMIC_RELAXED);
+    }
+    if(!req->alive && fidx < 0) fidx = i;
+  }
+  uint64_t wait = __atomic_load_n(&rct->lastwait, __ATOMIC_RELAXED);
+  if(fidx < 0 || wait < serv->spawnwait * 1000000 ||
+     __atomic_load_n(&rct->qidle, __ATOMIC_SEQ_CST) > 0 ||
+     __atomic_load_n(&rct->wnum, __ATOMIC_SEQ_CST) >= rct->wmax) return;
+  __atomic_store_n(&rct->lastwait, 0, __ATOMIC_RELAXED);
+  TTREQ *req = reqs + fidx;
+  req->mtime = tctime();
+  req->keep = false;
+  req->retired = false;
+  req->cfd = -1;
+  req->done = false;
+  __atomic_add_fetch(&rct->wnum, 1, __ATOMIC_SEQ_CST);
+  if(pthread_create(&req->thid, NULL, ttservdeqtasks, req) == 0){
+    req->alive = true;
+    __atomic_add_fetch(&serv->thcur, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&serv->spawnnum, 1, __ATOMIC_RELAXED);
+    ttservlog(serv, TTLOGINFO, "worker thread %d spawned", fidx + 1);
+  } else {
+    __atomic_sub_fetch(&rct->wnum, 1, __ATOMIC_SEQ_CST);
+    ttservlog(serv, TTLOGERROR, "pthread_create (ttservdeqtasks) failed");
+  }
+}
+
+
+/* Check whether the calling worker of a reactor can retire.
+   `rct' specifies the reactor object.
+   If the worker can retire, the return value is true, else, it is false.  The number of the
+   running workers is decremented if so but is never less than the minimum. */
+static bool ttservretire(TTREACTOR *rct){
+  int wnum = __atomic_load_n(&rct->wnum, __ATOMIC_SEQ_CST);
+  while(wnum > rct->wmin){
+    if(__atomic_compare_exchange_n(&rct->wnum, &wnum, wnum - 1, true,
+                                   __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)){
+      __atomic_sub_fetch(&rct->serv->thcur, 1, __ATOMIC_RELAXED);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/* Wake up workers parked on the request queue of a reactor.
+   `rct' specifies the reactor object.
+   `all' specifies whether every worker is waked up or only one.
+   If successful, the return value is true, else, it is false. */
+static bool ttservqwake(TTREACTOR *rct, bool all){
+  TTSERV *serv = rct->serv;
+  __atomic_add_fetch(&rct->qseq, 1, __ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&rct->qidle, __ATOMIC_SEQ_CST) < 1) return true;
+#if defined(TTUSEFUTEX)
+  if(syscall(SYS_futex, &rct->qseq, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1,
+             NULL, NULL, 0) == -1){
+    ttservlog(serv, TTLOGERROR, "futex failed");
+    return false;
+  }
+#else
+  if(pthread_mutex_lock(&rct->qmtx) != 0){
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+    return false;
+  }
   bool err = false;
-  if(pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL) != 0){
+  if((all ? pthread_cond_broadcast(&rct->qcnd) : pthread_cond_signal(&rct->qcnd)) != 0){
     err = true;
-    ttservlog(serv, TTLOGERROR, "pthread_setcancelstate failed");
+    ttservlog(serv, TTLOGERROR, "pthread_cond_signal failed");
   }
-  usleep(100000);
-  double freqi;
-  double freqd = modf(timer->freq_timed, &freqi);
-  while(!serv->term){
-    if(pthread_mutex_lock(&serv->tmtx) == 0){
-      struct timeval tv;
-      struct timespec ts;
-      if(gettimeofday(&tv, NULL) == 0){
-        ts.tv_sec = tv.tv_sec + (int)freqi;
-        ts.tv_nsec = tv.tv_usec * 1000 + freqd * 1000000000;
-        if(ts.tv_nsec >= 1000000000){
-          ts.tv_nsec -= 1000000000;
-          ts.tv_sec++;
-        }
-      } else {
-        ts.tv_sec = (1ULL << (sizeof(time_t) * 8 - 1)) - 1;
-        ts.tv_nsec = 0;
+  if(pthread_mutex_unlock(&rct->qmtx) != 0){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+  }
+  if(err) return false;
+#endif
+  return true;
+}
+
+
+/* Park the calling worker until the request queue of a reactor is updated.
+   `rct' specifies the reactor object.
+   `seq' specifies the wake-up sequence observed before the queue was found empty.
+   `ms' specifies the maximum waiting time in milliseconds.
+   If successful, the return value is true, else, it is false. */
+static bool ttservqpark(TTREACTOR *rct, uint32_t seq, int ms){
+  TTSERV *serv = rct->serv;
+  bool err = false;
+  __atomic_add_fetch(&rct->qidle, 1, __ATOMIC_SEQ_CST);
+#if defined(TTUSEFUTEX)
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000;
+  if(syscall(SYS_futex, &rct->qseq, FUTEX_WAIT_PRIVATE, seq, &ts, NULL, 0) == -1 &&
+     errno != EAGAIN && errno != ETIMEDOUT && errno != EINTR){
+    err = true;
+    ttservlog(serv, TTLOGERROR, "futex failed");
+  }
+#else
+  if(pthread_mutex_lock(&rct->qmtx) == 0){
+    struct timeval tv;
+    struct timespec ts;
+    if(gettimeofday(&tv, NULL) == 0){
+      ts.tv_sec = tv.tv_sec;
+      ts.tv_nsec = tv.tv_usec * 1000 + ms * 1000000;
+      if(ts.tv_nsec >= 1000000000){
+        ts.tv_sec += ts.tv_nsec / 1000000000;
+        ts.tv_nsec %= 1000000000;
       }
-      int code = pthread_cond_timedwait(&serv->tcnd, &serv->tmtx, &ts);
-      if(code == 0 || code == ETIMEDOUT || code == EINTR){
-        if(pthread_mutex_unlock(&serv->tmtx) != 0){
-          err = true;
-          ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
-          break;
-        }
-        if(code != 0) timer->do_timed(timer->opq_timed);
-      } else {
-        pthread_mutex_unlock(&serv->tmtx);
+    } else {
+      ts.tv_sec = (1ULL << (sizeof(time_t) * 8 - 1)) - 1;
+      ts.tv_nsec = 0;
+    }
+    if(__atomic_load_n(&rct->qseq, __ATOMIC_SEQ_CST) == seq){
+      int code = pthread_cond_timedwait(&rct->qcnd, &rct->qmtx, &ts);
+      if(code != 0 && code != ETIMEDOUT && code != EINTR){
         err = true;
         ttservlog(serv, TTLOGERROR, "pthread_cond_timedwait failed");
       }
-    } else {
+    }
+    if(pthread_mutex_unlock(&rct->qmtx) != 0){
       err = true;
-      ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
+      ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
     }
+  } else {
+    err = true;
+    ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
   }
-  return err ? "error" : NULL;
+#endif
+  __atomic_sub_fetch(&rct->qidle, 1, __ATOMIC_SEQ_CST);
+  return !err;
 }
 
 
-/* Call the task function of a server object.
-   `req' specifies the request object.
-   `sock' specifies the socket object. */
-static void ttservtask(TTSOCK *sock, TTREQ *req){
-  TTSERV *serv = req->serv;
-  if(!serv->do_task) return;
-  serv->do_task(sock, serv->opq_task, req);
+#if defined(TTUSEURING)
+
+
+/* Create an io_uring object.
+   The return value is the new object or `NULL' if io_uring is not available. */
+static TTURING *tturingnew(void){
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = syscall(__NR_io_uring_setup, TTURINGSIZ, &params);
+  if(fd == -1) return NULL;
+  if(!(params.features & IORING_FEAT_EXT_ARG)){
+    close(fd);
+    return NULL;
+  }
+  TTURING *ring = tcmalloc(sizeof(*ring));
+  ring->fd = fd;
+  ring->sqmsiz = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  ring->cqmsiz = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  ring->sqesiz = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqmap = mmap(NULL, ring->sqmsiz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_SQ_RING);
+  ring->cqmap = mmap(NULL, ring->cqmsiz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_CQ_RING);
+  ring->sqes = mmap(NULL, ring->sqesiz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd, IORING_OFF_SQES);
+  if(ring->sqmap == MAP_FAILED || ring->cqmap == MAP_FAILED || ring->sqes == MAP_FAILED){
+    if(ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqesiz);
+    if(ring->cqmap != MAP_FAILED) munmap(ring->cqmap, ring->cqmsiz);
+    if(ring->sqmap != MAP_FAILED) munmap(ring->sqmap, ring->sqmsiz);
+    close(fd);
+    tcfree(ring);
+    return NULL;
+  }
+  char *sp = ring->sqmap;
+  ring->sqhead = (uint32_t *)(sp + params.sq_off.head);
+  ring->sqtail = (uint32_t *)(sp + params.sq_off.tail);
+  ring->sqarray = (uint32_t *)(sp + params.sq_off.array);
+  ring->sqmask = *(uint32_t *)(sp + params.sq_off.ring_mask);
+  ring->sqnum = params.sq_entries;
+  char *cp = ring->cqmap;
+  ring->cqhead = (uint32_t *)(cp + params.cq_off.head);
+  ring->cqtail = (uint32_t *)(cp + params.cq_off.tail);
+  ring->cqes = (struct io_uring_cqe *)(cp + params.cq_off.cqes);
+  ring->cqmask = *(uint32_t *)(cp + params.cq_off.ring_mask);
+  ring->multi = true;
+  ring->waking = false;
+  return ring;
 }
 
 
-/* Dequeue tasks of a server object and dispatch them.
-   `argp' specifies the argument structure of the server object.
-   The return value is `NULL' on success and other on failure. */
-static void *ttservdeqtasks(void *argp){
-  TTREQ *req = argp;
-  TTSERV *serv = req->serv;
-  bool err = false;
-  if(pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL) != 0){
-    err = true;
-    ttservlog(serv, TTLOGERROR, "pthread_setcancelstate failed");
+/* Delete an io_uring object.
+   `ring' specifies the io_uring object.  Pending requests are canceled. */
+static void tturingdel(TTURING *ring){
+  munmap(ring->sqes, ring->sqesiz);
+  munmap(ring->cqmap, ring->cqmsiz);
+  munmap(ring->sqmap, ring->sqmsiz);
+  close(ring->fd);
+  tcfree(ring);
+}
+
+
+/* Get a cleared submission entry of an io_uring object.
+   `ring' specifies the io_uring object.
+   `serv' specifies the server object.
+   The return value is the submission entry or `NULL' on failure.  The entry is submitted by the
+   next call of `tturingenter'.  As only the owner thread enters the ring, the tail can be
+   advanced before the entry is filled. */
+static struct io_uring_sqe *tturingsqe(TTURING *ring, TTSERV *serv){
+  uint32_t tail = *ring->sqtail;
+  if(tail - __atomic_load_n(ring->sqhead, __ATOMIC_ACQUIRE) >= ring->sqnum &&
+     (tturingenter(ring, serv, 0, 0) == -1 ||
+      tail - __atomic_load_n(ring->sqhead, __ATOMIC_ACQUIRE) >= ring->sqnum)) return NULL;
+  uint32_t idx = tail & ring->sqmask;
+  struct io_uring_sqe *sqe = ring->sqes + idx;
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sqarray[idx] = idx;
+  __atomic_store_n(ring->sqtail, tail + 1, __ATOMIC_RELEASE);
+  return sqe;
+}
+
+
+/* Prepare a polling request for input of a file descriptor of an io_uring object.
+   `ring' specifies the io_uring object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor.
+   `tag' specifies the tag of the request.
+   `multi' specifies whether the request is multishot.
+   If successful, the return value is true, else, it is false. */
+static bool tturingpoll(TTURING *ring, TTSERV *serv, int fd, uint64_t tag, bool multi){
+  struct io_uring_sqe *sqe = tturingsqe(ring, serv);
+  if(!sqe) return false;
+  uint32_t events = POLLIN;
+#if defined(_MYBIGEND)
+  events = (events << 16) | (events >> 16);
+#endif
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = events;
+  if(multi) sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = (tag << 32) | (uint32_t)fd;
+  return true;
+}
+
+
+/* Prepare an accepting request of a listening socket of an io_uring object.
+   `ring' specifies the io_uring object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the listening socket.
+   `multi' specifies whether the request is multishot.
+   If successful, the return value is true, else, it is false. */
+static bool tturingaccept(TTURING *ring, TTSERV *serv, int fd, bool multi){
+  struct io_uring_sqe *sqe = tturingsqe(ring, serv);
+  if(!sqe) return false;
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = fd;
+  if(multi) sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->user_data = ((uint64_t)TTURACCEPT << 32) | (uint32_t)fd;
+  return true;
+}
+
+
+/* Prepare a canceling request of the accepting request of an io_uring object.
+   `ring' specifies the io_uring object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the listening socket.
+   If successful, the return value is true, else, it is false. */
+static bool tturingcancel(TTURING *ring, TTSERV *serv, int fd){
+  struct io_uring_sqe *sqe = tturingsqe(ring, serv);
+  if(!sqe) return false;
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = ((uint64_t)TTURACCEPT << 32) | (uint32_t)fd;
+  sqe->user_data = ((uint64_t)TTURCANCEL << 32) | (uint32_t)fd;
+  return true;
+}
+
+
+/* Submit prepared requests of an io_uring object and wait for completions.
+   `ring' specifies the io_uring object.
+   `serv' specifies the server object.
+   `wnum' specifies the number of completions to wait for.  If it is 0, it does not wait.
+   `ms' specifies the maximum waiting time in milliseconds.
+   The return value is the number of submitted requests or -1 on failure. */
+static int tturingenter(TTURING *ring, TTSERV *serv, int wnum, int ms){
+  uint32_t pnum = *ring->sqtail - __atomic_load_n(ring->sqhead, __ATOMIC_ACQUIRE);
+  if(pnum < 1 && wnum < 1) return 0;
+  struct __kernel_timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000;
+  struct io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  arg.ts = (uint64_t)(uintptr_t)&ts;
+  unsigned int flags = IORING_ENTER_EXT_ARG;
+  if(wnum > 0) flags |= IORING_ENTER_GETEVENTS;
+  __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
+  int rv = syscall(__NR_io_uring_enter, ring->fd, pnum, wnum, flags, &arg, sizeof(arg));
+  if(rv == -1){
+    if(errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY) return 0;
+    return -1;
   }
-  sigset_t sigset;
-  sigemptyset(&sigset);
-  sigaddset(&sigset, SIGPIPE);
-  sigset_t oldsigset;
-  sigemptyset(&sigset);
-  if(pthread_sigmask(SIG_BLOCK, &sigset, &oldsigset) != 0){
+  return rv;
+}
+
+
+/* Accept connections and dispatch ready requests to the workers of a reactor with io_uring.
+   `rct' specifies the reactor object.
+   If successful, the return value is true, else, it is false.
+   The listening socket is watched by a multishot accept request and each connection by a
+   oneshot polling request.  Workers pass keep-alive connections back through the rearm queue,
+   whose polling requests are submitted in a batch together with the wait for completions, and
+   the event file descriptor is written only when the reactor is sleeping.  If the server is
+   held, the accepting request is canceled before returning so that no connection is accepted
+   until the next start, and the other requests are kept in the ring. */
+static bool ttservreactoruring(TTREACTOR *rct){
+  TTSERV *serv = rct->serv;
+  TTURING *ring = rct->uring;
+  bool err = false;
+  if(!tturingaccept(ring, serv, rct->lfd, ring->multi) ||
+     (!ring->waking && !tturingpoll(ring, serv, rct->evfd, TTURWAKE, true))){
     err = true;
-    ttservlog(serv, TTLOGERROR, "pthread_sigmask failed");
+    ttservlog(serv, TTLOGERROR, "io_uring_enter failed");
   }
-  bool empty = false;
-  while(!serv->term){
-    if(pthread_mutex_lock(&serv->qmtx) == 0){
-      struct timeval tv;
-      struct timespec ts;
-      if(gettimeofday(&tv, NULL) == 0){
-        ts.tv_sec = tv.tv_sec;
-        ts.tv_nsec = tv.tv_usec * 1000 + TTWAITREQUEST * 1000000;
-        if(ts.tv_nsec >= 1000000000){
-          ts.tv_nsec -= 1000000000;
-          ts.tv_sec++;
-        }
-      } else {
-        ts.tv_sec = (1ULL << (sizeof(time_t) * 8 - 1)) - 1;
-        ts.tv_nsec = 0;
+  ring->waking = true;
+  bool accepting = true;
+  bool canceling = false;
+  while(!serv->term || (serv->hold && accepting)){
+    if(serv->term && !canceling){
+      canceling = true;
+      if(!tturingcancel(ring, serv, rct->lfd)){
+        accepting = false;
+        err = true;
+        ttservlog(serv, TTLOGERROR, "io_uring_enter failed");
+      }
+    }
+    __atomic_store_n(&rct->rsleep, 1, __ATOMIC_SEQ_CST);
+    int cfd;
+    while((cfd = ttservdequeue(rct->rslots, &rct->rhead, NULL)) != -1){
+      if(!tturingpoll(ring, serv, cfd, TTURPOLL, false)){
+        ttservconnmark(serv, cfd, false);
+        ttservpartdel(cfd < serv->connmax ? serv->parts + cfd : NULL);
+        close(cfd);
+        err = true;
+        ttservlog(serv, TTLOGERROR, "io_uring_enter failed");
       }
-      int code = empty ? pthread_cond_timedwait(&serv->qcnd, &serv->qmtx, &ts) : 0;
-      if(code == 0 || code == ETIMEDOUT || code == EINTR){
-        void *val = tclistshift2(serv->queue);
-        if(pthread_mutex_unlock(&serv->qmtx) != 0){
+    }
+    int rv = tturingenter(ring, serv, 1, TTWAITREQUEST);
+    __atomic_store_n(&rct->rsleep, 0, __ATOMIC_SEQ_CST);
+    if(rv == -1){
+      err = true;
+      ttservlog(serv, TTLOGERROR, "io_uring_enter failed");
+    }
+    uint32_t head = *ring->cqhead;
+    uint32_t tail = __atomic_load_n(ring->cqtail, __ATOMIC_ACQUIRE);
+    while(head != tail){
+      struct io_uring_cqe *cqe = ring->cqes + (head & ring->cqmask);
+      int tag = cqe->user_data >> 32;
+      int fd = (int)(uint32_t)cqe->user_data;
+      int res = cqe->res;
+      bool more = cqe->flags & IORING_CQE_F_MORE;
+      head++;
+      if(tag == TTURACCEPT){
+        if(res >= 0){
+          char addr[TTADDRBUFSIZ];
+          int port = 0;
+          struct sockaddr_in sain;
+          memset(&sain, 0, sizeof(sain));
+          socklen_t slen = sizeof(sain);
+          if(serv->port < 1){
+            sprintf(addr, "(unix)");
+          } else {
+            __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
+            if(getpeername(res, (struct sockaddr *)&sain, &slen) != 0 ||
+               getnameinfo((struct sockaddr *)&sain, sizeof(sain), addr, TTADDRBUFSIZ,
+                           NULL, 0, NI_NUMERICHOST) != 0) sprintf(addr, "0.0.0.0");
+            port = (int)ntohs(sain.sin_port);
+          }
+          int optint = 1;
+          setsockopt(res, SOL_SOCKET, SO_KEEPALIVE, (char *)&optint, sizeof(optint));
+          struct timeval opttv;
+          opttv.tv_sec = (int)SOCKRCVTIMEO;
+          opttv.tv_usec = (SOCKRCVTIMEO - (int)SOCKRCVTIMEO) * 1000000;
+          setsockopt(res, SOL_SOCKET, SO_RCVTIMEO, (char *)&opttv, sizeof(opttv));
+          opttv.tv_sec = (int)SOCKSNDTIMEO;
+          opttv.tv_usec = (SOCKSNDTIMEO - (int)SOCKSNDTIMEO) * 1000000;
+          setsockopt(res, SOL_SOCKET, SO_SNDTIMEO, (char *)&opttv, sizeof(opttv));
+          if(serv->port > 0){
+            optint = 1;
+            setsockopt(res, IPPROTO_TCP, TCP_NODELAY, (char *)&optint, sizeof(optint));
+          }
+          ttservlog(serv, TTLOGINFO, "connected: %s:%d", addr, port);
+          ttservconnmark(serv, res, true);
+          if(!tturingpoll(ring, serv, res, TTURPOLL, false)){
+            ttservconnmark(serv, res, false);
+            close(res);
+            err = true;
+            ttservlog(serv, TTLOGERROR, "io_uring_enter failed");
+          }
+        } else if(res == -EINVAL && ring->multi){
+          ring->multi = false;
+          ttservlog(serv, TTLOGINFO, "warning: multishot accept is not supported");
+        } else if(res != -EAGAIN && res != -EINTR && res != -ECONNABORTED && res != -ECANCELED){
           err = true;
-          ttservlog(serv, TTLOGERROR, "pthread_mutex_unlock failed");
+          ttservlog(serv, TTLOGERROR, "ttacceptsock failed");
         }
-        if(val){
-          empty = false;
-          int cfd = *(int *)val;
-          tcfree(val);
-          pthread_cleanup_push((void (*)(void *))close, (void *)(intptr_t)cfd);
-          TTSOCK *sock = ttsocknew(cfd);
-          pthread_cleanup_push((void (*)(void *))ttsockdel, sock);
-          bool reuse;
-          do {
-            if(serv->timeout > 0) ttsocksetlife(sock, serv->timeout);
-            req->mtime = tctime();
-            req->keep = false;
-            ttservtask(sock, req);
-            reuse = false;
-            if(sock->end){
-              req->keep = false;
-            } else if(sock->ep > sock->rp){
-              reuse = true;
-            }
-          } while(reuse);
-          pthread_cleanup_pop(1);
-          pthread_cleanup_pop(0);
-          if(req->keep){
-            struct epoll_event ev;
-            memset(&ev, 0, sizeof(ev));
-            ev.events = EPOLLIN | EPOLLONESHOT;
-            ev.data.fd = cfd;
-            if(epoll_ctl(req->epfd, EPOLL_CTL_MOD, cfd, &ev) != 0){
-              close(cfd);
-              err = true;
-              ttservlog(serv, TTLOGERROR, "epoll_ctl failed");
-            }
-          } else {
-            if(epoll_ctl(req->epfd, EPOLL_CTL_DEL, cfd, NULL) != 0){
-              err = true;
-              ttservlog(serv, TTLOGERROR, "epoll_ctl failed");
-            }
-            if(!ttclosesock(cfd)){
-              err = true;
-              ttservlog(serv, TTLOGERROR, "close failed");
-            }
-            ttservlog(serv, TTLOGINFO, "connection finished");
+        if(!more){
+          if(canceling){
+            accepting = false;
+          } else if(!tturingaccept(ring, serv, fd, ring->multi)){
+            err = true;
+            ttservlog(serv, TTLOGERROR, "io_uring_enter failed");
           }
-        } else {
-          empty = true;
+        }
+      } else if(tag == TTURCANCEL){
+        if(res < 0 && res != -EALREADY) accepting = false;
+      } else if(tag == TTURWAKE){
+        uint64_t num;
+        __atomic_add_fetch(&serv->evsysnum, 1, __ATOMIC_RELAXED);
+        if(read(fd, &num, sizeof(num)) == -1 && errno != EAGAIN){
+          err = true;
+          ttservlog(serv, TTLOGERROR, "read failed");
+        }
+        if(!more && !tturingpoll(ring, serv, fd, TTURWAKE, true)){
+          err = true;
+          ttservlog(serv, TTLOGERROR, "io_uring_enter failed");
         }
       } else {
-        pthread_mutex_unlock(&serv->qmtx);
-        err = true;
-        ttservlog(serv, TTLOGERROR, "pthread_cond_timedwait failed");
+        bool queued;
+        while(!(queued = ttservenqueue(rct->qslots, &rct->qtail, fd)) && !serv->term){
+          if(!ttservqwake(rct, true)) err = true;
+          sched_yield();
+        }
+        if(!queued) ttservabandon(rct, fd);
+        if(!ttservqwake(rct, false)) err = true;
       }
-    } else {
-      err = true;
-      ttservlog(serv, TTLOGERROR, "pthread_mutex_lock failed");
     }
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-    pthread_testcancel();
-    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    req->mtime = tctime();
+    __atomic_store_n(ring->cqhead, head, __ATOMIC_RELEASE);
+    if(!ttservsweep(rct)) err = true;
   }
-  if(pthread_sigmask(SIG_SETMASK, &oldsigset, NULL) != 0){
-    err = true;
-    ttservlog(serv, TTLOGERROR, "pthread_sigmask failed");
-  }
-  return err ? "error" : NULL;
+  return !err;
 }
 
 
+#endif
+
+
 
 /*************************************************************************************************
  * features for experts
@@ -33,6 +33,7 @@ __TTUTIL_CLINKAGEBEGIN
 #include <stdint.h>
 #include <time.h>
 #include <pthread.h>
+#include <sys/uio.h>
 
 
 
@@ -44,13 +45,36 @@ __TTUTIL_CLINKAGEBEGIN
 #define TTIOBUFSIZ     65536             /* size of an I/O buffer */
 #define TTADDRBUFSIZ   1024              /* size of an address buffer */
 
+typedef struct {                         /* type of structure for a shared memory transport */
+  char name[TTADDRBUFSIZ];               /* name of the segment to be unlinked */
+  void *map;                             /* mapped region of the segment */
+  size_t msiz;                           /* size of the mapped region */
+  void *irng;                            /* ring of input */
+  void *orng;                            /* ring of output */
+  char *ibuf;                            /* data region of the ring of input */
+  char *obuf;                            /* data region of the ring of output */
+  uint32_t rsiz;                         /* size of the data region of each ring */
+  int side;                              /* side of the segment */
+  int fd;                                /* file descriptor connected to the peer */
+} TTSHM;
+
 typedef struct {                         /* type of structure for a socket */
   int fd;                                /* file descriptor */
   char buf[TTIOBUFSIZ];                  /* reading buffer */
+  char *bp;                              /* beginning pointer of the reading buffer */
   char *rp;                              /* reading pointer */
   char *ep;                              /* end pointer */
   bool end;                              /* end flag */
   double dl;                             /* deadline time */
+  char *obuf;                            /* buffer of coalesced output */
+  int osiz;                              /* size of coalesced output */
+  bool coal;                             /* whether to coalesce output */
+  char *lbuf;                            /* buffer of the last line */
+  int lbsiz;                             /* allocated size of the line buffer */
+  char **tokens;                         /* array of the tokens of the last line */
+  int tanum;                             /* allocated number of the tokens */
+  TTSHM *shm;                            /* shared memory transport */
+  char *zbuf;                            /* buffer of expanded input */
 } TTSOCK;
 
 
@@ -93,6 +117,15 @@ int ttopensockunix(const char *path);
 int ttopenservsock(const char *addr, int port);
 
 
+/* Open a server socket of TCP/IP stream to clients, which can be shared by other sockets.
+   `addr' specifies the address of the server.  If it is `NULL', every network address is binded.
+   `port' specifies the port number.
+   `share' specifies whether other sockets are allowed to be bound to the same address and port
+   number at the same time.  If so, the kernel distributes incoming connections among them.
+   The return value is the file descriptor of the stream, or -1 on error. */
+int ttopenservsock2(const char *addr, int port, bool share);
+
+
 /* Open a server socket of UNIX domain stream to clients.
    `addr' specifies the address of the server.  If it is `NULL', every network address is binded.
    `port' specifies the port number of the server.
@@ -139,6 +172,53 @@ void ttsockdel(TTSOCK *sock);
 void ttsocksetlife(TTSOCK *sock, double lifetime);
 
 
+/* Set the output coalescing mode of a socket object.
+   `sock' specifies the socket object.
+   `coal' specifies whether to coalesce output.  If it is true, data sent while further input is
+   already prefetched is kept in the output buffer and written together with the data sent after
+   the input buffer drains.  The output buffer is also written before waiting for input.
+   By default, output is not coalesced. */
+void ttsocksetcoalesce(TTSOCK *sock, bool coal);
+
+
+/* Bind a socket object to a shared memory transport.
+   `sock' specifies the socket object.
+   `shm' specifies the shared memory transport object.  It is deleted with the socket object.
+   Data is sent and received through the rings of the segment instead of the file descriptor,
+   which is only watched to detect the death of the peer. */
+void ttsocksetshm(TTSOCK *sock, TTSHM *shm);
+
+
+/* Create a shared memory transport as a server.
+   `fd' specifies the file descriptor of a socket connected to the client.
+   The return value is the new shared memory transport object or `NULL' on failure.
+   A segment holding a ring of requests and a ring of responses is created with a unique name
+   stored in the `name' member.  It should be passed to the client, which attaches to it with
+   `ttshmopen' and unlinks the name.  The name is also unlinked when the object is deleted.
+   Sleeping sides are waked up by futexes, so this is supported only on Linux. */
+TTSHM *ttshmnew(int fd);
+
+
+/* Attach to a shared memory transport as a client.
+   `fd' specifies the file descriptor of a socket connected to the server.
+   `name' specifies the name of the segment created by the server.
+   The return value is the new shared memory transport object or `NULL' on failure. */
+TTSHM *ttshmopen(int fd, const char *name);
+
+
+/* Delete a shared memory transport object.
+   `shm' specifies the shared memory transport object.
+   The peer is notified of the closing.  The file descriptor is not closed. */
+void ttshmdel(TTSHM *shm);
+
+
+/* Wait for input of a shared memory transport.
+   `shm' specifies the shared memory transport object.
+   `ms' specifies the maximum waiting time in milliseconds.
+   The return value is 1 if input is available, 0 if the peer is closed, or -1 on timeout. */
+int ttshmwait(TTSHM *shm, int ms);
+
+
 /* Send data by a socket.
    `sock' specifies the socket object.
    `buf' specifies the pointer to the region of the data to send.
@@ -147,6 +227,22 @@ void ttsocksetlife(TTSOCK *sock, double lifetime);
 bool ttsocksend(TTSOCK *sock, const void *buf, int size);
 
 
+/* Send vectored data by a socket.
+   `sock' specifies the socket object.
+   `iov' specifies the array of the regions of the data to send.  It is not modified.
+   `iovcnt' specifies the number of the regions.  It is not limited by `IOV_MAX'.
+   If successful, the return value is true, else, it is false.
+   The regions are written in order by as few system calls as possible without being copied,
+   unless they are small enough to be coalesced. */
+bool ttsocksendv(TTSOCK *sock, const struct iovec *iov, int iovcnt);
+
+
+/* Write the coalesced output of a socket.
+   `sock' specifies the socket object.
+   If successful, the return value is true, else, it is false. */
+bool ttsockflush(TTSOCK *sock);
+
+
 /* Send formatted data by a socket.
    `sock' specifies the socket object.
    `format' specifies the printf-like format string.
@@ -164,7 +260,8 @@ bool ttsockprintf(TTSOCK *sock, const char *format, ...);
    `buf' specifies the pointer to the region of the data to be received.
    `size' specifies the size of the buffer.
    If successful, the return value is true, else, it is false.   False is returned if the socket
-   is closed before receiving the specified size of data. */
+   is closed before receiving the specified size of data.  Data beyond the reading buffer is
+   received directly into the region. */
 bool ttsockrecv(TTSOCK *sock, char *buf, int size);
 
 
@@ -199,6 +296,27 @@ bool ttsockgets(TTSOCK *sock, char *buf, int size);
 char *ttsockgets2(TTSOCK *sock);
 
 
+/* Receive one line by a socket and split it into tokens.
+   `sock' specifies the socket object.
+   `np' specifies the pointer to the variable into which the number of the tokens is assigned.
+   If successful, the return value is the pointer to the array of the tokens, else, it is
+   `NULL'.  `NULL' is returned if the socket is closed before receiving linefeed.
+   Tokens are separated by space or tab characters and each of them is terminated by zero
+   code.  The line is found in the reading buffer by `memchr' and copied once into the line
+   buffer of the socket object, where it is split in place.  The array and the tokens are
+   valid until the next call of this function or the deletion of the socket object. */
+char **ttsockgettokens(TTSOCK *sock, int *np);
+
+
+/* Expand a compressed frame at the head of the input of a socket.
+   `sock' specifies the socket object.
+   If successful, the return value is true, else, it is false.
+   If the next byte is the response code `TTCODECOMP', the frame following it is decompressed
+   and the original response is read from the socket afterward as if it were sent as is.
+   Otherwise, nothing is consumed. */
+bool ttsockexpand(TTSOCK *sock);
+
+
 /* Receive an 32-bit integer by a socket.
    `sock' specifies the socket object.
    The return value is the 32-bit integer. */
@@ -223,6 +341,22 @@ bool ttsockcheckend(TTSOCK *sock);
 int ttsockcheckpfsiz(TTSOCK *sock);
 
 
+/* Get the prefetched data in a socket without consuming it.
+   `sock' specifies the socket object.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   The return value is the pointer to the region of the prefetched data.  It is valid until the
+   next operation on the socket. */
+const char *ttsockpeek(TTSOCK *sock, int *sp);
+
+
+/* Skip data received by a socket.
+   `sock' specifies the socket object.
+   `size' specifies the size of the data to be skipped.
+   If successful, the return value is true, else, it is false. */
+bool ttsockskip(TTSOCK *sock, int size);
+
+
 /* Fetch the resource of a URL by HTTP.
    `url' specifies the URL.
    `reqheads' specifies a map object contains request header names and their values.  The header
@@ -250,6 +384,33 @@ void ttpackdouble(double num, char *buf);
 double ttunpackdouble(const char *buf);
 
 
+/* Compress a serial object.
+   `codec' specifies the compression codec: `TTZDEFLATE' for Deflate, `TTZBZIP' for BZIP2.
+   `ptr' specifies the pointer to the region.
+   `size' specifies the size of the region.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   If successful, the return value is the pointer to the result object, else, it is `NULL'.
+   `NULL' is also returned if the codec is not supported by the linked library.  Because the
+   region of the return value is allocated with the `malloc' call, it should be released with
+   the `free' call when it is no longer in use. */
+char *ttcompress(int codec, const char *ptr, int size, int *sp);
+
+
+/* Decompress a serial object compressed by `ttcompress'.
+   `codec' specifies the compression codec.
+   `ptr' specifies the pointer to the region.
+   `size' specifies the size of the region.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   If successful, the return value is the pointer to the result object, else, it is `NULL'.
+   Because an additional zero code is appended at the end of the region of the return value,
+   the return value can be treated as a character string.  Because the region of the return
+   value is allocated with the `malloc' call, it should be released with the `free' call when it
+   is no longer in use. */
+char *ttdecompress(int codec, const char *ptr, int size, int *sp);
+
+
 
 /*************************************************************************************************
  * server utilities
@@ -261,14 +422,23 @@ double ttunpackdouble(const char *buf);
 #define TTCMDPUTKEEP   0x11              /* ID of putkeep command */
 #define TTCMDPUTCAT    0x12              /* ID of putcat command */
 #define TTCMDPUTSHL    0x13              /* ID of putshl command */
+#define TTCMDCAS       0x14              /* ID of cas command */
+#define TTCMDPUTTTL    0x15              /* ID of putttl command */
+#define TTCMDPUTXT     0x16              /* ID of expiration record of update logs */
 #define TTCMDPUTNR     0x18              /* ID of putnr command */
+#define TTCMDBATCH     0x19              /* ID of batch command */
 #define TTCMDOUT       0x20              /* ID of out command */
 #define TTCMDGET       0x30              /* ID of get command */
 #define TTCMDMGET      0x31              /* ID of mget command */
+#define TTCMDGETS      0x32              /* ID of gets command */
+#define TTCMDMGETSTRM  0x33              /* ID of mgetstrm command */
 #define TTCMDVSIZ      0x38              /* ID of vsiz command */
 #define TTCMDITERINIT  0x50              /* ID of iterinit command */
 #define TTCMDITERNEXT  0x51              /* ID of iternext command */
+#define TTCMDITERPAGE  0x52              /* ID of iterpage command */
+#define TTCMDITERPART  0x53              /* ID of iterpart command */
 #define TTCMDFWMKEYS   0x58              /* ID of fwmkeys command */
+#define TTCMDFWMRECS   0x59              /* ID of fwmrecs command */
 #define TTCMDADDINT    0x60              /* ID of addint command */
 #define TTCMDADDDOUBLE 0x61              /* ID of adddouble command */
 #define TTCMDEXT       0x68              /* ID of ext command */
@@ -282,48 +452,151 @@ double ttunpackdouble(const char *buf);
 #define TTCMDSTAT      0x88              /* ID of stat command */
 #define TTCMDMISC      0x90              /* ID of misc command */
 #define TTCMDREPL      0xa0              /* ID of repl command */
+#define TTCMDSHM       0xa8              /* ID of shm command */
 
-#define TTTIMERMAX     8                 /* maximum number of timers */
+#define TTCMDCOMP      0xa9              /* ID of comp command */
+
+#define TTCODEMORE     0xfc              /* response code of a chunk followed by more chunks */
+#define TTCODECOMP     0xfd              /* response code of a compressed frame */
+#define TTCODEBUSY     0xfe              /* response code of a request shed by overload */
+
+enum {                                   /* enumeration for compression codecs */
+  TTZNONE,                               /* no compression */
+  TTZDEFLATE,                            /* Deflate */
+  TTZBZIP                                /* BZIP2 */
+};
+
+#define TTQUEUESIZ     4096              /* number of slots of the request queue */
 
 typedef struct _TTTIMER {                /* type of structure for a timer */
-  pthread_t thid;                        /* thread ID */
-  bool alive;                            /* alive flag */
   struct _TTSERV *serv;                  /* server object */
   double freq_timed;                     /* frequency of timed handler */
   void (*do_timed)(void *);              /* call back function for timed handler */
   void *opq_timed;                       /* opaque pointer for timed handler */
   bool delay;     /** set to false when started; */
   bool started;/** set to true when started;*/
+  double wait;                           /* waiting seconds before the first call */
+  bool once;                             /* whether the handler is called only once */
+  int state;                             /* state of scheduling */
+  double due;                            /* due time of the next call */
+  uint64_t tick;                         /* tick of the next call in the timer wheel */
+  struct _TTTIMER *next;                 /* next timer in the same list */
 } TTTIMER;
 
+typedef struct {                         /* type of structure for a slot of the request queue */
+  uint32_t seq;                          /* sequence number */
+  int fd;                                /* file descriptor */
+  double etime;                          /* enqueued time */
+} TTQSLOT;
+
+typedef struct {                         /* type of structure for a partial request */
+  char *buf;                             /* buffer of received data */
+  int size;                              /* size of received data */
+  int asiz;                              /* allocated size of the buffer */
+  double stime;                          /* starting time */
+} TTPART;
+
 typedef struct _TTREQ {                  /* type of structure for a server */
   pthread_t thid;                        /* thread ID */
   bool alive;                            /* alive flag */
   struct _TTSERV *serv;                  /* server object */
+  struct _TTREACTOR *rct;                /* reactor object */
   int epfd;                              /* polling file descriptor */
   double mtime;                          /* last modified time */
   bool keep;                             /* keep-alive flag */
   int idx;                               /* ordinal index */
+  bool retired;                          /* retired flag */
+  bool shed;                             /* whether to shed requests of low priority */
+  int cfd;                               /* file descriptor of the current connection */
+  bool done;                             /* whether the thread has finished */
+  void *arena;                           /* arena of buffers reset after each request */
 } TTREQ;
 
+typedef struct _TTREACTOR {              /* type of structure for a reactor */
+  pthread_t thid;                        /* thread ID */
+  bool alive;                            /* alive flag */
+  struct _TTSERV *serv;                  /* server object */
+  int idx;                               /* ordinal index */
+  int lfd;                               /* listening file descriptor */
+  int epfd;                              /* polling file descriptor */
+  TTQSLOT *qslots;                       /* ring of slots of the request queue */
+  uint32_t qhead;                        /* dequeue position of the request queue */
+  uint32_t qtail;                        /* enqueue position of the request queue */
+  uint32_t qseq;                         /* wake-up sequence of the request queue */
+  uint32_t qidle;                        /* number of parked workers */
+  pthread_mutex_t qmtx;                  /* mutex for parking on the queue */
+  pthread_cond_t qcnd;                   /* condition variable for parking on the queue */
+  uint32_t qshed;                        /* whether the queue is over the high watermark */
+  void *uring;                           /* io_uring object or `NULL' for epoll */
+  int evfd;                              /* event file descriptor to wake the reactor */
+  TTQSLOT *rslots;                       /* ring of slots of the rearm queue */
+  uint32_t rhead;                        /* dequeue position of the rearm queue */
+  uint32_t rtail;                        /* enqueue position of the rearm queue */
+  uint32_t rsleep;                       /* whether the reactor is sleeping */
+  uint64_t lastwait;                     /* last queue waiting microseconds */
+  int wnum;                              /* number of running workers */
+  int wmin;                              /* minimum number of running workers */
+  int wmax;                              /* maximum number of running workers */
+  TTREQ *reqs;                           /* request objects of all workers */
+  int thnum;                             /* number of all worker slots */
+  int rnum;                              /* number of all reactors */
+} TTREACTOR;
+
 typedef struct _TTSERV {                 /* type of structure for a server */
   char host[TTADDRBUFSIZ];               /* host name */
   char addr[TTADDRBUFSIZ];               /* host address */
   uint16_t port;                         /* port number */
-  TCLIST *queue;                         /* queue of requests */
-  pthread_mutex_t qmtx;                  /* mutex for the queue */
-  pthread_cond_t qcnd;                   /* condition variable for the queue */
   pthread_mutex_t tmtx;                  /* mutex for the timer */
   pthread_cond_t tcnd;                   /* condition variable for the timer */
   int thnum;                             /* number of threads */
+  int thmax;                             /* maximum number of threads */
+  double spawnwait;                      /* queue waiting seconds to spawn a thread */
+  double idletime;                       /* idle seconds to retire a thread */
+  int rnum;                              /* number of reactors */
+  int qhigh;                             /* high watermark of the request queue */
+  int qlow;                              /* low watermark of the request queue */
+  bool uring;                            /* whether io_uring is requested */
   double timeout;                        /* timeout milliseconds of each task */
   bool term;                             /* terminate flag */
   void (*do_log)(int, const char *, void *);  /* call back function for logging */
   void *opq_log;                         /* opaque pointer for logging */
-  TTTIMER timers[TTTIMERMAX];            /* timer objects */
+  TTTIMER **timers;                      /* timer objects */
   int timernum;                          /* number of timer objects */
+  void *wheel;                           /* timer wheel object */
   void (*do_task)(TTSOCK *, void *, TTREQ *req);  /* call back function for task */
   void *opq_task;                        /* opaque pointer for task */
+  int (*do_frame)(const char *, int, void *);  /* call back function for framing */
+  void *opq_frame;                       /* opaque pointer for framing */
+  uint8_t *conns;                        /* flags of open connections indexed by descriptor */
+  uint32_t *copts;                       /* options of connections indexed by descriptor */
+  void **cdats;                          /* data of connections indexed by descriptor */
+  void (*do_conndel)(void *, void *);    /* call back function to release connection data */
+  void *opq_conndel;                     /* opaque pointer for releasing connection data */
+  TTPART **parts;                        /* partial requests indexed by file descriptor */
+  int connmax;                           /* number of slots of connections */
+  bool hold;                             /* whether to hold descriptors over termination */
+  struct _TTREACTOR *rcts;               /* reactor objects held over termination */
+  int rctnum;                            /* number of held reactor objects */
+  int *lfds;                             /* inherited listening file descriptors */
+  int lfdnum;                            /* number of inherited listening file descriptors */
+  int *cfds;                             /* inherited connection file descriptors */
+  int cfdnum;                            /* number of inherited connection file descriptors */
+  int thcur;                             /* number of running threads */
+  uint64_t spawnnum;                     /* number of spawned threads */
+  uint64_t retirenum;                    /* number of retired threads */
+  uint64_t waitnum;                      /* number of dequeued requests */
+  uint64_t waitsum;                      /* total queue waiting microseconds */
+  uint64_t waitmax;                      /* maximum queue waiting microseconds */
+  int uringnum;                          /* number of reactors using io_uring */
+  uint64_t evsysnum;                     /* number of system calls of the event loop */
+  uint64_t defernum;                     /* number of deferred partial requests */
+  uint64_t firenum;                      /* number of calls of timed handlers */
+  uint64_t jitsum;                       /* total delay microseconds of timed handlers */
+  uint64_t jitmax;                       /* maximum delay microseconds of timed handlers */
+  pthread_mutex_t smtx;                  /* mutex for shared memory sessions */
+  void *shms;                            /* shared memory sessions */
+  uint64_t shmnum;                       /* number of opened shared memory sessions */
+  int shmmax;                            /* maximum number of shared memory sessions */
 } TTSERV;
 
 enum {                                   /* enumeration for logging levels */
@@ -362,6 +635,55 @@ bool ttservconf(TTSERV *serv, const char *host, int port);
 void ttservtune(TTSERV *serv, int thnum, double timeout);
 
 
+/* Set tuning parameters of the elastic worker pool of a server object.
+   `serv' specifies the server object.
+   `thmax' specifies the maximum number of worker threads.  If it is more than the number set by
+   `ttservtune', that number is treated as the minimum and worker threads are spawned and retired
+   between the two numbers.  By default, the pool is not elastic.
+   `spawnwait' specifies the queue waiting seconds of a request over which another worker thread
+   is spawned.  If it is not more than 0, the default of 0.01 seconds is specified.
+   `idletime' specifies the idle seconds over which a spawned worker thread is retired.  If it is
+   not more than 0, the default of 30 seconds is specified. */
+void ttservtunepool(TTSERV *serv, int thmax, double spawnwait, double idletime);
+
+
+/* Set the watermarks of the request queue of a server object.
+   `serv' specifies the server object.
+   `qhigh' specifies the number of pending requests of a reactor over which workers are told to
+   shed requests of low priority.  If it is not more than 0, shedding is disabled.  By default,
+   shedding is disabled.
+   `qlow' specifies the number of pending requests under which shedding stops.  If it is not more
+   than 0 or not less than `qhigh', a half of `qhigh' is specified.
+   Whether to shed the current request is passed to the task handler by the `shed' member of the
+   request object.  Each watermark is limited by the capacity of the queue, 4096. */
+void ttservtunequeue(TTSERV *serv, int qhigh, int qlow);
+
+
+/* Set the number of reactors of a server object.
+   `serv' specifies the server object.
+   `rnum' specifies the number of reactors.  By default, the number is 1.  If it is more than 1,
+   each reactor thread has its own listening socket bound to the same port, its own polling
+   object, its own request queue, and its own part of the worker threads.  The number is limited
+   by the number of worker threads.  UNIX domain socket supports one reactor only. */
+void ttservsetreactors(TTSERV *serv, int rnum);
+
+
+/* Set the event backend of a server object.
+   `serv' specifies the server object.
+   `uring' specifies whether io_uring is used instead of epoll.  By default, epoll is used.  If
+   io_uring is not supported by the system, epoll is used as the fallback.  With io_uring, new
+   connections are accepted by a multishot request and readiness of keep-alive connections is
+   rearmed in batches so that the event loop makes fewer system calls per request. */
+void ttservseturing(TTSERV *serv, bool uring);
+
+
+/* Set the maximum number of shared memory sessions of a server object.
+   `serv' specifies the server object.
+   `max' specifies the maximum number of sessions running at the same time.  If it is not more
+   than 0, the shared memory transport is disabled, which is the default. */
+void ttservsetshm(TTSERV *serv, int max);
+
+
 /* Set the logging handler of a server object.
    `serv' specifies the server object.
    `do_log' specifies the pointer to a function to do with a log message.  Its first parameter is
@@ -376,7 +698,11 @@ void ttservsetloghandler(TTSERV *serv, void (*do_log)(int, const char *, void *)
    `freq' specifies the frequency of execution in seconds.
    `do_timed' specifies the pointer to a function to do with a event.  Its parameter is the
    opaque pointer.
-   `opq' specifies the opaque pointer to be passed to the handler.  It can be `NULL'. */
+   `opq' specifies the opaque pointer to be passed to the handler.  It can be `NULL'.
+   The number of timed handlers is not limited.  All of them are driven by a single timer
+   wheel thread and called by a small pool of executor threads, which grows while every
+   executor is busy with a long handler.  The next call of a handler is scheduled after the
+   previous call returns. */
 void ttservaddtimedhandler(TTSERV *serv, double freq, void (*do_timed)(void *), void *opq);
 /* Add a timed handler to a server object.
    `serv' specifies the server object.
@@ -387,6 +713,20 @@ void ttservaddtimedhandler(TTSERV *serv, double freq, void (*do_timed)(void *),
 void ttservaddtimedhandler_delay(TTSERV *serv, double freq, void (*do_timed)(void *), void *opq);
 
 
+/* Add a timer to a server object.
+   `serv' specifies the server object.
+   `wait' specifies the waiting seconds before the first call.
+   `freq' specifies the frequency of execution in seconds.  If it is not more than 0, the
+   handler is called only once.
+   `do_timed' specifies the pointer to a function to do with a event.  Its parameter is the
+   opaque pointer.
+   `opq' specifies the opaque pointer to be passed to the handler.  It can be `NULL'.
+   This function can be called while the server is running.  The delay of each call from its
+   due time is measured and the total and the maximum are recorded in the `jitsum' and the
+   `jitmax' members of the server object. */
+void ttservaddtimer(TTSERV *serv, double wait, double freq, void (*do_timed)(void *), void *opq);
+
+
 /* Set the response handler of a server object.
    `serv' specifies the server object.
    `do_task' specifies the pointer to a function to do with a task.  Its first parameter is
@@ -396,6 +736,32 @@ void ttservaddtimedhandler_delay(TTSERV *serv, double freq, void (*do_timed)(voi
 void ttservsettaskhandler(TTSERV *serv, void (*do_task)(TTSOCK *, void *, TTREQ *), void *opq);
 
 
+/* Set the framing handler of a server object.
+   `serv' specifies the server object.
+   `do_frame' specifies the pointer to a function to check whether a request is complete.  Its
+   first parameter is the pointer to the received data.  Its second parameter is the size of the
+   data.  Its third parameter is the opaque pointer.  It should return the size of the first
+   request if the data contains it entirely, 0 if more data is needed, -1 if the request can not
+   be judged, or -2 if the request is too large to be buffered and the connection should be
+   closed.
+   `opq' specifies the opaque pointer to be passed to the handler.  It can be `NULL'.
+   If this handler is set, a worker receives data of a connection without blocking and passes
+   the connection back to the reactor until a whole request arrives, so that slow clients do not
+   hold workers.  A partial request is discarded with its connection if it is not completed
+   within the timeout of the server, or within 30 seconds if the timeout is not specified. */
+void ttservsetframehandler(TTSERV *serv, int (*do_frame)(const char *, int, void *), void *opq);
+
+
+/* Set the handler to release data of connections of a server object.
+   `serv' specifies the server object.
+   `do_conndel' specifies the pointer to a function to release data of a connection.  Its
+   parameters are the data set by `ttservsetconndata' and the opaque pointer.
+   `opq' specifies the opaque pointer to be passed to the handler.
+   The handler is called when a connection is closed, when its data is replaced, and when the
+   service is finished even if the connections are held. */
+void ttservsetconndelhandler(TTSERV *serv, void (*do_conndel)(void *, void *), void *opq);
+
+
 /* Start the service of a server object.
    `serv' specifies the server object.
    If successful, the return value is true, else, it is false. */
@@ -408,6 +774,86 @@ bool ttservstart(TTSERV *serv);
 bool ttservkill(TTSERV *serv);
 
 
+/* Send the terminate signal to a server object holding its descriptors.
+   `serv' specifies the server object.
+   If successful, the return value is true, else, it is false.
+   `ttservstart' returns after the running tasks are finished but the listening sockets, the
+   polling objects, the pending requests, and the keep-alive connections are kept, so that the
+   next call of `ttservstart' restarts the service without refusing nor dropping any client.
+   This function can be called in a signal handler. */
+bool ttservhold(TTSERV *serv);
+
+
+/* Hand the held descriptors of a server object over to another process.
+   `serv' specifies the server object terminated by `ttservhold'.
+   `fd' specifies the file descriptor of a UNIX domain socket connected to the process.
+   If successful, the return value is true, else, it is false.
+   The listening sockets and the keep-alive connections with their partial requests are sent
+   with `SCM_RIGHTS' and then closed in this process.  The receiver should call
+   `ttservtakeover'. */
+bool ttservhandover(TTSERV *serv, int fd);
+
+
+/* Take over the descriptors handed over by another process to a server object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of a listening UNIX domain socket.
+   `timeout' specifies the timeout seconds to wait for the sender.
+   If successful, the return value is true, else, it is false.
+   The next call of `ttservstart' uses the received listening sockets instead of binding new
+   ones and serves the received connections as if they were accepted by itself. */
+bool ttservtakeover(TTSERV *serv, int fd, double timeout);
+
+
+/* Serve a client of a server object through a shared memory segment.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the connection with the client.
+   `name' specifies the buffer of `TTADDRBUFSIZ' bytes into which the name of the segment
+   created by the server is written.  It should be sent to the client.
+   If successful, the return value is true, else, it is false.  It fails if the transport is
+   disabled, if the peer of the connection is neither a UNIX domain socket nor the loopback
+   address, if the connection already has a session, or if the number of running sessions
+   reaches the maximum.
+   A dedicated thread calls the task handler for the requests in the segment until the client
+   closes it, the connection is closed, or the server is terminated.  The request object given
+   to the handler has -1 as the ordinal index. */
+bool ttservopenshm(TTSERV *serv, int fd, char *name);
+
+
+/* Set the options of a connection of a server object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the connection.
+   `opts' specifies the options defined by the task handler.
+   The options are cleared when the connection is opened or closed, so that they are never
+   inherited by another connection reusing the same descriptor.  They are not handed over to a
+   new process by `ttservhandover'. */
+void ttservsetconnopts(TTSERV *serv, int fd, uint32_t opts);
+
+
+/* Get the options of a connection of a server object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the connection.
+   The return value is the options of the connection or 0 if they are not set. */
+uint32_t ttservconnopts(TTSERV *serv, int fd);
+
+
+/* Set the data of a connection of a server object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the connection.
+   `data' specifies the pointer to the data defined by the task handler.  If it is `NULL', the
+   data is cleared.
+   If successful, the return value is true, else, it is false.  The data replaced by this
+   function is released by the handler set by `ttservsetconndelhandler'.  The data should be
+   touched only by the task handler serving the connection. */
+bool ttservsetconndata(TTSERV *serv, int fd, void *data);
+
+
+/* Get the data of a connection of a server object.
+   `serv' specifies the server object.
+   `fd' specifies the file descriptor of the connection.
+   The return value is the data of the connection or `NULL' if it is not set. */
+void *ttservconndata(TTSERV *serv, int fd);
+
+
 /* Call the logging function of a server object.
    `serv' specifies the server object.
    `level' specifies the logging level.